@@ -18,15 +18,19 @@ HEADERS += \
     src/base/categorymodel.h \
     src/base/categoryselectionmodel.h \
     src/base/clipboardurlmodel.h \
+    src/base/concurrencycontroller.h \
     src/base/concurrenttransfersmodel.h \
     src/base/downloadrequester.h \
     src/base/downloadrequestmodel.h \
-    src/base/json.h \
+    src/base/htmlparser.h \
     src/base/logger.h \
     src/base/loggerverbositymodel.h \
+    src/base/logreader.h \
+    src/base/metrics.h \
     src/base/networkproxytypemodel.h \
     src/base/package.h \
     src/base/qdl.h \
+    src/base/schedulingpolicy.h \
     src/base/searchmodel.h \
     src/base/searchresult.h \
     src/base/searchselectionmodel.h \
@@ -36,7 +40,10 @@ HEADERS += \
     src/base/transfer.h \
     src/base/transferitem.h \
     src/base/transferitemprioritymodel.h \
+    src/base/transfermetrics.h \
     src/base/transfermodel.h \
+    src/base/transferquery.h \
+    src/base/transfersnapshot.h \
     src/base/urlchecker.h \
     src/base/urlcheckmodel.h \
     src/base/urlresult.h \
@@ -52,16 +59,20 @@ HEADERS += \
     src/plugins/javascriptnetworkrequest.h \
     src/plugins/javascriptpluginengine.h \
     src/plugins/javascriptpluginglobalobject.h \
+    src/plugins/javascriptpluginwatchdog.h \
     src/plugins/javascriptrecaptchaplugin.h \
     src/plugins/javascriptsearchplugin.h \
     src/plugins/javascriptsearchresult.h \
     src/plugins/javascriptserviceplugin.h \
     src/plugins/javascripturlresult.h \
+    src/plugins/lazypluginfactory.h \
+    src/plugins/pluginmanifestcache.h \
     src/plugins/pluginsettings.h \
     src/plugins/recaptchaplugin.h \
     src/plugins/recaptchapluginconfig.h \
     src/plugins/recaptchapluginconfigmodel.h \
     src/plugins/recaptchapluginmanager.h \
+    src/plugins/rulesserviceplugin.h \
     src/plugins/searchplugin.h \
     src/plugins/searchpluginconfig.h \
     src/plugins/searchpluginconfigmodel.h \
@@ -78,18 +89,25 @@ SOURCES += \
     src/base/categories.cpp \
     src/base/categorymodel.cpp \
     src/base/clipboardurlmodel.cpp \
+    src/base/concurrencycontroller.cpp \
     src/base/downloadrequester.cpp \
     src/base/downloadrequestmodel.cpp \
-    src/base/json.cpp \
+    src/base/htmlparser.cpp \
     src/base/logger.cpp \
+    src/base/logreader.cpp \
+    src/base/metrics.cpp \
     src/base/package.cpp \
     src/base/qdl.cpp \
+    src/base/schedulingpolicy.cpp \
     src/base/searchmodel.cpp \
     src/base/selectionmodel.cpp \
     src/base/stringmodel.cpp \
     src/base/transfer.cpp \
     src/base/transferitem.cpp \
+    src/base/transfermetrics.cpp \
     src/base/transfermodel.cpp \
+    src/base/transferquery.cpp \
+    src/base/transfersnapshot.cpp \
     src/base/urlchecker.cpp \
     src/base/urlcheckmodel.cpp \
     src/base/urlretrievalmodel.cpp \
@@ -102,15 +120,18 @@ SOURCES += \
     src/plugins/javascriptnetworkrequest.cpp \
     src/plugins/javascriptpluginengine.cpp \
     src/plugins/javascriptpluginglobalobject.cpp \
+    src/plugins/javascriptpluginwatchdog.cpp \
     src/plugins/javascriptrecaptchaplugin.cpp \
     src/plugins/javascriptsearchplugin.cpp \
     src/plugins/javascriptsearchresult.cpp \
     src/plugins/javascriptserviceplugin.cpp \
     src/plugins/javascripturlresult.cpp \
+    src/plugins/pluginmanifestcache.cpp \
     src/plugins/pluginsettings.cpp \
     src/plugins/recaptchapluginconfig.cpp \
     src/plugins/recaptchapluginconfigmodel.cpp \
     src/plugins/recaptchapluginmanager.cpp \
+    src/plugins/rulesserviceplugin.cpp \
     src/plugins/searchpluginconfig.cpp \
     src/plugins/searchpluginconfigmodel.cpp \
     src/plugins/searchpluginmanager.cpp \
@@ -119,6 +140,26 @@ SOURCES += \
     src/plugins/servicepluginmanager.cpp \
     src/plugins/xmlhttprequest.cpp
 
+greaterThan(QT_MAJOR_VERSION, 4) {
+    QT += qml
+
+    HEADERS += \
+        src/plugins/javascriptv4pluginengine.h \
+        src/plugins/javascriptv4pluginglobalobject.h \
+        src/plugins/javascriptv4searchplugin.h \
+        src/plugins/javascriptv4serviceplugin.h \
+        src/plugins/javascriptv4xmlhttprequest.h
+
+    SOURCES += \
+        src/plugins/javascriptv4pluginengine.cpp \
+        src/plugins/javascriptv4pluginglobalobject.cpp \
+        src/plugins/javascriptv4searchplugin.cpp \
+        src/plugins/javascriptv4serviceplugin.cpp \
+        src/plugins/javascriptv4xmlhttprequest.cpp
+}
+
+include(../json/json.pri)
+
 maemo5 {
     QT += \
         dbus \
@@ -246,6 +287,7 @@ maemo5 {
         src/desktop/downloadrequestdialog.h \
         src/desktop/generalsettingspage.h \
         src/desktop/interfacesettingspage.h \
+        src/desktop/logdialog.h \
         src/desktop/networksettingspage.h \
         src/desktop/nocaptchadialog.h \
         src/desktop/mainwindow.h \
@@ -277,6 +319,7 @@ maemo5 {
         src/desktop/downloadrequestdialog.cpp \
         src/desktop/generalsettingspage.cpp \
         src/desktop/interfacesettingspage.cpp \
+        src/desktop/logdialog.cpp \
         src/desktop/networksettingspage.cpp \
         src/desktop/nocaptchadialog.cpp \
         src/desktop/main.cpp \
@@ -350,12 +393,21 @@ contains(DEFINES, WEB_INTERFACE) {
         src/webif/clipboardserver.h \
         src/webif/decaptchaserver.h \
         src/webif/downloadrequestserver.h \
+        src/webif/eventserver.h \
         src/webif/fileserver.h \
+        src/webif/filestreamer.h \
+        src/webif/logserver.h \
+        src/webif/metricsserver.h \
         src/webif/recaptchaserver.h \
+        src/webif/requestbody.h \
+        src/webif/requeststats.h \
+        src/webif/requestworker.h \
         src/webif/searchserver.h \
         src/webif/serviceserver.h \
         src/webif/settingsserver.h \
+        src/webif/transferfileserver.h \
         src/webif/transferserver.h \
+        src/webif/transferstreamer.h \
         src/webif/urlcheckserver.h \
         src/webif/urlretrievalserver.h \
         src/webif/webserver.h
@@ -370,13 +422,44 @@ contains(DEFINES, WEB_INTERFACE) {
         src/webif/clipboardserver.cpp \
         src/webif/decaptchaserver.cpp \
         src/webif/downloadrequestserver.cpp \
+        src/webif/eventserver.cpp \
         src/webif/fileserver.cpp \
+        src/webif/filestreamer.cpp \
+        src/webif/logserver.cpp \
+        src/webif/metricsserver.cpp \
         src/webif/recaptchaserver.cpp \
+        src/webif/requestbody.cpp \
+        src/webif/requeststats.cpp \
+        src/webif/requestworker.cpp \
         src/webif/searchserver.cpp \
         src/webif/serviceserver.cpp \
         src/webif/settingsserver.cpp \
+        src/webif/transferfileserver.cpp \
         src/webif/transferserver.cpp \
+        src/webif/transferstreamer.cpp \
         src/webif/urlcheckserver.cpp \
         src/webif/urlretrievalserver.cpp \
         src/webif/webserver.cpp
+    
+    # Copy the web interface and add gzip variants of the text assets, which FileServer
+    # serves to clients that accept gzip. The stamp file is the target, so the copy is only
+    # redone when one of the web interface files changes
+    compress_webif.target = $$OUT_PWD/webif-dist/.stamp
+    compress_webif.depends = $$files($$PWD/webif/*) $$files($$PWD/webif/css/*) $$files($$PWD/webif/js/*)
+    compress_webif.commands = \
+        rm -rf $$OUT_PWD/webif-dist && cp -R $$PWD/webif $$OUT_PWD/webif-dist && \
+        for f in $$OUT_PWD/webif-dist/desktop $$OUT_PWD/webif-dist/mobile \
+                 $$OUT_PWD/webif-dist/css/*.css $$OUT_PWD/webif-dist/js/*.js; do \
+            gzip -9 -n -c \$\$f > \$\$f.gz; \
+        done && \
+        touch $${compress_webif.target}
+    
+    webif.path = /usr/share/qdl2/webif
+    webif.extra = mkdir -p $(INSTALL_ROOT)/usr/share/qdl2/webif && \
+        cp -Rp $$OUT_PWD/webif-dist/. $(INSTALL_ROOT)/usr/share/qdl2/webif/ && \
+        rm -f $(INSTALL_ROOT)/usr/share/qdl2/webif/.stamp
+    
+    QMAKE_EXTRA_TARGETS += compress_webif
+    PRE_TARGETDEPS += $${compress_webif.target}
+    INSTALLS += webif
 }
@@ -0,0 +1,245 @@
+/*
+ * Copyright (C) 2016 Stuart Howarth <showarth@marxoft.co.uk>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "concurrencycontroller.h"
+#include "logger.h"
+#include "settings.h"
+#include "transfermodel.h"
+#include <QTimer>
+
+const int ConcurrencyController::SAMPLE_INTERVAL = 1000;
+const int ConcurrencyController::WINDOW_SAMPLES = 15;
+const int ConcurrencyController::HOLD_WINDOWS = 4;
+const int ConcurrencyController::HISTORY_SIZE = 10;
+
+// A transfer is considered throttled if its speed is below this fraction of the mean transfer speed
+static const double SLOW_TRANSFER_RATIO = 0.25;
+// An additional slot must increase the aggregate throughput by at least this fraction
+static const double MINIMUM_THROUGHPUT_GAIN = 0.05;
+// The proportion of finished transfers that may fail before the limit is reduced
+static const double MAXIMUM_ERROR_RATE = 0.25;
+
+ConcurrencyController::ConcurrencyController(QObject *parent) :
+    QObject(parent),
+    m_timer(new QTimer(this)),
+    m_maximum(Settings::minimumConcurrentTransfers()),
+    m_samples(0),
+    m_speedTotal(0),
+    m_activeTotal(0),
+    m_completed(0),
+    m_failed(0),
+    m_throughput(0),
+    m_previousThroughput(0),
+    m_errorRate(0),
+    m_slowTransfers(0),
+    m_lastAction(Hold),
+    m_holdWindows(0)
+{
+    m_timer->setInterval(SAMPLE_INTERVAL);
+    connect(m_timer, SIGNAL(timeout()), this, SLOT(sample()));
+    connect(Settings::instance(), SIGNAL(adaptiveConcurrentTransfersChanged(bool)),
+            this, SLOT(onAdaptiveChanged(bool)));
+    connect(Settings::instance(), SIGNAL(maximumConcurrentTransfersChanged(int)), this, SLOT(onBoundsChanged()));
+    connect(Settings::instance(), SIGNAL(minimumConcurrentTransfersChanged(int)), this, SLOT(onBoundsChanged()));
+
+    if (adaptive()) {
+        m_timer->start();
+    }
+}
+
+bool ConcurrencyController::adaptive() const {
+    return Settings::adaptiveConcurrentTransfers();
+}
+
+int ConcurrencyController::maximum() const {
+    return adaptive() ? m_maximum : Settings::maximumConcurrentTransfers();
+}
+
+QVariantMap ConcurrencyController::status() const {
+    QVariantMap map;
+    map["adaptive"] = adaptive();
+    map["maximum"] = maximum();
+    map["minimumBound"] = Settings::minimumConcurrentTransfers();
+    map["maximumBound"] = Settings::maximumConcurrentTransfers();
+
+    if (adaptive()) {
+        map["throughput"] = m_throughput;
+        map["errorRate"] = m_errorRate;
+        map["slowTransfers"] = m_slowTransfers;
+        map["lastDecision"] = m_lastDecision;
+        map["lastDecisionTime"] = m_lastDecisionTime.toString(Qt::ISODate);
+        map["decisions"] = m_history;
+    }
+
+    return map;
+}
+
+void ConcurrencyController::transferCompleted() {
+    ++m_completed;
+}
+
+void ConcurrencyController::transferFailed() {
+    ++m_failed;
+}
+
+void ConcurrencyController::sample() {
+    const TransferModel *model = TransferModel::instance();
+    const int active = model->activeTransfers();
+
+    if (active == 0) {
+        return;
+    }
+
+    ++m_samples;
+    m_speedTotal += model->totalSpeed();
+    m_activeTotal += active;
+
+    for (int i = 0; i < active; i++) {
+        if (const TransferItem *transfer = model->activeTransfer(i)) {
+            if (transfer->data(TransferItem::StatusRole) == TransferItem::Downloading) {
+                const QString id = transfer->data(TransferItem::IdRole).toString();
+                m_transferSpeedTotals[id] += transfer->data(TransferItem::SpeedRole).toInt();
+                m_transferSamples[id] += 1;
+            }
+        }
+    }
+
+    if (m_samples >= WINDOW_SAMPLES) {
+        evaluate();
+    }
+}
+
+void ConcurrencyController::evaluate() {
+    const int throughput = int(m_speedTotal / m_samples);
+    const double active = double(m_activeTotal) / m_samples;
+    const int downloading = m_transferSpeedTotals.size();
+    const int finished = m_completed + m_failed;
+    m_errorRate = finished > 0 ? double(m_failed) / finished : 0;
+    m_slowTransfers = 0;
+
+    if (downloading > 1) {
+        const double mean = double(throughput) / downloading;
+        QHashIterator<QString, qint64> iterator(m_transferSpeedTotals);
+
+        while (iterator.hasNext()) {
+            iterator.next();
+
+            if (iterator.value() / m_transferSamples.value(iterator.key(), 1) < mean * SLOW_TRANSFER_RATIO) {
+                ++m_slowTransfers;
+            }
+        }
+    }
+
+    m_previousThroughput = m_throughput;
+    m_throughput = throughput;
+    const int minimum = Settings::minimumConcurrentTransfers();
+    const int upper = qMax(minimum, Settings::maximumConcurrentTransfers());
+    Logger::log(QString("ConcurrencyController::evaluate(): Maximum: %1, Active: %2, Throughput: %3, Errors: %4/%5, Slow transfers: %6/%7")
+                .arg(m_maximum).arg(active).arg(throughput).arg(m_failed).arg(finished).arg(m_slowTransfers)
+                .arg(downloading), Logger::HighVerbosity);
+
+    if ((m_failed > 0) && (m_errorRate >= MAXIMUM_ERROR_RATE)) {
+        setMaximum(qMax(minimum, m_maximum / 2), Decrease, QString("Error rate is %1%")
+                   .arg(int(m_errorRate * 100)));
+    }
+    else if ((downloading > 1) && (m_slowTransfers * 2 > downloading)) {
+        setMaximum(qMax(minimum, m_maximum / 2), Decrease, QString("%1 of %2 transfers are throttled")
+                   .arg(m_slowTransfers).arg(downloading));
+    }
+    else if ((m_lastAction == Increase) && (active <= m_maximum - 1)) {
+        setMaximum(qMax(minimum, m_maximum - 1), Decrease, QString("Additional slot is unused"));
+    }
+    else if ((m_lastAction == Increase) && (throughput < m_previousThroughput * (1 + MINIMUM_THROUGHPUT_GAIN))) {
+        setMaximum(qMax(minimum, m_maximum - 1), Decrease, QString("No throughput gain from additional slot (%1 -> %2)")
+                   .arg(m_previousThroughput).arg(throughput));
+    }
+    else if (m_holdWindows > 0) {
+        --m_holdWindows;
+        m_lastAction = Hold;
+    }
+    else if ((active >= m_maximum) && (m_maximum < upper)) {
+        setMaximum(m_maximum + 1, Increase, QString("All slots are busy at %1 bytes/s").arg(throughput));
+    }
+    else {
+        m_lastAction = Hold;
+    }
+
+    resetWindow();
+}
+
+void ConcurrencyController::resetWindow() {
+    m_samples = 0;
+    m_speedTotal = 0;
+    m_activeTotal = 0;
+    m_transferSpeedTotals.clear();
+    m_transferSamples.clear();
+    m_completed = 0;
+    m_failed = 0;
+}
+
+void ConcurrencyController::setMaximum(int m, Action action, const QString &reason) {
+    m_lastAction = action;
+
+    if (action == Decrease) {
+        m_holdWindows = HOLD_WINDOWS;
+    }
+
+    if (m == m_maximum) {
+        return;
+    }
+
+    m_lastDecision = QString("%1 -> %2: %3").arg(m_maximum).arg(m).arg(reason);
+    m_lastDecisionTime = QDateTime::currentDateTime();
+    m_history.prepend(QString("%1 %2").arg(m_lastDecisionTime.toString(Qt::ISODate)).arg(m_lastDecision));
+
+    while (m_history.size() > HISTORY_SIZE) {
+        m_history.removeLast();
+    }
+
+    Logger::log("ConcurrencyController::setMaximum(): " + m_lastDecision, Logger::LowVerbosity);
+    m_maximum = m;
+    emit maximumChanged(m);
+}
+
+void ConcurrencyController::onAdaptiveChanged(bool enabled) {
+    Logger::log(QString("ConcurrencyController::onAdaptiveChanged(): %1").arg(enabled), Logger::LowVerbosity);
+    resetWindow();
+    m_lastAction = Hold;
+    m_holdWindows = 0;
+    m_throughput = 0;
+    m_previousThroughput = 0;
+
+    if (enabled) {
+        m_maximum = Settings::minimumConcurrentTransfers();
+        m_timer->start();
+    }
+    else {
+        m_timer->stop();
+    }
+
+    emit adaptiveChanged(enabled);
+    emit maximumChanged(maximum());
+}
+
+void ConcurrencyController::onBoundsChanged() {
+    if (adaptive()) {
+        const int minimum = Settings::minimumConcurrentTransfers();
+        m_maximum = qBound(minimum, m_maximum, qMax(minimum, Settings::maximumConcurrentTransfers()));
+    }
+
+    emit maximumChanged(maximum());
+}
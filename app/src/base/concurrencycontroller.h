@@ -0,0 +1,102 @@
+/*
+ * Copyright (C) 2016 Stuart Howarth <showarth@marxoft.co.uk>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef CONCURRENCYCONTROLLER_H
+#define CONCURRENCYCONTROLLER_H
+
+#include <QDateTime>
+#include <QHash>
+#include <QObject>
+#include <QStringList>
+#include <QVariantMap>
+
+class QTimer;
+
+class ConcurrencyController : public QObject
+{
+    Q_OBJECT
+
+    Q_PROPERTY(bool adaptive READ adaptive NOTIFY adaptiveChanged)
+    Q_PROPERTY(int maximum READ maximum NOTIFY maximumChanged)
+
+public:
+    explicit ConcurrencyController(QObject *parent = 0);
+
+    bool adaptive() const;
+
+    int maximum() const;
+
+    QVariantMap status() const;
+
+public Q_SLOTS:
+    void transferCompleted();
+    void transferFailed();
+
+private Q_SLOTS:
+    void sample();
+
+    void onAdaptiveChanged(bool enabled);
+    void onBoundsChanged();
+
+Q_SIGNALS:
+    void adaptiveChanged(bool enabled);
+    void maximumChanged(int maximum);
+
+private:
+    enum Action {
+        Hold = 0,
+        Increase,
+        Decrease
+    };
+
+    void evaluate();
+    void resetWindow();
+
+    void setMaximum(int m, Action action, const QString &reason);
+
+    static const int SAMPLE_INTERVAL;
+    static const int WINDOW_SAMPLES;
+    static const int HOLD_WINDOWS;
+    static const int HISTORY_SIZE;
+
+    QTimer *m_timer;
+
+    int m_maximum;
+
+    int m_samples;
+    qint64 m_speedTotal;
+    qint64 m_activeTotal;
+    QHash<QString, qint64> m_transferSpeedTotals;
+    QHash<QString, int> m_transferSamples;
+
+    int m_completed;
+    int m_failed;
+
+    int m_throughput;
+    int m_previousThroughput;
+    double m_errorRate;
+    int m_slowTransfers;
+
+    Action m_lastAction;
+    int m_holdWindows;
+
+    QString m_lastDecision;
+    QDateTime m_lastDecisionTime;
+    QStringList m_history;
+};
+
+#endif // CONCURRENCYCONTROLLER_H
@@ -0,0 +1,781 @@
+/*
+ * Copyright (C) 2017 Stuart Howarth <showarth@marxoft.co.uk>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "htmlparser.h"
+#include "logger.h"
+#include "utils.h"
+#include <QRegExp>
+#if QT_VERSION >= 0x050000
+#include <QRegularExpression>
+#endif
+
+struct HtmlElement {
+    QString tag;
+    QVariantMap attributes;
+    int parent;
+    int start;
+    int contentStart;
+    int contentEnd;
+};
+
+struct HtmlAttributeSelector {
+    QString name;
+    char op;
+    QString value;
+};
+
+struct HtmlSimpleSelector {
+    HtmlSimpleSelector() : combinator(' ') {}
+
+    QString tag;
+    QString id;
+    QStringList classes;
+    QList<HtmlAttributeSelector> attributes;
+    // The relation to the previous simple selector, either ' ' (descendant) or '>' (child)
+    char combinator;
+};
+
+typedef QList<HtmlSimpleSelector> HtmlSelector;
+
+static const char *VOID_ELEMENTS[] = { "area", "base", "br", "col", "embed", "hr", "img", "input", "keygen", "link",
+                                       "meta", "param", "source", "track", "wbr", 0 };
+
+static const char *RAW_TEXT_ELEMENTS[] = { "script", "style", "textarea", "title", 0 };
+
+// Elements that are implicitly closed by another of the same type
+static const char *SIBLING_ELEMENTS[] = { "dd", "dt", "li", "option", "p", "td", "th", "tr", 0 };
+
+static bool contains(const char **names, const QString &name) {
+    for (int i = 0; names[i]; i++) {
+        if (name == QLatin1String(names[i])) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static bool isNameChar(const QChar &c) {
+    return (c.isLetterOrNumber()) || (c == '-') || (c == '_') || (c == ':');
+}
+
+static int skipSpaces(const QChar *data, int size, int i) {
+    while ((i < size) && (data[i].isSpace())) {
+        ++i;
+    }
+
+    return i;
+}
+
+// Reads the start tag at i, returning the position after it, or -1 if the tag is not closed
+static int parseStartTag(const QString &html, int i, HtmlElement &element, bool &selfClosing) {
+    const QChar *data = html.constData();
+    const int size = html.size();
+    int j = i + 1;
+
+    while ((j < size) && (isNameChar(data[j]))) {
+        ++j;
+    }
+
+    element.tag = html.mid(i + 1, j - i - 1).toLower();
+    selfClosing = false;
+
+    while (j < size) {
+        const QChar c = data[j];
+
+        if (c == '>') {
+            return j + 1;
+        }
+
+        if (c == '/') {
+            selfClosing = (j + 1 < size) && (data[j + 1] == '>');
+            ++j;
+            continue;
+        }
+
+        if ((c.isSpace()) || (c == '"') || (c == '\'') || (c == '=')) {
+            ++j;
+            continue;
+        }
+
+        const int nameStart = j;
+
+        while ((j < size) && (!data[j].isSpace()) && (data[j] != '=') && (data[j] != '>') && (data[j] != '/')) {
+            ++j;
+        }
+
+        const QString name = html.mid(nameStart, j - nameStart).toLower();
+        QString value;
+        j = skipSpaces(data, size, j);
+
+        if ((j < size) && (data[j] == '=')) {
+            j = skipSpaces(data, size, j + 1);
+
+            if ((j < size) && ((data[j] == '"') || (data[j] == '\''))) {
+                const int end = html.indexOf(data[j], j + 1);
+
+                if (end == -1) {
+                    return -1;
+                }
+
+                value = Utils::decodeHtml(html.mid(j + 1, end - j - 1));
+                j = end + 1;
+            }
+            else {
+                const int valueStart = j;
+
+                while ((j < size) && (!data[j].isSpace()) && (data[j] != '>')) {
+                    ++j;
+                }
+
+                value = Utils::decodeHtml(html.mid(valueStart, j - valueStart));
+            }
+        }
+
+        // As in browsers, the first occurrence of an attribute wins
+        if (!element.attributes.contains(name)) {
+            element.attributes[name] = value;
+        }
+    }
+
+    return -1;
+}
+
+static QList<HtmlElement> parseElements(const QString &html) {
+    QList<HtmlElement> elements;
+    QList<int> open;
+    const QChar *data = html.constData();
+    const int size = html.size();
+    int i = 0;
+
+    while ((i = html.indexOf('<', i)) != -1) {
+        if (i + 1 >= size) {
+            break;
+        }
+
+        const QChar next = data[i + 1];
+
+        if (next == '!') {
+            if (html.midRef(i, 4) == QLatin1String("<!--")) {
+                const int end = html.indexOf("-->", i + 4);
+                i = (end == -1 ? size : end + 3);
+            }
+            else {
+                const int end = html.indexOf('>', i);
+                i = (end == -1 ? size : end + 1);
+            }
+
+            continue;
+        }
+
+        if (next == '/') {
+            int j = i + 2;
+
+            while ((j < size) && (isNameChar(data[j]))) {
+                ++j;
+            }
+
+            const QString tag = html.mid(i + 2, j - i - 2).toLower();
+            const int end = html.indexOf('>', j);
+
+            if (end == -1) {
+                break;
+            }
+
+            // Close the matching element, along with any unclosed elements inside it
+            for (int k = open.size() - 1; k >= 0; k--) {
+                if (elements.at(open.at(k)).tag == tag) {
+                    while (open.size() > k) {
+                        elements[open.takeLast()].contentEnd = i;
+                    }
+
+                    break;
+                }
+            }
+
+            i = end + 1;
+            continue;
+        }
+
+        if (!next.isLetter()) {
+            ++i;
+            continue;
+        }
+
+        HtmlElement element;
+        bool selfClosing;
+        const int contentStart = parseStartTag(html, i, element, selfClosing);
+
+        if (contentStart == -1) {
+            if (html.indexOf('>', i) == -1) {
+                // No tag can be closed after this point
+                break;
+            }
+
+            // A tag with an unclosed attribute quote is treated as text, so that the rest of the document is parsed
+            ++i;
+            continue;
+        }
+
+        if ((!open.isEmpty()) && (elements.at(open.last()).tag == element.tag)
+                && (contains(SIBLING_ELEMENTS, element.tag))) {
+            elements[open.takeLast()].contentEnd = i;
+        }
+
+        element.parent = (open.isEmpty() ? -1 : open.last());
+        element.start = i;
+        element.contentStart = contentStart;
+        element.contentEnd = contentStart;
+        i = contentStart;
+
+        if ((!selfClosing) && (!contains(VOID_ELEMENTS, element.tag))) {
+            if (contains(RAW_TEXT_ELEMENTS, element.tag)) {
+                // The content of these elements is not markup
+                const int end = html.indexOf("</" + element.tag, contentStart, Qt::CaseInsensitive);
+                element.contentEnd = (end == -1 ? size : end);
+                i = element.contentEnd;
+            }
+            else {
+                open << elements.size();
+            }
+        }
+
+        elements << element;
+    }
+
+    while (!open.isEmpty()) {
+        elements[open.takeLast()].contentEnd = size;
+    }
+
+    return elements;
+}
+
+static QString textContent(const QString &html) {
+    QString text;
+    text.reserve(html.size());
+    int i = 0;
+
+    while (i < html.size()) {
+        const int start = html.indexOf('<', i);
+
+        if (start == -1) {
+            text.append(html.midRef(i));
+            break;
+        }
+
+        text.append(html.midRef(i, start - i));
+        const bool comment = (html.midRef(start, 4) == QLatin1String("<!--"));
+        const int end = (comment ? html.indexOf("-->", start) : html.indexOf('>', start));
+
+        if (end == -1) {
+            break;
+        }
+
+        i = (comment ? end + 3 : end + 1);
+    }
+
+    return Utils::decodeHtml(text).simplified();
+}
+
+static QString readIdentifier(const QString &selector, int &i) {
+    const int start = i;
+
+    while ((i < selector.size()) && (isNameChar(selector.at(i))) && (selector.at(i) != ':')) {
+        ++i;
+    }
+
+    return selector.mid(start, i - start);
+}
+
+static HtmlAttributeSelector parseAttributeSelector(const QString &selector) {
+    HtmlAttributeSelector attribute;
+    attribute.op = 0;
+    int i = 0;
+    attribute.name = readIdentifier(selector, i).toLower();
+    i = skipSpaces(selector.constData(), selector.size(), i);
+
+    if (i < selector.size()) {
+        const QChar c = selector.at(i);
+
+        if (c == '=') {
+            attribute.op = '=';
+            ++i;
+        }
+        else if ((QString("~|^$*").contains(c)) && (i + 1 < selector.size()) && (selector.at(i + 1) == '=')) {
+            attribute.op = c.toLatin1();
+            i += 2;
+        }
+
+        QString value = selector.mid(i).trimmed();
+
+        if ((!value.isEmpty()) && ((value.at(0) == '"') || (value.at(0) == '\''))) {
+            const int end = value.indexOf(value.at(0), 1);
+            value = value.mid(1, end == -1 ? -1 : end - 1);
+        }
+
+        attribute.value = value;
+    }
+
+    return attribute;
+}
+
+static QList<HtmlSelector> parseSelectors(const QString &selectors) {
+    QList<HtmlSelector> groups;
+    HtmlSelector current;
+    HtmlSimpleSelector simple;
+    bool hasSimple = false;
+    char combinator = ' ';
+    int i = 0;
+
+    while (i <= selectors.size()) {
+        const QChar c = (i < selectors.size() ? selectors.at(i) : QChar(','));
+
+        if ((c.isSpace()) || (c == '>') || (c == ',')) {
+            if (hasSimple) {
+                simple.combinator = combinator;
+                current << simple;
+                simple = HtmlSimpleSelector();
+                hasSimple = false;
+                combinator = ' ';
+            }
+
+            if (c == '>') {
+                combinator = '>';
+            }
+            else if (c == ',') {
+                if (!current.isEmpty()) {
+                    groups << current;
+                    current.clear();
+                }
+
+                combinator = ' ';
+            }
+
+            ++i;
+        }
+        else if (c == '*') {
+            hasSimple = true;
+            ++i;
+        }
+        else if (c == '#') {
+            ++i;
+            simple.id = readIdentifier(selectors, i);
+            hasSimple = true;
+        }
+        else if (c == '.') {
+            ++i;
+            simple.classes << readIdentifier(selectors, i);
+            hasSimple = true;
+        }
+        else if (c == '[') {
+            int end = selectors.indexOf(']', i);
+
+            if (end == -1) {
+                end = selectors.size();
+            }
+
+            simple.attributes << parseAttributeSelector(selectors.mid(i + 1, end - i - 1));
+            hasSimple = true;
+            i = end + 1;
+        }
+        else if (c == ':') {
+            // Pseudo-classes are not supported, so they are skipped
+            ++i;
+
+            while ((i < selectors.size()) && (selectors.at(i) == ':')) {
+                ++i;
+            }
+
+            readIdentifier(selectors, i);
+
+            if ((i < selectors.size()) && (selectors.at(i) == '(')) {
+                const int end = selectors.indexOf(')', i);
+                i = (end == -1 ? selectors.size() : end + 1);
+            }
+        }
+        else if (isNameChar(c)) {
+            simple.tag = readIdentifier(selectors, i).toLower();
+            hasSimple = true;
+        }
+        else {
+            ++i;
+        }
+    }
+
+    return groups;
+}
+
+static bool matchesAttribute(const HtmlElement &element, const HtmlAttributeSelector &selector) {
+    if (!element.attributes.contains(selector.name)) {
+        return false;
+    }
+
+    const QString value = element.attributes.value(selector.name).toString();
+
+    switch (selector.op) {
+    case '=':
+        return value == selector.value;
+    case '~':
+        return value.split(QRegExp("\\s+"), QString::SkipEmptyParts).contains(selector.value);
+    case '|':
+        return (value == selector.value) || (value.startsWith(selector.value + "-"));
+    case '^':
+        return (!selector.value.isEmpty()) && (value.startsWith(selector.value));
+    case '$':
+        return (!selector.value.isEmpty()) && (value.endsWith(selector.value));
+    case '*':
+        return (!selector.value.isEmpty()) && (value.contains(selector.value));
+    default:
+        return true;
+    }
+}
+
+static bool matchesSimpleSelector(const HtmlElement &element, const HtmlSimpleSelector &selector) {
+    if ((!selector.tag.isEmpty()) && (element.tag != selector.tag)) {
+        return false;
+    }
+
+    if ((!selector.id.isEmpty()) && (element.attributes.value("id").toString() != selector.id)) {
+        return false;
+    }
+
+    if (!selector.classes.isEmpty()) {
+        const QStringList classes = element.attributes.value("class").toString().split(QRegExp("\\s+"),
+                QString::SkipEmptyParts);
+
+        foreach (const QString &c, selector.classes) {
+            if (!classes.contains(c)) {
+                return false;
+            }
+        }
+    }
+
+    foreach (const HtmlAttributeSelector &attribute, selector.attributes) {
+        if (!matchesAttribute(element, attribute)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static bool matchesSelector(const QList<HtmlElement> &elements, int index, const HtmlSelector &selector, int part) {
+    if (!matchesSimpleSelector(elements.at(index), selector.at(part))) {
+        return false;
+    }
+
+    if (part == 0) {
+        return true;
+    }
+
+    int parent = elements.at(index).parent;
+
+    if (selector.at(part).combinator == '>') {
+        return (parent != -1) && (matchesSelector(elements, parent, selector, part - 1));
+    }
+
+    while (parent != -1) {
+        if (matchesSelector(elements, parent, selector, part - 1)) {
+            return true;
+        }
+
+        parent = elements.at(parent).parent;
+    }
+
+    return false;
+}
+
+static QList<int> selectElements(const QList<HtmlElement> &elements, const QString &selector) {
+    const QList<HtmlSelector> groups = parseSelectors(selector);
+    QList<int> indexes;
+
+    for (int i = 0; i < elements.size(); i++) {
+        foreach (const HtmlSelector &group, groups) {
+            if (matchesSelector(elements, i, group, group.size() - 1)) {
+                indexes << i;
+                break;
+            }
+        }
+    }
+
+    return indexes;
+}
+
+#if QT_VERSION < 0x050000
+// QRegExp does not support named groups, so they are removed from the pattern and their names are recorded by
+// group number
+static QString removeGroupNames(const QString &pattern, QStringList &names) {
+    QString result;
+    result.reserve(pattern.size());
+    names << QString();
+    int i = 0;
+
+    while (i < pattern.size()) {
+        const QChar c = pattern.at(i);
+
+        if (c == '\\') {
+            result.append(pattern.midRef(i, 2));
+            i += 2;
+        }
+        else if (c == '[') {
+            // Parentheses in a character class are not groups
+            int end = i + 1;
+
+            if ((end < pattern.size()) && (pattern.at(end) == '^')) {
+                ++end;
+            }
+
+            if ((end < pattern.size()) && (pattern.at(end) == ']')) {
+                ++end;
+            }
+
+            while ((end < pattern.size()) && (pattern.at(end) != ']')) {
+                end += (pattern.at(end) == '\\' ? 2 : 1);
+            }
+
+            result.append(pattern.midRef(i, end - i + 1));
+            i = end + 1;
+        }
+        else if ((c == '(') && (pattern.midRef(i + 1, 2) == QLatin1String("?<"))
+                 && (i + 3 < pattern.size()) && (pattern.at(i + 3) != '=') && (pattern.at(i + 3) != '!')
+                 && (pattern.indexOf('>', i + 3) != -1)) {
+            const int end = pattern.indexOf('>', i + 3);
+            names << pattern.mid(i + 3, end - i - 3);
+            result.append('(');
+            i = end + 1;
+        }
+        else if ((c == '(') && (pattern.midRef(i + 1, 3) == QLatin1String("?P<"))
+                 && (pattern.indexOf('>', i + 4) != -1)) {
+            const int end = pattern.indexOf('>', i + 4);
+            names << pattern.mid(i + 4, end - i - 4);
+            result.append('(');
+            i = end + 1;
+        }
+        else {
+            if ((c == '(') && ((i + 1 >= pattern.size()) || (pattern.at(i + 1) != '?'))) {
+                names << QString();
+            }
+
+            result.append(c);
+            ++i;
+        }
+    }
+
+    return result;
+}
+#endif
+
+HtmlParser::HtmlParser(QObject *parent) :
+    QObject(parent)
+{
+}
+
+QVariantList HtmlParser::findAll(const QString &text, const QString &pattern, const QString &flags) {
+    return match(text, pattern, flags, -1);
+}
+
+QVariantMap HtmlParser::find(const QString &text, const QString &pattern, const QString &flags) {
+    const QVariantList matches = match(text, pattern, flags, 1);
+    return matches.isEmpty() ? QVariantMap() : matches.first().toMap();
+}
+
+QVariantList HtmlParser::match(const QString &text, const QString &pattern, const QString &flags, int maximum) {
+    QVariantList matches;
+#if QT_VERSION >= 0x050000
+    QRegularExpression::PatternOptions options = QRegularExpression::NoPatternOption;
+
+    if (flags.contains('i')) {
+        options |= QRegularExpression::CaseInsensitiveOption;
+    }
+
+    if (flags.contains('m')) {
+        options |= QRegularExpression::MultilineOption;
+    }
+
+    if (flags.contains('s')) {
+        options |= QRegularExpression::DotMatchesEverythingOption;
+    }
+
+    const QRegularExpression re(pattern, options);
+
+    if (!re.isValid()) {
+        Logger::log("HtmlParser::match(): Invalid pattern: " + re.errorString());
+        return matches;
+    }
+
+    const QStringList names = re.namedCaptureGroups();
+    QRegularExpressionMatchIterator iterator = re.globalMatch(text);
+
+    while ((iterator.hasNext()) && (matches.size() != maximum)) {
+        const QRegularExpressionMatch regExpMatch = iterator.next();
+        QVariantMap result;
+
+        for (int i = 0; i <= re.captureCount(); i++) {
+            result[QString::number(i)] = regExpMatch.captured(i);
+
+            if ((i < names.size()) && (!names.at(i).isEmpty())) {
+                result[names.at(i)] = regExpMatch.captured(i);
+            }
+        }
+
+        matches << result;
+    }
+#else
+    // QRegExp has no multiline mode, and its dot always matches newlines
+    QStringList names;
+    QRegExp re(removeGroupNames(pattern, names), flags.contains('i') ? Qt::CaseInsensitive : Qt::CaseSensitive,
+               QRegExp::RegExp2);
+
+    if (!re.isValid()) {
+        Logger::log("HtmlParser::match(): Invalid pattern: " + re.errorString());
+        return matches;
+    }
+
+    int pos = 0;
+
+    while ((matches.size() != maximum) && ((pos = re.indexIn(text, pos)) != -1)) {
+        QVariantMap result;
+
+        for (int i = 0; i <= re.captureCount(); i++) {
+            result[QString::number(i)] = re.cap(i);
+
+            if ((i < names.size()) && (!names.at(i).isEmpty())) {
+                result[names.at(i)] = re.cap(i);
+            }
+        }
+
+        matches << result;
+        pos += qMax(1, re.matchedLength());
+    }
+#endif
+    return matches;
+}
+
+QVariantList HtmlParser::forms(const QString &html) {
+    const QList<HtmlElement> elements = parseElements(html);
+    QVariantList forms;
+
+    for (int i = 0; i < elements.size(); i++) {
+        const HtmlElement &form = elements.at(i);
+
+        if (form.tag != "form") {
+            continue;
+        }
+
+        QVariantMap inputs;
+        QVariantMap hidden;
+
+        for (int j = i + 1; (j < elements.size()) && (elements.at(j).start < form.contentEnd); j++) {
+            const HtmlElement &element = elements.at(j);
+            const QString name = element.attributes.value("name").toString();
+
+            if (name.isEmpty()) {
+                continue;
+            }
+
+            if (element.tag == "input") {
+                const QString type = element.attributes.value("type").toString().toLower();
+
+                if (((type == "checkbox") || (type == "radio")) && (!element.attributes.contains("checked"))) {
+                    continue;
+                }
+
+                if ((type == "button") || (type == "image") || (type == "reset") || (type == "submit")) {
+                    continue;
+                }
+
+                const QVariant value = element.attributes.value("value", QString());
+                inputs[name] = value;
+
+                if (type == "hidden") {
+                    hidden[name] = value;
+                }
+            }
+            else if (element.tag == "textarea") {
+                inputs[name] = Utils::decodeHtml(html.mid(element.contentStart,
+                            element.contentEnd - element.contentStart));
+            }
+            else if (element.tag == "select") {
+                // Use the selected option, or the first if none is selected
+                QVariant value;
+
+                for (int k = j + 1; (k < elements.size()) && (elements.at(k).start < element.contentEnd); k++) {
+                    const HtmlElement &option = elements.at(k);
+
+                    if (option.tag != "option") {
+                        continue;
+                    }
+
+                    if ((!value.isValid()) || (option.attributes.contains("selected"))) {
+                        value = option.attributes.contains("value") ? option.attributes.value("value")
+                            : textContent(html.mid(option.contentStart, option.contentEnd - option.contentStart));
+
+                        if (option.attributes.contains("selected")) {
+                            break;
+                        }
+                    }
+                }
+
+                inputs[name] = value.isValid() ? value : QString();
+            }
+        }
+
+        QVariantMap result;
+        result["action"] = form.attributes.value("action", QString());
+        result["method"] = form.attributes.value("method", QString("get")).toString().toLower();
+        result["id"] = form.attributes.value("id", QString());
+        result["name"] = form.attributes.value("name", QString());
+        result["inputs"] = inputs;
+        result["hidden"] = hidden;
+        forms << result;
+    }
+
+    return forms;
+}
+
+QVariantList HtmlParser::select(const QString &html, const QString &selector) {
+    const QList<HtmlElement> elements = parseElements(html);
+    QVariantList results;
+
+    foreach (int i, selectElements(elements, selector)) {
+        const HtmlElement &element = elements.at(i);
+        const QString inner = html.mid(element.contentStart, element.contentEnd - element.contentStart);
+        QVariantMap result;
+        result["tag"] = element.tag;
+        result["attributes"] = element.attributes;
+        result["html"] = inner;
+        result["text"] = textContent(inner);
+        results << result;
+    }
+
+    return results;
+}
+
+QStringList HtmlParser::attribute(const QString &html, const QString &selector, const QString &attribute) {
+    const QList<HtmlElement> elements = parseElements(html);
+    const QString name = attribute.toLower();
+    QStringList values;
+
+    foreach (int i, selectElements(elements, selector)) {
+        const HtmlElement &element = elements.at(i);
+
+        if (element.attributes.contains(name)) {
+            values << element.attributes.value(name).toString();
+        }
+    }
+
+    return values;
+}
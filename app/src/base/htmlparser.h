@@ -0,0 +1,77 @@
+/*
+ * Copyright (C) 2017 Stuart Howarth <showarth@marxoft.co.uk>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef HTMLPARSER_H
+#define HTMLPARSER_H
+
+#include <QObject>
+#include <QStringList>
+#include <QVariantList>
+
+/**
+ * Native text and HTML extraction functions for plugins, available to scripts as the HtmlParser object.
+ *
+ * The HTML functions work on a flat list of elements built in a single pass over the markup. Unclosed and
+ * stray tags are tolerated, so they can be used on real world pages.
+ */
+class HtmlParser : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit HtmlParser(QObject *parent = 0);
+
+public Q_SLOTS:
+    /**
+     * Returns every match of pattern in text. Each match is an object containing the captured text by group
+     * number (0 being the whole match) and by group name, for groups declared with (?<name>...).
+     *
+     * flags may contain "i" (case insensitive), "m" (multiline) and "s" (dot matches newlines).
+     */
+    static QVariantList findAll(const QString &text, const QString &pattern, const QString &flags = QString());
+
+    /**
+     * Returns the first match of pattern in text, in the same form as findAll(), or an empty object if there is
+     * no match.
+     */
+    static QVariantMap find(const QString &text, const QString &pattern, const QString &flags = QString());
+
+    /**
+     * Returns the forms in html. Each form is an object with the action, method, id and name attributes,
+     * an inputs object containing the values of the named inputs, textareas and selects, and a hidden
+     * object containing only the hidden inputs.
+     */
+    static QVariantList forms(const QString &html);
+
+    /**
+     * Returns the elements in html that match a CSS selector. Type, #id, .class, attribute ([name],
+     * [name=value], ~=, |=, ^=, $= and *=), descendant and child selectors are supported, and selectors may be
+     * grouped with commas. Pseudo-classes are ignored.
+     *
+     * Each element is an object containing the tag name, the attributes, the inner html and the decoded text.
+     */
+    static QVariantList select(const QString &html, const QString &selector);
+
+    /**
+     * Returns the value of attribute for each element in html that matches selector and has the attribute.
+     */
+    static QStringList attribute(const QString &html, const QString &selector, const QString &attribute);
+
+private:
+    static QVariantList match(const QString &text, const QString &pattern, const QString &flags, int maximum);
+};
+
+#endif // HTMLPARSER_H
@@ -14,15 +14,240 @@
  * along with this program; if not, write to the Free Software Foundation,
  * Inc., 51 Franklin St - Fifth Floor, Boston, MA 02110-1301 USA.
  */
-
 #include "logger.h"
+#include "logreader.h"
+#include <QAtomicInt>
+#include <QCoreApplication>
 #include <QDateTime>
 #include <QFile>
-#include <QTextStream>
+#include <QMutex>
+#include <QThread>
+#include <QWaitCondition>
 #include <iostream>
 
+// Number of messages that can wait to be written. Must be a power of two.
+static const int QUEUE_SIZE = 4096;
+// How often the writer thread writes queued messages
+static const int WRITE_INTERVAL = 250;
+static const qint64 DEFAULT_MAXIMUM_FILE_SIZE = 5 * 1024 * 1024;
+
+struct LogEntry
+{
+    qint64 time;
+    QString message;
+    QString transferId;
+    QString pluginId;
+};
+
+// Positions wrap around, so they are compared by their distance
+static inline int distance(int a, int b) {
+    return int(uint(a) - uint(b));
+}
+
+// A bounded queue that any number of threads can add to without blocking. Each producer claims a slot by
+// advancing the enqueue position with a compare-and-swap, and publishes the entry by advancing the slot's
+// sequence number. Entries are taken by one thread at a time, under the write mutex.
+class LogQueue
+{
+
+public:
+    LogQueue() :
+        m_enqueuePos(0),
+        m_dequeuePos(0)
+    {
+        for (int i = 0; i < QUEUE_SIZE; i++) {
+            m_slots[i].sequence.fetchAndStoreRelease(i);
+        }
+    }
+
+    // Returns the position of the entry, or -1 if the queue is full
+    int enqueue(const LogEntry &entry) {
+        int pos = m_enqueuePos.fetchAndAddAcquire(0);
+        Slot *slot;
+
+        while (true) {
+            slot = &m_slots[pos & (QUEUE_SIZE - 1)];
+            const int diff = distance(slot->sequence.fetchAndAddAcquire(0), pos);
+
+            if (diff == 0) {
+                if (m_enqueuePos.testAndSetOrdered(pos, int(uint(pos) + 1))) {
+                    break;
+                }
+
+                pos = m_enqueuePos.fetchAndAddAcquire(0);
+            }
+            else if (diff < 0) {
+                return -1;
+            }
+            else {
+                pos = m_enqueuePos.fetchAndAddAcquire(0);
+            }
+        }
+
+        slot->entry = entry;
+        slot->sequence.fetchAndStoreRelease(int(uint(pos) + 1));
+        return pos;
+    }
+
+    bool dequeue(LogEntry &entry) {
+        Slot *slot = &m_slots[m_dequeuePos & (QUEUE_SIZE - 1)];
+
+        if (distance(slot->sequence.fetchAndAddAcquire(0), int(uint(m_dequeuePos) + 1)) < 0) {
+            return false;
+        }
+
+        entry = slot->entry;
+        slot->entry = LogEntry();
+        slot->sequence.fetchAndStoreRelease(int(uint(m_dequeuePos) + QUEUE_SIZE));
+        m_dequeuePos = int(uint(m_dequeuePos) + 1);
+        return true;
+    }
+
+private:
+    struct Slot
+    {
+        QAtomicInt sequence;
+        LogEntry entry;
+    };
+
+    Slot m_slots[QUEUE_SIZE];
+    QAtomicInt m_enqueuePos;
+    int m_dequeuePos;
+};
+
+class LogWriter : public QThread
+{
+
+public:
+    LogWriter() :
+        QThread(),
+        m_stopping(false)
+    {
+    }
+
+    void wake() {
+        m_condition.wakeOne();
+    }
+
+    void stop() {
+        QMutexLocker locker(&m_mutex);
+        m_stopping = true;
+        m_condition.wakeOne();
+    }
+
+protected:
+    virtual void run() {
+        QMutexLocker locker(&m_mutex);
+
+        while (!m_stopping) {
+            locker.unlock();
+            Logger::flush();
+            locker.relock();
+
+            if (!m_stopping) {
+                m_condition.wait(&m_mutex, WRITE_INTERVAL);
+            }
+        }
+    }
+
+private:
+    QMutex m_mutex;
+    QWaitCondition m_condition;
+    bool m_stopping;
+};
+
+Q_GLOBAL_STATIC(LogQueue, logQueue)
+Q_GLOBAL_STATIC(QMutex, writeMutex)
+// Guards the writer pointer, which producers in any thread use to wake the writer
+Q_GLOBAL_STATIC(QMutex, writerMutex)
+
+// Only accessed while holding the write mutex
+static QFile logFile;
+
+static QAtomicInt dropped(0);
+
+enum WriterState {
+    WriterNotStarted = 0,
+    WriterRunning,
+    WriterStopped
+};
+
+static QAtomicInt writerState(WriterNotStarted);
+static LogWriter *writer = 0;
+
+static void stopWriter() {
+    writerState.fetchAndStoreOrdered(WriterStopped);
+    LogWriter *stopped;
+
+    {
+        // Once the pointer is cleared, no producer can reach the writer, so it can be deleted without
+        // holding the mutex, while its thread may still be logging
+        QMutexLocker locker(writerMutex());
+        stopped = writer;
+        writer = 0;
+    }
+
+    if (stopped) {
+        stopped->stop();
+        stopped->wait();
+        delete stopped;
+    }
+
+    Logger::flush();
+}
+
+// Returns false if there is no writer thread, in which case messages must be written by the caller
+static bool startWriter() {
+    const int state = writerState.fetchAndAddAcquire(0);
+
+    if (state == WriterRunning) {
+        return true;
+    }
+
+    if ((state == WriterNotStarted) && (QCoreApplication::instance())
+        && (writerState.testAndSetOrdered(WriterNotStarted, WriterRunning))) {
+        QMutexLocker locker(writerMutex());
+        writer = new LogWriter;
+        writer->start(QThread::LowPriority);
+        qAddPostRoutine(stopWriter);
+        return true;
+    }
+
+    return false;
+}
+
+static QByteArray formatEntry(const LogEntry &entry) {
+    QString output = QString("%1: %2").arg(QDateTime::fromMSecsSinceEpoch(entry.time).toString(Qt::ISODate))
+                                      .arg(entry.message);
+
+    if (!entry.transferId.isEmpty()) {
+        output.append(" transferId=" + entry.transferId);
+    }
+
+    if (!entry.pluginId.isEmpty()) {
+        output.append(" pluginId=" + entry.pluginId);
+    }
+
+    output.append("\n");
+    return output.toUtf8();
+}
+
+static bool openLogFile() {
+    logFile.setFileName(Logger::fileName());
+    return logFile.open(QFile::Append | QFile::Text);
+}
+
+static void writeError(const QByteArray &output) {
+    const QString date = QDateTime::currentDateTime().toString(Qt::ISODate);
+    std::cout << Logger::tr("%1: Cannot write to log file '%2'. Error: %3\n").arg(date).arg(Logger::fileName())
+                                                                           .arg(logFile.errorString())
+                                                                           .toUtf8().constData()
+              << output.constData() << std::flush;
+}
+
 QString Logger::fn;
 int Logger::vb = 0;
+qint64 Logger::maxSize = DEFAULT_MAXIMUM_FILE_SIZE;
 
 Logger::Logger(QObject *parent) :
     QObject(parent)
@@ -34,28 +259,15 @@ QString Logger::fileName() {
 }
 
 void Logger::setFileName(const QString &f) {
+    flush();
+    QMutexLocker locker(writeMutex());
     fn = f;
+    logFile.close();
 }
 
 QString Logger::text() {
-    QString output;
-    
-    if (!fn.isEmpty()) {
-        QFile file(fn);
-        
-        if (file.open(QFile::ReadOnly | QFile::Text)) {
-            QTextStream stream(&file);
-
-            while (!stream.atEnd()) {
-                output.append(stream.readLine());
-                output.append("\n");
-            }
-
-            file.close();
-        }
-    }
-    
-    return output;
+    const QStringList lines = LogReader().tail(LogReader::MAXIMUM_LINES).lines;
+    return lines.isEmpty() ? QString() : lines.join("\n").append("\n");
 }
 
 int Logger::verbosity() {
@@ -66,30 +278,109 @@ void Logger::setVerbosity(int v) {
     vb = v;
 }
 
+qint64 Logger::maximumFileSize() {
+    return maxSize;
+}
+
+void Logger::setMaximumFileSize(qint64 bytes) {
+    maxSize = bytes;
+}
+
 void Logger::clear() {
+    QMutexLocker locker(writeMutex());
+    logFile.close();
+
     if (!fn.isEmpty()) {
         QFile::remove(fn);
     }
 }
 
+void Logger::flush() {
+    QMutexLocker locker(writeMutex());
+    QByteArray output;
+    LogEntry entry;
+
+    while (logQueue()->dequeue(entry)) {
+        output.append(formatEntry(entry));
+    }
+
+    const int missed = dropped.fetchAndStoreOrdered(0);
+
+    if (missed > 0) {
+        entry.time = QDateTime::currentMSecsSinceEpoch();
+        entry.message = QString("Logger: %1 messages were dropped").arg(missed);
+        entry.transferId.clear();
+        entry.pluginId.clear();
+        output.append(formatEntry(entry));
+    }
+
+    if (output.isEmpty()) {
+        return;
+    }
+
+    if (fn.isEmpty()) {
+        std::cout << output.constData() << std::flush;
+        return;
+    }
+
+    if ((!logFile.isOpen()) && (!openLogFile())) {
+        writeError(output);
+        return;
+    }
+
+    if ((maxSize > 0) && (logFile.size() > 0) && (logFile.size() + output.size() > maxSize)) {
+        // Keep one previous file
+        logFile.close();
+        QFile::remove(fn + ".1");
+        QFile::rename(fn, fn + ".1");
+
+        if (!openLogFile()) {
+            writeError(output);
+            return;
+        }
+    }
+
+    logFile.write(output);
+    logFile.flush();
+}
+
 void Logger::log(const QString &message, int minimumVerbosity) {
-    if (minimumVerbosity <= vb) {
-        const QString date = QDateTime::currentDateTime().toString(Qt::ISODate);
-        QString output = QString("%1: %2\n").arg(date).arg(message);
-        
-        if (!fn.isEmpty()) {
-            QFile file(fn);
-            
-            if (file.open(QFile::Append | QFile::Text)) {
-                QTextStream stream(&file);
-                stream << output;
-                file.close();
-                return;
-            }
-            
-            output = tr("%1: Cannot write to log file '%2'. Error: %3").arg(date).arg(fn).arg(file.errorString());
+    log(message, minimumVerbosity, QString(), QString());
+}
+
+void Logger::log(const QString &message, int minimumVerbosity, const QString &transferId,
+                 const QString &pluginId) {
+    if (!isEnabled(minimumVerbosity)) {
+        return;
+    }
+
+    LogEntry entry;
+    entry.time = QDateTime::currentMSecsSinceEpoch();
+    entry.message = message;
+    entry.transferId = transferId;
+    entry.pluginId = pluginId;
+    int pos = logQueue()->enqueue(entry);
+
+    if (pos < 0) {
+        // The queue is full, so write the queued messages here and try again
+        flush();
+        pos = logQueue()->enqueue(entry);
+
+        if (pos < 0) {
+            dropped.ref();
+            return;
+        }
+    }
+
+    if (!startWriter()) {
+        flush();
+    }
+    else if ((pos & (QUEUE_SIZE / 2 - 1)) == 0) {
+        // Don't let the queue fill up before the next interval
+        QMutexLocker locker(writerMutex());
+
+        if (writer) {
+            writer->wake();
         }
-        
-        std::cout << output.toUtf8().constData();
     }
 }
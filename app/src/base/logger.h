@@ -20,6 +20,24 @@
 
 #include <QObject>
 
+/**
+ * Logs message if verbosity is enabled. Unlike calling Logger::log() directly, the message expression is
+ * only evaluated when it will be logged, so it may be expensive to build.
+ */
+#define QDL_LOG(verbosity, message) \
+    do { if (Logger::isEnabled(verbosity)) Logger::log((message), (verbosity)); } while (0)
+
+/**
+ * As QDL_LOG, but records the id of the transfer and the plugin that the message concerns.
+ */
+#define QDL_LOG_TRANSFER(verbosity, transferId, pluginId, message) \
+    do { if (Logger::isEnabled(verbosity)) Logger::log((message), (verbosity), (transferId), (pluginId)); } while (0)
+
+/**
+ * Messages are added to a lock-free queue and written to the log file by a background thread, so logging
+ * never waits for the disk. Once the file reaches maximumFileSize(), it is renamed with a ".1" suffix and
+ * a new file is started.
+ */
 class Logger : public QObject
 {
     Q_OBJECT
@@ -44,10 +62,21 @@ public:
 
     static QString fileName();
     
+    /**
+     * Returns the most recent LogReader::MAXIMUM_LINES lines. Use LogReader to page through the whole log.
+     */
     static QString text();
     
     static int verbosity();
 
+    static inline bool isEnabled(int minimumVerbosity) { return minimumVerbosity <= vb; }
+
+    static qint64 maximumFileSize();
+    static void setMaximumFileSize(qint64 bytes);
+
+    static void log(const QString &message, int minimumVerbosity, const QString &transferId,
+                    const QString &pluginId = QString());
+
 public Q_SLOTS:
     static void setFileName(const QString &f);
 
@@ -55,11 +84,17 @@ public Q_SLOTS:
 
     static void clear();
 
+    /**
+     * Writes any queued messages to the log file before returning.
+     */
+    static void flush();
+
     static void log(const QString &message, int minimumVerbosity = LowestVerbosity);
 
 private:
     static QString fn;
     static int vb;
+    static qint64 maxSize;
 };
 
 #endif // LOGGER_H
@@ -0,0 +1,355 @@
+/*
+ * Copyright (C) 2016 Stuart Howarth <showarth@marxoft.co.uk>
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 3, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin St - Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+#include "logreader.h"
+#include "logger.h"
+#include <QFile>
+#include <QFileInfo>
+#include <cstring>
+
+// Lines are read in blocks of this size
+static const int BLOCK_SIZE = 65536;
+// The offset of every INDEX_INTERVAL'th line is stored in the index
+static const int INDEX_INTERVAL = 1000;
+// Used to detect that the file has been replaced since it was indexed
+static const int HEAD_SIZE = 64;
+// Log lines begin with an ISO 8601 timestamp, e.g. 2017-01-01T12:00:00
+static const int TIMESTAMP_LENGTH = 19;
+
+const int LogReader::MAXIMUM_LINES = 5000;
+
+static QString decodeLine(const char *data, int size) {
+    if ((size > 0) && (data[size - 1] == '\r')) {
+        --size;
+    }
+
+    return QString::fromUtf8(data, size);
+}
+
+// Returns the offset after count further line breaks, or -1 if the end of the file is reached first
+static qint64 skipLines(QFile &file, qint64 offset, int count) {
+    if (count <= 0) {
+        return offset;
+    }
+
+    if (!file.seek(offset)) {
+        return -1;
+    }
+
+    while (true) {
+        const QByteArray block = file.read(BLOCK_SIZE);
+
+        if (block.isEmpty()) {
+            return -1;
+        }
+
+        const char *data = block.constData();
+        const char *end = data + block.size();
+
+        while (const char *lineBreak = static_cast<const char*>(memchr(data, '\n', end - data))) {
+            data = lineBreak + 1;
+
+            if (--count == 0) {
+                return offset + (data - block.constData());
+            }
+        }
+
+        offset += block.size();
+    }
+}
+
+// Returns the offset of the first line that begins at or after offset
+static qint64 lineStart(QFile &file, qint64 offset) {
+    if (offset <= 0) {
+        return 0;
+    }
+
+    const qint64 start = skipLines(file, offset - 1, 1);
+    return start < 0 ? file.size() : start;
+}
+
+static QDateTime lineTime(QFile &file, qint64 offset) {
+    if (!file.seek(offset)) {
+        return QDateTime();
+    }
+
+    return QDateTime::fromString(QString::fromLatin1(file.read(TIMESTAMP_LENGTH)), Qt::ISODate);
+}
+
+LogReader::LogReader(const QString &fileName) :
+    m_fileName(fileName),
+    m_indexedSize(0),
+    m_lineCount(0)
+{
+    m_index << 0;
+}
+
+QString LogReader::fileName() const {
+    return m_fileName;
+}
+
+void LogReader::setFileName(const QString &fileName) {
+    m_fileName = fileName;
+    m_index.clear();
+    m_index << 0;
+    m_indexedSize = 0;
+    m_lineCount = 0;
+    m_head.clear();
+}
+
+qint64 LogReader::size() const {
+    return QFileInfo(currentFileName()).size();
+}
+
+int LogReader::lineCount() {
+    updateIndex();
+    return m_lineCount;
+}
+
+LogReader::Page LogReader::lines(int first, int count) {
+    updateIndex();
+    first = qBound(0, first, m_lineCount);
+    const int block = first / INDEX_INTERVAL;
+    QFile file(currentFileName());
+    
+    if ((block >= m_index.size()) || (!file.open(QFile::ReadOnly))) {
+        return Page();
+    }
+
+    const qint64 offset = skipLines(file, m_index.at(block), first % INDEX_INTERVAL);
+    file.close();
+    return offset < 0 ? Page() : read(offset, count);
+}
+
+LogReader::Page LogReader::tail(int count) {
+    return before(size(), count);
+}
+
+LogReader::Page LogReader::before(qint64 offset, int count) {
+    Page page;
+    QFile file(currentFileName());
+
+    if (!file.open(QFile::ReadOnly)) {
+        return page;
+    }
+
+    count = qBound(0, count, MAXIMUM_LINES);
+    qint64 pos = qBound<qint64>(0, offset, file.size());
+    QByteArray data;
+    int lineBreaks = 0;
+
+    // Read backwards until there is a line break before the first of the requested lines
+    while ((pos > 0) && (lineBreaks <= count)) {
+        const qint64 blockSize = qMin<qint64>(BLOCK_SIZE, pos);
+        pos -= blockSize;
+
+        if (!file.seek(pos)) {
+            return page;
+        }
+
+        const QByteArray block = file.read(blockSize);
+        lineBreaks += block.count('\n');
+        data.prepend(block);
+    }
+
+    // Exclude a partial line that is still being written
+    const int end = data.lastIndexOf('\n') + 1;
+    page.nextOffset = pos + end;
+    page.offset = page.nextOffset;
+
+    QStringList lines;
+    int lineEnd = end - 1;
+
+    while ((lines.size() < count) && (lineEnd >= 0)) {
+        const int previous = lineEnd > 0 ? data.lastIndexOf('\n', lineEnd - 1) : -1;
+
+        if ((previous < 0) && (pos > 0)) {
+            break;
+        }
+
+        lines << decodeLine(data.constData() + previous + 1, lineEnd - previous - 1);
+        page.offset = pos + previous + 1;
+        lineEnd = previous;
+    }
+
+    for (int i = lines.size() - 1; i >= 0; i--) {
+        page.lines << lines.at(i);
+    }
+
+    return page;
+}
+
+LogReader::Page LogReader::read(qint64 offset, int count) {
+    Page page;
+    QFile file(currentFileName());
+
+    if (!file.open(QFile::ReadOnly)) {
+        return page;
+    }
+
+    if ((offset < 0) || (offset > file.size())) {
+        offset = 0;
+    }
+    else {
+        // The offset may be within a line if the file has been rotated and has since grown past it
+        offset = lineStart(file, offset);
+    }
+
+    page.offset = offset;
+    page.nextOffset = offset;
+    count = qBound(0, count, MAXIMUM_LINES);
+
+    if ((count == 0) || (!file.seek(offset))) {
+        return page;
+    }
+
+    QByteArray pending;
+
+    while (page.lines.size() < count) {
+        const QByteArray block = file.read(BLOCK_SIZE);
+
+        if (block.isEmpty()) {
+            break;
+        }
+
+        pending.append(block);
+        const char *data = pending.constData();
+        const char *start = data;
+        const char *end = data + pending.size();
+
+        while (page.lines.size() < count) {
+            const char *lineBreak = static_cast<const char*>(memchr(start, '\n', end - start));
+
+            if (!lineBreak) {
+                break;
+            }
+
+            page.lines << decodeLine(start, lineBreak - start);
+            start = lineBreak + 1;
+        }
+
+        page.nextOffset += start - data;
+        pending.remove(0, start - data);
+    }
+
+    return page;
+}
+
+qint64 LogReader::offsetForTime(const QDateTime &time) {
+    QFile file(currentFileName());
+
+    if (!file.open(QFile::ReadOnly)) {
+        return 0;
+    }
+
+    const qint64 size = file.size();
+    qint64 lower = 0;
+    qint64 upper = size;
+
+    // Lines are logged in time order, so a binary search over line starts narrows the range down to
+    // one block, which is then scanned
+    while (upper - lower > BLOCK_SIZE) {
+        const qint64 start = lineStart(file, lower + (upper - lower) / 2);
+
+        if (start >= upper) {
+            break;
+        }
+
+        const QDateTime t = lineTime(file, start);
+
+        if ((t.isValid()) && (t < time)) {
+            lower = start;
+        }
+        else {
+            upper = start;
+        }
+    }
+
+    qint64 start = lower;
+
+    while (start < upper) {
+        const QDateTime t = lineTime(file, start);
+
+        if ((t.isValid()) && (t >= time)) {
+            return start;
+        }
+
+        start = skipLines(file, start, 1);
+
+        if (start < 0) {
+            break;
+        }
+    }
+
+    return upper;
+}
+
+QString LogReader::currentFileName() const {
+    if (m_fileName.isEmpty()) {
+        Logger::flush();
+        return Logger::fileName();
+    }
+
+    return m_fileName;
+}
+
+void LogReader::updateIndex() {
+    QFile file(currentFileName());
+
+    if (!file.open(QFile::ReadOnly)) {
+        setFileName(m_fileName);
+        return;
+    }
+
+    const qint64 size = file.size();
+
+    if ((size < m_indexedSize) || (!file.peek(HEAD_SIZE).startsWith(m_head))) {
+        // The file has been cleared or rotated
+        setFileName(m_fileName);
+    }
+
+    if (m_head.size() < HEAD_SIZE) {
+        m_head = file.peek(HEAD_SIZE);
+    }
+
+    if ((size == m_indexedSize) || (!file.seek(m_indexedSize))) {
+        return;
+    }
+
+    qint64 pos = m_indexedSize;
+
+    while (true) {
+        const QByteArray block = file.read(BLOCK_SIZE);
+
+        if (block.isEmpty()) {
+            break;
+        }
+
+        const char *data = block.constData();
+        const char *end = data + block.size();
+
+        while (const char *lineBreak = static_cast<const char*>(memchr(data, '\n', end - data))) {
+            data = lineBreak + 1;
+            m_indexedSize = pos + (data - block.constData());
+
+            if (++m_lineCount % INDEX_INTERVAL == 0) {
+                m_index << m_indexedSize;
+            }
+        }
+
+        pos += block.size();
+    }
+}
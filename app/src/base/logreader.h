@@ -0,0 +1,105 @@
+/*
+ * Copyright (C) 2016 Stuart Howarth <showarth@marxoft.co.uk>
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 3, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin St - Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+#ifndef LOGREADER_H
+#define LOGREADER_H
+
+#include <QDateTime>
+#include <QList>
+#include <QStringList>
+
+/**
+ * Reads pages of lines from a log file without loading the whole file.
+ *
+ * All reads are done in bounded blocks, so the memory used depends only on the number of lines requested.
+ * A sparse index of line offsets is built as the file grows, so that lines can be fetched by number.
+ * The index is discarded if the file is found to have been cleared or rotated.
+ *
+ * If no file name is set, the current Logger file is read, and any queued messages are written to it
+ * first.
+ */
+class LogReader
+{
+
+public:
+    struct Page {
+        Page() : offset(0), nextOffset(0) {}
+
+        QStringList lines;
+        /**
+         * The byte offset of the first line.
+         */
+        qint64 offset;
+        /**
+         * The byte offset after the last complete line. Passing this to read() returns only the lines
+         * that have been written since, which allows a log to be followed.
+         */
+        qint64 nextOffset;
+    };
+
+    explicit LogReader(const QString &fileName = QString());
+
+    QString fileName() const;
+    void setFileName(const QString &fileName);
+
+    qint64 size() const;
+
+    int lineCount();
+
+    /**
+     * Returns up to count complete lines, starting with line number first.
+     */
+    Page lines(int first, int count);
+
+    /**
+     * Returns the last count complete lines.
+     */
+    Page tail(int count);
+
+    /**
+     * Returns up to count complete lines that end before byte offset. Only the lines read are scanned,
+     * so earlier pages can be fetched without indexing the file.
+     */
+    Page before(qint64 offset, int count);
+
+    /**
+     * Returns up to count complete lines, starting at the line that begins at byte offset. If offset is
+     * beyond the end of the file, the file has been replaced, and the lines are read from the beginning.
+     * An offset within a line is moved to the start of the next line.
+     */
+    Page read(qint64 offset, int count);
+
+    /**
+     * Returns the byte offset of the first line logged at or after time, or size() if there is none.
+     */
+    qint64 offsetForTime(const QDateTime &time);
+
+    static const int MAXIMUM_LINES;
+
+private:
+    QString currentFileName() const;
+
+    void updateIndex();
+
+    QString m_fileName;
+
+    QList<qint64> m_index;
+    qint64 m_indexedSize;
+    int m_lineCount;
+    QByteArray m_head;
+};
+
+#endif // LOGREADER_H
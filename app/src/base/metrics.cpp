@@ -0,0 +1,168 @@
+/*
+ * Copyright (C) 2016 Stuart Howarth <showarth@marxoft.co.uk>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "metrics.h"
+#include "logger.h"
+#include <QMutexLocker>
+
+static QString formatNumber(double value) {
+    return QString::number(value, 'g', 15);
+}
+
+static QString seriesName(const QString &name, const QString &labels) {
+    return labels.isEmpty() ? name : QString("%1{%2}").arg(name).arg(labels);
+}
+
+Metrics* Metrics::self = 0;
+
+Metrics::Metrics() {
+    const QList<double> requestBuckets = QList<double>() << 0.005 << 0.01 << 0.025 << 0.05 << 0.1 << 0.25 << 0.5
+                                                         << 1 << 2.5 << 5 << 10;
+    add("qdl_downloaded_bytes_total", Counter, "Bytes downloaded, by plugin, host and category.");
+    add("qdl_transfers_active", Gauge, "Transfers that are active, excluding those queued.");
+    add("qdl_transfers_queued", Gauge, "Transfers waiting in the queue.");
+    add("qdl_transfers_failed", Gauge, "Transfers that have failed.");
+    add("qdl_captcha_requests_total", Counter, "Captcha challenges presented, by plugin.");
+    add("qdl_captcha_solve_seconds", Histogram, "Time from a captcha challenge to its response, by plugin.",
+        QList<double>() << 1 << 5 << 10 << 30 << 60 << 120 << 300 << 600);
+    add("qdl_link_resolution_seconds", Histogram, "Time taken by service plugins to resolve download links, by plugin.",
+        QList<double>() << 0.1 << 0.25 << 0.5 << 1 << 2.5 << 5 << 10 << 30 << 60);
+    add("qdl_disk_write_seconds", Histogram, "Time taken to write downloaded data to disk.",
+        QList<double>() << 0.0001 << 0.0005 << 0.001 << 0.005 << 0.01 << 0.05 << 0.1 << 0.5 << 1);
+    add("qdl_postprocessing_queue_depth", Gauge,
+        "Packages extracting archives, moving files or executing custom commands.");
+    add("qdl_http_request_duration_seconds", Histogram, "Web interface request latency, by route and method.",
+        requestBuckets);
+    add("qdl_plugin_script_seconds", Histogram, "CPU time spent running plugin scripts per call, by plugin.",
+        requestBuckets);
+    add("qdl_plugin_script_memory_growth_bytes", Histogram,
+        "Growth in process resident memory while running plugin scripts per call, by plugin.",
+        QList<double>() << 65536 << 262144 << 1048576 << 4194304 << 16777216 << 67108864 << 268435456);
+    add("qdl_plugin_script_aborts_total", Counter,
+        "Plugin script calls aborted for exceeding their time or memory budget, by plugin and reason.");
+}
+
+Metrics::~Metrics() {
+    self = 0;
+}
+
+Metrics* Metrics::instance() {
+    static QMutex mutex;
+    QMutexLocker locker(&mutex);
+    return self ? self : self = new Metrics;
+}
+
+QString Metrics::label(const QString &name, const QString &value) {
+    QString escaped = value;
+    escaped.replace("\\", "\\\\").replace("\"", "\\\"").replace("\n", "\\n");
+    return QString("%1=\"%2\"").arg(name).arg(escaped);
+}
+
+void Metrics::add(const QString &name, Type type, const QString &help, const QList<double> &buckets) {
+    Family family;
+    family.type = type;
+    family.help = help;
+    family.buckets = buckets;
+    m_names << name;
+    m_families.insert(name, family);
+}
+
+void Metrics::increment(const QString &name, const QString &labels, double value) {
+    QMutexLocker locker(&m_mutex);
+
+    if (!m_families.contains(name)) {
+        Logger::log("Metrics::increment(): Unknown metric " + name, Logger::HighVerbosity);
+        return;
+    }
+
+    m_families[name].series[labels].value += value;
+}
+
+void Metrics::setGauge(const QString &name, const QString &labels, double value) {
+    QMutexLocker locker(&m_mutex);
+
+    if (!m_families.contains(name)) {
+        Logger::log("Metrics::setGauge(): Unknown metric " + name, Logger::HighVerbosity);
+        return;
+    }
+
+    m_families[name].series[labels].value = value;
+}
+
+void Metrics::observe(const QString &name, const QString &labels, double value) {
+    QMutexLocker locker(&m_mutex);
+
+    if (!m_families.contains(name)) {
+        Logger::log("Metrics::observe(): Unknown metric " + name, Logger::HighVerbosity);
+        return;
+    }
+
+    Family &family = m_families[name];
+    Series &series = family.series[labels];
+
+    if (series.buckets.isEmpty()) {
+        series.buckets.fill(0, family.buckets.size());
+    }
+
+    for (int i = 0; i < family.buckets.size(); i++) {
+        if (value <= family.buckets.at(i)) {
+            series.buckets[i]++;
+        }
+    }
+
+    series.sum += value;
+    series.count++;
+}
+
+QByteArray Metrics::exposition() const {
+    QMutexLocker locker(&m_mutex);
+    QString text;
+
+    foreach (const QString &name, m_names) {
+        const Family &family = m_families[name];
+        text += QString("# HELP %1 %2\n").arg(name).arg(family.help);
+        text += QString("# TYPE %1 %2\n").arg(name).arg(family.type == Counter ? "counter"
+                                                        : family.type == Gauge ? "gauge" : "histogram");
+        QMapIterator<QString, Series> iterator(family.series);
+
+        while (iterator.hasNext()) {
+            iterator.next();
+            const QString &labels = iterator.key();
+            const Series &series = iterator.value();
+
+            if (family.type != Histogram) {
+                text += QString("%1 %2\n").arg(seriesName(name, labels)).arg(formatNumber(series.value));
+                continue;
+            }
+
+            // Buckets are stored cumulatively
+            const QString prefix = labels.isEmpty() ? QString() : labels + ",";
+
+            for (int i = 0; i < family.buckets.size(); i++) {
+                text += QString("%1 %2\n").arg(seriesName(name + "_bucket", prefix + label("le",
+                                                          formatNumber(family.buckets.at(i)))))
+                                          .arg(series.buckets.value(i));
+            }
+
+            text += QString("%1 %2\n").arg(seriesName(name + "_bucket", prefix + label("le", "+Inf")))
+                                      .arg(series.count);
+            text += QString("%1 %2\n").arg(seriesName(name + "_sum", labels)).arg(formatNumber(series.sum));
+            text += QString("%1 %2\n").arg(seriesName(name + "_count", labels)).arg(series.count);
+        }
+    }
+
+    return text.toUtf8();
+}
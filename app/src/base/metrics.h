@@ -0,0 +1,85 @@
+/*
+ * Copyright (C) 2016 Stuart Howarth <showarth@marxoft.co.uk>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <QHash>
+#include <QMap>
+#include <QMutex>
+#include <QStringList>
+#include <QVector>
+
+/**
+ * A registry of counters, gauges and histograms, which are updated incrementally as events occur and
+ * exported in the Prometheus text exposition format. All methods are thread-safe.
+ */
+class Metrics
+{
+
+public:
+    enum Type {
+        Counter = 0,
+        Gauge,
+        Histogram
+    };
+
+    ~Metrics();
+
+    static Metrics* instance();
+
+    /**
+     * Returns a label pair for use in a series key, with the value escaped.
+     * Pairs are joined with commas.
+     */
+    static QString label(const QString &name, const QString &value);
+
+    void increment(const QString &name, const QString &labels = QString(), double value = 1);
+    void setGauge(const QString &name, const QString &labels, double value);
+    void observe(const QString &name, const QString &labels, double value);
+
+    QByteArray exposition() const;
+
+private:
+    struct Series {
+        Series() : value(0), sum(0), count(0) {}
+
+        double value;
+        double sum;
+        quint64 count;
+        QVector<quint64> buckets;
+    };
+
+    struct Family {
+        Type type;
+        QString help;
+        QList<double> buckets;
+        QMap<QString, Series> series;
+    };
+
+    Metrics();
+
+    void add(const QString &name, Type type, const QString &help, const QList<double> &buckets = QList<double>());
+
+    static Metrics *self;
+
+    mutable QMutex m_mutex;
+
+    QStringList m_names;
+    QHash<QString, Family> m_families;
+};
+
+#endif // METRICS_H
@@ -27,10 +27,13 @@
 #include "servicepluginmanager.h"
 #include "settings.h"
 #include "transfermodel.h"
+#include "transferquery.h"
 #include "urlcheckmodel.h"
 #include "urlretrievalmodel.h"
 #include <QCoreApplication>
+#include <QDBusArgument>
 #include <QDBusConnection>
+#include <QDBusMetaType>
 
 Qdl* Qdl::self = 0;
 
@@ -48,6 +51,40 @@ static QModelIndex getTransferModelIndexById(const QString &id) {
     return indexes.first();
 }
 
+// Maps and lists received over DBus are nested in QDBusArgument, so they are converted recursively
+static QVariant fromDBusArgument(const QVariant &value) {
+    if (value.userType() != qMetaTypeId<QDBusArgument>()) {
+        return value;
+    }
+
+    const QDBusArgument argument = value.value<QDBusArgument>();
+
+    switch (argument.currentType()) {
+    case QDBusArgument::MapType: {
+        QVariantMap map = qdbus_cast<QVariantMap>(argument);
+        QMutableMapIterator<QString, QVariant> iterator(map);
+
+        while (iterator.hasNext()) {
+            iterator.next();
+            iterator.setValue(fromDBusArgument(iterator.value()));
+        }
+
+        return map;
+    }
+    case QDBusArgument::ArrayType: {
+        QVariantList list = qdbus_cast<QVariantList>(argument);
+
+        for (int i = 0; i < list.size(); i++) {
+            list[i] = fromDBusArgument(list.at(i));
+        }
+
+        return list;
+    }
+    default:
+        return value;
+    }
+}
+
 static QVariantMap configToVariantMap(const DecaptchaPluginConfig *config) {
     QVariantMap map;
     map["displayName"] = config->displayName();
@@ -262,45 +299,55 @@ QVariantList Qdl::addTransfers(const QStringList &urls, const QString &requestMe
     return transfers;
 }
 
-QVariantList Qdl::getTransfers(int offset, int limit) {
-    const int count = TransferModel::instance()->rowCount();
+QVariantList Qdl::getTransfers(int offset, int limit, const QVariantMap &query) {
+    return TransferQuery(query).packages(TransferModel::instance()->get(QModelIndex()), offset, limit);
+}
 
-    if ((offset < 0) || (offset >= count - 1)) {
-        return QVariantList();
-    }
+QVariantMap Qdl::getTransfersSince(qint64 revision, const QVariantMap &query) {
+    TransferModel *model = TransferModel::instance();
+    // Only the projection applies, since items that stop matching a filter could not be reported
+    TransferQuery projection;
+    projection.setFields(TransferQuery(query).fields());
+    const bool reset = !model->hasRevisionHistory(revision);
 
-    if (limit < 0) {
-        limit = count - offset;
-    }
-    else {
-        limit += offset;
+    if (reset) {
+        // The requested revision is unknown, so return everything
+        revision = 0;
     }
 
     QVariantList transfers;
-    
-    for (int i = offset; i < limit; i++) {
-        const QModelIndex parent = TransferModel::instance()->index(i, 0, QModelIndex());
-        QVariantMap package = TransferModel::instance()->itemDataWithRoleNames(parent);
-
-        if (!package.isEmpty()) {
-            const int transferCount = TransferModel::instance()->rowCount(parent);
-            QVariantList children;
-            
-            for (int j = 0; j < transferCount; j++) {
-                const QModelIndex child = TransferModel::instance()->index(j, 0, parent);
-                const QVariantMap transfer = TransferModel::instance()->itemDataWithRoleNames(child);
-                
-                if (!transfer.isEmpty()) {
-                    children << transfer;
-                }
+    const int count = model->rowCount();
+
+    for (int i = 0; i < count; i++) {
+        const QModelIndex parent = model->index(i, 0, QModelIndex());
+        const TransferItem *package = model->get(parent);
+        const QString packageId = package->data(TransferItem::IdRole).toString();
+
+        if (model->itemRevision(package) > revision) {
+            QVariantMap item = projection.itemData(package);
+            item["parentId"] = QString();
+            transfers << item;
+        }
+
+        const int transferCount = package->rowCount();
+
+        for (int j = 0; j < transferCount; j++) {
+            const TransferItem *transfer = package->childItem(j);
+
+            if (model->itemRevision(transfer) > revision) {
+                QVariantMap item = projection.itemData(transfer);
+                item["parentId"] = packageId;
+                transfers << item;
             }
-            
-            package["children"] = children;
-            transfers << package;
         }
     }
 
-    return transfers;
+    QVariantMap result;
+    result["revision"] = model->revision();
+    result["reset"] = reset;
+    result["transfers"] = transfers;
+    result["removed"] = reset ? QStringList() : model->removedSince(revision);
+    return result;
 }
 
 QVariantMap Qdl::getTransfersStatus() {
@@ -308,6 +355,7 @@ QVariantMap Qdl::getTransfersStatus() {
     status["activeTransfers"] = TransferModel::instance()->activeTransfers();
     status["totalSpeed"] = TransferModel::instance()->totalSpeed();
     status["totalSpeedString"] = TransferModel::instance()->totalSpeedString();
+    status["concurrency"] = TransferModel::instance()->concurrencyStatus();
     return status;
 }
 
@@ -331,46 +379,11 @@ QVariantMap Qdl::getTransfer(const QString &id) {
     return QVariantMap();
 }
 
-QVariantList Qdl::searchTransfers(const QString &property, const QVariant &value, int offset, int limit) {
-    if ((limit <= 0) || (limit > TransferModel::instance()->rowCount())) {
-        limit = TransferModel::instance()->rowCount();
-    }
-
-    const int hits = qMin(offset + limit, TransferModel::instance()->rowCount());
-    const int role = TransferItem::roleNames().key(property.toUtf8());
-    Qt::MatchFlags flags;
-
-    switch (value.type()) {
-    case QVariant::String:
-        flags = Qt::MatchFixedString | Qt::MatchContains;
-        break;
-    default:
-        flags = Qt::MatchExactly;
-        break;
-    }
-
-    QVariantList transfers;
-    const QModelIndexList indexes =
-    TransferModel::instance()->match(TransferModel::instance()->index(0, 0), role, value, hits, flags);
-    
-    for (int i = offset; i < indexes.size(); i++) {
-        const QModelIndex &index = indexes.at(i);
-        QVariantMap transfer = TransferModel::instance()->itemDataWithRoleNames(index);
-        
-        if (!transfer.isEmpty()) {
-            QVariantList children;
-            const int count = TransferModel::instance()->rowCount(index);
-            
-            for (int i = 0; i < count; i++) {
-                children << TransferModel::instance()->itemDataWithRoleNames(TransferModel::instance()->index(i, 0, index));
-            }
-            
-            transfer["children"] = children;
-            transfers << transfer;
-        }
-    }
-    
-    return transfers;
+QVariantList Qdl::searchTransfers(const QString &property, const QVariant &value, int offset, int limit,
+                                  const QVariantMap &query) {
+    TransferQuery search(query);
+    search.addFilter(property, QVariantList() << value, value.type() == QVariant::String);
+    return search.packages(TransferModel::instance()->get(QModelIndex()), offset, limit <= 0 ? -1 : limit);
 }
 
 bool Qdl::setTransferProperty(const QString &id, const QString &property, const QVariant &value) {
@@ -420,6 +433,54 @@ void Qdl::pauseTransfers() {
     TransferModel::instance()->pause();
 }
 
+QVariantList Qdl::batchTransfers(const QVariantList &operations) {
+    Logger::log(QString("Qdl::batchTransfers(): %1 operations").arg(operations.size()), Logger::MediumVerbosity);
+    TransferModel::instance()->beginBatch();
+    QVariantList results;
+
+    foreach (const QVariant &v, operations) {
+        const QVariantMap operation = fromDBusArgument(v).toMap();
+        const QString method = operation.value("method").toString().toLower();
+        const QString id = operation.value("id").toString();
+        QVariantMap result;
+        result["method"] = method;
+        result["id"] = id;
+        bool success = false;
+
+        if (method == "settransferproperty") {
+            success = setTransferProperty(id, operation.value("property").toString(),
+                                          fromDBusArgument(operation.value("value")));
+        }
+        else if (method == "settransferproperties") {
+            success = setTransferProperties(id, fromDBusArgument(operation.value("properties")).toMap());
+        }
+        else if (method == "starttransfer") {
+            success = startTransfer(id);
+        }
+        else if (method == "pausetransfer") {
+            success = pauseTransfer(id);
+        }
+        else if (method == "removetransfer") {
+            success = removeTransfer(id, operation.value("deleteFiles", false).toBool());
+        }
+        else if (method == "movetransfers") {
+            success = moveTransfers(operation.value("sourceParentId").toString(),
+                                    operation.value("sourceRow", 0).toInt(), operation.value("count", 1).toInt(),
+                                    operation.value("destinationParentId").toString(),
+                                    operation.value("destinationRow", 0).toInt());
+        }
+        else {
+            result["error"] = QString("Unknown method");
+        }
+
+        result["success"] = success;
+        results << result;
+    }
+
+    TransferModel::instance()->endBatch();
+    return results;
+}
+
 QVariantMap Qdl::addCategory(const QString &name, const QString &path) {
     if (Categories::add(name, path)) {
         return getCategory(name);
@@ -436,6 +497,7 @@ QVariantList Qdl::getCategories() {
         QVariantMap category;
         category["name"] = categories.at(i).name;
         category["path"] = categories.at(i).path;
+        category["schedulingPolicy"] = Settings::schedulingPolicy(categories.at(i).name);
         list << category;
     }
 
@@ -447,6 +509,7 @@ QVariantMap Qdl::getCategory(const QString &name) {
     QVariantMap map;
     map["name"] = category.name;
     map["path"] = category.path;
+    map["schedulingPolicy"] = Settings::schedulingPolicy(category.name);
     return map;
 }
 
@@ -666,6 +729,15 @@ QVariantMap Qdl::getSettings() {
     map["deleteExtractedArchives"] = Settings::deleteExtractedArchives();
     map["archivePasswords"] = Settings::archivePasswords();
     map["maximumConcurrentTransfers"] = Settings::maximumConcurrentTransfers();
+    map["adaptiveConcurrentTransfers"] = Settings::adaptiveConcurrentTransfers();
+    map["minimumConcurrentTransfers"] = Settings::minimumConcurrentTransfers();
+    map["schedulingPolicies"] = Settings::schedulingPolicies();
+    map["stallTimeout"] = Settings::stallTimeout();
+    map["minimumTransferSpeed"] = Settings::minimumTransferSpeed();
+    map["slowTransferTimeout"] = Settings::slowTransferTimeout();
+    map["maximumTransferRetries"] = Settings::maximumTransferRetries();
+    map["pluginScriptTimeLimit"] = Settings::pluginScriptTimeLimit();
+    map["pluginScriptMemoryLimit"] = Settings::pluginScriptMemoryLimit();
     map["startTransfersAutomatically"] = Settings::startTransfersAutomatically();
     map["nextAction"] = Settings::nextAction();
     map["networkProxyEnabled"] = Settings::networkProxyEnabled();
@@ -727,6 +799,39 @@ bool Qdl::setSettings(const QVariantMap &settings) {
         else if (iterator.key() == "maximumConcurrentTransfers") {
             Settings::setMaximumConcurrentTransfers(iterator.value().toInt());
         }
+        else if (iterator.key() == "adaptiveConcurrentTransfers") {
+            Settings::setAdaptiveConcurrentTransfers(iterator.value().toBool());
+        }
+        else if (iterator.key() == "minimumConcurrentTransfers") {
+            Settings::setMinimumConcurrentTransfers(iterator.value().toInt());
+        }
+        else if (iterator.key() == "stallTimeout") {
+            Settings::setStallTimeout(iterator.value().toInt());
+        }
+        else if (iterator.key() == "minimumTransferSpeed") {
+            Settings::setMinimumTransferSpeed(iterator.value().toInt());
+        }
+        else if (iterator.key() == "slowTransferTimeout") {
+            Settings::setSlowTransferTimeout(iterator.value().toInt());
+        }
+        else if (iterator.key() == "maximumTransferRetries") {
+            Settings::setMaximumTransferRetries(iterator.value().toInt());
+        }
+        else if (iterator.key() == "pluginScriptTimeLimit") {
+            Settings::setPluginScriptTimeLimit(iterator.value().toInt());
+        }
+        else if (iterator.key() == "pluginScriptMemoryLimit") {
+            Settings::setPluginScriptMemoryLimit(iterator.value().toInt());
+        }
+        else if (iterator.key() == "schedulingPolicies") {
+            const QVariantMap policies = iterator.value().toMap();
+            QMapIterator<QString, QVariant> policyIterator(policies);
+
+            while (policyIterator.hasNext()) {
+                policyIterator.next();
+                Settings::setSchedulingPolicy(policyIterator.key(), policyIterator.value().toInt());
+            }
+        }
         else if (iterator.key() == "startTransfersAutomatically") {
             Settings::setStartTransfersAutomatically(iterator.value().toBool());
         }
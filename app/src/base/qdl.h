@@ -57,11 +57,13 @@ public Q_SLOTS:
             const QString &category = QString(), bool createSubfolder = false,
             int priority = TransferItem::NormalPriority, const QString &customCommand = QString(),
             bool overrideGlobalCommand = false, bool startAutomatically = false);
-    Q_SCRIPTABLE static QVariantList getTransfers(int offset = 0, int limit = -1);
+    Q_SCRIPTABLE static QVariantList getTransfers(int offset = 0, int limit = -1,
+            const QVariantMap &query = QVariantMap());
+    Q_SCRIPTABLE static QVariantMap getTransfersSince(qint64 revision, const QVariantMap &query = QVariantMap());
     Q_SCRIPTABLE static QVariantMap getTransfersStatus();
     Q_SCRIPTABLE static QVariantMap getTransfer(const QString &id);
     Q_SCRIPTABLE static QVariantList searchTransfers(const QString &property, const QVariant &value, int offset = 0,
-            int limit = -1);
+            int limit = -1, const QVariantMap &query = QVariantMap());
     Q_SCRIPTABLE static bool setTransferProperty(const QString &id, const QString &property, const QVariant &value);
     Q_SCRIPTABLE static bool setTransferProperties(const QString &id, const QVariantMap &properties);
     Q_SCRIPTABLE static bool startTransfer(const QString &id);
@@ -71,6 +73,7 @@ public Q_SLOTS:
             const QString &destinationParentId, int destinationRow);
     Q_SCRIPTABLE static void startTransfers();
     Q_SCRIPTABLE static void pauseTransfers();
+    Q_SCRIPTABLE static QVariantList batchTransfers(const QVariantList &operations);
 
     Q_SCRIPTABLE static QVariantMap addCategory(const QString &name, const QString &path);
     Q_SCRIPTABLE static QVariantList getCategories();
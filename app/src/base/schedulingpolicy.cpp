@@ -0,0 +1,230 @@
+/*
+ * Copyright (C) 2016 Stuart Howarth <showarth@marxoft.co.uk>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "schedulingpolicy.h"
+#include "transferitem.h"
+#include <QDateTime>
+
+class PrioritySchedulingPolicy : public SchedulingPolicy
+{
+public:
+    virtual Type type() const {
+        return PriorityPolicy;
+    }
+
+    virtual void sort(QList<TransferItem*> &, const QList<TransferItem*> &) const {}
+};
+
+static qint64 remainingBytes(const TransferItem *transfer) {
+    const qint64 size = transfer->data(TransferItem::SizeRole).toLongLong();
+    return size > 0 ? qMax(qint64(0), size - transfer->data(TransferItem::BytesTransferredRole).toLongLong()) : -1;
+}
+
+static bool remainingBytesLessThan(const TransferItem *transfer, const TransferItem *other) {
+    const qint64 remaining = remainingBytes(transfer);
+    const qint64 otherRemaining = remainingBytes(other);
+
+    // Transfers of unknown size are started after those of known size
+    if (otherRemaining < 0) {
+        return remaining >= 0;
+    }
+
+    return (remaining >= 0) && (remaining < otherRemaining);
+}
+
+class ShortestJobFirstSchedulingPolicy : public SchedulingPolicy
+{
+public:
+    virtual Type type() const {
+        return ShortestJobFirstPolicy;
+    }
+
+    virtual void sort(QList<TransferItem*> &queued, const QList<TransferItem*> &) const {
+        qStableSort(queued.begin(), queued.end(), remainingBytesLessThan);
+    }
+};
+
+class FairShareSchedulingPolicy : public SchedulingPolicy
+{
+public:
+    virtual Type type() const {
+        return FairSharePolicy;
+    }
+
+    // Repeatedly takes the next transfer from the package with the fewest active and already scheduled transfers
+    virtual void sort(QList<TransferItem*> &queued, const QList<TransferItem*> &active) const {
+        QHash<TransferItem*, int> load;
+        QList<TransferItem*> packages;
+        QHash<TransferItem*, QList<TransferItem*> > transfers;
+
+        foreach (TransferItem *transfer, active) {
+            load[transfer->parentItem()] += 1;
+        }
+
+        foreach (TransferItem *transfer, queued) {
+            TransferItem *package = transfer->parentItem();
+
+            if (!transfers.contains(package)) {
+                packages << package;
+            }
+
+            transfers[package] << transfer;
+        }
+
+        queued.clear();
+
+        while (!packages.isEmpty()) {
+            int next = 0;
+
+            for (int i = 1; i < packages.size(); i++) {
+                if (load.value(packages.at(i)) < load.value(packages.at(next))) {
+                    next = i;
+                }
+            }
+
+            TransferItem *package = packages.at(next);
+            QList<TransferItem*> &list = transfers[package];
+            queued << list.takeFirst();
+            load[package] += 1;
+
+            if (list.isEmpty()) {
+                packages.removeAt(next);
+            }
+        }
+    }
+};
+
+static bool deadlineLessThan(const TransferItem *transfer, const TransferItem *other) {
+    const QDateTime deadline = transfer->data(TransferItem::DeadlineRole).toDateTime();
+    const QDateTime otherDeadline = other->data(TransferItem::DeadlineRole).toDateTime();
+
+    // Transfers without a deadline are started after those with a deadline
+    if (!otherDeadline.isValid()) {
+        return deadline.isValid();
+    }
+
+    return (deadline.isValid()) && (deadline < otherDeadline);
+}
+
+class DeadlineSchedulingPolicy : public SchedulingPolicy
+{
+public:
+    virtual Type type() const {
+        return DeadlinePolicy;
+    }
+
+    virtual void sort(QList<TransferItem*> &queued, const QList<TransferItem*> &) const {
+        qStableSort(queued.begin(), queued.end(), deadlineLessThan);
+    }
+};
+
+const SchedulingPolicy* SchedulingPolicy::policy(int type) {
+    static PrioritySchedulingPolicy priorityPolicy;
+    static ShortestJobFirstSchedulingPolicy shortestJobFirstPolicy;
+    static FairShareSchedulingPolicy fairSharePolicy;
+    static DeadlineSchedulingPolicy deadlinePolicy;
+
+    switch (type) {
+    case ShortestJobFirstPolicy:
+        return &shortestJobFirstPolicy;
+    case FairSharePolicy:
+        return &fairSharePolicy;
+    case DeadlinePolicy:
+        return &deadlinePolicy;
+    default:
+        return &priorityPolicy;
+    }
+}
+
+static QString category(const TransferItem *transfer) {
+    const TransferItem *package = transfer->parentItem();
+    return package ? package->data(TransferItem::CategoryRole).toString() : QString();
+}
+
+QList<TransferItem*> SchedulingPolicy::schedule(const QList<TransferItem*> &queued, const QList<TransferItem*> &active,
+                                                const QHash<QString, int> &policies) {
+    QList<TransferItem*> scheduled;
+
+    for (int priority = TransferItem::HighestPriority; priority <= TransferItem::LowestPriority; priority++) {
+        QList<TransferItem*> transfers;
+        QList<QList<TransferItem*> > groups;
+        QList<QList<int> > groupPositions;
+        QList<int> groupPolicies;
+        QHash<QString, int> categoryGroups;
+        int fairShareGroup = -1;
+
+        foreach (TransferItem *transfer, queued) {
+            if (transfer->data(TransferItem::PriorityRole) != priority) {
+                continue;
+            }
+
+            const QString name = category(transfer);
+            const int type = policies.value(name, PriorityPolicy);
+            int group = type == FairSharePolicy ? fairShareGroup : categoryGroups.value(name, -1);
+
+            if (group == -1) {
+                group = groups.size();
+                groups << QList<TransferItem*>();
+                groupPositions << QList<int>();
+                groupPolicies << type;
+
+                if (type == FairSharePolicy) {
+                    fairShareGroup = group;
+                }
+                else {
+                    categoryGroups[name] = group;
+                }
+            }
+
+            groups[group] << transfer;
+            groupPositions[group] << transfers.size();
+            transfers << transfer;
+        }
+
+        // Each group's policy orders its transfers within the positions they occupy in the queue
+        for (int i = 0; i < groups.size(); i++) {
+            QList<TransferItem*> &list = groups[i];
+            const QList<int> &positions = groupPositions.at(i);
+            policy(groupPolicies.at(i))->sort(list, active);
+
+            for (int j = 0; j < positions.size(); j++) {
+                transfers[positions.at(j)] = list.at(j);
+            }
+        }
+
+        scheduled << transfers;
+    }
+
+    return scheduled;
+}
+
+QString SchedulingPolicy::typeString(int type) {
+    switch (type) {
+    case ShortestJobFirstPolicy:
+        return tr("Shortest first");
+    case FairSharePolicy:
+        return tr("Fair share between packages");
+    case DeadlinePolicy:
+        return tr("Earliest deadline first");
+    default:
+        return tr("Priority and queue order");
+    }
+}
+
+QList<int> SchedulingPolicy::types() {
+    return QList<int>() << PriorityPolicy << ShortestJobFirstPolicy << FairSharePolicy << DeadlinePolicy;
+}
@@ -0,0 +1,64 @@
+/*
+ * Copyright (C) 2016 Stuart Howarth <showarth@marxoft.co.uk>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef SCHEDULINGPOLICY_H
+#define SCHEDULINGPOLICY_H
+
+#include <QCoreApplication>
+#include <QHash>
+#include <QList>
+
+class TransferItem;
+
+class SchedulingPolicy
+{
+    Q_DECLARE_TR_FUNCTIONS(SchedulingPolicy)
+
+public:
+    enum Type {
+        PriorityPolicy = 0,
+        ShortestJobFirstPolicy,
+        FairSharePolicy,
+        DeadlinePolicy
+    };
+
+    virtual ~SchedulingPolicy() {}
+
+    virtual Type type() const = 0;
+
+    /**
+     * Sorts queued transfers of equal priority into the order in which they should be started.
+     * The sort must be stable, so that transfers the policy does not distinguish keep their queue order.
+     */
+    virtual void sort(QList<TransferItem*> &queued, const QList<TransferItem*> &active) const = 0;
+
+    static const SchedulingPolicy* policy(int type);
+
+    /**
+     * Returns queued transfers in the order in which they should be started. Priority takes precedence. Within
+     * each priority, the transfers of a category are ordered by that category's policy in policies, within the queue
+     * positions they occupy. Categories using FairSharePolicy are balanced as one group, so that packages take turns
+     * across those categories. Categories missing from policies use PriorityPolicy.
+     */
+    static QList<TransferItem*> schedule(const QList<TransferItem*> &queued, const QList<TransferItem*> &active,
+                                         const QHash<QString, int> &policies);
+
+    static QString typeString(int type);
+    static QList<int> types();
+};
+
+#endif // SCHEDULINGPOLICY_H
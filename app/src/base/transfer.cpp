@@ -18,16 +18,54 @@
 #include "captchatype.h"
 #include "definitions.h"
 #include "logger.h"
+#include "metrics.h"
 #include "servicepluginconfig.h"
 #include "servicepluginmanager.h"
 #include "settings.h"
 #include "utils.h"
 #include <QBuffer>
 #include <QDir>
+#include <QElapsedTimer>
 #include <QFile>
 #include <QNetworkAccessManager>
 #include <QNetworkReply>
 #include <QSettings>
+#include <QTimer>
+
+// Writes data to file, recording the time taken
+static qint64 writeData(QFile *file, const QByteArray &data) {
+    QElapsedTimer timer;
+    timer.start();
+    const qint64 written = file->write(data);
+#if QT_VERSION >= 0x040800
+    Metrics::instance()->observe("qdl_disk_write_seconds", QString(), timer.nsecsElapsed() / 1000000000.0);
+#else
+    Metrics::instance()->observe("qdl_disk_write_seconds", QString(), timer.elapsed() / 1000.0);
+#endif
+    return written;
+}
+
+static bool isRetryableError(QNetworkReply::NetworkError error) {
+    switch (error) {
+    case QNetworkReply::ConnectionRefusedError:
+    case QNetworkReply::RemoteHostClosedError:
+    case QNetworkReply::HostNotFoundError:
+    case QNetworkReply::TimeoutError:
+    case QNetworkReply::TemporaryNetworkFailureError:
+    case QNetworkReply::ProxyConnectionRefusedError:
+    case QNetworkReply::ProxyConnectionClosedError:
+    case QNetworkReply::ProxyTimeoutError:
+    case QNetworkReply::UnknownNetworkError:
+#if QT_VERSION >= 0x050300
+    case QNetworkReply::NetworkSessionFailedError:
+    case QNetworkReply::InternalServerError:
+    case QNetworkReply::ServiceUnavailableError:
+#endif
+        return true;
+    default:
+        return false;
+    }
+}
 
 const QRegExp Transfer::CONTENT_DISPOSITION_REGEXP("(filename=|filename\\*=UTF-8''|filename\\*= UTF-8'')([^;]+)");
 
@@ -41,12 +79,21 @@ Transfer::Transfer(QObject *parent) :
     m_lastBytesTransferred(0),
     m_size(0),
     m_speed(0),
+    m_monitorTimer(0),
+    m_progressBytes(0),
+    m_slowBytes(0),
+    m_retries(0),
+    m_slowReconnects(0),
+    m_retryDelay(0),
+    m_retryPending(false),
     m_status(Paused),
     m_requestMethod("GET"),
     m_servicePluginIcon(DEFAULT_ICON),
     m_customCommandOverrideEnabled(false),
     m_usePlugins(true),
     m_metadataSet(false),
+    m_usingCachedRequest(false),
+    m_requeue(false),
     m_redirects(0)
 {
 }
@@ -71,6 +118,8 @@ QVariant Transfer::data(int role) const {
         return customCommand();
     case CustomCommandOverrideEnabledRole:
         return customCommandOverrideEnabled();
+    case DeadlineRole:
+        return deadline();
     case DownloadPathRole:
         return downloadPath();
     case ErrorStringRole:
@@ -145,6 +194,9 @@ bool Transfer::setData(int role, const QVariant &value) {
     case CustomCommandOverrideEnabledRole:
         setCustomCommandOverrideEnabled(value.toBool());
         return true;
+    case DeadlineRole:
+        setDeadline(value.toDateTime());
+        return true;
     case DownloadPathRole:
         setDownloadPath(value.toString());
         return true;
@@ -209,6 +261,7 @@ QMap<int, QVariant> Transfer::itemData() const {
     map[CaptchaTypeStringRole] = captchaTypeString();
     map[CustomCommandRole] = customCommand();
     map[CustomCommandOverrideEnabledRole] = customCommandOverrideEnabled();
+    map[DeadlineRole] = deadline();
     map[DownloadPathRole] = downloadPath();
     map[ErrorStringRole] = errorString();
     map[FileNameRole] = fileName();
@@ -252,6 +305,7 @@ QVariantMap Transfer::itemDataWithRoleNames() const {
     map[roleNames().value(CaptchaTypeStringRole)] = captchaTypeString();
     map[roleNames().value(CustomCommandRole)] = customCommand();
     map[roleNames().value(CustomCommandOverrideEnabledRole)] = customCommandOverrideEnabled();
+    map[roleNames().value(DeadlineRole)] = deadline();
     map[roleNames().value(DownloadPathRole)] = downloadPath();
     map[roleNames().value(ErrorStringRole)] = errorString();
     map[roleNames().value(FileNameRole)] = fileName();
@@ -348,6 +402,17 @@ void Transfer::setCustomCommandOverrideEnabled(bool enabled) {
     }
 }
 
+QDateTime Transfer::deadline() const {
+    return m_deadline;
+}
+
+void Transfer::setDeadline(const QDateTime &d) {
+    if (d != deadline()) {
+        m_deadline = d;
+        emit dataChanged(this, DeadlineRole);
+    }
+}
+
 QString Transfer::downloadPath() const {
     return m_downloadPath;
 }
@@ -633,7 +698,24 @@ TransferItem::Status Transfer::status() const {
 void Transfer::setStatus(TransferItem::Status s) {
     if (s != status()) {
         m_status = s;
-        Logger::log(QString("Transfer::setStatus(): ID: %1, Status: %2").arg(id()).arg(statusString()));
+        QDL_LOG_TRANSFER(Logger::LowestVerbosity, id(), pluginId(),
+                         QString("Transfer::setStatus(): ID: %1, Status: %2").arg(id()).arg(statusString()));
+
+        switch (s) {
+        case Downloading:
+            startMonitor();
+            break;
+        case WaitingActive:
+            if (!m_retryPending) {
+                stopMonitor();
+            }
+
+            break;
+        default:
+            m_retryPending = false;
+            stopMonitor();
+            break;
+        }
 
         switch (s) {
         case Canceled:
@@ -658,6 +740,9 @@ QString Transfer::statusString() const {
     switch (status()) {
     case Failed:
         return QString("%1: %2").arg(TransferItem::statusString(Failed)).arg(errorString());
+    case Queued:
+        return errorString().isEmpty() ? TransferItem::statusString(Queued)
+                                       : QString("%1: %2").arg(TransferItem::statusString(Queued)).arg(errorString());
     case WaitingInactive:
         return QString("%1: %2").arg(TransferItem::statusString(WaitingInactive)).arg(waitTimeString());
     case WaitingActive:
@@ -686,21 +771,42 @@ QString Transfer::url() const {
 void Transfer::setUrl(const QString &u) {
     if (u != url()) {
         m_url = u;
+        clearCachedRequest();
         emit dataChanged(this, UrlRole);
         updatePluginInfo();
     }
 }
 
 int Transfer::waitTime() const {
+    if (m_retryPending) {
+        return qMax(0, m_retryDelay - m_retryTime.elapsed());
+    }
+
     return m_requester ? m_requester->waitTime() : 0;
 }
 
 QString Transfer::waitTimeString() const {
+    if (m_retryPending) {
+        return Utils::formatMSecs(waitTime());
+    }
+
     return m_requester ? m_requester->waitTimeString() : QString();
 }
 
+void Transfer::hold(const QString &reason) {
+    if (reason != errorString()) {
+        setErrorString(reason);
+        emit dataChanged(this, ErrorStringRole);
+    }
+}
+
 bool Transfer::queue() {
     if (canStart()) {
+        if (!errorString().isEmpty()) {
+            setErrorString(QString());
+            emit dataChanged(this, ErrorStringRole);
+        }
+
         setStatus(Queued);
         return true;
     }
@@ -710,13 +816,17 @@ bool Transfer::queue() {
 
 bool Transfer::start() {
     if (canStart()) {
+        m_retries = 0;
+        m_slowReconnects = 0;
+        
         if (!usePlugins()) {
             startDownload();
         }
+        else if (hasCachedRequest()) {
+            startCachedDownload();
+        }
         else {
-            initRequester();
-            setStatus(Connecting);
-            m_requester->getDownloadRequest(url());
+            startPluginDownload();
         }
 
         return true;
@@ -750,6 +860,8 @@ bool Transfer::pause() {
     case Downloading:
         if (m_reply) {
             if (m_reply->isRunning()) {
+                m_requeue = false;
+                m_reconnectReason.clear();
                 m_reply->abort();
                 return true;
             }
@@ -812,6 +924,7 @@ bool Transfer::cancel(bool deleteFiles) {
 void Transfer::restore(const QSettings &settings) {
     setCustomCommand(settings.value("customCommand").toString());
     setCustomCommandOverrideEnabled(settings.value("customCommandOverrideEnabled", false).toBool());
+    setDeadline(settings.value("deadline").toDateTime());
     setDownloadPath(settings.value("downloadPath").toString());
     setErrorString(settings.value("errorString").toString());
     setFileName(settings.value("fileName").toString());
@@ -824,6 +937,14 @@ void Transfer::restore(const QSettings &settings) {
     setUrl(settings.value("url").toString());
     setUsePlugins(settings.value("usePlugins", true).toBool());
 
+    if (settings.contains("cachedRequestUrl")) {
+        m_cachedRequestUrl = settings.value("cachedRequestUrl").toUrl();
+        m_cachedRequestHeaders = settings.value("cachedRequestHeaders").toMap();
+        m_cachedRequestMethod = settings.value("cachedRequestMethod").toByteArray();
+        m_cachedRequestData = settings.value("cachedRequestData").toByteArray();
+        m_cachedRequestExpiry = settings.value("cachedRequestExpiry").toDateTime();
+    }
+
     const TransferItem::Status status = TransferItem::Status(settings.value("status", Paused).toInt());
 
     switch (status) {
@@ -841,6 +962,7 @@ void Transfer::restore(const QSettings &settings) {
 void Transfer::save(QSettings &settings) {
     settings.setValue("customCommand", customCommand());
     settings.setValue("customCommandOverrideEnabled", customCommandOverrideEnabled());
+    settings.setValue("deadline", deadline());
     settings.setValue("downloadPath", downloadPath());
     settings.setValue("errorString", errorString());
     settings.setValue("fileName", fileName());
@@ -853,6 +975,14 @@ void Transfer::save(QSettings &settings) {
     settings.setValue("url", url());
     settings.setValue("usePlugins", usePlugins());
 
+    if (hasCachedRequest()) {
+        settings.setValue("cachedRequestUrl", m_cachedRequestUrl);
+        settings.setValue("cachedRequestHeaders", m_cachedRequestHeaders);
+        settings.setValue("cachedRequestMethod", m_cachedRequestMethod);
+        settings.setValue("cachedRequestData", m_cachedRequestData);
+        settings.setValue("cachedRequestExpiry", m_cachedRequestExpiry);
+    }
+
     switch (status()) {
     case Paused:
     case Failed:
@@ -874,6 +1004,8 @@ bool Transfer::submitSettingsResponse(const QVariantMap &settings) {
 }
 
 void Transfer::cleanup() {
+    clearCachedRequest();
+
     if (m_requester) {
         m_requester->deleteLater();
         m_requester = 0;
@@ -910,6 +1042,60 @@ void Transfer::initRequester() {
     }
 }
 
+bool Transfer::hasCachedRequest() const {
+    return (!m_cachedRequestUrl.isEmpty()) && (m_cachedRequestExpiry.isValid())
+        && (m_cachedRequestExpiry > QDateTime::currentDateTime());
+}
+
+void Transfer::setCachedRequest(const QNetworkRequest &request, const QByteArray &method, const QByteArray &data) {
+    // The request is always kept for the first retry, but is only reused by later starts if the plugin gives
+    // its links a lifetime
+    const ServicePluginConfig *config = ServicePluginManager::instance()->getConfigByUrl(url());
+    const int linkTtl = config ? config->linkTtl() : 0;
+
+    if (linkTtl > 0) {
+        QDL_LOG_TRANSFER(Logger::MediumVerbosity, id(), pluginId(),
+                         QString("Transfer::setCachedRequest(): Caching download request for %1 seconds")
+                         .arg(linkTtl));
+    }
+
+    m_cachedRequestUrl = request.url();
+    m_cachedRequestHeaders.clear();
+
+    foreach (const QByteArray &header, request.rawHeaderList()) {
+        m_cachedRequestHeaders[QString::fromUtf8(header)] = request.rawHeader(header);
+    }
+
+    m_cachedRequestMethod = method;
+    m_cachedRequestData = data;
+    m_cachedRequestExpiry = linkTtl > 0 ? QDateTime::currentDateTime().addSecs(linkTtl) : QDateTime();
+}
+
+void Transfer::clearCachedRequest() {
+    m_cachedRequestUrl.clear();
+    m_cachedRequestHeaders.clear();
+    m_cachedRequestMethod.clear();
+    m_cachedRequestData.clear();
+    m_cachedRequestExpiry = QDateTime();
+}
+
+bool Transfer::cachedRequestRejected() const {
+    if ((!m_reply) || (!m_reply->rawHeader("Location").isEmpty())) {
+        return false;
+    }
+
+    switch (m_reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt()) {
+    case 403:
+    case 404:
+    case 410:
+        return true;
+    default:
+        break;
+    }
+
+    return m_reply->header(QNetworkRequest::ContentTypeHeader).toString().startsWith("text/html");
+}
+
 void Transfer::initNetworkAccessManager() {
     if (!m_nam) {
         m_nam = new QNetworkAccessManager(this);
@@ -934,8 +1120,8 @@ bool Transfer::openFile() {
 }
 
 void Transfer::startDownload() {
-    Logger::log(QString("Transfer::startDownload(). URL: %1, Method: %2").arg(url()).arg(requestMethod()),
-                Logger::LowVerbosity);
+    QDL_LOG_TRANSFER(Logger::LowVerbosity, id(), pluginId(),
+                     QString("Transfer::startDownload(). URL: %1, Method: %2").arg(url()).arg(requestMethod()));
     m_redirects = 0;
     m_metadataSet = false;
     initNetworkAccessManager();
@@ -949,8 +1135,8 @@ void Transfer::startDownload() {
     }
 
     if (bytesTransferred() > 0) {
-        Logger::log("Transfer::startDownload(). Setting 'Range' header to " + QString::number(bytesTransferred()),
-                    Logger::MediumVerbosity);
+        QDL_LOG_TRANSFER(Logger::MediumVerbosity, id(), pluginId(),
+                         "Transfer::startDownload(). Setting 'Range' header to " + QString::number(bytesTransferred()));
         request.setRawHeader("Range", "bytes=" + QByteArray::number(bytesTransferred()) + "-");
     }
 
@@ -976,15 +1162,37 @@ void Transfer::startDownload() {
     }
 }
 
+void Transfer::startCachedDownload() {
+    QDL_LOG_TRANSFER(Logger::LowVerbosity, id(), pluginId(),
+                     "Transfer::startCachedDownload(). URL: " + m_cachedRequestUrl.toString());
+    QNetworkRequest request(m_cachedRequestUrl);
+    QMapIterator<QString, QVariant> iterator(m_cachedRequestHeaders);
+
+    while (iterator.hasNext()) {
+        iterator.next();
+        request.setRawHeader(iterator.key().toUtf8(), iterator.value().toByteArray());
+    }
+
+    m_usingCachedRequest = true;
+    sendDownloadRequest(request, m_cachedRequestMethod, m_cachedRequestData);
+}
+
+void Transfer::startPluginDownload() {
+    m_usingCachedRequest = false;
+    initRequester();
+    setStatus(Connecting);
+    m_requester->getDownloadRequest(url());
+}
+
 void Transfer::followRedirect(const QUrl &url) {
-    Logger::log("Transfer::followRedirect(): " + url.toString(), Logger::LowVerbosity);
+    QDL_LOG_TRANSFER(Logger::LowVerbosity, id(), pluginId(), "Transfer::followRedirect(): " + url.toString());
     m_redirects++;
     initNetworkAccessManager();
     QNetworkRequest request(url);
 
     if (bytesTransferred() > 0) {
-        Logger::log("Transfer::followRedirect(). Setting 'Range' header to " + QString::number(bytesTransferred()),
-                    Logger::MediumVerbosity);
+        QDL_LOG_TRANSFER(Logger::MediumVerbosity, id(), pluginId(),
+                         "Transfer::followRedirect(). Setting 'Range' header to " + QString::number(bytesTransferred()));
         request.setRawHeader("Range", "bytes=" + QByteArray::number(bytesTransferred()) + "-");
     }
     
@@ -994,17 +1202,15 @@ void Transfer::followRedirect(const QUrl &url) {
     connect(m_reply, SIGNAL(readyRead()), this, SLOT(onReplyReadyRead()));
 }
 
-void Transfer::onDownloadRequest(QNetworkRequest request, const QByteArray &method, const QByteArray &data) {
-    Logger::log(QString("Transfer::onDownloadRequest(). URL: %1, Method: %2, Data: %3")
-            .arg(request.url().toString()).arg(QString::fromUtf8(method)).arg(QString::fromUtf8(data)),
-            Logger::LowVerbosity);
+void Transfer::sendDownloadRequest(QNetworkRequest request, const QByteArray &method, const QByteArray &data) {
     m_redirects = 0;
     m_metadataSet = false;
     initNetworkAccessManager();
 
     if (bytesTransferred() > 0) {
-        Logger::log("Transfer::startDownload(). Setting 'Range' header to " + QString::number(bytesTransferred()),
-                    Logger::MediumVerbosity);
+        QDL_LOG_TRANSFER(Logger::MediumVerbosity, id(), pluginId(),
+                         "Transfer::sendDownloadRequest(). Setting 'Range' header to "
+                         + QString::number(bytesTransferred()));
         request.setRawHeader("Range", "bytes=" + QByteArray::number(bytesTransferred()) + "-");
     }
 
@@ -1030,6 +1236,93 @@ void Transfer::onDownloadRequest(QNetworkRequest request, const QByteArray &meth
     }
 }
 
+void Transfer::startMonitor() {
+    if (!m_monitorTimer) {
+        m_monitorTimer = new QTimer(this);
+        m_monitorTimer->setInterval(1000);
+        connect(m_monitorTimer, SIGNAL(timeout()), this, SLOT(onMonitorTimeout()));
+    }
+
+    m_progressBytes = bytesTransferred();
+    m_slowBytes = m_progressBytes;
+    m_progressTime.start();
+    m_slowTime.start();
+    m_monitorTimer->start();
+}
+
+void Transfer::stopMonitor() {
+    if (m_monitorTimer) {
+        m_monitorTimer->stop();
+    }
+}
+
+void Transfer::reconnect(const QString &reason) {
+    QDL_LOG_TRANSFER(Logger::LowVerbosity, id(), pluginId(),
+                     QString("Transfer::reconnect(): ID: %1, Reason: %2").arg(id()).arg(reason));
+    stopMonitor();
+    m_reconnectReason = reason;
+    m_reply->abort();
+}
+
+void Transfer::scheduleRetry(const QString &reason) {
+    if (m_retries >= Settings::maximumTransferRetries()) {
+        QDL_LOG_TRANSFER(Logger::LowVerbosity, id(), pluginId(),
+                         QString("Transfer::scheduleRetry(): ID: %1. Maximum retries reached").arg(id()));
+        setErrorString(reason);
+        setStatus(Failed);
+        return;
+    }
+
+    m_retryDelay = qMin(MAX_RETRY_DELAY, RETRY_DELAY << qMin(m_retries, 16));
+    m_retries++;
+    QDL_LOG_TRANSFER(Logger::LowVerbosity, id(), pluginId(),
+                     QString("Transfer::scheduleRetry(): ID: %1, Reason: %2, Attempt: %3, Delay: %4")
+                     .arg(id()).arg(reason).arg(m_retries).arg(m_retryDelay));
+    m_retryPending = true;
+    m_retryTime.start();
+    setStatus(WaitingActive);
+    startMonitor();
+    emit dataChanged(this, WaitTimeRole);
+}
+
+void Transfer::retry() {
+    m_retryPending = false;
+
+    if (!usePlugins()) {
+        startDownload();
+    }
+    else {
+        // Try the same link once more before asking the service plugin for a new one
+        if (m_retries > 1) {
+            clearCachedRequest();
+        }
+
+        if ((hasCachedRequest()) || ((m_retries == 1) && (!m_cachedRequestUrl.isEmpty()))) {
+            startCachedDownload();
+        }
+        else {
+            startPluginDownload();
+        }
+    }
+}
+
+void Transfer::requeue() {
+    if ((status() == Downloading) && (m_reply) && (m_reply->isRunning())) {
+        // The download is resumed when the transfer is next started
+        m_requeue = true;
+        m_reply->abort();
+    }
+}
+
+void Transfer::onDownloadRequest(QNetworkRequest request, const QByteArray &method, const QByteArray &data) {
+    QDL_LOG_TRANSFER(Logger::LowVerbosity, id(), pluginId(),
+                     QString("Transfer::onDownloadRequest(). URL: %1, Method: %2, Data: %3")
+                     .arg(request.url().toString()).arg(QString::fromUtf8(method)).arg(QString::fromUtf8(data)));
+    setCachedRequest(request, method, data);
+    m_usingCachedRequest = false;
+    sendDownloadRequest(request, method, data);
+}
+
 void Transfer::onDownloadRequestCaptchaTimeoutChanged() {
     emit dataChanged(this, CaptchaTimeoutRole);
 }
@@ -1089,6 +1382,18 @@ void Transfer::onDownloadRequestError(const QString &errorString) {
 }
 
 void Transfer::onReplyMetaDataChanged() {
+    if ((m_usingCachedRequest) && (!m_metadataSet) && (cachedRequestRejected())) {
+        QDL_LOG_TRANSFER(Logger::LowVerbosity, id(), pluginId(),
+                         "Transfer::onReplyMetaDataChanged(): Cached download request rejected. Using service plugin");
+        disconnect(m_reply, 0, this, 0);
+        m_reply->abort();
+        m_reply->deleteLater();
+        m_reply = 0;
+        clearCachedRequest();
+        startPluginDownload();
+        return;
+    }
+
     if ((m_metadataSet) || (m_reply->error() != QNetworkReply::NoError)
         || (!m_reply->rawHeader("Location").isEmpty())) {
         return;
@@ -1100,8 +1405,8 @@ void Transfer::onReplyMetaDataChanged() {
         bytes = m_reply->rawHeader("Content-Length").toLongLong();
     }
 
-    Logger::log("Transfer::onReplyMetadataChanged(): Content-Length: " + QString::number(bytes),
-                Logger::MediumVerbosity);
+    QDL_LOG_TRANSFER(Logger::MediumVerbosity, id(), pluginId(),
+                     "Transfer::onReplyMetadataChanged(): Content-Length: " + QString::number(bytes));
     
     if (bytes > 0) {
         setSize(bytes + bytesTransferred());
@@ -1111,13 +1416,15 @@ void Transfer::onReplyMetaDataChanged() {
         // Only set the filename if no data has been written
         const QString contentDisposition =
         QString::fromUtf8(QByteArray::fromPercentEncoding(m_reply->rawHeader("Content-Disposition"))).remove('"');
-        Logger::log("Transfer::onReplyMetadataChanged(): Content-Disposition: " + contentDisposition);
+        QDL_LOG_TRANSFER(Logger::LowestVerbosity, id(), pluginId(),
+                         "Transfer::onReplyMetadataChanged(): Content-Disposition: " + contentDisposition);
         
         if ((!contentDisposition.isEmpty()) && (CONTENT_DISPOSITION_REGEXP.indexIn(contentDisposition) != -1)) {
             const QString fileName = CONTENT_DISPOSITION_REGEXP.cap(2);
             
             if (!fileName.isEmpty()) {
-                Logger::log("Transfer::onReplyMetadataChanged(): Found filename: " + fileName, Logger::MediumVerbosity);
+                QDL_LOG_TRANSFER(Logger::MediumVerbosity, id(), pluginId(),
+                                 "Transfer::onReplyMetadataChanged(): Found filename: " + fileName);
                 setFileName(Utils::getSanitizedFileName(fileName));
             }
         }
@@ -1137,7 +1444,7 @@ void Transfer::onReplyReadyRead() {
         return;
     }
 
-    if ((!openFile()) || (m_file->write(m_reply->read(bytes)) == -1)) {
+    if ((!openFile()) || (writeData(m_file, m_reply->read(bytes)) == -1)) {
         m_reply->deleteLater();
         m_reply = 0;
         setErrorString(tr("Cannot write to file - %1").arg(m_file->errorString()));
@@ -1145,6 +1452,8 @@ void Transfer::onReplyReadyRead() {
         return;
     }
     
+    // The connection is working again, so a later failure starts a fresh series of retries
+    m_retries = 0;
     setSpeed(int(bytes) * 1000 / qMax(1, m_speedTime.restart()));
     emit dataChanged(this, BytesTransferredRole);
 }
@@ -1172,11 +1481,15 @@ void Transfer::onReplyFinished() {
     const QNetworkReply::NetworkError error = m_reply->error();
     const QString errorString = m_reply->errorString();
 
+    // A rejected cached request is handled in onReplyMetaDataChanged(), which is always called first for a reply
+    // with a status code
+    m_usingCachedRequest = false;
+
     if ((m_reply->isOpen()) && (error == QNetworkReply::NoError) && (openFile())) {
         const qint64 bytes = m_reply->bytesAvailable();
         
         if ((bytes > 0) && (m_metadataSet)) {
-            m_file->write(m_reply->read(bytes));
+            writeData(m_file, m_reply->read(bytes));
             emit dataChanged(this, BytesTransferredRole);
         }
     }
@@ -1198,16 +1511,87 @@ void Transfer::onReplyFinished() {
                 setStatus(Canceled);
             }
         }
+        else if (m_requeue) {
+            m_requeue = false;
+            setStatus(Queued);
+        }
+        else if (!m_reconnectReason.isEmpty()) {
+            const QString reason = m_reconnectReason;
+            m_reconnectReason.clear();
+            scheduleRetry(reason);
+        }
         else {
             setStatus(Paused);
         }
 
         return;
     default:
-        setErrorString(errorString);
-        setStatus(Failed);
+        if (isRetryableError(error)) {
+            scheduleRetry(errorString);
+        }
+        else {
+            setErrorString(errorString);
+            setStatus(Failed);
+        }
+        
         return;
     }
 
     setStatus(Completed);
 }
+
+void Transfer::onMonitorTimeout() {
+    if (m_retryPending) {
+        if (m_retryTime.elapsed() >= m_retryDelay) {
+            retry();
+        }
+        else {
+            emit dataChanged(this, WaitTimeRole);
+        }
+
+        return;
+    }
+
+    if ((status() != Downloading) || (!m_reply) || (!m_reply->isRunning())) {
+        return;
+    }
+
+    const qint64 bytes = bytesTransferred() + m_reply->bytesAvailable();
+
+    if (bytes > m_progressBytes) {
+        m_progressBytes = bytes;
+        m_progressTime.start();
+    }
+    else {
+        const int stallTimeout = Settings::stallTimeout();
+
+        if ((stallTimeout > 0) && (m_progressTime.elapsed() >= stallTimeout * 1000)) {
+            reconnect(tr("No data received for %1 seconds").arg(stallTimeout));
+            return;
+        }
+    }
+
+    const int minimumSpeed = Settings::minimumTransferSpeed();
+    const int slowTimeout = Settings::slowTransferTimeout();
+
+    if ((minimumSpeed > 0) && (slowTimeout > 0) && (m_slowTime.elapsed() >= slowTimeout * 1000)) {
+        const qint64 speed = (bytes - m_slowBytes) * 1000 / qMax(1, m_slowTime.elapsed());
+
+        if (speed < minimumSpeed) {
+            // Slow transfers still receive data, so they are counted separately from the retries.
+            // Once the reconnects are used up, a slow transfer is left to continue
+            if (m_slowReconnects < Settings::maximumTransferRetries()) {
+                m_slowReconnects++;
+                reconnect(tr("Transfer speed below %1/s for %2 seconds").arg(Utils::formatBytes(minimumSpeed))
+                          .arg(slowTimeout));
+                return;
+            }
+        }
+        else {
+            m_slowReconnects = 0;
+        }
+
+        m_slowBytes = bytes;
+        m_slowTime.start();
+    }
+}
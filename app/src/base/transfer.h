@@ -19,6 +19,7 @@
 
 #include "downloadrequester.h"
 #include "transferitem.h"
+#include <QDateTime>
 #include <QNetworkRequest>
 #include <QTime>
 #include <QUrl>
@@ -26,6 +27,7 @@
 class QFile;
 class QNetworkAccessManager;
 class QNetworkReply;
+class QTimer;
 
 class Transfer : public TransferItem
 {
@@ -34,6 +36,7 @@ class Transfer : public TransferItem
     Q_PROPERTY(QString customCommand READ customCommand WRITE setCustomCommand)
     Q_PROPERTY(bool customCommandOverrideEnabled READ customCommandOverrideEnabled
                WRITE setCustomCommandOverrideEnabled)
+    Q_PROPERTY(QDateTime deadline READ deadline WRITE setDeadline)
     Q_PROPERTY(QString downloadPath READ downloadPath WRITE setDownloadPath)
     Q_PROPERTY(QString fileName READ fileName WRITE setFileName)
     Q_PROPERTY(QString filePath READ filePath WRITE setFilePath)
@@ -86,10 +89,15 @@ public:
     virtual bool canPause() const;
     virtual bool canCancel() const;
 
+    virtual void hold(const QString &reason);
+
     QString customCommand() const;
     void setCustomCommand(const QString &c);
     bool customCommandOverrideEnabled() const;
     void setCustomCommandOverrideEnabled(bool enabled);
+
+    QDateTime deadline() const;
+    void setDeadline(const QDateTime &d);
     
     QString downloadPath() const;
     void setDownloadPath(const QString &p);
@@ -165,6 +173,8 @@ public Q_SLOTS:
     bool submitSettingsResponse(const QVariantMap &settings);
 
 private Q_SLOTS:
+    void requeue();
+
     void onDownloadRequest(QNetworkRequest request, const QByteArray &method, const QByteArray &data);
     void onDownloadRequestCaptchaTimeoutChanged();
     void onDownloadRequestRequestedSettingsTimeoutChanged();
@@ -176,6 +186,8 @@ private Q_SLOTS:
     void onReplyReadyRead();
     void onReplyFinished();
 
+    void onMonitorTimeout();
+
 private:
     void setPluginIconPath(const QString &p);
     void setPluginId(const QString &i);
@@ -193,12 +205,26 @@ private:
     void initNetworkAccessManager();
     void initRequester();
 
+    bool hasCachedRequest() const;
+    void setCachedRequest(const QNetworkRequest &request, const QByteArray &method, const QByteArray &data);
+    void clearCachedRequest();
+    bool cachedRequestRejected() const;
+
     bool openBuffer(const QByteArray &data);
     bool openFile();
 
     void startDownload();
+    void startCachedDownload();
+    void startPluginDownload();
+    void sendDownloadRequest(QNetworkRequest request, const QByteArray &method, const QByteArray &data);
     void followRedirect(const QUrl &url);
 
+    void startMonitor();
+    void stopMonitor();
+    void reconnect(const QString &reason);
+    void scheduleRetry(const QString &reason);
+    void retry();
+
     void deleteFile();
     
     static const QRegExp CONTENT_DISPOSITION_REGEXP;
@@ -209,6 +235,7 @@ private:
     QFile *m_file;
 
     QString m_customCommand;
+    QDateTime m_deadline;
     QString m_downloadPath;
     QString m_fileName;
     QString m_id;
@@ -222,6 +249,18 @@ private:
 
     QTime m_speedTime;
 
+    QTimer *m_monitorTimer;
+    QTime m_progressTime;
+    QTime m_slowTime;
+    QTime m_retryTime;
+    qint64 m_progressBytes;
+    qint64 m_slowBytes;
+    int m_retries;
+    int m_slowReconnects;
+    int m_retryDelay;
+    bool m_retryPending;
+    QString m_reconnectReason;
+
     Status m_status;
 
     QString m_postData;
@@ -235,10 +274,18 @@ private:
     QString m_servicePluginName;
     QString m_servicePluginIcon;
 
+    QUrl m_cachedRequestUrl;
+    QVariantMap m_cachedRequestHeaders;
+    QByteArray m_cachedRequestMethod;
+    QByteArray m_cachedRequestData;
+    QDateTime m_cachedRequestExpiry;
+
     bool m_customCommandOverrideEnabled;
     bool m_usePlugins;
     bool m_metadataSet;
     bool m_deleteFiles;
+    bool m_usingCachedRequest;
+    bool m_requeue;
 
     int m_redirects;
 };
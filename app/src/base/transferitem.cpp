@@ -37,6 +37,7 @@ public:
         insert(TransferItem::CreateSubfolderRole, "createSubfolder");
         insert(TransferItem::CustomCommandRole, "customCommand");
         insert(TransferItem::CustomCommandOverrideEnabledRole, "customCommandOverrideEnabled");
+        insert(TransferItem::DeadlineRole, "deadline");
         insert(TransferItem::DownloadPathRole, "downloadPath");
         insert(TransferItem::ErrorStringRole, "errorString");
         insert(TransferItem::ExpandedRole, "expanded");
@@ -388,6 +389,8 @@ bool TransferItem::canCancel() const {
     return true;
 }
 
+void TransferItem::hold(const QString &) {}
+
 bool TransferItem::queue() {
     foreach (TransferItem *child, m_childItems) {
         child->queue();
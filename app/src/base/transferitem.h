@@ -67,6 +67,7 @@ public:
         CreateSubfolderRole,
         CustomCommandRole,
         CustomCommandOverrideEnabledRole,
+        DeadlineRole,
         DownloadPathRole,
         ErrorStringRole,
         ExpandedRole,
@@ -155,6 +156,11 @@ public:
     virtual bool canPause() const;
     virtual bool canCancel() const;
 
+    /**
+     * Keeps a queued item waiting, reporting reason as its error string. The default implementation does nothing.
+     */
+    virtual void hold(const QString &reason);
+
     bool expanded() const;
     void setExpanded(bool enabled);
 
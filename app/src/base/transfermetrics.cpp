@@ -0,0 +1,248 @@
+/*
+ * Copyright (C) 2016 Stuart Howarth <showarth@marxoft.co.uk>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "transfermetrics.h"
+#include "metrics.h"
+#include "transfermodel.h"
+#include <QUrl>
+
+static bool isPostProcessing(int status) {
+    return (status == TransferItem::ExtractingArchive) || (status == TransferItem::MovingFiles)
+           || (status == TransferItem::ExecutingCustomCommand);
+}
+
+TransferMetrics* TransferMetrics::self = 0;
+
+TransferMetrics::TransferMetrics() :
+    QObject(),
+    m_postProcessing(0)
+{
+    TransferModel *model = TransferModel::instance();
+    connect(model, SIGNAL(itemDataChanged(TransferItem*, int)), this, SLOT(onItemDataChanged(TransferItem*, int)));
+    connect(model, SIGNAL(rowsInserted(QModelIndex, int, int)), this, SLOT(onRowsInserted(QModelIndex, int, int)));
+    connect(model, SIGNAL(rowsAboutToBeRemoved(QModelIndex, int, int)),
+            this, SLOT(onRowsAboutToBeRemoved(QModelIndex, int, int)));
+    connect(model, SIGNAL(rowsMoved(QModelIndex, int, int, QModelIndex, int)), this, SLOT(onRowsMoved()));
+    connect(model, SIGNAL(modelReset()), this, SLOT(onModelReset()));
+    onModelReset();
+}
+
+TransferMetrics::~TransferMetrics() {
+    self = 0;
+}
+
+TransferMetrics* TransferMetrics::instance() {
+    return self ? self : self = new TransferMetrics;
+}
+
+void TransferMetrics::onItemDataChanged(TransferItem *item, int role) {
+    if (!m_items.contains(item)) {
+        return;
+    }
+
+    Item &state = m_items[item];
+
+    switch (role) {
+    case TransferItem::BytesTransferredRole: {
+        const qint64 bytes = item->data(TransferItem::BytesTransferredRole).toLongLong();
+
+        // The count restarts if a download cannot be resumed, and nothing is added
+        if (bytes > state.bytes) {
+            Metrics::instance()->increment("qdl_downloaded_bytes_total", labels(item, state), bytes - state.bytes);
+        }
+
+        state.bytes = bytes;
+        break;
+    }
+    case TransferItem::StatusRole:
+        setStatus(item, state, item->data(TransferItem::StatusRole).toInt());
+        updateGauges();
+        break;
+    case TransferItem::CategoryRole:
+        // Transfers inherit the category of their package
+        for (int i = 0; i < item->rowCount(); i++) {
+            TransferItem *transfer = item->childItem(i);
+
+            if (m_items.contains(transfer)) {
+                m_items[transfer].labels.clear();
+            }
+        }
+
+        state.labels.clear();
+        break;
+    case TransferItem::PluginIdRole:
+    case TransferItem::UrlRole:
+        state.labels.clear();
+        break;
+    default:
+        break;
+    }
+}
+
+void TransferMetrics::onRowsInserted(const QModelIndex &parent, int first, int last) {
+    TransferModel *model = TransferModel::instance();
+
+    for (int i = first; i <= last; i++) {
+        if (TransferItem *item = model->get(model->index(i, 0, parent))) {
+            addItem(item);
+
+            for (int j = 0; j < item->rowCount(); j++) {
+                addItem(item->childItem(j));
+            }
+        }
+    }
+
+    updateGauges();
+}
+
+void TransferMetrics::onRowsAboutToBeRemoved(const QModelIndex &parent, int first, int last) {
+    TransferModel *model = TransferModel::instance();
+
+    for (int i = first; i <= last; i++) {
+        if (TransferItem *item = model->get(model->index(i, 0, parent))) {
+            for (int j = 0; j < item->rowCount(); j++) {
+                removeItem(item->childItem(j));
+            }
+
+            removeItem(item);
+        }
+    }
+
+    updateGauges();
+}
+
+void TransferMetrics::onRowsMoved() {
+    // A transfer moved to another package may have a different category
+    QMutableHashIterator<TransferItem*, Item> iterator(m_items);
+
+    while (iterator.hasNext()) {
+        iterator.next().value().labels.clear();
+    }
+}
+
+void TransferMetrics::onModelReset() {
+    m_items.clear();
+    m_statusCounts.clear();
+    m_postProcessing = 0;
+    const TransferItem *root = TransferModel::instance()->get(QModelIndex());
+
+    for (int i = 0; i < root->rowCount(); i++) {
+        TransferItem *package = root->childItem(i);
+        addItem(package);
+
+        for (int j = 0; j < package->rowCount(); j++) {
+            addItem(package->childItem(j));
+        }
+    }
+
+    updateGauges();
+}
+
+void TransferMetrics::addItem(TransferItem *item) {
+    if (m_items.contains(item)) {
+        return;
+    }
+
+    Item &state = m_items[item];
+    state.bytes = item->data(TransferItem::BytesTransferredRole).toLongLong();
+    state.status = TransferItem::Null;
+    setStatus(item, state, item->data(TransferItem::StatusRole).toInt());
+}
+
+void TransferMetrics::removeItem(TransferItem *item) {
+    if (!m_items.contains(item)) {
+        return;
+    }
+
+    Item &state = m_items[item];
+    setStatus(item, state, TransferItem::Null);
+    m_items.remove(item);
+}
+
+void TransferMetrics::setStatus(TransferItem *item, Item &state, int status) {
+    const int previous = state.status;
+
+    if (status == previous) {
+        return;
+    }
+
+    if (item->itemType() == TransferItem::PackageType) {
+        m_postProcessing += (isPostProcessing(status) ? 1 : 0) - (isPostProcessing(previous) ? 1 : 0);
+    }
+    else {
+        m_statusCounts[previous]--;
+        m_statusCounts[status]++;
+
+        if (status == TransferItem::AwaitingCaptchaResponse) {
+            Metrics::instance()->increment("qdl_captcha_requests_total", pluginLabel(item));
+            state.captchaTimer.start();
+        }
+        else if ((status == TransferItem::SubmittingCaptchaResponse) && (state.captchaTimer.isValid())) {
+            Metrics::instance()->observe("qdl_captcha_solve_seconds", pluginLabel(item),
+                                         state.captchaTimer.elapsed() / 1000.0);
+            state.captchaTimer.invalidate();
+        }
+
+        if ((previous == TransferItem::Connecting) && (status > TransferItem::Connecting)
+            && (status != TransferItem::Canceling) && (state.statusTimer.isValid())) {
+            // The service plugin has returned a download request, a captcha or a wait
+            Metrics::instance()->observe("qdl_link_resolution_seconds", pluginLabel(item),
+                                         state.statusTimer.elapsed() / 1000.0);
+        }
+    }
+
+    state.status = status;
+    state.statusTimer.start();
+}
+
+QString TransferMetrics::labels(TransferItem *item, Item &state) const {
+    if (state.labels.isEmpty()) {
+        QString category = item->data(TransferItem::CategoryRole).toString();
+
+        if ((category.isEmpty()) && (item->parentItem())) {
+            category = item->parentItem()->data(TransferItem::CategoryRole).toString();
+        }
+
+        state.labels = pluginLabel(item) + ","
+                       + Metrics::label("host", QUrl(item->data(TransferItem::UrlRole).toString()).host()) + ","
+                       + Metrics::label("category", category);
+    }
+
+    return state.labels;
+}
+
+QString TransferMetrics::pluginLabel(TransferItem *item) {
+    return Metrics::label("plugin", item->data(TransferItem::PluginIdRole).toString());
+}
+
+void TransferMetrics::updateGauges() {
+    int active = 0;
+    QHashIterator<int, int> iterator(m_statusCounts);
+
+    while (iterator.hasNext()) {
+        iterator.next();
+
+        if (iterator.key() > TransferItem::Queued) {
+            active += iterator.value();
+        }
+    }
+
+    Metrics *metrics = Metrics::instance();
+    metrics->setGauge("qdl_transfers_active", QString(), active);
+    metrics->setGauge("qdl_transfers_queued", QString(), m_statusCounts.value(TransferItem::Queued));
+    metrics->setGauge("qdl_transfers_failed", QString(), m_statusCounts.value(TransferItem::Failed));
+    metrics->setGauge("qdl_postprocessing_queue_depth", QString(), m_postProcessing);
+}
@@ -0,0 +1,76 @@
+/*
+ * Copyright (C) 2016 Stuart Howarth <showarth@marxoft.co.uk>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TRANSFERMETRICS_H
+#define TRANSFERMETRICS_H
+
+#include <QObject>
+#include <QElapsedTimer>
+#include <QHash>
+
+class TransferItem;
+class QModelIndex;
+
+/**
+ * Keeps the transfer metrics up to date by following changes to the transfer model, so that they never
+ * require a walk of the model to be exported.
+ */
+class TransferMetrics : public QObject
+{
+    Q_OBJECT
+
+public:
+    ~TransferMetrics();
+
+    static TransferMetrics* instance();
+
+private Q_SLOTS:
+    void onItemDataChanged(TransferItem *item, int role);
+    void onRowsInserted(const QModelIndex &parent, int first, int last);
+    void onRowsAboutToBeRemoved(const QModelIndex &parent, int first, int last);
+    void onRowsMoved();
+    void onModelReset();
+
+private:
+    struct Item {
+        Item() : status(0), bytes(0) {}
+
+        int status;
+        qint64 bytes;
+        QString labels;
+        QElapsedTimer statusTimer;
+        QElapsedTimer captchaTimer;
+    };
+
+    TransferMetrics();
+
+    void addItem(TransferItem *item);
+    void removeItem(TransferItem *item);
+    void setStatus(TransferItem *item, Item &state, int status);
+
+    QString labels(TransferItem *item, Item &state) const;
+    static QString pluginLabel(TransferItem *item);
+
+    void updateGauges();
+
+    static TransferMetrics *self;
+
+    QHash<TransferItem*, Item> m_items;
+    QHash<int, int> m_statusCounts;
+    int m_postProcessing;
+};
+
+#endif // TRANSFERMETRICS_H
@@ -15,16 +15,19 @@
  */
 
 #include "transfermodel.h"
+#include "concurrencycontroller.h"
 #include "definitions.h"
 #include "logger.h"
 #include "package.h"
 #include "qdl.h"
+#include "schedulingpolicy.h"
 #include "settings.h"
 #include "transfer.h"
 #include "utils.h"
 #include <QDataStream>
 #include <QIcon>
 #include <QMimeData>
+#include <QRect>
 #include <QSettings>
 #include <QTimer>
 
@@ -32,10 +35,20 @@ TransferModel* TransferModel::self = 0;
 
 const QString TransferModel::MIME_TYPE("application/x-qdl2transfermodeldatalist");
 
+// The number of removed item ids retained for revisioned queries
+static const int MAX_REMOVED_ITEMS = 1000;
+
 TransferModel::TransferModel() :
     QAbstractItemModel(),
     m_packages(new TransferItem(this)),
-    m_queueTimer(new QTimer(this))
+    m_queueTimer(new QTimer(this)),
+    m_diskSpaceTimer(new QTimer(this)),
+    m_concurrency(new ConcurrencyController(this)),
+    m_revision(1),
+    m_baseRevision(1),
+    m_removedBaseRevision(0),
+    m_structureRevision(1),
+    m_batchDepth(0)
 {
 #if QT_VERSION < 0x050000
     setRoleNames(TransferItem::roleNames());
@@ -43,8 +56,16 @@ TransferModel::TransferModel() :
     m_queueTimer->setInterval(1000);
     m_queueTimer->setSingleShot(true);
     connect(m_queueTimer, SIGNAL(timeout()), this, SLOT(startNextTransfers()));
-    connect(Settings::instance(), SIGNAL(maximumConcurrentTransfersChanged(int)),
-            this, SLOT(onMaximumConcurrentTransfersChanged(int)));
+    m_diskSpaceTimer->setInterval(30000);
+    m_diskSpaceTimer->setSingleShot(true);
+    connect(m_diskSpaceTimer, SIGNAL(timeout()), this, SLOT(startNextTransfers()));
+    connect(m_concurrency, SIGNAL(maximumChanged(int)), this, SLOT(onMaximumConcurrentTransfersChanged(int)));
+    connect(this, SIGNAL(rowsInserted(QModelIndex, int, int)), this, SLOT(onRowsInserted(QModelIndex, int, int)));
+    connect(this, SIGNAL(rowsAboutToBeRemoved(QModelIndex, int, int)),
+            this, SLOT(onRowsAboutToBeRemoved(QModelIndex, int, int)));
+    connect(this, SIGNAL(rowsMoved(QModelIndex, int, int, QModelIndex, int)),
+            this, SLOT(onRowsMoved(QModelIndex, int, int, QModelIndex, int)));
+    connect(this, SIGNAL(modelReset()), this, SLOT(onModelReset()));
 }
 
 TransferModel::~TransferModel() {
@@ -335,8 +356,9 @@ bool TransferModel::setItemData(const QVariant &index, const QVariantMap &data)
 
 bool TransferModel::moveRows(const QModelIndex &sourceParent, int sourceRow, int count,
                              const QModelIndex &destinationParent, int destinationChild) {
-    Logger::log(QString("TransferModel::moveRows(): sourceParent: %1, sourceRow: %2, count: %3, destinationParent: %4, destinationChild: %5").arg(sourceParent.row()).arg(sourceRow).arg(count).arg(destinationParent.row())
-                     .arg(destinationChild), Logger::HighVerbosity);
+    QDL_LOG(Logger::HighVerbosity,
+            QString("TransferModel::moveRows(): sourceParent: %1, sourceRow: %2, count: %3, destinationParent: %4, destinationChild: %5").arg(sourceParent.row()).arg(sourceRow).arg(count).arg(destinationParent.row())
+            .arg(destinationChild));
     if ((sourceRow < 0) || (sourceRow + count > rowCount(sourceParent))
         || (destinationChild < 0) || (destinationChild > rowCount(destinationParent))) {
         return false;
@@ -344,8 +366,8 @@ bool TransferModel::moveRows(const QModelIndex &sourceParent, int sourceRow, int
     
     const int sourceParentType = data(sourceParent, TransferItem::ItemTypeRole).toInt();
     const int destinationParentType = data(destinationParent, TransferItem::ItemTypeRole).toInt();
-    Logger::log(QString("TransferModel::moveRows(): sourceParentType: %1, destinationParentType: %2")
-                       .arg(sourceParentType).arg(destinationParentType), Logger::HighVerbosity);
+    QDL_LOG(Logger::HighVerbosity, QString("TransferModel::moveRows(): sourceParentType: %1, destinationParentType: %2")
+            .arg(sourceParentType).arg(destinationParentType));
 
     if ((sourceParentType != destinationParentType) || (sourceParentType == TransferItem::TransferType)
         || (destinationParentType == TransferItem::TransferType)) {
@@ -387,6 +409,18 @@ int TransferModel::activeTransfers() const {
     return m_activeTransfers.size();
 }
 
+TransferItem* TransferModel::activeTransfer(int i) const {
+    return m_activeTransfers.value(i);
+}
+
+int TransferModel::maximumConcurrentTransfers() const {
+    return m_concurrency->maximum();
+}
+
+QVariantMap TransferModel::concurrencyStatus() const {
+    return m_concurrency->status();
+}
+
 int TransferModel::totalSpeed() const {
     int speed = 0;
 
@@ -401,6 +435,102 @@ QString TransferModel::totalSpeedString() const {
     return Utils::formatBytes(totalSpeed()) + "/s";
 }
 
+qint64 TransferModel::revision() const {
+    return m_revision;
+}
+
+qint64 TransferModel::itemRevision(const TransferItem *item) const {
+    return m_itemRevisions.value(item->data(TransferItem::IdRole).toString(), m_baseRevision);
+}
+
+// The last revision at which items were inserted, removed or moved
+qint64 TransferModel::structureRevision() const {
+    return m_structureRevision;
+}
+
+// Returns the items changed after revision, in the order they were last changed
+QList<const TransferItem*> TransferModel::changedSince(qint64 revision) const {
+    QList<const TransferItem*> items;
+
+    for (QMap<qint64, const TransferItem*>::const_iterator iterator = m_changedItems.upperBound(revision);
+         iterator != m_changedItems.constEnd(); ++iterator) {
+        items << iterator.value();
+    }
+
+    return items;
+}
+
+bool TransferModel::hasRevisionHistory(qint64 revision) const {
+    return (revision >= m_removedBaseRevision) && (revision <= m_revision);
+}
+
+QStringList TransferModel::removedSince(qint64 revision) const {
+    QStringList ids;
+
+    for (int i = m_removedItems.size() - 1; i >= 0; i--) {
+        const QPair<qint64, QString> &removed = m_removedItems.at(i);
+
+        if (removed.first <= revision) {
+            break;
+        }
+
+        ids << removed.second;
+    }
+
+    return ids;
+}
+
+// Defers dataChanged() until the matching endBatch(), so that many changes are reported as one range per parent
+void TransferModel::beginBatch() {
+    m_batchDepth++;
+}
+
+void TransferModel::endBatch() {
+    if ((m_batchDepth == 0) || (--m_batchDepth > 0)) {
+        return;
+    }
+
+    // The changed rows and columns of each parent
+    QHash<TransferItem*, QRect> ranges;
+
+    for (int i = 0; i < m_batchChanges.size(); i++) {
+        const QPair<QPointer<TransferItem>, int> &change = m_batchChanges.at(i);
+
+        if (!change.first) {
+            continue;
+        }
+
+        TransferItem *parent = change.first->parentItem();
+
+        if ((!parent) || ((parent != m_packages) && (!parent->parentItem()))) {
+            // Removed during the batch
+            continue;
+        }
+
+        const QRect cell(change.second, change.first->row(), 1, 1);
+        ranges[parent] = ranges.contains(parent) ? ranges.value(parent).united(cell) : cell;
+    }
+
+    m_batchChanges.clear();
+    QHashIterator<TransferItem*, QRect> iterator(ranges);
+
+    while (iterator.hasNext()) {
+        iterator.next();
+        const QModelIndex parent = iterator.key() == m_packages ? QModelIndex()
+                                                                : index(iterator.key()->row(), 0, QModelIndex());
+        const QRect &range = iterator.value();
+        emit dataChanged(index(range.top(), range.left(), parent), index(range.bottom(), range.right(), parent));
+    }
+}
+
+qint64 TransferModel::removedBaseRevision() const {
+    return m_removedBaseRevision;
+}
+
+QList<QPair<qint64, QString> > TransferModel::removedItems() const {
+    return m_removedItems;
+}
+
 TransferItem* TransferModel::get(const QModelIndex &index) const {
     return index.isValid() ? static_cast<TransferItem*>(index.internalPointer()) : m_packages;
 }
@@ -412,7 +542,7 @@ TransferItem* TransferModel::get(const QVariant &index) const {
 TransferItem* TransferModel::append(const QString &url, const QString &requestMethod, const QVariantMap &requestHeaders,
         const QString &postData, const QString &category, bool createSubfolder, int priority, const QString &customCommand,
         bool overrideGlobalCommand, bool startAutomatically) {
-    Logger::log("TransferModel::append(): " + url + " " + requestMethod, Logger::LowVerbosity);
+    QDL_LOG(Logger::LowVerbosity, "TransferModel::append(): " + url + " " + requestMethod);
     const QString fileName = url.mid(url.lastIndexOf("/") + 1);
     TransferItem *package = findPackage(fileName);
 
@@ -429,7 +559,7 @@ TransferItem* TransferModel::append(const QString &url, const QString &requestMe
 
     const int transferCount = package->rowCount();
     const QString transferId = Utils::createId();
-    Logger::log("TransferModel::append(): Creating transfer " + transferId, Logger::MediumVerbosity);
+    QDL_LOG(Logger::MediumVerbosity, "TransferModel::append(): Creating transfer " + transferId);
     Transfer *transfer = new Transfer(package);
     transfer->setCustomCommand(customCommand);
     transfer->setCustomCommandOverrideEnabled(overrideGlobalCommand);
@@ -471,7 +601,7 @@ QList<TransferItem*> TransferModel::append(const QStringList &urls, const QStrin
 
 TransferItem* TransferModel::append(const UrlResult &result, const QString &category, bool createSubfolder,
         int priority, const QString &customCommand, bool overrideGlobalCommand, bool startAutomatically) {
-    Logger::log("TransferModel::append(): " + result.url + " " + result.fileName, Logger::LowVerbosity);
+    QDL_LOG(Logger::LowVerbosity, "TransferModel::append(): " + result.url + " " + result.fileName);
     TransferItem *package = findPackage(result.fileName);
 
     if (!package) {
@@ -487,7 +617,7 @@ TransferItem* TransferModel::append(const UrlResult &result, const QString &cate
 
     const int transferCount = package->rowCount();
     const QString transferId = Utils::createId();
-    Logger::log("TransferModel::append(): Creating transfer " + transferId, Logger::MediumVerbosity);
+    QDL_LOG(Logger::MediumVerbosity, "TransferModel::append(): Creating transfer " + transferId);
     Transfer *transfer = new Transfer(package);
     transfer->setCustomCommand(customCommand);
     transfer->setCustomCommandOverrideEnabled(overrideGlobalCommand);
@@ -516,11 +646,11 @@ QList<TransferItem*> TransferModel::append(const UrlResultList &results, const Q
     QList<TransferItem*> transfers;
 
     if (results.isEmpty()) {
-        Logger::log("TransferModel::append(). URL list is empty for package " + packageName, Logger::LowVerbosity);
+        QDL_LOG(Logger::LowVerbosity, "TransferModel::append(). URL list is empty for package " + packageName);
         return transfers;
     }
     
-    Logger::log("TransferModel::append(): " + packageName, Logger::LowVerbosity);
+    QDL_LOG(Logger::LowVerbosity, "TransferModel::append(): " + packageName);
     TransferItem *package = createPackage(packageName);
     package->setData(TransferItem::CategoryRole, category);
     package->setData(TransferItem::CreateSubfolderRole, createSubfolder);
@@ -533,7 +663,7 @@ QList<TransferItem*> TransferModel::append(const UrlResultList &results, const Q
     for (int i = 0; i < results.size(); i++) {
         const int transferCount = package->rowCount();
         const QString transferId = Utils::createId();
-        Logger::log("TransferModel::append(): Creating transfer " + transferId, Logger::MediumVerbosity);
+        QDL_LOG(Logger::MediumVerbosity, "TransferModel::append(): Creating transfer " + transferId);
         Transfer *transfer = new Transfer(package);
         transfer->setCustomCommand(customCommand);
         transfer->setCustomCommandOverrideEnabled(overrideGlobalCommand);
@@ -575,7 +705,7 @@ void TransferModel::pause() {
 
 void TransferModel::restore() {    
     if (m_packages->rowCount() > 0) {
-        Logger::log("TransferModel::restore(). No packages restored", Logger::LowVerbosity);
+        QDL_LOG(Logger::LowVerbosity, "TransferModel::restore(). No packages restored");
         return;
     }
     
@@ -591,16 +721,16 @@ void TransferModel::restore() {
 
     for (int i = 0; i < packageCount; i++) {
         settings.setArrayIndex(i);
-        Logger::log("TransferModel::restore(): Restoring package " + settings.value("id").toString(),
-                    Logger::MediumVerbosity);
+        QDL_LOG(Logger::MediumVerbosity,
+                "TransferModel::restore(): Restoring package " + settings.value("id").toString());
         Package *package = new Package(m_packages);
         package->restore(settings);
         const int transferCount = settings.beginReadArray("transfers");
 
         for (int j = 0; j < transferCount; j++) {
             settings.setArrayIndex(j);
-            Logger::log("TransferModel::restore(): Restoring transfer " + settings.value("id").toString(),
-                        Logger::MediumVerbosity);
+            QDL_LOG(Logger::MediumVerbosity,
+                    "TransferModel::restore(): Restoring transfer " + settings.value("id").toString());
             Transfer *transfer = new Transfer(package);
             transfer->restore(settings);
             package->appendRow(transfer);
@@ -615,7 +745,7 @@ void TransferModel::restore() {
 
     settings.endArray();
     endResetModel();
-    Logger::log(QString("TransferModel::restore() %1 packages restored").arg(packageCount), Logger::LowVerbosity);
+    QDL_LOG(Logger::LowVerbosity, QString("TransferModel::restore() %1 packages restored").arg(packageCount));
 }
 
 void TransferModel::save() {
@@ -625,16 +755,16 @@ void TransferModel::save() {
 
     for (int i = 0; i < m_packages->rowCount(); i++) {
         if (TransferItem *package = m_packages->childItem(i)) {
-            Logger::log("TransferModel::save(): Saving package " + package->data(TransferItem::IdRole).toString(),
-                        Logger::MediumVerbosity);
+            QDL_LOG(Logger::MediumVerbosity,
+                    "TransferModel::save(): Saving package " + package->data(TransferItem::IdRole).toString());
             settings.setArrayIndex(i);
             package->save(settings);
             settings.beginWriteArray("transfers");
             
             for (int j = 0; j < package->rowCount(); j++) {
                 if (TransferItem *transfer = package->childItem(j)) {
-                    Logger::log("TransferModel::save(): Saving transfer "
-                                + transfer->data(TransferItem::IdRole).toString(), Logger::MediumVerbosity);
+                    QDL_LOG(Logger::MediumVerbosity, "TransferModel::save(): Saving transfer "
+                            + transfer->data(TransferItem::IdRole).toString());
                     settings.setArrayIndex(j);
                     transfer->save(settings);
                 }
@@ -645,12 +775,12 @@ void TransferModel::save() {
     }
 
     settings.endArray();
-    Logger::log(QString("TransferModel::save(). %1 packages saved").arg(m_packages->rowCount()), Logger::LowVerbosity);
+    QDL_LOG(Logger::LowVerbosity, QString("TransferModel::save(). %1 packages saved").arg(m_packages->rowCount()));
 }
 
 TransferItem* TransferModel::createPackage(const QString &fileName) {
     const QString packageId = Utils::createId();
-    Logger::log("TransferModel::createPackage(): Creating package " + packageId, Logger::MediumVerbosity);
+    QDL_LOG(Logger::MediumVerbosity, "TransferModel::createPackage(): Creating package " + packageId);
     Package *package = new Package(m_packages);
     package->setId(packageId);
     package->setCategory(Settings::defaultCategory());
@@ -679,7 +809,7 @@ TransferItem* TransferModel::createPackage(const QString &fileName) {
 
 TransferItem* TransferModel::findPackage(const QString &fileName) const {
     if (!Utils::isSplitArchive(fileName)) {
-        Logger::log("TransferModel::findPackage(). No package found for " + fileName, Logger::MediumVerbosity);
+        QDL_LOG(Logger::MediumVerbosity, "TransferModel::findPackage(). No package found for " + fileName);
         return 0;
     }
     
@@ -690,20 +820,130 @@ TransferItem* TransferModel::findPackage(const QString &fileName) const {
         if (TransferItem *package = m_packages->childItem(i)) {
             if ((package->data(TransferItem::NameRole).toString() == name)
                 && (package->data(TransferItem::SuffixRole).toString() == suffix)) {
-                Logger::log("TransferModel::findPackage(). Found package for " + fileName, Logger::MediumVerbosity);
+                QDL_LOG(Logger::MediumVerbosity, "TransferModel::findPackage(). Found package for " + fileName);
                 return package;
             }
         }
     }
 
-    Logger::log("TransferModel::findPackage(). No package found for " + fileName, Logger::MediumVerbosity);
+    QDL_LOG(Logger::MediumVerbosity, "TransferModel::findPackage(). No package found for " + fileName);
     return 0;
 }
 
+qint64 TransferModel::requiredDiskSpace(const TransferItem *transfer) const {
+    const qint64 size = transfer->data(TransferItem::SizeRole).toLongLong();
+
+    if (size <= 0) {
+        return 0;
+    }
+
+    qint64 required = qMax(qint64(0), size - transfer->data(TransferItem::BytesTransferredRole).toLongLong());
+
+    // Allow for the extracted contents, which are assumed to be no larger than the archive
+    if ((Settings::extractArchives()) && (Utils::isArchive(transfer->data(TransferItem::FileNameRole).toString()))) {
+        required += size;
+    }
+
+    return required;
+}
+
+QString TransferModel::storageVolume(const QString &path, DiskSpace &space) const {
+    const QHash<QString, QString>::const_iterator iterator = space.pathVolumes.constFind(path);
+
+    if (iterator != space.pathVolumes.constEnd()) {
+        return iterator.value();
+    }
+
+    const QString volume = Utils::storageVolume(path);
+    space.pathVolumes.insert(path, volume);
+    return volume;
+}
+
+// Sums the space reserved on each volume in one pass over the transfers
+TransferModel::DiskSpace TransferModel::diskSpace() const {
+    DiskSpace space;
+
+    foreach (const TransferItem *active, m_activeTransfers) {
+        const QString volume = storageVolume(active->data(TransferItem::DownloadPathRole).toString(), space);
+        space.volumes[volume].reserved += requiredDiskSpace(active);
+    }
+
+    if (Settings::extractArchives()) {
+        // Completed archives in unfinished packages have yet to be extracted
+        for (int i = 0; i < m_packages->rowCount(); i++) {
+            if (const TransferItem *package = m_packages->childItem(i)) {
+                switch (package->data(TransferItem::StatusRole).toInt()) {
+                case TransferItem::Completed:
+                case TransferItem::Canceled:
+                case TransferItem::CanceledAndDeleted:
+                    continue;
+                default:
+                    break;
+                }
+
+                for (int j = 0; j < package->rowCount(); j++) {
+                    const TransferItem *child = package->childItem(j);
+
+                    if ((child) && (child->data(TransferItem::StatusRole) == TransferItem::Completed)
+                        && (Utils::isArchive(child->data(TransferItem::FileNameRole).toString()))) {
+                        const QString volume =
+                            storageVolume(child->data(TransferItem::DownloadPathRole).toString(), space);
+                        space.volumes[volume].reserved += child->data(TransferItem::SizeRole).toLongLong();
+                    }
+                }
+            }
+        }
+    }
+
+    return space;
+}
+
+bool TransferModel::hasDiskSpace(TransferItem *transfer) {
+    if (requiredDiskSpace(transfer) == 0) {
+        return true;
+    }
+
+    DiskSpace space = diskSpace();
+    return hasDiskSpace(transfer, space);
+}
+
+bool TransferModel::hasDiskSpace(TransferItem *transfer, DiskSpace &space) {
+    const qint64 required = requiredDiskSpace(transfer);
+
+    if (required == 0) {
+        return true;
+    }
+
+    const QString path = transfer->data(TransferItem::DownloadPathRole).toString();
+    VolumeSpace &volume = space.volumes[storageVolume(path, space)];
+
+    if (!volume.measured) {
+        volume.available = Utils::bytesAvailable(path);
+        volume.measured = true;
+    }
+
+    if (volume.available < 0) {
+        return true;
+    }
+
+    // The reservation includes the transfer itself if it is already active
+    const qint64 reserved = m_activeTransfers.contains(transfer) ? volume.reserved - required : volume.reserved;
+
+    if (volume.available - reserved >= required) {
+        return true;
+    }
+
+    QDL_LOG(Logger::MediumVerbosity,
+            QString("TransferModel::hasDiskSpace(): Insufficient space for %1. Required: %2, Free: %3, Reserved: %4")
+            .arg(transfer->data(TransferItem::IdRole).toString()).arg(required).arg(volume.available).arg(reserved));
+    transfer->hold(tr("Insufficient disk space (%1 required)").arg(Utils::formatBytes(required)));
+    return false;
+}
+
 void TransferModel::addActiveTransfer(TransferItem *transfer) {
     if (!m_activeTransfers.contains(transfer)) {
-        Logger::log("TransferModel::addActiveTransfer(): " + transfer->data(TransferItem::IdRole).toString(),
-                    Logger::MediumVerbosity);
+        QDL_LOG(Logger::MediumVerbosity,
+                "TransferModel::addActiveTransfer(): " + transfer->data(TransferItem::IdRole).toString());
         m_activeTransfers.append(transfer);
         transfer->start();
         emit activeTransfersChanged(activeTransfers());
@@ -712,25 +952,53 @@ void TransferModel::addActiveTransfer(TransferItem *transfer) {
 }
 
 void TransferModel::removeActiveTransfer(TransferItem *transfer) {
-    Logger::log("TransferModel::removeActiveTransfer(): " + transfer->data(TransferItem::IdRole).toString(),
-                Logger::MediumVerbosity);
+    QDL_LOG(Logger::MediumVerbosity,
+            "TransferModel::removeActiveTransfer(): " + transfer->data(TransferItem::IdRole).toString());
     m_activeTransfers.removeOne(transfer);
     emit activeTransfersChanged(activeTransfers());
     emit totalSpeedChanged(totalSpeed());
 }
 
+void TransferModel::touch(const TransferItem *item) {
+    const QString id = item->data(TransferItem::IdRole).toString();
+    const QHash<QString, qint64>::const_iterator iterator = m_itemRevisions.constFind(id);
+
+    if (iterator != m_itemRevisions.constEnd()) {
+        m_changedItems.remove(iterator.value());
+    }
+
+    m_itemRevisions[id] = ++m_revision;
+    m_changedItems.insert(m_revision, item);
+}
+
+void TransferModel::touchChildren(const TransferItem *parent) {
+    for (int i = 0; i < parent->rowCount(); i++) {
+        touch(parent->childItem(i));
+    }
+}
+
+void TransferModel::itemChanged(TransferItem *item, int column) {
+    if (m_batchDepth > 0) {
+        m_batchChanges << QPair<QPointer<TransferItem>, int>(item, column);
+        return;
+    }
+
+    const TransferItem *package = item->itemType() == TransferItem::TransferType ? item->parentItem() : 0;
+    const QModelIndex idx = index(item->row(), column, package ? index(package->row(), 0, QModelIndex()) : QModelIndex());
+    emit dataChanged(idx, idx);
+}
+
 void TransferModel::startNextTransfers() {
     if (m_packages->rowCount() == 0) {
-        Logger::log("TransferModel::startNextTransfers(): Transfer queue is empty.", Logger::MediumVerbosity);
+        QDL_LOG(Logger::MediumVerbosity, "TransferModel::startNextTransfers(): Transfer queue is empty.");
         save();
         return;
     }
 
-    const int maximum = Settings::maximumConcurrentTransfers();
+    const int maximum = maximumConcurrentTransfers();
 
     if (activeTransfers() >= maximum) {
-        Logger::log("TransferModel::startNextTransfers(): Maximum concurrent transfers is reached.",
-                    Logger::MediumVerbosity);
+        QDL_LOG(Logger::MediumVerbosity, "TransferModel::startNextTransfers(): Maximum concurrent transfers is reached.");
         return;
     }
 
@@ -749,23 +1017,50 @@ void TransferModel::startNextTransfers() {
     }
 
     if (queued.isEmpty()) {
-        Logger::log("TransferModel::startNextTransfers(): No transfers have status TransferItem::Queued.",
-                    Logger::MediumVerbosity);
+        QDL_LOG(Logger::MediumVerbosity,
+                "TransferModel::startNextTransfers(): No transfers have status TransferItem::Queued.");
         save();
         return;
     }
     
-    for (int priority = TransferItem::HighestPriority; priority <= TransferItem::LowestPriority; priority++) {
-        foreach (TransferItem *transfer, queued) {
-            if (transfer->data(TransferItem::PriorityRole) == priority) {
-                addActiveTransfer(transfer);
+    bool held = false;
+    DiskSpace space = diskSpace();
+    
+    foreach (TransferItem *transfer, schedule(queued)) {
+        if (!hasDiskSpace(transfer, space)) {
+            held = true;
+            continue;
+        }
 
-                if (activeTransfers() == maximum) {
-                    return;
-                }
-            }
+        // Reserve the space of the started transfer for the rest of the pass
+        const QString path = transfer->data(TransferItem::DownloadPathRole).toString();
+        space.volumes[storageVolume(path, space)].reserved += requiredDiskSpace(transfer);
+        addActiveTransfer(transfer);
+
+        if (activeTransfers() >= maximum) {
+            break;
+        }
+    }
+
+    if (held) {
+        // Check again later in case space has been freed by other means
+        m_diskSpaceTimer->start();
+    }
+}
+
+QList<TransferItem*> TransferModel::schedule(const QList<TransferItem*> &queued) const {
+    QHash<QString, int> policies;
+
+    foreach (const TransferItem *transfer, queued) {
+        const TransferItem *package = transfer->parentItem();
+        const QString category = package ? package->data(TransferItem::CategoryRole).toString() : QString();
+
+        if (!policies.contains(category)) {
+            policies[category] = Settings::schedulingPolicy(category);
         }
     }
+
+    return SchedulingPolicy::schedule(queued, m_activeTransfers, policies);
 }
 
 void TransferModel::onMaximumConcurrentTransfersChanged(int maximum) {
@@ -774,7 +1069,8 @@ void TransferModel::onMaximumConcurrentTransfersChanged(int maximum) {
     if (active < maximum) {
         startNextTransfers();
     }
-    else if (active > maximum) {
+    else if ((active > maximum) && (!m_concurrency->adaptive())) {
+        // When the limit is tuned automatically, surplus transfers are allowed to finish
         for (int priority = TransferItem::LowestPriority; priority >= TransferItem::HighestPriority; priority--) {
             for (int i = m_activeTransfers.size() - 1; i >= 0; i--) {
                 if (m_activeTransfers.at(i)->data(TransferItem::PriorityRole) == priority) {
@@ -791,6 +1087,8 @@ void TransferModel::onMaximumConcurrentTransfersChanged(int maximum) {
 }
 
 void TransferModel::onPackageDataChanged(TransferItem *package, int role) {
+    touch(package);
+    emit itemDataChanged(package, role);
     int column = 3;
         
     switch (role) {
@@ -815,23 +1113,31 @@ void TransferModel::onPackageDataChanged(TransferItem *package, int role) {
         return;
     }
 
-    const QModelIndex idx = index(package->row(), column, QModelIndex());
-    emit dataChanged(idx, idx);
+    itemChanged(package, column);
 }
 
 void TransferModel::onTransferDataChanged(TransferItem *transfer, int role) {
+    touch(transfer);
+    emit itemDataChanged(transfer, role);
     int column = 3;
         
     switch (role) {
     case TransferItem::BytesTransferredRole:
     case TransferItem::ProgressRole:
+        break;
     case TransferItem::SizeRole:
+        if ((m_activeTransfers.contains(transfer)) && (!hasDiskSpace(transfer))) {
+            // Return the transfer to the queue once the current reply has been handled
+            QMetaObject::invokeMethod(transfer, "requeue", Qt::QueuedConnection);
+        }
+        
         break;
     case TransferItem::SpeedRole:
         column = 4;
         emit totalSpeedChanged(totalSpeed());
         break;
     case TransferItem::CaptchaTimeoutRole:
+    case TransferItem::ErrorStringRole:
     case TransferItem::RequestedSettingsTimeoutRole:
     case TransferItem::WaitTimeRole:
         column = 5;
@@ -853,10 +1159,7 @@ void TransferModel::onTransferDataChanged(TransferItem *transfer, int role) {
         return;
     }
 
-    const TransferItem *package = transfer->parentItem();
-    const QModelIndex idx = index(transfer->row(), column,
-                                  package ? index(package->row(), 0, QModelIndex()) : QModelIndex());
-    emit dataChanged(idx, idx);
+    itemChanged(transfer, column);
 }
 
 void TransferModel::onPackageStatusChanged(TransferItem *package) {
@@ -869,8 +1172,8 @@ void TransferModel::onPackageStatusChanged(TransferItem *package) {
         return;
     }
     
-    Logger::log("TransferModel::onPackageStatusChanged(): Removing package "
-                + package->data(TransferItem::IdRole).toString(), Logger::LowVerbosity);
+    QDL_LOG(Logger::LowVerbosity, "TransferModel::onPackageStatusChanged(): Removing package "
+            + package->data(TransferItem::IdRole).toString());
     const int row = package->row();
     beginRemoveRows(QModelIndex(), row, row);
     m_packages->removeRow(row);
@@ -880,6 +1183,10 @@ void TransferModel::onPackageStatusChanged(TransferItem *package) {
 void TransferModel::onTransferStatusChanged(TransferItem *transfer) {
     switch (transfer->data(TransferItem::StatusRole).toInt()) {
     case TransferItem::Queued:
+        if (m_activeTransfers.contains(transfer)) {
+            removeActiveTransfer(transfer);
+        }
+        
         m_queueTimer->start();        
         break;
     case TransferItem::Paused:
@@ -893,6 +1200,15 @@ void TransferModel::onTransferStatusChanged(TransferItem *transfer) {
         break;
     case TransferItem::Failed:
     case TransferItem::Completed:
+        if (m_activeTransfers.contains(transfer)) {
+            if (transfer->data(TransferItem::StatusRole) == TransferItem::Failed) {
+                m_concurrency->transferFailed();
+            }
+            else {
+                m_concurrency->transferCompleted();
+            }
+        }
+        
         removeActiveTransfer(transfer);
 
         switch (Settings::nextAction()) {
@@ -930,8 +1246,8 @@ void TransferModel::onTransferStatusChanged(TransferItem *transfer) {
                 break;
             }
             
-            Logger::log("TransferModel::onTransferStatusChanged(): Removing transfer "
-                        + transfer->data(TransferItem::IdRole).toString(), Logger::LowVerbosity);
+            QDL_LOG(Logger::LowVerbosity, "TransferModel::onTransferStatusChanged(): Removing transfer "
+                    + transfer->data(TransferItem::IdRole).toString());
             const int row = transfer->row();
             beginRemoveRows(index(package->row(), 0), row, row);
             package->removeRow(row);
@@ -956,3 +1272,63 @@ void TransferModel::onTransferStatusChanged(TransferItem *transfer) {
         break;
     }
 }
+
+void TransferModel::onRowsInserted(const QModelIndex &parent, int first, int last) {
+    for (int i = first; i <= last; i++) {
+        if (const TransferItem *item = get(index(i, 0, parent))) {
+            touch(item);
+            touchChildren(item);
+        }
+    }
+
+    m_structureRevision = m_revision;
+}
+
+void TransferModel::onRowsAboutToBeRemoved(const QModelIndex &parent, int first, int last) {
+    ++m_revision;
+
+    for (int i = first; i <= last; i++) {
+        if (const TransferItem *item = get(index(i, 0, parent))) {
+            QStringList ids;
+            ids << item->data(TransferItem::IdRole).toString();
+
+            for (int j = 0; j < item->rowCount(); j++) {
+                ids << item->childItem(j)->data(TransferItem::IdRole).toString();
+            }
+
+            foreach (const QString &id, ids) {
+                m_changedItems.remove(m_itemRevisions.value(id, -1));
+                m_itemRevisions.remove(id);
+                m_removedItems << qMakePair(m_revision, id);
+            }
+        }
+    }
+
+    while (m_removedItems.size() > MAX_REMOVED_ITEMS) {
+        m_removedBaseRevision = m_removedItems.takeFirst().first;
+    }
+
+    m_structureRevision = m_revision;
+}
+
+void TransferModel::onRowsMoved(const QModelIndex &sourceParent, int, int, const QModelIndex &destinationParent,
+                                int) {
+    // Rows after the moved ones also change position, so mark every row of both parents as modified
+    touchChildren(get(sourceParent));
+
+    if (destinationParent != sourceParent) {
+        touchChildren(get(destinationParent));
+    }
+
+    m_structureRevision = m_revision;
+}
+
+void TransferModel::onModelReset() {
+    // Deltas cannot span a reset, so all clients must reload
+    m_baseRevision = ++m_revision;
+    m_removedBaseRevision = m_revision;
+    m_structureRevision = m_revision;
+    m_itemRevisions.clear();
+    m_changedItems.clear();
+    m_removedItems.clear();
+}
@@ -20,7 +20,11 @@
 #include "transferitem.h"
 #include "urlresult.h"
 #include <QAbstractItemModel>
+#include <QHash>
+#include <QMap>
+#include <QPointer>
 
+class ConcurrencyController;
 class QTimer;
 
 class TransferModel : public QAbstractItemModel
@@ -84,13 +88,29 @@ public:
                                       const QVariant &destinationParent, int destinationRow);
 
     int activeTransfers() const;
+    TransferItem* activeTransfer(int i) const;
+
+    int maximumConcurrentTransfers() const;
+    QVariantMap concurrencyStatus() const;
 
     int totalSpeed() const;
     QString totalSpeedString() const;
 
+    qint64 revision() const;
+    qint64 itemRevision(const TransferItem *item) const;
+    qint64 structureRevision() const;
+    QList<const TransferItem*> changedSince(qint64 revision) const;
+    bool hasRevisionHistory(qint64 revision) const;
+    QStringList removedSince(qint64 revision) const;
+    qint64 removedBaseRevision() const;
+    QList<QPair<qint64, QString> > removedItems() const;
+
     TransferItem* get(const QModelIndex &index) const;
     Q_INVOKABLE TransferItem* get(const QVariant &index) const;
 
+    void beginBatch();
+    void endBatch();
+
 public Q_SLOTS:
     TransferItem* append(const QString &url, const QString &requestMethod = QString("GET"),
                          const QVariantMap &requestHeaders = QVariantMap(), const QString &postData = QString(),
@@ -127,11 +147,19 @@ private Q_SLOTS:
 
     void onPackageStatusChanged(TransferItem *package);
     void onTransferStatusChanged(TransferItem *transfer);
+
+    void onRowsInserted(const QModelIndex &parent, int first, int last);
+    void onRowsAboutToBeRemoved(const QModelIndex &parent, int first, int last);
+    void onRowsMoved(const QModelIndex &sourceParent, int first, int last, const QModelIndex &destinationParent,
+                     int row);
+    void onModelReset();
     
 Q_SIGNALS:
     void activeTransfersChanged(int active);
     void totalSpeedChanged(int speed);
 
+    void itemDataChanged(TransferItem *item, int role);
+
     void captchaRequest(TransferItem *transfer);
     void settingsRequest(TransferItem *transfer);
 
@@ -141,9 +169,40 @@ private:
     TransferItem* createPackage(const QString &fileName);
     TransferItem* findPackage(const QString &fileName) const;
 
+    QList<TransferItem*> schedule(const QList<TransferItem*> &queued) const;
+
+    struct VolumeSpace
+    {
+        VolumeSpace() : measured(false), available(-1), reserved(0) {}
+
+        bool measured;
+        qint64 available;
+        qint64 reserved;
+    };
+
+    /**
+     * The free and reserved space of each volume, gathered once per scheduling pass.
+     */
+    struct DiskSpace
+    {
+        QHash<QString, QString> pathVolumes;
+        QHash<QString, VolumeSpace> volumes;
+    };
+
+    qint64 requiredDiskSpace(const TransferItem *transfer) const;
+    QString storageVolume(const QString &path, DiskSpace &space) const;
+    DiskSpace diskSpace() const;
+    bool hasDiskSpace(TransferItem *transfer);
+    bool hasDiskSpace(TransferItem *transfer, DiskSpace &space);
+
     void addActiveTransfer(TransferItem *transfer);
     void removeActiveTransfer(TransferItem *transfer);
 
+    void touch(const TransferItem *item);
+    void touchChildren(const TransferItem *parent);
+
+    void itemChanged(TransferItem *item, int column);
+
     static TransferModel *self;
 
     static const QString MIME_TYPE;
@@ -151,8 +210,22 @@ private:
     TransferItem *m_packages;
 
     QTimer *m_queueTimer;
+    QTimer *m_diskSpaceTimer;
+
+    ConcurrencyController *m_concurrency;
 
     QList<TransferItem*> m_activeTransfers;
+
+    qint64 m_revision;
+    qint64 m_baseRevision;
+    qint64 m_removedBaseRevision;
+    qint64 m_structureRevision;
+    QHash<QString, qint64> m_itemRevisions;
+    QMap<qint64, const TransferItem*> m_changedItems;
+    QList<QPair<qint64, QString> > m_removedItems;
+
+    int m_batchDepth;
+    QList<QPair<QPointer<TransferItem>, int> > m_batchChanges;
 };
 
 #if QT_VERSION < 0x050000
@@ -0,0 +1,484 @@
+/*
+ * Copyright (C) 2016 Stuart Howarth <showarth@marxoft.co.uk>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "transferquery.h"
+#include "transferitem.h"
+#include "transfersnapshot.h"
+#include "jsonwriter.h"
+#include <QDateTime>
+
+static QStringList toStringList(const QVariant &value) {
+    if (value.type() == QVariant::String) {
+        return value.toString().split(",", QString::SkipEmptyParts);
+    }
+
+    return value.toStringList();
+}
+
+static bool isNumeric(const QVariant &value) {
+    switch (value.type()) {
+    case QVariant::Bool:
+    case QVariant::Double:
+    case QVariant::Int:
+    case QVariant::LongLong:
+    case QVariant::UInt:
+    case QVariant::ULongLong:
+        return true;
+    default:
+        return false;
+    }
+}
+
+static int compare(const QVariant &a, const QVariant &b) {
+    if ((isNumeric(a)) && (isNumeric(b))) {
+        const double x = a.toDouble();
+        const double y = b.toDouble();
+        return x < y ? -1 : x > y ? 1 : 0;
+    }
+
+    if ((a.type() == QVariant::DateTime) || (b.type() == QVariant::DateTime)) {
+        // Transfers without a date are ordered last
+        const QDateTime x = a.toDateTime();
+        const QDateTime y = b.toDateTime();
+
+        if (x.isValid() != y.isValid()) {
+            return x.isValid() ? -1 : 1;
+        }
+
+        return x < y ? -1 : x > y ? 1 : 0;
+    }
+
+    return QString::localeAwareCompare(a.toString().toLower(), b.toString().toLower());
+}
+
+class SortLessThan
+{
+
+public:
+    SortLessThan(const QList<int> &roles, const QStringList &names, const QList<bool> &descending) :
+        m_roles(roles),
+        m_names(names),
+        m_descending(descending)
+    {
+    }
+
+    bool operator()(const TransferItem *a, const TransferItem *b) const {
+        for (int i = 0; i < m_roles.size(); i++) {
+            const int result = compare(a->data(m_roles.at(i)), b->data(m_roles.at(i)));
+
+            if (result != 0) {
+                return m_descending.at(i) ? result > 0 : result < 0;
+            }
+        }
+
+        return false;
+    }
+
+    bool operator()(const QVariantMap &a, const QVariantMap &b) const {
+        for (int i = 0; i < m_names.size(); i++) {
+            const int result = compare(a.value(m_names.at(i)), b.value(m_names.at(i)));
+
+            if (result != 0) {
+                return m_descending.at(i) ? result > 0 : result < 0;
+            }
+        }
+
+        return false;
+    }
+
+    bool operator()(const TransferQuery::Package &a, const TransferQuery::Package &b) const {
+        return (*this)(a.first, b.first);
+    }
+
+private:
+    QList<int> m_roles;
+    QStringList m_names;
+    QList<bool> m_descending;
+};
+
+TransferQuery::TransferQuery() {
+}
+
+TransferQuery::TransferQuery(const QVariantMap &query) {
+    QMapIterator<QString, QVariant> iterator(query);
+
+    while (iterator.hasNext()) {
+        iterator.next();
+
+        if (iterator.key() == "fields") {
+            setFields(toStringList(iterator.value()));
+        }
+        else if (iterator.key() == "sort") {
+            setSort(iterator.value().toString());
+        }
+        else {
+            // Any other key filters on the role of that name
+            const QString roleName = iterator.key() == "plugin" ? QString("pluginId") : iterator.key();
+            QVariantList values;
+
+            if (iterator.value().type() == QVariant::String) {
+                foreach (const QString &value, toStringList(iterator.value())) {
+                    values << value;
+                }
+            }
+            else if (iterator.value().type() == QVariant::List) {
+                values = iterator.value().toList();
+            }
+            else {
+                values << iterator.value();
+            }
+
+            addFilter(roleName, values);
+        }
+    }
+}
+
+QStringList TransferQuery::fields() const {
+    return m_fields;
+}
+
+void TransferQuery::setFields(const QStringList &fields) {
+    m_fields.clear();
+    m_fieldRoles.clear();
+    const QHash<int, QByteArray> roleNames = TransferItem::roleNames();
+
+    foreach (const QString &field, fields) {
+        const int role = roleNames.key(field.trimmed().toUtf8(), -1);
+
+        if (role != -1) {
+            m_fields << field.trimmed();
+            m_fieldRoles << role;
+        }
+    }
+
+    if ((!m_fieldRoles.isEmpty()) && (!m_fieldRoles.contains(TransferItem::IdRole))) {
+        // Results cannot be identified without the id
+        m_fields.prepend("id");
+        m_fieldRoles.prepend(TransferItem::IdRole);
+    }
+}
+
+QString TransferQuery::sort() const {
+    return m_sort;
+}
+
+void TransferQuery::setSort(const QString &sort) {
+    m_sort = sort;
+    m_sortKeys.clear();
+    const QHash<int, QByteArray> roleNames = TransferItem::roleNames();
+
+    foreach (QString key, sort.split(",", QString::SkipEmptyParts)) {
+        key = key.trimmed();
+        SortKey sortKey;
+        sortKey.descending = key.startsWith("-");
+
+        if (sortKey.descending) {
+            key.remove(0, 1);
+        }
+
+        sortKey.role = roleNames.key(key.toUtf8(), -1);
+        sortKey.name = key;
+
+        if (sortKey.role != -1) {
+            m_sortKeys << sortKey;
+        }
+    }
+}
+
+void TransferQuery::addFilter(const QString &roleName, const QVariantList &values, bool contains) {
+    const int role = TransferItem::roleNames().key(roleName.toUtf8(), -1);
+
+    if ((role != -1) && (!values.isEmpty())) {
+        Filter filter;
+        filter.role = role;
+        filter.name = roleName;
+        filter.values = values;
+        filter.contains = contains;
+        m_filters << filter;
+    }
+}
+
+bool TransferQuery::isFiltered() const {
+    return !m_filters.isEmpty();
+}
+
+// Returns the names of the roles read by the filters, the sort and the projection, or none if every role is projected
+QStringList TransferQuery::roleNamesRead() const {
+    if (m_fields.isEmpty()) {
+        return QStringList();
+    }
+
+    QStringList names = m_fields;
+
+    foreach (const Filter &filter, m_filters) {
+        names << filter.name;
+    }
+
+    foreach (const SortKey &key, m_sortKeys) {
+        names << key.name;
+    }
+
+    return names;
+}
+
+QVariant TransferQuery::value(const TransferItem *item, int role) {
+    const QVariant value = item->data(role);
+
+    if ((!value.isValid()) && (item->itemType() == TransferItem::TransferType)) {
+        // Transfers inherit package properties such as the category
+        if (const TransferItem *package = item->parentItem()) {
+            return package->data(role);
+        }
+    }
+
+    return value;
+}
+
+bool TransferQuery::matches(const Filter &filter, const QVariant &itemValue) {
+    foreach (const QVariant &filterValue, filter.values) {
+        bool match = false;
+
+        if ((filter.contains) && (itemValue.type() == QVariant::String)) {
+            match = itemValue.toString().contains(filterValue.toString(), Qt::CaseInsensitive);
+        }
+        else if (isNumeric(itemValue)) {
+            match = itemValue.toDouble() == filterValue.toDouble();
+        }
+        else {
+            match = itemValue.toString() == filterValue.toString();
+        }
+
+        if (match) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool TransferQuery::matches(const TransferItem *item) const {
+    foreach (const Filter &filter, m_filters) {
+        if (!matches(filter, value(item, filter.role))) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool TransferQuery::matches(const QVariantMap &data, const QVariantMap &parentData) const {
+    foreach (const Filter &filter, m_filters) {
+        const QVariant itemValue = data.value(filter.name);
+
+        if (!matches(filter, itemValue.isValid() ? itemValue : parentData.value(filter.name))) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void TransferQuery::sort(QList<TransferItem*> &items) const {
+    if (m_sortKeys.isEmpty()) {
+        return;
+    }
+
+    QList<int> roles;
+    QStringList names;
+    QList<bool> descending;
+
+    foreach (const SortKey &key, m_sortKeys) {
+        roles << key.role;
+        names << key.name;
+        descending << key.descending;
+    }
+
+    qStableSort(items.begin(), items.end(), SortLessThan(roles, names, descending));
+}
+
+void TransferQuery::sort(QList<QVariantMap> &items) const {
+    if (m_sortKeys.isEmpty()) {
+        return;
+    }
+
+    QList<int> roles;
+    QStringList names;
+    QList<bool> descending;
+
+    foreach (const SortKey &key, m_sortKeys) {
+        roles << key.role;
+        names << key.name;
+        descending << key.descending;
+    }
+
+    qStableSort(items.begin(), items.end(), SortLessThan(roles, names, descending));
+}
+
+void TransferQuery::sort(Selection &packages) const {
+    if (m_sortKeys.isEmpty()) {
+        return;
+    }
+
+    QList<int> roles;
+    QStringList names;
+    QList<bool> descending;
+
+    foreach (const SortKey &key, m_sortKeys) {
+        roles << key.role;
+        names << key.name;
+        descending << key.descending;
+    }
+
+    qStableSort(packages.begin(), packages.end(), SortLessThan(roles, names, descending));
+}
+
+QVariantMap TransferQuery::itemData(const TransferItem *item) const {
+    if (m_fieldRoles.isEmpty()) {
+        return item->itemDataWithRoleNames();
+    }
+
+    QVariantMap data;
+
+    for (int i = 0; i < m_fieldRoles.size(); i++) {
+        data[m_fields.at(i)] = item->data(m_fieldRoles.at(i));
+    }
+
+    return data;
+}
+
+QVariantMap TransferQuery::itemData(const QVariantMap &data) const {
+    if (m_fields.isEmpty()) {
+        return data;
+    }
+
+    QVariantMap projection;
+
+    foreach (const QString &field, m_fields) {
+        projection[field] = data.value(field);
+    }
+
+    return projection;
+}
+
+void TransferQuery::writeItemData(QtJson::JsonWriter &writer, const QVariantMap &data) const {
+    if (m_fields.isEmpty()) {
+        for (QVariantMap::const_iterator iterator = data.constBegin(); iterator != data.constEnd(); ++iterator) {
+            writer.writeKey(iterator.key());
+            writer.writeValue(iterator.value());
+        }
+
+        return;
+    }
+
+    QStringList fields = m_fields;
+    fields.removeDuplicates();
+
+    foreach (const QString &field, fields) {
+        writer.writeKey(field);
+        writer.writeValue(data.value(field));
+    }
+}
+
+QVariantList TransferQuery::packages(const TransferItem *root, int offset, int limit) const {
+    QList<TransferItem*> packages;
+    QHash<TransferItem*, QList<TransferItem*> > children;
+
+    for (int i = 0; i < root->rowCount(); i++) {
+        TransferItem *package = root->childItem(i);
+        const bool packageMatches = matches(package);
+        QList<TransferItem*> transfers;
+
+        for (int j = 0; j < package->rowCount(); j++) {
+            TransferItem *transfer = package->childItem(j);
+
+            if ((packageMatches) || (matches(transfer))) {
+                transfers << transfer;
+            }
+        }
+
+        if ((packageMatches) || (!transfers.isEmpty())) {
+            packages << package;
+            children[package] = transfers;
+        }
+    }
+
+    sort(packages);
+
+    if ((offset < 0) || (offset >= packages.size())) {
+        return QVariantList();
+    }
+
+    const int end = limit < 0 ? packages.size() : qMin(packages.size(), offset + limit);
+    QVariantList results;
+
+    for (int i = offset; i < end; i++) {
+        TransferItem *package = packages.at(i);
+        QList<TransferItem*> transfers = children.value(package);
+        sort(transfers);
+        QVariantList packageChildren;
+
+        foreach (const TransferItem *transfer, transfers) {
+            packageChildren << itemData(transfer);
+        }
+
+        QVariantMap data = itemData(package);
+        data["children"] = packageChildren;
+        results << data;
+    }
+
+    return results;
+}
+
+TransferQuery::Selection TransferQuery::select(const TransferSnapshot &snapshot, int offset, int limit) const {
+    // Only the formatted values that are read are computed
+    const QStringList roleNames = roleNamesRead();
+    Selection packages;
+
+    foreach (const QString &packageId, snapshot.packageIds()) {
+        const QVariantMap package = snapshot.itemData(packageId, roleNames);
+        const bool packageMatches = matches(package);
+        QList<QVariantMap> transfers;
+
+        foreach (const QString &transferId, snapshot.childIds(packageId)) {
+            const QVariantMap transfer = snapshot.itemData(transferId, roleNames);
+
+            if ((packageMatches) || (matches(transfer, package))) {
+                transfers << transfer;
+            }
+        }
+
+        if ((packageMatches) || (!transfers.isEmpty())) {
+            packages << Package(package, transfers);
+        }
+    }
+
+    sort(packages);
+
+    if ((offset < 0) || (offset >= packages.size())) {
+        return Selection();
+    }
+
+    const int end = limit < 0 ? packages.size() : qMin(packages.size(), offset + limit);
+    Selection results;
+
+    for (int i = offset; i < end; i++) {
+        Package package = packages.at(i);
+        sort(package.second);
+        results << package;
+    }
+
+    return results;
+}
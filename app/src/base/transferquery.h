@@ -0,0 +1,118 @@
+/*
+ * Copyright (C) 2016 Stuart Howarth <showarth@marxoft.co.uk>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TRANSFERQUERY_H
+#define TRANSFERQUERY_H
+
+#include <QList>
+#include <QPair>
+#include <QStringList>
+#include <QVariantMap>
+
+class TransferItem;
+class TransferSnapshot;
+
+namespace QtJson
+{
+    class JsonWriter;
+}
+
+/**
+ * Selects, orders and projects transfer items for external queries (DBus and the web interface).
+ * Only the roles needed to test the filters, sort the results and build the requested fields are
+ * ever read from the items.
+ */
+class TransferQuery
+{
+
+public:
+    /**
+     * A package's item data and the item data of its included children.
+     */
+    typedef QPair<QVariantMap, QList<QVariantMap> > Package;
+    typedef QList<Package> Selection;
+
+    TransferQuery();
+    explicit TransferQuery(const QVariantMap &query);
+
+    QStringList fields() const;
+    void setFields(const QStringList &fields);
+
+    QString sort() const;
+    void setSort(const QString &sort);
+
+    /**
+     * Restricts the results to items whose value for roleName is one of values.
+     * If contains is true, string values match if they contain the value, ignoring case.
+     */
+    void addFilter(const QString &roleName, const QVariantList &values, bool contains = false);
+
+    bool isFiltered() const;
+
+    bool matches(const TransferItem *item) const;
+    bool matches(const QVariantMap &data, const QVariantMap &parentData = QVariantMap()) const;
+    void sort(QList<TransferItem*> &items) const;
+    void sort(QList<QVariantMap> &items) const;
+    void sort(Selection &packages) const;
+    QVariantMap itemData(const TransferItem *item) const;
+    QVariantMap itemData(const QVariantMap &data) const;
+
+    /**
+     * Writes the projected item data as the members of the object that is being written by writer, so
+     * that no intermediate map is built.
+     */
+    void writeItemData(QtJson::JsonWriter &writer, const QVariantMap &data) const;
+
+    /**
+     * Returns the packages that match, or contain transfers that match, sorted and limited to the range
+     * given by offset and limit. The children of a matching package are all included, otherwise only
+     * the matching children are included.
+     */
+    QVariantList packages(const TransferItem *root, int offset = 0, int limit = -1) const;
+
+    /**
+     * As above, but reads the items from a snapshot, so that it is safe to call from any thread. The item
+     * data is not projected, so that the results can be written out incrementally with writeItemData().
+     */
+    Selection select(const TransferSnapshot &snapshot, int offset = 0, int limit = -1) const;
+
+private:
+    struct Filter {
+        int role;
+        QString name;
+        QVariantList values;
+        bool contains;
+    };
+
+    struct SortKey {
+        int role;
+        QString name;
+        bool descending;
+    };
+
+    QStringList roleNamesRead() const;
+
+    static QVariant value(const TransferItem *item, int role);
+    static bool matches(const Filter &filter, const QVariant &itemValue);
+
+    QStringList m_fields;
+    QList<int> m_fieldRoles;
+    QString m_sort;
+    QList<SortKey> m_sortKeys;
+    QList<Filter> m_filters;
+};
+
+#endif // TRANSFERQUERY_H
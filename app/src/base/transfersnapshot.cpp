@@ -0,0 +1,340 @@
+/*
+ * Copyright (C) 2016 Stuart Howarth <showarth@marxoft.co.uk>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "transfersnapshot.h"
+#include "captchatype.h"
+#include "qdl.h"
+#include "transfermodel.h"
+#include "utils.h"
+#include <QCoreApplication>
+
+// The roles that are formatted for display from the values of other roles
+static const int FORMATTED_ROLES[] = {
+    TransferItem::CaptchaTimeoutStringRole,
+    TransferItem::CaptchaTypeStringRole,
+    TransferItem::ItemTypeStringRole,
+    TransferItem::PriorityStringRole,
+    TransferItem::ProgressStringRole,
+    TransferItem::RequestedSettingsTimeoutStringRole,
+    TransferItem::SpeedStringRole,
+    TransferItem::StatusStringRole,
+    TransferItem::WaitTimeStringRole
+};
+
+static const int FORMATTED_ROLE_COUNT = sizeof(FORMATTED_ROLES) / sizeof(FORMATTED_ROLES[0]);
+
+static bool isFormattedRole(int role) {
+    for (int i = 0; i < FORMATTED_ROLE_COUNT; i++) {
+        if (FORMATTED_ROLES[i] == role) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+// Returns the same keys as TransferItem::itemDataWithRoleNames(), without the formatted values
+static QVariantMap rawItemData(const TransferItem *item) {
+    QVariantMap data;
+    QHashIterator<int, QByteArray> iterator(TransferItem::roleNames());
+
+    while (iterator.hasNext()) {
+        iterator.next();
+
+        if (!isFormattedRole(iterator.key())) {
+            const QVariant value = item->data(iterator.key());
+
+            if (value.isValid()) {
+                data[QString::fromUtf8(iterator.value())] = value;
+            }
+        }
+    }
+
+    return data;
+}
+
+// The formatting below matches that of the items, so the same translations are used
+
+static QString itemTypeString(int type) {
+    switch (type) {
+    case TransferItem::ListType:
+        return QCoreApplication::translate("TransferItem", "List");
+    case TransferItem::PackageType:
+        return QCoreApplication::translate("TransferItem", "Package");
+    case TransferItem::TransferType:
+        return QCoreApplication::translate("TransferItem", "Transfer");
+    default:
+        return QCoreApplication::translate("TransferItem", "Unknown");
+    }
+}
+
+static QString captchaTypeString(int type) {
+    switch (type) {
+    case CaptchaType::Image:
+        return QCoreApplication::translate("DownloadRequester", "Image");
+    case CaptchaType::NoCaptcha:
+        return QCoreApplication::translate("DownloadRequester", "NoCaptcha");
+    default:
+        return QCoreApplication::translate("DownloadRequester", "Unknown");
+    }
+}
+
+static QString transferProgressString(const QVariantMap &data) {
+    const qint64 bytesTransferred = data.value("bytesTransferred").toLongLong();
+    const qint64 size = data.value("size").toLongLong();
+
+    if (size > 0) {
+        return QCoreApplication::translate("Transfer", "%1 of %2 (%3%)").arg(Utils::formatBytes(bytesTransferred))
+                                           .arg(Utils::formatBytes(size)).arg(data.value("progress").toInt());
+    }
+
+    return QCoreApplication::translate("Transfer", "%1 of Unknown").arg(Utils::formatBytes(bytesTransferred));
+}
+
+static QString transferStatusString(const QVariantMap &data) {
+    const TransferItem::Status status = TransferItem::Status(data.value("status").toInt());
+    const QString errorString = data.value("errorString").toString();
+
+    switch (status) {
+    case TransferItem::Failed:
+        return QString("%1: %2").arg(TransferItem::statusString(status)).arg(errorString);
+    case TransferItem::Queued:
+        return errorString.isEmpty() ? TransferItem::statusString(status)
+                                     : QString("%1: %2").arg(TransferItem::statusString(status)).arg(errorString);
+    case TransferItem::WaitingInactive:
+    case TransferItem::WaitingActive:
+        return QString("%1: %2").arg(TransferItem::statusString(status))
+                                .arg(Utils::formatMSecs(data.value("waitTime").toLongLong()));
+    case TransferItem::AwaitingCaptchaResponse:
+        return QString("%1: %2").arg(TransferItem::statusString(status))
+                                .arg(Utils::formatMSecs(data.value("captchaTimeout").toLongLong()));
+    case TransferItem::AwaitingSettingsResponse:
+        return QString("%1: %2").arg(TransferItem::statusString(status))
+                                .arg(Utils::formatMSecs(data.value("requestedSettingsTimeout").toLongLong()));
+    default:
+        return TransferItem::statusString(status);
+    }
+}
+
+static QString packageStatusString(const QVariantMap &data) {
+    const TransferItem::Status status = TransferItem::Status(data.value("status").toInt());
+
+    if (status == TransferItem::Failed) {
+        return QString("%1: %2").arg(TransferItem::statusString(status)).arg(data.value("errorString").toString());
+    }
+
+    return TransferItem::statusString(status);
+}
+
+TransferSnapshot::TransferSnapshot() :
+    m_revision(-1),
+    m_removedBaseRevision(0)
+{
+}
+
+QSharedPointer<const TransferSnapshot> TransferSnapshot::current() {
+    static QSharedPointer<const TransferSnapshot> latest;
+    const TransferModel *model = TransferModel::instance();
+    TransferSnapshot *snapshot = latest ? new TransferSnapshot(*latest) : new TransferSnapshot;
+
+    if (snapshot->revision() != model->revision()) {
+        snapshot->update(model);
+    }
+
+    // The status includes the transfer speed, which does not change the revision
+    snapshot->m_status = Qdl::getTransfersStatus();
+    latest = QSharedPointer<const TransferSnapshot>(snapshot);
+    return latest;
+}
+
+qint64 TransferSnapshot::revision() const {
+    return m_revision;
+}
+
+QVariantMap TransferSnapshot::status() const {
+    return m_status;
+}
+
+QStringList TransferSnapshot::packageIds() const {
+    return m_packageIds;
+}
+
+QStringList TransferSnapshot::childIds(const QString &id) const {
+    return m_childIds.value(id);
+}
+
+bool TransferSnapshot::contains(const QString &id) const {
+    return m_itemData.contains(id);
+}
+
+QVariantMap TransferSnapshot::itemData(const QString &id, const QStringList &roleNames) const {
+    QVariantMap data = m_itemData.value(id);
+
+    if (data.isEmpty()) {
+        return data;
+    }
+
+    for (int i = 0; i < FORMATTED_ROLE_COUNT; i++) {
+        const QString name = QString::fromUtf8(TransferItem::roleNames().value(FORMATTED_ROLES[i]));
+
+        if ((roleNames.isEmpty()) || (roleNames.contains(name))) {
+            const QVariant value = formattedValue(id, data, FORMATTED_ROLES[i]);
+
+            if (value.isValid()) {
+                data[name] = value;
+            }
+        }
+    }
+
+    return data;
+}
+
+qint64 TransferSnapshot::itemRevision(const QString &id) const {
+    return m_itemRevisions.value(id);
+}
+
+bool TransferSnapshot::hasRevisionHistory(qint64 revision) const {
+    return (revision >= m_removedBaseRevision) && (revision <= m_revision);
+}
+
+QStringList TransferSnapshot::removedSince(qint64 revision) const {
+    QStringList ids;
+
+    for (int i = m_removedItems.size() - 1; i >= 0; i--) {
+        const QPair<qint64, QString> &removed = m_removedItems.at(i);
+
+        if (removed.first <= revision) {
+            break;
+        }
+
+        ids << removed.second;
+    }
+
+    return ids;
+}
+
+QVariant TransferSnapshot::formattedValue(const QString &id, const QVariantMap &data, int role) const {
+    const int type = data.value("itemType").toInt();
+
+    switch (role) {
+    case TransferItem::ItemTypeStringRole:
+        return itemTypeString(type);
+    case TransferItem::PriorityStringRole:
+        return TransferItem::priorityString(TransferItem::Priority(data.value("priority").toInt()));
+    case TransferItem::ProgressStringRole:
+        if (type == TransferItem::PackageType) {
+            const QStringList children = m_childIds.value(id);
+
+            if (children.isEmpty()) {
+                return QString();
+            }
+
+            int completed = 0;
+
+            foreach (const QString &childId, children) {
+                if (m_itemData.value(childId).value("status") == TransferItem::Completed) {
+                    ++completed;
+                }
+            }
+
+            return QCoreApplication::translate("Package", "%1 of %2 (%3%)").arg(completed).arg(children.size())
+                                                .arg(completed * 100 / children.size());
+        }
+
+        return transferProgressString(data);
+    case TransferItem::StatusStringRole:
+        return type == TransferItem::PackageType ? packageStatusString(data) : transferStatusString(data);
+    default:
+        break;
+    }
+
+    if (type != TransferItem::TransferType) {
+        // The remaining roles only apply to transfers
+        return QVariant();
+    }
+
+    switch (role) {
+    case TransferItem::CaptchaTimeoutStringRole:
+        return Utils::formatMSecs(data.value("captchaTimeout").toLongLong());
+    case TransferItem::CaptchaTypeStringRole:
+        return captchaTypeString(data.value("captchaType").toInt());
+    case TransferItem::RequestedSettingsTimeoutStringRole:
+        return Utils::formatMSecs(data.value("requestedSettingsTimeout").toLongLong());
+    case TransferItem::SpeedStringRole:
+        return QString("%1/s").arg(Utils::formatBytes(data.value("speed").toLongLong()));
+    case TransferItem::WaitTimeStringRole:
+        return Utils::formatMSecs(data.value("waitTime").toLongLong());
+    default:
+        return QVariant();
+    }
+}
+
+void TransferSnapshot::update(const TransferModel *model) {
+    if ((m_revision >= 0) && (model->structureRevision() <= m_revision)) {
+        // Only item data has changed, so update just the items touched since this snapshot
+        foreach (const TransferItem *item, model->changedSince(m_revision)) {
+            const QString id = item->data(TransferItem::IdRole).toString();
+            m_itemRevisions[id] = model->itemRevision(item);
+            m_itemData[id] = rawItemData(item);
+        }
+
+        m_revision = model->revision();
+        return;
+    }
+
+    const QHash<QString, QVariantMap> previousData = m_itemData;
+    const QHash<QString, qint64> previousRevisions = m_itemRevisions;
+    m_revision = model->revision();
+    m_removedBaseRevision = model->removedBaseRevision();
+    m_removedItems = model->removedItems();
+    m_packageIds.clear();
+    m_childIds.clear();
+    m_itemData.clear();
+    m_itemRevisions.clear();
+    const TransferItem *root = model->get(QModelIndex());
+
+    for (int i = 0; i < root->rowCount(); i++) {
+        const TransferItem *package = root->childItem(i);
+        const QString packageId = package->data(TransferItem::IdRole).toString();
+        QStringList childIds;
+        m_packageIds << packageId;
+        addItem(model, package, previousData, previousRevisions);
+
+        for (int j = 0; j < package->rowCount(); j++) {
+            const TransferItem *transfer = package->childItem(j);
+            childIds << transfer->data(TransferItem::IdRole).toString();
+            addItem(model, transfer, previousData, previousRevisions);
+        }
+
+        m_childIds[packageId] = childIds;
+    }
+}
+
+void TransferSnapshot::addItem(const TransferModel *model, const TransferItem *item,
+                               const QHash<QString, QVariantMap> &previousData,
+                               const QHash<QString, qint64> &previousRevisions) {
+    const QString id = item->data(TransferItem::IdRole).toString();
+    const qint64 revision = model->itemRevision(item);
+    m_itemRevisions[id] = revision;
+
+    if ((previousRevisions.value(id, -1) == revision) && (previousData.contains(id))) {
+        // Unchanged, so the data is shared with the previous snapshot
+        m_itemData[id] = previousData.value(id);
+    }
+    else {
+        m_itemData[id] = rawItemData(item);
+    }
+}
@@ -0,0 +1,86 @@
+/*
+ * Copyright (C) 2016 Stuart Howarth <showarth@marxoft.co.uk>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TRANSFERSNAPSHOT_H
+#define TRANSFERSNAPSHOT_H
+
+#include <QHash>
+#include <QPair>
+#include <QSharedPointer>
+#include <QStringList>
+#include <QVariantMap>
+
+class TransferItem;
+class TransferModel;
+
+/**
+ * An immutable copy of the transfer tree, which can be read from any thread.
+ * Consecutive snapshots share the data of items that have not changed, so publishing a new snapshot
+ * only copies the items touched since the last one. The tree is only walked when items have been
+ * inserted, removed or moved. Only the raw values of the items are copied. The values that are formatted for
+ * display, such as statusString, are computed when the data is read, in the thread that reads it.
+ */
+class TransferSnapshot
+{
+
+public:
+    /**
+     * Returns a snapshot of the current state of the transfer model.
+     * This must only be called in the main thread.
+     */
+    static QSharedPointer<const TransferSnapshot> current();
+
+    qint64 revision() const;
+    QVariantMap status() const;
+
+    QStringList packageIds() const;
+    QStringList childIds(const QString &id) const;
+
+    bool contains(const QString &id) const;
+
+    /**
+     * Returns the data of the item, including the formatted values in roleNames, or all of them if roleNames is
+     * empty.
+     */
+    QVariantMap itemData(const QString &id, const QStringList &roleNames = QStringList()) const;
+
+    qint64 itemRevision(const QString &id) const;
+
+    bool hasRevisionHistory(qint64 revision) const;
+    QStringList removedSince(qint64 revision) const;
+
+private:
+    TransferSnapshot();
+
+    void update(const TransferModel *model);
+    QVariant formattedValue(const QString &id, const QVariantMap &data, int role) const;
+
+    void addItem(const TransferModel *model, const TransferItem *item, const QHash<QString, QVariantMap> &previousData,
+                 const QHash<QString, qint64> &previousRevisions);
+
+    qint64 m_revision;
+    qint64 m_removedBaseRevision;
+
+    QVariantMap m_status;
+
+    QStringList m_packageIds;
+    QHash<QString, QStringList> m_childIds;
+    QHash<QString, QVariantMap> m_itemData;
+    QHash<QString, qint64> m_itemRevisions;
+    QList<QPair<qint64, QString> > m_removedItems;
+};
+
+#endif // TRANSFERSNAPSHOT_H
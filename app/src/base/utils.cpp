@@ -18,12 +18,22 @@
 #include "json.h"
 #include <QDir>
 #include <QFile>
+#include <QFileInfo>
 #include <QRegExp>
+#if QT_VERSION < 0x050000
+#include <QTextDocument>
+#endif
 #include <QUuid>
 #include <QUrl>
 #if QT_VERSION >= 0x050000
 #include <QUrlQuery>
 #endif
+#if QT_VERSION >= 0x050400
+#include <QStorageInfo>
+#elif defined(Q_OS_UNIX)
+#include <sys/stat.h>
+#include <sys/statvfs.h>
+#endif
 
 static const double KB = 1024;
 static const double MB = KB * 1024;
@@ -99,6 +109,58 @@ QString Utils::getSanitizedFileName(const QString &fileName) {
     return QString(fileName).replace(QRegExp("[\\/\\\\\\|]"), "_");
 }
 
+// Returns the nearest existing directory, since the download path may not have been created yet
+static QString existingPath(const QString &path) {
+    QString p = QFileInfo(path).absoluteFilePath();
+
+    while (!QFileInfo(p).exists()) {
+        const QString parent = QFileInfo(p).absolutePath();
+
+        if (parent == p) {
+            break;
+        }
+
+        p = parent;
+    }
+
+    return p;
+}
+
+qint64 Utils::bytesAvailable(const QString &path) {
+#if QT_VERSION >= 0x050400
+    const QStorageInfo storage(existingPath(path));
+    return storage.isValid() ? storage.bytesAvailable() : -1;
+#elif defined(Q_OS_UNIX)
+    struct statvfs stats;
+
+    if (statvfs(QFile::encodeName(existingPath(path)).constData(), &stats) == 0) {
+        return qint64(stats.f_bavail) * qint64(stats.f_frsize);
+    }
+
+    return -1;
+#else
+    Q_UNUSED(path)
+    return -1;
+#endif
+}
+
+QString Utils::storageVolume(const QString &path) {
+#if QT_VERSION >= 0x050400
+    return QStorageInfo(existingPath(path)).rootPath();
+#elif defined(Q_OS_UNIX)
+    struct stat stats;
+
+    if (stat(QFile::encodeName(existingPath(path)).constData(), &stats) == 0) {
+        return QString::number(qulonglong(stats.st_dev));
+    }
+
+    return QString();
+#else
+    Q_UNUSED(path)
+    return QString();
+#endif
+}
+
 QString Utils::getSaveDirectory(const QString &directory) {
     QDir dir;
 
@@ -195,3 +257,157 @@ QString Utils::urlQueryItemValue(const QUrl &url, const QString &queryItem, cons
     return url.hasQueryItem(queryItem) ? url.queryItemValue(queryItem) : defaultValue;
 #endif
 }
+
+struct HtmlEntity {
+    const char *name;
+    ushort code;
+};
+
+// Sorted by name, so that entities can be found by binary search
+static const HtmlEntity HTML_ENTITIES[] = {
+    { "AElig", 198 }, { "Aacute", 193 }, { "Acirc", 194 }, { "Agrave", 192 }, { "Alpha", 913 }, { "Aring", 197 },
+    { "Atilde", 195 }, { "Auml", 196 }, { "Beta", 914 }, { "Ccedil", 199 }, { "Chi", 935 }, { "Dagger", 8225 },
+    { "Delta", 916 }, { "ETH", 208 }, { "Eacute", 201 }, { "Ecirc", 202 }, { "Egrave", 200 }, { "Epsilon", 917 },
+    { "Eta", 919 }, { "Euml", 203 }, { "Gamma", 915 }, { "Iacute", 205 }, { "Icirc", 206 }, { "Igrave", 204 },
+    { "Iota", 921 }, { "Iuml", 207 }, { "Kappa", 922 }, { "Lambda", 923 }, { "Mu", 924 }, { "Ntilde", 209 },
+    { "Nu", 925 }, { "OElig", 338 }, { "Oacute", 211 }, { "Ocirc", 212 }, { "Ograve", 210 }, { "Omega", 937 },
+    { "Omicron", 927 }, { "Oslash", 216 }, { "Otilde", 213 }, { "Ouml", 214 }, { "Phi", 934 }, { "Pi", 928 },
+    { "Prime", 8243 }, { "Psi", 936 }, { "Rho", 929 }, { "Scaron", 352 }, { "Sigma", 931 }, { "THORN", 222 },
+    { "Tau", 932 }, { "Theta", 920 }, { "Uacute", 218 }, { "Ucirc", 219 }, { "Ugrave", 217 }, { "Upsilon", 933 },
+    { "Uuml", 220 }, { "Xi", 926 }, { "Yacute", 221 }, { "Yuml", 376 }, { "Zeta", 918 }, { "aacute", 225 },
+    { "acirc", 226 }, { "acute", 180 }, { "aelig", 230 }, { "agrave", 224 }, { "alefsym", 8501 }, { "alpha", 945 },
+    { "amp", 38 }, { "and", 8743 }, { "ang", 8736 }, { "apos", 39 }, { "aring", 229 }, { "asymp", 8776 },
+    { "atilde", 227 }, { "auml", 228 }, { "bdquo", 8222 }, { "beta", 946 }, { "brvbar", 166 }, { "bull", 8226 },
+    { "cap", 8745 }, { "ccedil", 231 }, { "cedil", 184 }, { "cent", 162 }, { "chi", 967 }, { "circ", 710 },
+    { "clubs", 9827 }, { "cong", 8773 }, { "copy", 169 }, { "crarr", 8629 }, { "cup", 8746 }, { "curren", 164 },
+    { "dArr", 8659 }, { "dagger", 8224 }, { "darr", 8595 }, { "deg", 176 }, { "delta", 948 }, { "diams", 9830 },
+    { "divide", 247 }, { "eacute", 233 }, { "ecirc", 234 }, { "egrave", 232 }, { "empty", 8709 }, { "emsp", 8195 },
+    { "ensp", 8194 }, { "epsilon", 949 }, { "equiv", 8801 }, { "eta", 951 }, { "eth", 240 }, { "euml", 235 },
+    { "euro", 8364 }, { "exist", 8707 }, { "fnof", 402 }, { "forall", 8704 }, { "frac12", 189 }, { "frac14", 188 },
+    { "frac34", 190 }, { "frasl", 8260 }, { "gamma", 947 }, { "ge", 8805 }, { "gt", 62 }, { "hArr", 8660 },
+    { "harr", 8596 }, { "hearts", 9829 }, { "hellip", 8230 }, { "iacute", 237 }, { "icirc", 238 }, { "iexcl", 161 },
+    { "igrave", 236 }, { "image", 8465 }, { "infin", 8734 }, { "int", 8747 }, { "iota", 953 }, { "iquest", 191 },
+    { "isin", 8712 }, { "iuml", 239 }, { "kappa", 954 }, { "lArr", 8656 }, { "lambda", 955 }, { "lang", 9001 },
+    { "laquo", 171 }, { "larr", 8592 }, { "lceil", 8968 }, { "ldquo", 8220 }, { "le", 8804 }, { "lfloor", 8970 },
+    { "lowast", 8727 }, { "loz", 9674 }, { "lrm", 8206 }, { "lsaquo", 8249 }, { "lsquo", 8216 }, { "lt", 60 },
+    { "macr", 175 }, { "mdash", 8212 }, { "micro", 181 }, { "middot", 183 }, { "minus", 8722 }, { "mu", 956 },
+    { "nabla", 8711 }, { "nbsp", 160 }, { "ndash", 8211 }, { "ne", 8800 }, { "ni", 8715 }, { "not", 172 },
+    { "notin", 8713 }, { "nsub", 8836 }, { "ntilde", 241 }, { "nu", 957 }, { "oacute", 243 }, { "ocirc", 244 },
+    { "oelig", 339 }, { "ograve", 242 }, { "oline", 8254 }, { "omega", 969 }, { "omicron", 959 }, { "oplus", 8853 },
+    { "or", 8744 }, { "ordf", 170 }, { "ordm", 186 }, { "oslash", 248 }, { "otilde", 245 }, { "otimes", 8855 },
+    { "ouml", 246 }, { "para", 182 }, { "part", 8706 }, { "permil", 8240 }, { "perp", 8869 }, { "phi", 966 },
+    { "pi", 960 }, { "piv", 982 }, { "plusmn", 177 }, { "pound", 163 }, { "prime", 8242 }, { "prod", 8719 },
+    { "prop", 8733 }, { "psi", 968 }, { "quot", 34 }, { "rArr", 8658 }, { "radic", 8730 }, { "rang", 9002 },
+    { "raquo", 187 }, { "rarr", 8594 }, { "rceil", 8969 }, { "rdquo", 8221 }, { "real", 8476 }, { "reg", 174 },
+    { "rfloor", 8971 }, { "rho", 961 }, { "rlm", 8207 }, { "rsaquo", 8250 }, { "rsquo", 8217 }, { "sbquo", 8218 },
+    { "scaron", 353 }, { "sdot", 8901 }, { "sect", 167 }, { "shy", 173 }, { "sigma", 963 }, { "sigmaf", 962 },
+    { "sim", 8764 }, { "spades", 9824 }, { "sub", 8834 }, { "sube", 8838 }, { "sum", 8721 }, { "sup", 8835 },
+    { "sup1", 185 }, { "sup2", 178 }, { "sup3", 179 }, { "supe", 8839 }, { "szlig", 223 }, { "tau", 964 },
+    { "there4", 8756 }, { "theta", 952 }, { "thetasym", 977 }, { "thinsp", 8201 }, { "thorn", 254 },
+    { "tilde", 732 }, { "times", 215 }, { "trade", 8482 }, { "uArr", 8657 }, { "uacute", 250 }, { "uarr", 8593 },
+    { "ucirc", 251 }, { "ugrave", 249 }, { "uml", 168 }, { "upsih", 978 }, { "upsilon", 965 }, { "uuml", 252 },
+    { "weierp", 8472 }, { "xi", 958 }, { "yacute", 253 }, { "yen", 165 }, { "yuml", 255 }, { "zeta", 950 },
+    { "zwj", 8205 }, { "zwnj", 8204 }
+};
+
+static const int HTML_ENTITY_COUNT = sizeof(HTML_ENTITIES) / sizeof(HtmlEntity);
+static const int HTML_ENTITY_MAX_LENGTH = 10;
+
+static uint htmlEntityCode(const QChar *name, int length) {
+    if (name[0] == '#') {
+        bool ok;
+        const QString number = QString(name + 1, length - 1);
+        const uint code = ((number.startsWith('x')) || (number.startsWith('X'))) ? number.mid(1).toUInt(&ok, 16)
+                                                                                   : number.toUInt(&ok, 10);
+        return (ok) && (code <= 0x10FFFF) ? code : 0;
+    }
+
+    char latin1[HTML_ENTITY_MAX_LENGTH + 1];
+
+    for (int i = 0; i < length; i++) {
+        latin1[i] = name[i].toLatin1();
+    }
+
+    latin1[length] = '\0';
+    int first = 0;
+    int last = HTML_ENTITY_COUNT - 1;
+
+    while (first <= last) {
+        const int middle = (first + last) / 2;
+        const int cmp = qstrcmp(HTML_ENTITIES[middle].name, latin1);
+
+        if (cmp == 0) {
+            return HTML_ENTITIES[middle].code;
+        }
+
+        if (cmp < 0) {
+            first = middle + 1;
+        }
+        else {
+            last = middle - 1;
+        }
+    }
+
+    return 0;
+}
+
+QString Utils::decodeHtml(const QString &text) {
+    int i = text.indexOf('&');
+
+    if (i == -1) {
+        return text;
+    }
+
+    // Each entity is replaced as it is found, so decoded text is never decoded again
+    const QChar *data = text.constData();
+    const int size = text.size();
+    QString result;
+    result.reserve(size);
+    int copied = 0;
+
+    while (i < size) {
+        if (data[i] != '&') {
+            ++i;
+            continue;
+        }
+
+        int end = i + 1;
+
+        while ((end < size) && (end - i <= HTML_ENTITY_MAX_LENGTH)
+               && ((data[end].isLetterOrNumber()) || ((end == i + 1) && (data[end] == '#')))) {
+            ++end;
+        }
+
+        const uint code = ((end < size) && (data[end] == ';') && (end - i > 1)
+                           && (end - i <= HTML_ENTITY_MAX_LENGTH)) ? htmlEntityCode(data + i + 1, end - i - 1) : 0;
+
+        if (code == 0) {
+            ++i;
+            continue;
+        }
+
+        result.append(text.midRef(copied, i - copied));
+
+        if (code > 0xFFFF) {
+            result.append(QChar(QChar::highSurrogate(code)));
+            result.append(QChar(QChar::lowSurrogate(code)));
+        }
+        else {
+            result.append(QChar(code));
+        }
+
+        i = end + 1;
+        copied = i;
+    }
+
+    result.append(text.midRef(copied));
+    return result;
+}
+
+QString Utils::encodeHtml(const QString &text) {
+#if QT_VERSION >= 0x050000
+    return text.toHtmlEscaped();
+#else
+    return Qt::escape(text);
+#endif
+}
@@ -38,6 +38,12 @@ public Q_SLOTS:
     static bool isSplitArchive(const QString &fileName);
     static bool belongsToArchive(const QString &fileName, const QString &archiveFileName);
 
+    static qint64 bytesAvailable(const QString &path);
+    static QString storageVolume(const QString &path);
+
+    static QString decodeHtml(const QString &text);
+    static QString encodeHtml(const QString &text);
+
     static QString getSanitizedFileName(const QString &fileName);
     static QString getSaveDirectory(const QString &directory);
     static QString getSaveFileName(const QString &fileName, const QString &outputDirectory);
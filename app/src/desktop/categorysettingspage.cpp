@@ -16,6 +16,9 @@
 
 #include "categorysettingspage.h"
 #include "categorymodel.h"
+#include "schedulingpolicy.h"
+#include "settings.h"
+#include <QComboBox>
 #include <QFileDialog>
 #include <QFormLayout>
 #include <QHeaderView>
@@ -30,6 +33,7 @@ CategorySettingsPage::CategorySettingsPage(QWidget *parent) :
     m_view(new QTreeView(this)),
     m_nameEdit(new QLineEdit(this)),
     m_pathEdit(new QLineEdit(this)),
+    m_policySelector(new QComboBox(this)),
     m_pathButton(new QPushButton(QIcon::fromTheme("document-open"), tr("&Browse"), this)),
     m_saveButton(new QPushButton(QIcon::fromTheme("document-save"), tr("&Save"), this)),
     m_layout(new QFormLayout(this))
@@ -49,10 +53,15 @@ CategorySettingsPage::CategorySettingsPage(QWidget *parent) :
 
     m_saveButton->setEnabled(false);
 
+    foreach (const int policy, SchedulingPolicy::types()) {
+        m_policySelector->addItem(SchedulingPolicy::typeString(policy), policy);
+    }
+
     m_layout->addRow(m_view);
     m_layout->addRow(tr("&Name:"), m_nameEdit);
     m_layout->addRow(tr("&Path:"), m_pathEdit);
     m_layout->addWidget(m_pathButton);
+    m_layout->addRow(tr("&Scheduling:"), m_policySelector);
     m_layout->addWidget(m_saveButton);
 
     connect(m_view, SIGNAL(clicked(QModelIndex)), this, SLOT(setCurrentCategory(QModelIndex)));
@@ -67,13 +76,18 @@ CategorySettingsPage::CategorySettingsPage(QWidget *parent) :
 
 void CategorySettingsPage::addCategory() {
     m_model->append(m_nameEdit->text(), m_pathEdit->text());
+    Settings::setSchedulingPolicy(m_nameEdit->text(),
+                                  m_policySelector->itemData(m_policySelector->currentIndex()).toInt());
     m_nameEdit->clear();
     m_pathEdit->clear();
+    m_policySelector->setCurrentIndex(0);
 }
 
 void CategorySettingsPage::setCurrentCategory(const QModelIndex &index) {
     m_nameEdit->setText(index.data(CategoryModel::NameRole).toString());
     m_pathEdit->setText(index.data(CategoryModel::ValueRole).toString());
+    m_policySelector->setCurrentIndex(qMax(0, m_policySelector->findData(Settings::schedulingPolicy(
+                                           m_nameEdit->text()))));
 }
 
 void CategorySettingsPage::showContextMenu(const QPoint &pos) {
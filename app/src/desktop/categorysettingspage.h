@@ -20,6 +20,7 @@
 #include "settingspage.h"
 
 class CategoryModel;
+class QComboBox;
 class QFormLayout;
 class QLineEdit;
 class QPushButton;
@@ -50,6 +51,8 @@ private:
     QLineEdit *m_nameEdit;
     QLineEdit *m_pathEdit;
 
+    QComboBox *m_policySelector;
+
     QPushButton *m_pathButton;
     QPushButton *m_saveButton;
 
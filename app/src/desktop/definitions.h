@@ -55,6 +55,7 @@ static const QString ERROR_ICON("gtk-no");
 // Config
 static const QString APP_CONFIG_PATH(HOME_PATH + "/.config/qdl2/");
 static const QString PLUGIN_CONFIG_PATH(APP_CONFIG_PATH + "plugins/");
+static const QString PLUGIN_MANIFEST_CACHE_FILE(APP_CONFIG_PATH + "pluginmanifests.json");
 
 // Downloads
 static const QString DOWNLOAD_PATH(HOME_PATH + "/Downloads/qdl2/");
@@ -66,6 +67,8 @@ static const int CAPTCHA_TIMEOUT = 300000;
 static const int DOWNLOAD_BUFFER_SIZE = 64000;
 static const int MAX_CONCURRENT_TRANSFERS = 4;
 static const int MAX_REDIRECTS = 8;
+static const int RETRY_DELAY = 5000;
+static const int MAX_RETRY_DELAY = 300000;
 static const QByteArray USER_AGENT("Mozilla/5.0 (X11; Linux x86_64; rv:53.0) Gecko/20100101 Firefox/53.0");
 
 // Web interface
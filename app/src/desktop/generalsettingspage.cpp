@@ -37,6 +37,8 @@ GeneralSettingsPage::GeneralSettingsPage(QWidget *parent) :
     m_pathButton(new QPushButton(QIcon::fromTheme("document-open"), tr("&Browse"), this)),
     m_passwordButton(new QPushButton(QIcon::fromTheme("list-add"), tr("&Add"), this)),
     m_concurrentSpinBox(new QSpinBox(this)),
+    m_minimumConcurrentSpinBox(new QSpinBox(this)),
+    m_adaptiveCheckBox(new QCheckBox(tr("Adjust concurrent downloads &automatically"), this)),
     m_commandCheckBox(new QCheckBox(tr("&Enable custom command"), this)),
     m_clipboardCheckBox(new QCheckBox(tr("Monitor &clipboard for URLs"), this)),
     m_extractCheckBox(new QCheckBox(tr("&Extract archives"), this)),
@@ -49,6 +51,7 @@ GeneralSettingsPage::GeneralSettingsPage(QWidget *parent) :
     m_passwordButton->setEnabled(false);
 
     m_concurrentSpinBox->setRange(1, MAX_CONCURRENT_TRANSFERS);
+    m_minimumConcurrentSpinBox->setRange(1, MAX_CONCURRENT_TRANSFERS);
 
     m_passwordView->setModel(m_passwordModel);
     m_passwordView->setContextMenuPolicy(Qt::CustomContextMenu);
@@ -56,6 +59,8 @@ GeneralSettingsPage::GeneralSettingsPage(QWidget *parent) :
     m_layout->addRow(tr("Download &path:"), m_pathEdit);
     m_layout->addWidget(m_pathButton);
     m_layout->addRow(tr("&Maximum concurrent downloads:"), m_concurrentSpinBox);
+    m_layout->addRow(m_adaptiveCheckBox);
+    m_layout->addRow(tr("M&inimum concurrent downloads:"), m_minimumConcurrentSpinBox);
     m_layout->addRow(tr("&Custom command (%f for filename):"), m_commandEdit);
     m_layout->addRow(m_commandCheckBox);
     m_layout->addRow(m_clipboardCheckBox);
@@ -66,6 +71,7 @@ GeneralSettingsPage::GeneralSettingsPage(QWidget *parent) :
     m_layout->addRow(tr("Add &password:"), m_passwordEdit);
     m_layout->addWidget(m_passwordButton);
 
+    connect(m_adaptiveCheckBox, SIGNAL(toggled(bool)), m_minimumConcurrentSpinBox, SLOT(setEnabled(bool)));
     connect(m_passwordEdit, SIGNAL(textChanged(QString)), this, SLOT(onPasswordChanged(QString)));
     connect(m_passwordEdit, SIGNAL(returnPressed()), m_passwordButton, SLOT(animateClick()));
     connect(m_pathButton, SIGNAL(clicked()), this, SLOT(showFileDialog()));
@@ -78,6 +84,9 @@ GeneralSettingsPage::GeneralSettingsPage(QWidget *parent) :
 void GeneralSettingsPage::restore() {
     m_pathEdit->setText(Settings::downloadPath());
     m_concurrentSpinBox->setValue(Settings::maximumConcurrentTransfers());
+    m_minimumConcurrentSpinBox->setValue(Settings::minimumConcurrentTransfers());
+    m_adaptiveCheckBox->setChecked(Settings::adaptiveConcurrentTransfers());
+    m_minimumConcurrentSpinBox->setEnabled(m_adaptiveCheckBox->isChecked());
     m_commandEdit->setText(Settings::customCommand());
     m_commandCheckBox->setChecked(Settings::customCommandEnabled());
     m_clipboardCheckBox->setChecked(Settings::clipboardMonitorEnabled());
@@ -88,6 +97,8 @@ void GeneralSettingsPage::restore() {
 void GeneralSettingsPage::save() {
     Settings::setDownloadPath(m_pathEdit->text());
     Settings::setMaximumConcurrentTransfers(m_concurrentSpinBox->value());
+    Settings::setMinimumConcurrentTransfers(m_minimumConcurrentSpinBox->value());
+    Settings::setAdaptiveConcurrentTransfers(m_adaptiveCheckBox->isChecked());
     Settings::setCustomCommand(m_commandEdit->text());
     Settings::setCustomCommandEnabled(m_commandCheckBox->isChecked());
     Settings::setClipboardMonitorEnabled(m_clipboardCheckBox->isChecked());
@@ -58,7 +58,9 @@ private:
     QPushButton *m_passwordButton;
 
     QSpinBox *m_concurrentSpinBox;
+    QSpinBox *m_minimumConcurrentSpinBox;
     
+    QCheckBox *m_adaptiveCheckBox;
     QCheckBox *m_commandCheckBox;
     QCheckBox *m_clipboardCheckBox;
     QCheckBox *m_extractCheckBox;
@@ -0,0 +1,108 @@
+/*
+ * Copyright (C) 2017 Stuart Howarth <showarth@marxoft.co.uk>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "logdialog.h"
+#include <QCheckBox>
+#include <QDialogButtonBox>
+#include <QPlainTextEdit>
+#include <QPushButton>
+#include <QScrollBar>
+#include <QTextCursor>
+#include <QVBoxLayout>
+
+static const int PAGE_SIZE = 500;
+static const int FOLLOW_INTERVAL = 1000;
+
+LogDialog::LogDialog(QWidget *parent) :
+    QDialog(parent),
+    m_firstOffset(0),
+    m_nextOffset(0),
+    m_edit(new QPlainTextEdit(this)),
+    m_followCheckBox(new QCheckBox(tr("&Follow"), this)),
+    m_earlierButton(new QPushButton(tr("Load &earlier lines"), this)),
+    m_buttonBox(new QDialogButtonBox(QDialogButtonBox::Close, Qt::Horizontal, this)),
+    m_layout(new QVBoxLayout(this))
+{
+    setWindowTitle(tr("Log"));
+    resize(800, 500);
+
+    m_edit->setReadOnly(true);
+    m_edit->setLineWrapMode(QPlainTextEdit::NoWrap);
+    
+    m_timer.setInterval(FOLLOW_INTERVAL);
+
+    m_buttonBox->addButton(m_earlierButton, QDialogButtonBox::ActionRole);
+
+    m_layout->addWidget(m_edit);
+    m_layout->addWidget(m_followCheckBox);
+    m_layout->addWidget(m_buttonBox);
+
+    // Pages are located by byte offset, so the file is never indexed
+    const LogReader::Page page = m_reader.tail(PAGE_SIZE);
+    m_firstOffset = page.offset;
+    m_nextOffset = page.nextOffset;
+    m_edit->setPlainText(page.lines.join("\n"));
+    m_edit->verticalScrollBar()->setValue(m_edit->verticalScrollBar()->maximum());
+    m_earlierButton->setEnabled(m_firstOffset > 0);
+
+    connect(&m_timer, SIGNAL(timeout()), this, SLOT(loadNewLines()));
+    connect(m_followCheckBox, SIGNAL(toggled(bool)), this, SLOT(setFollowing(bool)));
+    connect(m_earlierButton, SIGNAL(clicked()), this, SLOT(loadEarlierLines()));
+    connect(m_buttonBox, SIGNAL(rejected()), this, SLOT(reject()));
+}
+
+void LogDialog::loadEarlierLines() {
+    const LogReader::Page page = m_reader.before(m_firstOffset, PAGE_SIZE);
+
+    if (!page.lines.isEmpty()) {
+        QTextCursor cursor(m_edit->document());
+        cursor.movePosition(QTextCursor::Start);
+        cursor.insertText(page.lines.join("\n") + "\n");
+        m_firstOffset = page.offset;
+    }
+    else {
+        m_firstOffset = 0;
+    }
+
+    m_earlierButton->setEnabled(m_firstOffset > 0);
+}
+
+void LogDialog::loadNewLines() {
+    if (m_nextOffset > m_reader.size()) {
+        // The log has been cleared or rotated, so start again
+        m_edit->clear();
+        m_firstOffset = 0;
+        m_nextOffset = 0;
+        m_earlierButton->setEnabled(false);
+    }
+
+    const LogReader::Page page = m_reader.read(m_nextOffset, LogReader::MAXIMUM_LINES);
+    m_nextOffset = page.nextOffset;
+
+    foreach (const QString &line, page.lines) {
+        m_edit->appendPlainText(line);
+    }
+}
+
+void LogDialog::setFollowing(bool enabled) {
+    if (enabled) {
+        loadNewLines();
+        m_timer.start();
+    }
+    else {
+        m_timer.stop();
+    }
+}
@@ -0,0 +1,66 @@
+/*
+ * Copyright (C) 2017 Stuart Howarth <showarth@marxoft.co.uk>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LOGDIALOG_H
+#define LOGDIALOG_H
+
+#include "logreader.h"
+#include <QDialog>
+#include <QTimer>
+
+class QCheckBox;
+class QDialogButtonBox;
+class QPlainTextEdit;
+class QPushButton;
+class QVBoxLayout;
+
+/**
+ * Shows the most recent lines of the log. Earlier lines are loaded a page at a time, and new lines are
+ * appended while following is enabled.
+ */
+class LogDialog : public QDialog
+{
+    Q_OBJECT
+
+public:
+    explicit LogDialog(QWidget *parent = 0);
+
+private Q_SLOTS:
+    void loadEarlierLines();
+    void loadNewLines();
+
+    void setFollowing(bool enabled);
+
+private:
+    LogReader m_reader;
+
+    qint64 m_firstOffset;
+    qint64 m_nextOffset;
+
+    QTimer m_timer;
+
+    QPlainTextEdit *m_edit;
+
+    QCheckBox *m_followCheckBox;
+
+    QPushButton *m_earlierButton;
+
+    QDialogButtonBox *m_buttonBox;
+
+    QVBoxLayout *m_layout;
+};
+
+#endif // LOGDIALOG_H
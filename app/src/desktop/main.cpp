@@ -21,6 +21,7 @@
 #include "downloadrequestmodel.h"
 #include "javascriptpluginengine.h"
 #include "logger.h"
+#include "pluginmanifestcache.h"
 #include "qdl.h"
 #include "recaptchapluginmanager.h"
 #include "searchpluginmanager.h"
@@ -55,7 +56,8 @@ Q_DECL_EXPORT int main(int argc, char *argv[]) {
     QScopedPointer<ClipboardUrlModel> clipboard(ClipboardUrlModel::instance());
     QScopedPointer<DecaptchaPluginManager> decaptchaManager(DecaptchaPluginManager::instance());
     QScopedPointer<DownloadRequestModel> requester(DownloadRequestModel::instance());
-    QScopedPointer<JavaScriptPluginEngine> engine(JavaScriptPluginEngine::instance());
+    QScopedPointer<JavaScriptPluginEnginePool> engines(JavaScriptPluginEnginePool::instance());
+    QScopedPointer<PluginManifestCache> manifests(PluginManifestCache::instance());
     QScopedPointer<Qdl> qdl(Qdl::instance());
     QScopedPointer<RecaptchaPluginManager> recaptchaManager(RecaptchaPluginManager::instance());
     QScopedPointer<SearchPluginManager> searchManager(SearchPluginManager::instance());
@@ -78,6 +80,7 @@ Q_DECL_EXPORT int main(int argc, char *argv[]) {
     recaptchaManager.data()->load();
     searchManager.data()->load();
     serviceManager.data()->load();
+    manifests.data()->save();
     clipboard.data()->restore();
     transfers.data()->restore();
     
@@ -25,6 +25,7 @@
 #include "decaptchapluginmanager.h"
 #include "definitions.h"
 #include "downloadrequestdialog.h"
+#include "logdialog.h"
 #include "nocaptchadialog.h"
 #include "packagepropertiesdialog.h"
 #include "pluginsettingsdialog.h"
@@ -98,6 +99,7 @@ MainWindow::MainWindow(QWidget *parent) :
     m_transfersAction(new QAction(tr("Downloads"), this)),
     m_pluginsAction(new QAction(QIcon::fromTheme("view-refresh"), tr("&Load plugins"), this)),
     m_settingsAction(new QAction(QIcon::fromTheme("document-properties"), tr("&Preferences"), this)),
+    m_logAction(new QAction(QIcon::fromTheme("text-x-generic"), tr("Show &log"), this)),
     m_aboutAction(new QAction(QIcon::fromTheme("help-about"), tr("&About"), this)),
     m_transferPriorityGroup(new QActionGroup(this)),
     m_packageCategoryGroup(new QActionGroup(this)),
@@ -211,6 +213,7 @@ MainWindow::MainWindow(QWidget *parent) :
 
     m_toolsMenu->addAction(m_pluginsAction);
     m_toolsMenu->addAction(m_settingsAction);
+    m_toolsMenu->addAction(m_logAction);
 
     m_helpMenu->addAction(m_aboutAction);
 
@@ -351,6 +354,7 @@ MainWindow::MainWindow(QWidget *parent) :
     
     connect(m_pluginsAction, SIGNAL(triggered()), this, SLOT(loadPlugins()));
     connect(m_settingsAction, SIGNAL(triggered()), this, SLOT(showSettingsDialog()));
+    connect(m_logAction, SIGNAL(triggered()), this, SLOT(showLogDialog()));
     
     connect(m_aboutAction, SIGNAL(triggered()), this, SLOT(showAboutDialog()));
     
@@ -795,6 +799,10 @@ void MainWindow::showSettingsDialog() {
     SettingsDialog(this).exec();
 }
 
+void MainWindow::showLogDialog() {
+    LogDialog(this).exec();
+}
+
 void MainWindow::showAboutDialog() {
     AboutDialog(this).exec();
 }
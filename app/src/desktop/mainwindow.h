@@ -84,6 +84,7 @@ private Q_SLOTS:
     void showDownloadRequestDialog(const QStringList &urls);
     void showSearchDialog();
     void showSettingsDialog();
+    void showLogDialog();
     void showAboutDialog();
     
     void showCaptchaDialog(TransferItem *transfer);
@@ -144,6 +145,7 @@ private:
     
     QAction *m_pluginsAction;
     QAction *m_settingsAction;
+    QAction *m_logAction;
 
     QAction *m_aboutAction;
 
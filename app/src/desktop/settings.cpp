@@ -271,6 +271,155 @@ void Settings::setMaximumConcurrentTransfers(int maximum) {
     }
 }
 
+bool Settings::adaptiveConcurrentTransfers() {
+    return value("adaptiveConcurrentTransfers", false).toBool();
+}
+
+void Settings::setAdaptiveConcurrentTransfers(bool enabled) {
+    if (enabled != adaptiveConcurrentTransfers()) {
+        setValue("adaptiveConcurrentTransfers", enabled);
+
+        if (self) {
+            emit self->adaptiveConcurrentTransfersChanged(enabled);
+        }
+    }
+}
+
+int Settings::minimumConcurrentTransfers() {
+    return qBound(1, value("minimumConcurrentTransfers", 1).toInt(), 5);
+}
+
+void Settings::setMinimumConcurrentTransfers(int minimum) {
+    if (minimum != minimumConcurrentTransfers()) {
+        minimum = qBound(1, minimum, 5);
+        setValue("minimumConcurrentTransfers", minimum);
+
+        if (self) {
+            emit self->minimumConcurrentTransfersChanged(minimum);
+        }
+    }
+}
+
+int Settings::stallTimeout() {
+    return qMax(0, value("stallTimeout", 60).toInt());
+}
+
+void Settings::setStallTimeout(int timeout) {
+    if (timeout != stallTimeout()) {
+        timeout = qMax(0, timeout);
+        setValue("stallTimeout", timeout);
+
+        if (self) {
+            emit self->stallTimeoutChanged(timeout);
+        }
+    }
+}
+
+int Settings::minimumTransferSpeed() {
+    return qMax(0, value("minimumTransferSpeed", 0).toInt());
+}
+
+void Settings::setMinimumTransferSpeed(int speed) {
+    if (speed != minimumTransferSpeed()) {
+        speed = qMax(0, speed);
+        setValue("minimumTransferSpeed", speed);
+
+        if (self) {
+            emit self->minimumTransferSpeedChanged(speed);
+        }
+    }
+}
+
+int Settings::slowTransferTimeout() {
+    return qMax(0, value("slowTransferTimeout", 120).toInt());
+}
+
+void Settings::setSlowTransferTimeout(int timeout) {
+    if (timeout != slowTransferTimeout()) {
+        timeout = qMax(0, timeout);
+        setValue("slowTransferTimeout", timeout);
+
+        if (self) {
+            emit self->slowTransferTimeoutChanged(timeout);
+        }
+    }
+}
+
+int Settings::maximumTransferRetries() {
+    return qMax(0, value("maximumTransferRetries", 5).toInt());
+}
+
+void Settings::setMaximumTransferRetries(int retries) {
+    if (retries != maximumTransferRetries()) {
+        retries = qMax(0, retries);
+        setValue("maximumTransferRetries", retries);
+
+        if (self) {
+            emit self->maximumTransferRetriesChanged(retries);
+        }
+    }
+}
+
+// The CPU time that one call into a plugin script may use, in milliseconds. 0 means no limit
+int Settings::pluginScriptTimeLimit() {
+    return qMax(0, value("pluginScriptTimeLimit", 10000).toInt());
+}
+
+void Settings::setPluginScriptTimeLimit(int msecs) {
+    if (msecs != pluginScriptTimeLimit()) {
+        msecs = qMax(0, msecs);
+        setValue("pluginScriptTimeLimit", msecs);
+
+        if (self) {
+            emit self->pluginScriptTimeLimitChanged(msecs);
+        }
+    }
+}
+
+// The growth in resident memory of the whole process allowed during one call into a plugin script, in MiB.
+// Script engines do not report their own heap usage, so this also counts memory allocated by other threads
+// during the call. Memory is only measured on Linux. 0 means no limit
+int Settings::pluginScriptMemoryLimit() {
+    return qMax(0, value("pluginScriptMemoryLimit", 256).toInt());
+}
+
+void Settings::setPluginScriptMemoryLimit(int mebibytes) {
+    if (mebibytes != pluginScriptMemoryLimit()) {
+        mebibytes = qMax(0, mebibytes);
+        setValue("pluginScriptMemoryLimit", mebibytes);
+
+        if (self) {
+            emit self->pluginScriptMemoryLimitChanged(mebibytes);
+        }
+    }
+}
+
+int Settings::schedulingPolicy(const QString &category) {
+    return category.isEmpty() ? 0 : value("SchedulingPolicies/" + category, 0).toInt();
+}
+
+QVariantMap Settings::schedulingPolicies() {
+    QSettings settings(APP_CONFIG_PATH + "settings", QSettings::IniFormat);
+    settings.beginGroup("SchedulingPolicies");
+    QVariantMap policies;
+
+    foreach (const QString &category, settings.childKeys()) {
+        policies[category] = settings.value(category, 0).toInt();
+    }
+
+    return policies;
+}
+
+void Settings::setSchedulingPolicy(const QString &category, int policy) {
+    if ((!category.isEmpty()) && (policy != schedulingPolicy(category))) {
+        setValue("SchedulingPolicies/" + category, policy);
+
+        if (self) {
+            emit self->schedulingPolicyChanged(category, policy);
+        }
+    }
+}
+
 bool Settings::startTransfersAutomatically() {
     return value("startTransfersAutomatically", true).toBool();
 }
@@ -18,6 +18,7 @@
 #define SETTINGS_H
 
 #include <QObject>
+#include <QVariantMap>
 
 class Settings : public QObject
 {
@@ -46,6 +47,21 @@ class Settings : public QObject
     Q_PROPERTY(int loggerVerbosity READ loggerVerbosity WRITE setLoggerVerbosity NOTIFY loggerVerbosityChanged)
     Q_PROPERTY(int maximumConcurrentTransfers READ maximumConcurrentTransfers WRITE setMaximumConcurrentTransfers
                NOTIFY maximumConcurrentTransfersChanged)
+    Q_PROPERTY(bool adaptiveConcurrentTransfers READ adaptiveConcurrentTransfers WRITE setAdaptiveConcurrentTransfers
+               NOTIFY adaptiveConcurrentTransfersChanged)
+    Q_PROPERTY(int minimumConcurrentTransfers READ minimumConcurrentTransfers WRITE setMinimumConcurrentTransfers
+               NOTIFY minimumConcurrentTransfersChanged)
+    Q_PROPERTY(int stallTimeout READ stallTimeout WRITE setStallTimeout NOTIFY stallTimeoutChanged)
+    Q_PROPERTY(int minimumTransferSpeed READ minimumTransferSpeed WRITE setMinimumTransferSpeed
+               NOTIFY minimumTransferSpeedChanged)
+    Q_PROPERTY(int slowTransferTimeout READ slowTransferTimeout WRITE setSlowTransferTimeout
+               NOTIFY slowTransferTimeoutChanged)
+    Q_PROPERTY(int maximumTransferRetries READ maximumTransferRetries WRITE setMaximumTransferRetries
+               NOTIFY maximumTransferRetriesChanged)
+    Q_PROPERTY(int pluginScriptTimeLimit READ pluginScriptTimeLimit WRITE setPluginScriptTimeLimit
+               NOTIFY pluginScriptTimeLimitChanged)
+    Q_PROPERTY(int pluginScriptMemoryLimit READ pluginScriptMemoryLimit WRITE setPluginScriptMemoryLimit
+               NOTIFY pluginScriptMemoryLimitChanged)
     Q_PROPERTY(bool startTransfersAutomatically READ startTransfersAutomatically WRITE setStartTransfersAutomatically
                NOTIFY startTransfersAutomaticallyChanged)
     Q_PROPERTY(int nextAction READ nextAction WRITE setNextAction NOTIFY nextActionChanged)
@@ -104,6 +120,16 @@ public:
     static int loggerVerbosity();
 
     static int maximumConcurrentTransfers();
+    static bool adaptiveConcurrentTransfers();
+    static int minimumConcurrentTransfers();
+    static int stallTimeout();
+    static int minimumTransferSpeed();
+    static int slowTransferTimeout();
+    static int maximumTransferRetries();
+    static int pluginScriptTimeLimit();
+    static int pluginScriptMemoryLimit();
+    static int schedulingPolicy(const QString &category);
+    static QVariantMap schedulingPolicies();
     static bool startTransfersAutomatically();
 
     static int nextAction();
@@ -153,6 +179,15 @@ public Q_SLOTS:
     static void setLoggerVerbosity(int verbosity);
 
     static void setMaximumConcurrentTransfers(int maximum);
+    static void setAdaptiveConcurrentTransfers(bool enabled);
+    static void setMinimumConcurrentTransfers(int minimum);
+    static void setStallTimeout(int timeout);
+    static void setMinimumTransferSpeed(int speed);
+    static void setSlowTransferTimeout(int timeout);
+    static void setMaximumTransferRetries(int retries);
+    static void setPluginScriptTimeLimit(int msecs);
+    static void setPluginScriptMemoryLimit(int mebibytes);
+    static void setSchedulingPolicy(const QString &category, int policy);
 
     static void setNextAction(int action);
 
@@ -195,6 +230,15 @@ Q_SIGNALS:
     void loggerFileNameChanged(const QString &fileName);
     void loggerVerbosityChanged(int verbosity);
     void maximumConcurrentTransfersChanged(int maximum);
+    void adaptiveConcurrentTransfersChanged(bool enabled);
+    void minimumConcurrentTransfersChanged(int minimum);
+    void stallTimeoutChanged(int timeout);
+    void minimumTransferSpeedChanged(int speed);
+    void slowTransferTimeoutChanged(int timeout);
+    void maximumTransferRetriesChanged(int retries);
+    void pluginScriptTimeLimitChanged(int msecs);
+    void pluginScriptMemoryLimitChanged(int mebibytes);
+    void schedulingPolicyChanged(const QString &category, int policy);
     void nextActionChanged(int action);
     void startTransfersAutomaticallyChanged(bool enabled);
     void networkProxyEnabledChanged(bool enabled);
@@ -41,7 +41,9 @@ SettingsDialog::SettingsDialog(QWidget *parent) :
     m_container(new QWidget(m_scrollArea)),
     m_downloadPathButton(new QMaemo5ValueButton(tr("Default download path"), m_container)),
     m_concurrentSelector(new ValueSelector(tr("Maximum concurrent downloads"), m_container)),
+    m_minimumConcurrentSelector(new ValueSelector(tr("Minimum concurrent downloads"), m_container)),
     m_commandEdit(new QLineEdit(Settings::customCommand(), m_container)),
+    m_adaptiveCheckBox(new QCheckBox(tr("Adjust concurrent downloads automatically"), m_container)),
     m_commandCheckBox(new QCheckBox(tr("Enable custom command"), m_container)),
     m_subfoldersCheckBox(new QCheckBox(tr("Create subfolders for downloads"), m_container)),
     m_clipboardCheckBox(new QCheckBox(tr("Monitor clipboard for URLs"), m_container)),
@@ -67,6 +69,10 @@ SettingsDialog::SettingsDialog(QWidget *parent) :
     m_downloadPathButton->setValueText(Settings::downloadPath());
     m_concurrentSelector->setModel(m_concurrentModel);
     m_concurrentSelector->setValue(Settings::maximumConcurrentTransfers());
+    m_minimumConcurrentSelector->setModel(m_concurrentModel);
+    m_minimumConcurrentSelector->setValue(Settings::minimumConcurrentTransfers());
+    m_minimumConcurrentSelector->setEnabled(Settings::adaptiveConcurrentTransfers());
+    m_adaptiveCheckBox->setChecked(Settings::adaptiveConcurrentTransfers());
     m_commandCheckBox->setChecked(Settings::customCommandEnabled());
     m_subfoldersCheckBox->setChecked(Settings::createSubfolders());
     m_clipboardCheckBox->setChecked(Settings::clipboardMonitorEnabled());
@@ -79,6 +85,8 @@ SettingsDialog::SettingsDialog(QWidget *parent) :
                                         .arg(midColor).arg(tr("General")), m_container));
     m_vbox->addWidget(m_downloadPathButton);
     m_vbox->addWidget(m_concurrentSelector);
+    m_vbox->addWidget(m_adaptiveCheckBox);
+    m_vbox->addWidget(m_minimumConcurrentSelector);
     m_vbox->addWidget(m_subfoldersCheckBox);
     m_vbox->addWidget(m_clipboardCheckBox);
     m_vbox->addWidget(new QLabel(tr("Custom command (%f for filename)"), m_container));
@@ -106,6 +114,7 @@ SettingsDialog::SettingsDialog(QWidget *parent) :
     m_layout->addWidget(m_scrollArea);
     m_layout->addWidget(m_buttonBox);
 
+    connect(m_adaptiveCheckBox, SIGNAL(toggled(bool)), m_minimumConcurrentSelector, SLOT(setEnabled(bool)));
     connect(m_downloadPathButton, SIGNAL(clicked()), this, SLOT(showFileDialog()));
     connect(m_passwordsButton, SIGNAL(clicked()), this, SLOT(showArchivePasswordsDialog()));
     connect(m_proxyButton, SIGNAL(clicked()), this, SLOT(showNetworkProxyDialog()));
@@ -121,6 +130,8 @@ SettingsDialog::SettingsDialog(QWidget *parent) :
 void SettingsDialog::accept() {
     Settings::setDownloadPath(m_downloadPathButton->valueText());
     Settings::setMaximumConcurrentTransfers(m_concurrentSelector->currentValue().toInt());
+    Settings::setMinimumConcurrentTransfers(m_minimumConcurrentSelector->currentValue().toInt());
+    Settings::setAdaptiveConcurrentTransfers(m_adaptiveCheckBox->isChecked());
     Settings::setCustomCommand(m_commandEdit->text());
     Settings::setCustomCommandEnabled(m_commandCheckBox->isChecked());
     Settings::setCreateSubfolders(m_subfoldersCheckBox->isChecked());
@@ -60,9 +60,11 @@ private:
     QMaemo5ValueButton *m_downloadPathButton;
 
     ValueSelector *m_concurrentSelector;
+    ValueSelector *m_minimumConcurrentSelector;
     
     QLineEdit *m_commandEdit;
     
+    QCheckBox *m_adaptiveCheckBox;
     QCheckBox *m_commandCheckBox;
     QCheckBox *m_subfoldersCheckBox;
     QCheckBox *m_clipboardCheckBox;
@@ -17,9 +17,8 @@
 
 #include "decaptchapluginconfig.h"
 #include "definitions.h"
-#include "json.h"
 #include "logger.h"
-#include <QFile>
+#include "pluginmanifestcache.h"
 
 DecaptchaPluginConfig::DecaptchaPluginConfig(QObject *parent) :
     QObject(parent),
@@ -61,23 +60,13 @@ int DecaptchaPluginConfig::version() const {
 
 bool DecaptchaPluginConfig::load(const QString &filePath) {
     m_filePath = filePath;
-    QFile file(filePath);
-
-    if ((!file.exists()) || (!file.open(QFile::ReadOnly))) {
-        Logger::log("DecaptchaPluginConfig::load(): Unable to open config file: " + filePath);
-        return false;
-    }
-
     bool ok;
-    const QVariant v = QtJson::Json::parse(QString::fromUtf8(file.readAll()), ok);
-    file.close();
+    const QVariantMap config = PluginManifestCache::instance()->manifest(filePath, &ok);
 
     if (!ok) {
-        Logger::log("DecaptchaPluginConfig::load(): Error parsing config file: " + filePath);
+        Logger::log("DecaptchaPluginConfig::load(): Unable to load config file: " + filePath);
         return false;
     }
-
-    const QVariantMap config = v.toMap();
     
     if (!config.contains("name")) {
         Logger::log("DecaptchaPluginConfig::load(): 'name' parameter is missing");
@@ -19,11 +19,13 @@
 #include "definitions.h"
 #include "javascriptdecaptchaplugin.h"
 #include "javascriptpluginengine.h"
+#include "lazypluginfactory.h"
 #include "logger.h"
 #include <QDir>
 #include <QFileInfo>
 #include <QNetworkAccessManager>
-#include <QPluginLoader>
+
+typedef LazyPluginFactory<DecaptchaPluginFactory, DecaptchaPlugin> LazyDecaptchaPluginFactory;
 
 static bool displayNameLessThan(const DecaptchaPluginPair &pair, const DecaptchaPluginPair &other) {
     return QString::localeAwareCompare(pair.config->displayName(), other.config->displayName()) < 0;
@@ -57,38 +59,38 @@ DecaptchaPluginList DecaptchaPluginManager::plugins() const {
 DecaptchaPluginConfig* DecaptchaPluginManager::getConfigById(const QString &id) const {
     foreach (const DecaptchaPluginPair &pair, m_plugins) {
         if (pair.config->id() == id) {
-            Logger::log("DecaptchaPluginManager::getConfigById(). Config found: " + id, Logger::HighVerbosity);
+            QDL_LOG(Logger::HighVerbosity, "DecaptchaPluginManager::getConfigById(). Config found: " + id);
             return pair.config;
         }
     }
     
-    Logger::log("DecaptchaPluginManager::getConfigById(). No config found for id " + id, Logger::HighVerbosity);
+    QDL_LOG(Logger::HighVerbosity, "DecaptchaPluginManager::getConfigById(). No config found for id " + id);
     return 0;
 }
 
 DecaptchaPluginConfig* DecaptchaPluginManager::getConfigByFilePath(const QString &filePath) const {
     foreach (const DecaptchaPluginPair &pair, m_plugins) {
         if (pair.config->filePath() == filePath) {
-            Logger::log("DecaptchaPluginManager::getConfigByFilePath(). Config found: " + pair.config->id(),
-                        Logger::HighVerbosity);
+            QDL_LOG(Logger::HighVerbosity,
+                    "DecaptchaPluginManager::getConfigByFilePath(). Config found: " + pair.config->id());
             return pair.config;
         }
     }
     
-    Logger::log("DecaptchaPluginManager::getConfigByFilePath(). No config found for filePath " + filePath,
-                Logger::HighVerbosity);
+    QDL_LOG(Logger::HighVerbosity,
+            "DecaptchaPluginManager::getConfigByFilePath(). No config found for filePath " + filePath);
     return 0;
 }
 
 DecaptchaPluginFactory* DecaptchaPluginManager::getFactoryById(const QString &id) const {
     foreach (const DecaptchaPluginPair &pair, m_plugins) {
         if (pair.config->id() == id) {
-            Logger::log("DecaptchaPluginManager::getFactoryById(). Factory found: " + id, Logger::HighVerbosity);
+            QDL_LOG(Logger::HighVerbosity, "DecaptchaPluginManager::getFactoryById(). Factory found: " + id);
             return pair.factory;
         }
     }
     
-    Logger::log("DecaptchaPluginManager::getFactoryById(). No factory found for id " + id, Logger::HighVerbosity);
+    QDL_LOG(Logger::HighVerbosity, "DecaptchaPluginManager::getFactoryById(). No factory found for id " + id);
     return 0;
 }
 
@@ -108,8 +110,8 @@ QNetworkAccessManager* DecaptchaPluginManager::networkAccessManager() {
 }
 
 int DecaptchaPluginManager::load() {
-    Logger::log("DecaptchaPluginManager::load(): Loading plugins modified since "
-                + m_lastLoaded.toString(Qt::ISODate), Logger::LowVerbosity);
+    QDL_LOG(Logger::LowVerbosity, "DecaptchaPluginManager::load(): Loading plugins modified since "
+            + m_lastLoaded.toString(Qt::ISODate));
     int count = 0;
     QDir dir;
     
@@ -127,32 +129,25 @@ int DecaptchaPluginManager::load() {
                         if (config->pluginType() == "js") {
                             JavaScriptDecaptchaPluginFactory *js =
                                 new JavaScriptDecaptchaPluginFactory(config->pluginFilePath(),
-                                        JavaScriptPluginEngine::instance(), this);
+                                        JavaScriptPluginEnginePool::instance()->engine(), this);
                             m_plugins << DecaptchaPluginPair(config, js);
                             ++count;
-                            Logger::log("DecaptchaPluginManager::load(). JavaScript plugin loaded: "
-                                        + config->id(), Logger::MediumVerbosity);
+                            QDL_LOG(Logger::MediumVerbosity,
+                                    "DecaptchaPluginManager::load(). JavaScript plugin loaded: "
+                                    + config->id());
+                        }
+                        else if (QFileInfo(config->pluginFilePath()).exists()) {
+                            // The library is loaded when the first plugin is created
+                            m_plugins << DecaptchaPluginPair(config,
+                                    new LazyDecaptchaPluginFactory(config->pluginFilePath(), this));
+                            ++count;
+                            QDL_LOG(Logger::MediumVerbosity,
+                                    "DecaptchaPluginManager::load(). Qt plugin found: " + config->id());
                         }
                         else {
-                            QPluginLoader loader(config->pluginFilePath());
-                            QObject *obj = loader.instance();
-                            
-                            if (obj) {
-                                if (DecaptchaPluginFactory *factory = qobject_cast<DecaptchaPluginFactory*>(obj)) {
-                                    m_plugins << DecaptchaPluginPair(config, factory);
-                                    ++count;
-                                    Logger::log("DecaptchaPluginManager::load(). Qt Plugin loaded: "
-                                                + config->id(), Logger::MediumVerbosity);
-                                }
-                                else {
-                                    loader.unload();
-                                    Logger::log("DecaptchaPluginManager::load(). Error loading Qt plugin: "
-                                                + config->id());
-                                }
-                            }
-                            else {
-                                Logger::log("DecaptchaPluginManager::load(). Qt plugin is NULL: " + config->id());
-                            }
+                            QDL_LOG(Logger::LowestVerbosity,
+                                    "DecaptchaPluginManager::load(). Qt plugin library not found: " + config->id());
+                            delete config;
                         }
                     }
                     else {
@@ -166,7 +161,7 @@ int DecaptchaPluginManager::load() {
         }
     }
     
-    Logger::log(QString("DecaptchaPluginManager::load() %1 plugins loaded").arg(count), Logger::LowVerbosity);
+    QDL_LOG(Logger::LowVerbosity, QString("DecaptchaPluginManager::load() %1 plugins loaded").arg(count));
 
     if (count > 0) {
         qSort(m_plugins.begin(), m_plugins.end(), displayNameLessThan);
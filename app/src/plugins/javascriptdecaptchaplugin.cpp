@@ -15,27 +15,39 @@
  */
 
 #include "javascriptdecaptchaplugin.h"
+#include "javascriptpluginengine.h"
+#include "javascriptpluginwatchdog.h"
 #include "logger.h"
-#include <QFile>
 
-JavaScriptDecaptchaPlugin::JavaScriptDecaptchaPlugin(const QScriptValue &plugin, QObject *parent) :
+JavaScriptDecaptchaPlugin::JavaScriptDecaptchaPlugin(const QString &fileName, JavaScriptPluginEngine *engine,
+        QObject *parent) :
     DecaptchaPlugin(parent),
-    m_plugin(plugin),
+    m_engine(engine),
+    m_fileName(fileName),
     m_initted(false)
 {
 }
 
-JavaScriptDecaptchaPlugin::~JavaScriptDecaptchaPlugin() {
-    if (QScriptEngine *engine = m_plugin.engine()) {
-        engine->collectGarbage();
-    }
-}
-
 bool JavaScriptDecaptchaPlugin::init() {
     if (m_initted) {
         return true;
     }
 
+    if (!m_engine) {
+        Logger::log("JavaScriptDecaptchaPlugin::init(): No JavaScript engine");
+        return false;
+    }
+
+    if (!m_plugin.isValid()) {
+        const QScriptValue constructor = m_engine->pluginConstructor(m_fileName);
+
+        if (!constructor.isFunction()) {
+            return false;
+        }
+
+        m_plugin = constructor.construct();
+    }
+
     if (!m_plugin.property("cancelCurrentOperation").isFunction()) {
         Logger::log("JavaScriptDecaptchaPlugin::init(): No cancelCurrentOperation() function found");
         return false;
@@ -70,6 +82,8 @@ bool JavaScriptDecaptchaPlugin::init() {
 }
 
 bool JavaScriptDecaptchaPlugin::cancelCurrentOperation() {
+    const JavaScriptPluginScope scope(m_engine, this, m_fileName);
+
     if (!init()) {
         error(tr("Plugin not initialized"));
         return false;
@@ -80,6 +94,8 @@ bool JavaScriptDecaptchaPlugin::cancelCurrentOperation() {
 
 void JavaScriptDecaptchaPlugin::getCaptchaResponse(int captchaType, const QByteArray &captchaData,
         const QVariantMap &settings) {
+    const JavaScriptPluginScope scope(m_engine, this, m_fileName);
+
     if (!init()) {
         error(tr("Plugin not initialized"));
         return;
@@ -97,6 +113,8 @@ void JavaScriptDecaptchaPlugin::getCaptchaResponse(int captchaType, const QByteA
 }
 
 void JavaScriptDecaptchaPlugin::reportCaptchaResponse(const QString &captchaId) {
+    const JavaScriptPluginScope scope(m_engine, this, m_fileName);
+
     if (!init()) {
         error(tr("Plugin not initialized"));
         return;
@@ -114,6 +132,8 @@ void JavaScriptDecaptchaPlugin::reportCaptchaResponse(const QString &captchaId)
 }
 
 void JavaScriptDecaptchaPlugin::submitSettingsResponse(const QVariantMap &settings) {
+    const JavaScriptPluginScope scope(m_engine, this, m_fileName);
+
     if (!init()) {
         error(tr("Plugin not initialized"));
         return;
@@ -156,7 +176,7 @@ void JavaScriptDecaptchaPlugin::submitSettingsResponse(const QVariantMap &settin
 void JavaScriptDecaptchaPlugin::onSettingsRequest(const QString &title, const QVariantList &settings,
         const QScriptValue &callback) {
     m_callback = callback;
-    emit settingsRequest(title, settings, "submitSettingsRepsonse");
+    emit settingsRequest(title, settings, "submitSettingsResponse");
 }
 
 JavaScriptDecaptchaPluginSignaller::JavaScriptDecaptchaPluginSignaller(QObject *parent) :
@@ -164,56 +184,77 @@ JavaScriptDecaptchaPluginSignaller::JavaScriptDecaptchaPluginSignaller(QObject *
 {
 }
 
-JavaScriptDecaptchaPluginFactory::JavaScriptDecaptchaPluginFactory(const QString &fileName, QScriptEngine *engine,
-        QObject *parent) :
-    QObject(parent),
-    m_engine(engine),
-    m_fileName(fileName),
-    m_initted(false)
+JavaScriptDecaptchaPluginProxy::JavaScriptDecaptchaPluginProxy(DecaptchaPlugin *plugin, QObject *parent) :
+    DecaptchaPlugin(parent),
+    m_plugin(plugin)
 {
+    connectPlugin();
 }
 
-DecaptchaPlugin* JavaScriptDecaptchaPluginFactory::createPlugin(QObject *parent) {
-    if (init()) {
-        return new JavaScriptDecaptchaPlugin(m_constructor.construct(), parent);
+JavaScriptDecaptchaPluginProxy::~JavaScriptDecaptchaPluginProxy() {
+    // The plugin must be deleted in the thread of its engine, which deletes it itself if it has already finished
+    if (m_plugin) {
+        m_plugin->deleteLater();
     }
-
-    return 0;
 }
 
-bool JavaScriptDecaptchaPluginFactory::init() {
-    if (m_initted) {
-        return true;
-    }
-    
-    if (!m_engine) {
-        Logger::log("JavaScriptDecaptchaPluginFactory::init(): No JavaScript engine");
-        return false;
+bool JavaScriptDecaptchaPluginProxy::cancelCurrentOperation() {
+    if (m_plugin) {
+        // A script may still be running in the thread of the engine, so the plugin is not waited for. Its signals are
+        // dropped until the next request instead
+        disconnect(m_plugin, 0, this, 0);
+        QMetaObject::invokeMethod(m_plugin, "cancelCurrentOperation", Qt::QueuedConnection);
     }
 
-    QFile file(m_fileName);
+    return true;
+}
 
-    if (!file.open(QFile::ReadOnly)) {
-        Logger::log("JavaScriptDecaptchaPluginFactory::init(): Cannot read file: " + m_fileName);
-        return false;
+void JavaScriptDecaptchaPluginProxy::getCaptchaResponse(int captchaType, const QByteArray &captchaData,
+        const QVariantMap &settings) {
+    connectPlugin();
+    QMetaObject::invokeMethod(m_plugin, "getCaptchaResponse", Qt::QueuedConnection,
+            Q_ARG(int, captchaType), Q_ARG(QByteArray, captchaData), Q_ARG(QVariantMap, settings));
+}
+
+void JavaScriptDecaptchaPluginProxy::reportCaptchaResponse(const QString &captchaId) {
+    connectPlugin();
+    QMetaObject::invokeMethod(m_plugin, "reportCaptchaResponse", Qt::QueuedConnection, Q_ARG(QString, captchaId));
+}
+
+void JavaScriptDecaptchaPluginProxy::submitSettingsResponse(const QVariantMap &settings) {
+    QMetaObject::invokeMethod(m_plugin, "submitSettingsResponse", Qt::QueuedConnection, Q_ARG(QVariantMap, settings));
+}
+
+void JavaScriptDecaptchaPluginProxy::connectPlugin() {
+    if (!m_plugin) {
+        return;
     }
 
-    m_constructor = m_engine->evaluate(QString::fromUtf8(file.readAll()), m_fileName);
-    file.close();
+    connect(m_plugin, SIGNAL(captchaResponse(QString, QString)),
+            this, SIGNAL(captchaResponse(QString, QString)), Qt::UniqueConnection);
+    connect(m_plugin, SIGNAL(captchaResponseReported(QString)),
+            this, SIGNAL(captchaResponseReported(QString)), Qt::UniqueConnection);
+    connect(m_plugin, SIGNAL(error(QString)), this, SIGNAL(error(QString)), Qt::UniqueConnection);
+    connect(m_plugin, SIGNAL(settingsRequest(QString, QVariantList, QByteArray)),
+            this, SIGNAL(settingsRequest(QString, QVariantList, QByteArray)), Qt::UniqueConnection);
+}
 
-    if (!m_constructor.isFunction()) {
-        if (m_constructor.isError()) {
-            Logger::log("JavaScriptDecaptchaPluginFactory::init(): Error evaluating JavaScript file: "
-                    + m_constructor.toString());
-        }
-        else {
-            Logger::log("JavaScriptDecaptchaPluginFactory::init(): No constructor function");
-        }
+JavaScriptDecaptchaPluginFactory::JavaScriptDecaptchaPluginFactory(const QString &fileName,
+        JavaScriptPluginEngine *engine, QObject *parent) :
+    QObject(parent),
+    m_engine(engine),
+    m_fileName(fileName)
+{
+}
 
-        return false;
+DecaptchaPlugin* JavaScriptDecaptchaPluginFactory::createPlugin(QObject *parent) {
+    if (!m_engine) {
+        Logger::log("JavaScriptDecaptchaPluginFactory::createPlugin(): No JavaScript engine");
+        return 0;
     }
 
-    Logger::log("JavaScriptDecaptchaPluginFactory::init(): Initialized OK", Logger::HighVerbosity);
-    m_initted = true;
-    return true;
+    // The script is evaluated in the thread of the engine when the plugin is first used
+    JavaScriptDecaptchaPlugin *plugin = new JavaScriptDecaptchaPlugin(m_fileName, m_engine);
+    JavaScriptPluginEnginePool::instance()->addPlugin(plugin, m_engine->thread());
+    return new JavaScriptDecaptchaPluginProxy(plugin, parent);
 }
@@ -21,13 +21,14 @@
 #include <QPointer>
 #include <QScriptEngine>
 
+class JavaScriptPluginEngine;
+
 class JavaScriptDecaptchaPlugin : public DecaptchaPlugin
 {
     Q_OBJECT
 
 public:
-    explicit JavaScriptDecaptchaPlugin(const QScriptValue &plugin, QObject *parent = 0);
-    ~JavaScriptDecaptchaPlugin();
+    explicit JavaScriptDecaptchaPlugin(const QString &fileName, JavaScriptPluginEngine *engine, QObject *parent = 0);
 
 public Q_SLOTS:
     virtual bool cancelCurrentOperation();
@@ -42,6 +43,10 @@ private Q_SLOTS:
 
 private:
     bool init();
+
+    QPointer<JavaScriptPluginEngine> m_engine;
+
+    QString m_fileName;
     
     QScriptValue m_plugin;
     QScriptValue m_callback;
@@ -49,6 +54,34 @@ private:
     bool m_initted;
 };
 
+/**
+ * Forwards calls to a JavaScript decaptcha plugin in the thread of its engine, and re-emits its signals.
+ *
+ * All calls are queued and return at once. After cancelCurrentOperation(), the signals of the plugin are not
+ * forwarded until the next request.
+ */
+class JavaScriptDecaptchaPluginProxy : public DecaptchaPlugin
+{
+    Q_OBJECT
+
+public:
+    explicit JavaScriptDecaptchaPluginProxy(DecaptchaPlugin *plugin, QObject *parent = 0);
+    ~JavaScriptDecaptchaPluginProxy();
+
+public Q_SLOTS:
+    virtual bool cancelCurrentOperation();
+    
+    virtual void getCaptchaResponse(int captchaType, const QByteArray &captchaData, const QVariantMap &settings);
+    virtual void reportCaptchaResponse(const QString &captchaId);
+    
+    void submitSettingsResponse(const QVariantMap &settings);
+
+private:
+    void connectPlugin();
+
+    QPointer<DecaptchaPlugin> m_plugin;
+};
+
 class JavaScriptDecaptchaPluginSignaller : public QObject
 {
     Q_OBJECT
@@ -69,20 +102,15 @@ class JavaScriptDecaptchaPluginFactory : public QObject, public DecaptchaPluginF
     Q_INTERFACES(DecaptchaPluginFactory)
 
 public:
-    explicit JavaScriptDecaptchaPluginFactory(const QString &fileName, QScriptEngine *engine, QObject *parent = 0);
+    explicit JavaScriptDecaptchaPluginFactory(const QString &fileName, JavaScriptPluginEngine *engine,
+            QObject *parent = 0);
 
     virtual DecaptchaPlugin* createPlugin(QObject *parent = 0);
 
 private:
-    bool init();
-
-    QPointer<QScriptEngine> m_engine;
+    QPointer<JavaScriptPluginEngine> m_engine;
 
     QString m_fileName;
-
-    QScriptValue m_constructor;
-
-    bool m_initted;
 };
 
 #endif // JAVASCRIPTDECAPTCHAPLUGIN_H
@@ -16,20 +16,184 @@
 
 #include "javascriptpluginengine.h"
 #include "javascriptpluginglobalobject.h"
+#include "javascriptpluginwatchdog.h"
+#include "logger.h"
+#include "searchresult.h"
+#include "urlresult.h"
+#include <QCoreApplication>
+#include <QEvent>
+#include <QFile>
+#include <QMutex>
+#include <QNetworkRequest>
+#include <QPointer>
+#include <QThread>
+#include <QWaitCondition>
 
-JavaScriptPluginEngine* JavaScriptPluginEngine::self = 0;
+static const int MAX_ENGINES = 4;
 
-JavaScriptPluginEngine::JavaScriptPluginEngine() :
-    QScriptEngine(),
-    m_global(new JavaScriptPluginGlobalObject(this))
+class JavaScriptPluginEngineThread : public QThread
+{
+
+public:
+    JavaScriptPluginEngineThread() :
+        QThread(),
+        m_engine(0)
+    {
+    }
+
+    JavaScriptPluginEngine* engine() {
+        QMutexLocker locker(&m_mutex);
+
+        while (!m_engine) {
+            m_started.wait(&m_mutex);
+        }
+
+        return m_engine;
+    }
+
+    void addPlugin(QObject *plugin) {
+        QMutexLocker locker(&m_mutex);
+        m_plugins.removeAll(QPointer<QObject>());
+        m_plugins << plugin;
+    }
+
+protected:
+    virtual void run() {
+        // The engine is created here so that it belongs to this thread, and is owned by it until exec() returns
+        JavaScriptPluginEngine *engine = new JavaScriptPluginEngine;
+        m_mutex.lock();
+        m_engine = engine;
+        m_started.wakeAll();
+        m_mutex.unlock();
+        exec();
+        // Plugins released by their proxies are deleted first, then any that are still in use,
+        // and the engine last, since the plugins refer to it
+        QCoreApplication::sendPostedEvents(0, QEvent::DeferredDelete);
+        m_mutex.lock();
+        const QList<QPointer<QObject> > plugins = m_plugins;
+        m_plugins.clear();
+        m_mutex.unlock();
+
+        foreach (const QPointer<QObject> &plugin, plugins) {
+            if (plugin) {
+                delete plugin;
+            }
+        }
+
+        m_mutex.lock();
+        m_engine = 0;
+        m_mutex.unlock();
+        delete engine;
+    }
+
+private:
+    QMutex m_mutex;
+    QWaitCondition m_started;
+
+    JavaScriptPluginEngine *m_engine;
+
+    QList<QPointer<QObject> > m_plugins;
+};
+
+JavaScriptPluginEngine::JavaScriptPluginEngine(QObject *parent) :
+    QScriptEngine(parent),
+    m_global(new JavaScriptPluginGlobalObject(this)),
+    m_watchdog(new JavaScriptPluginWatchdog(this))
 {
     installTranslatorFunctions();
+    setAgent(m_watchdog);
+}
+
+JavaScriptPluginWatchdog* JavaScriptPluginEngine::watchdog() const {
+    return m_watchdog;
+}
+
+QScriptValue JavaScriptPluginEngine::pluginConstructor(const QString &fileName) {
+    const QHash<QString, QScriptValue>::const_iterator iterator = m_constructors.constFind(fileName);
+
+    if (iterator != m_constructors.constEnd()) {
+        return iterator.value();
+    }
+
+    QFile file(fileName);
+
+    if (!file.open(QFile::ReadOnly)) {
+        Logger::log("JavaScriptPluginEngine::pluginConstructor(): Cannot read file: " + fileName);
+        return QScriptValue();
+    }
+
+    const QScriptValue constructor = evaluate(QString::fromUtf8(file.readAll()), fileName);
+    file.close();
+
+    if (!constructor.isFunction()) {
+        if (constructor.isError()) {
+            Logger::log("JavaScriptPluginEngine::pluginConstructor(): Error evaluating JavaScript file: "
+                    + constructor.toString());
+        }
+        else {
+            Logger::log("JavaScriptPluginEngine::pluginConstructor(): No constructor function: " + fileName);
+        }
+
+        return QScriptValue();
+    }
+
+    Logger::log("JavaScriptPluginEngine::pluginConstructor(): Initialized OK: " + fileName, Logger::HighVerbosity);
+    m_constructors.insert(fileName, constructor);
+    return constructor;
 }
 
-JavaScriptPluginEngine::~JavaScriptPluginEngine() {
+JavaScriptPluginEnginePool* JavaScriptPluginEnginePool::self = 0;
+
+JavaScriptPluginEnginePool::JavaScriptPluginEnginePool() :
+    QObject(),
+    m_next(0)
+{
+    // Plugin signals are delivered to the UI thread as queued connections
+    qRegisterMetaType<QNetworkRequest>("QNetworkRequest");
+    qRegisterMetaType<SearchResultList>("SearchResultList");
+    qRegisterMetaType<UrlResult>("UrlResult");
+    qRegisterMetaType<UrlResultList>("UrlResultList");
+}
+
+JavaScriptPluginEnginePool::~JavaScriptPluginEnginePool() {
     self = 0;
+
+    foreach (JavaScriptPluginEngineThread *thread, m_threads) {
+        thread->quit();
+        thread->wait();
+        delete thread;
+    }
 }
 
-JavaScriptPluginEngine* JavaScriptPluginEngine::instance() {
-    return self ? self : self = new JavaScriptPluginEngine;
+JavaScriptPluginEnginePool* JavaScriptPluginEnginePool::instance() {
+    return self ? self : self = new JavaScriptPluginEnginePool;
+}
+
+int JavaScriptPluginEnginePool::maximumEngines() const {
+    return qBound(1, QThread::idealThreadCount(), MAX_ENGINES);
+}
+
+JavaScriptPluginEngine* JavaScriptPluginEnginePool::engine() {
+    if (m_threads.size() < maximumEngines()) {
+        JavaScriptPluginEngineThread *thread = new JavaScriptPluginEngineThread;
+        thread->start();
+        m_threads << thread;
+        return thread->engine();
+    }
+
+    m_next = (m_next + 1) % m_threads.size();
+    return m_threads.at(m_next)->engine();
+}
+
+void JavaScriptPluginEnginePool::addPlugin(QObject *plugin, QThread *thread) {
+    plugin->moveToThread(thread);
+
+    foreach (JavaScriptPluginEngineThread *engineThread, m_threads) {
+        if (engineThread == thread) {
+            engineThread->addPlugin(plugin);
+            return;
+        }
+    }
+
+    Logger::log("JavaScriptPluginEnginePool::addPlugin(): Thread is not in the pool");
 }
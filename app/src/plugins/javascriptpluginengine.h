@@ -17,25 +17,72 @@
 #ifndef JAVASCRIPTPLUGINENGINE_H
 #define JAVASCRIPTPLUGINENGINE_H
 
+#include <QHash>
 #include <QScriptEngine>
 
+class QThread;
+
+class JavaScriptPluginEngineThread;
 class JavaScriptPluginGlobalObject;
+class JavaScriptPluginWatchdog;
 
 class JavaScriptPluginEngine : public QScriptEngine
 {
     Q_OBJECT
 
 public:
-    ~JavaScriptPluginEngine();
+    explicit JavaScriptPluginEngine(QObject *parent = 0);
+
+    /**
+     * Returns the plugin constructor defined by the script in fileName, evaluating the script on first use.
+     * Must only be called from the thread of the engine.
+     */
+    QScriptValue pluginConstructor(const QString &fileName);
 
-    static JavaScriptPluginEngine* instance();
+    JavaScriptPluginWatchdog* watchdog() const;
 
 private:
-    JavaScriptPluginEngine();
+    JavaScriptPluginGlobalObject *m_global;
+    JavaScriptPluginWatchdog *m_watchdog;
 
-    static JavaScriptPluginEngine *self;
+    QHash<QString, QScriptValue> m_constructors;
+};
 
-    JavaScriptPluginGlobalObject *m_global;
+/**
+ * Runs each JavaScriptPluginEngine in its own thread, so that plugin scripts never block the UI.
+ *
+ * Each plugin is bound to one engine, and its instances are run in the thread of that engine.
+ * Engines are started as they are needed, up to maximumEngines(), and are then shared in turn.
+ *
+ * Each engine is owned by its thread. When the pool is deleted, each thread deletes the plugins that were added to
+ * it before its engine, so the pool must outlive the plugin managers.
+ */
+class JavaScriptPluginEnginePool : public QObject
+{
+    Q_OBJECT
+
+public:
+    ~JavaScriptPluginEnginePool();
+
+    static JavaScriptPluginEnginePool* instance();
+
+    int maximumEngines() const;
+
+    JavaScriptPluginEngine* engine();
+
+    /**
+     * Moves plugin to thread, which must belong to the pool, where it is deleted at the latest before the engine.
+     */
+    void addPlugin(QObject *plugin, QThread *thread);
+
+private:
+    JavaScriptPluginEnginePool();
+
+    static JavaScriptPluginEnginePool *self;
+
+    QList<JavaScriptPluginEngineThread*> m_threads;
+
+    int m_next;
 };
 
 #endif // JAVASCRIPTPLUGINENGINE_H
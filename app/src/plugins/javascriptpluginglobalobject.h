@@ -17,6 +17,7 @@
 #ifndef JAVASCRIPTPLUGINGLOBALOBJECT_H
 #define JAVASCRIPTPLUGINGLOBALOBJECT_H
 
+#include "javascriptpluginwatchdog.h"
 #include <QObject>
 #include <QPointer>
 #include <QScriptEngine>
@@ -55,7 +56,7 @@ private:
     
     QNetworkAccessManager* networkAccessManager();
         
-    bool callFunction(QScriptValue function) const;
+    bool callFunction(QScriptValue function, const JavaScriptPluginWatchdog::Owner &owner) const;
         
     virtual void timerEvent(QTimerEvent *event);
 
@@ -65,6 +66,7 @@ private:
     
     QHash<int, QScriptValue> m_intervals;
     QHash<int, QScriptValue> m_timeouts;
+    QHash<int, JavaScriptPluginWatchdog::Owner> m_owners;
 };
 
 #endif // JAVASCRIPTPLUGINGLOBALOBJECT_H
@@ -0,0 +1,203 @@
+/*
+ * Copyright (C) 2017 Stuart Howarth <showarth@marxoft.co.uk>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "javascriptpluginwatchdog.h"
+#include "javascriptpluginengine.h"
+#include "logger.h"
+#include "metrics.h"
+#include "settings.h"
+#include <QFile>
+#include <QScriptEngine>
+#ifdef Q_OS_UNIX
+#include <time.h>
+#include <unistd.h>
+#endif
+
+static const int CHECK_INTERVAL_STATEMENTS = 256;
+static const int MEMORY_CHECK_INTERVAL = 50;
+
+// Returns the CPU time used by the calling thread in milliseconds, or -1 if it cannot be measured
+static qint64 threadCpuTime() {
+#if defined(Q_OS_UNIX) && defined(CLOCK_THREAD_CPUTIME_ID)
+    struct timespec time;
+
+    if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &time) == 0) {
+        return qint64(time.tv_sec) * 1000 + time.tv_nsec / 1000000;
+    }
+#endif
+    return -1;
+}
+
+// Returns the resident memory of the process in bytes, or -1 if it cannot be measured
+static qint64 residentMemory() {
+#ifdef Q_OS_LINUX
+    QFile file("/proc/self/statm");
+
+    if (file.open(QFile::ReadOnly)) {
+        const QList<QByteArray> fields = file.readAll().split(' ');
+
+        if (fields.size() > 1) {
+            return fields.at(1).toLongLong() * sysconf(_SC_PAGESIZE);
+        }
+    }
+#endif
+    return -1;
+}
+
+static QString pluginLabel(const QString &fileName) {
+    return Metrics::label("plugin", fileName.section('/', -1).section('.', 0, 0));
+}
+
+JavaScriptPluginWatchdog::JavaScriptPluginWatchdog(QScriptEngine *engine) :
+    QScriptEngineAgent(engine),
+    m_timeLimit(0),
+    m_memoryLimit(0),
+    m_startCpuTime(-1),
+    m_startMemory(-1),
+    m_peakMemory(-1),
+    m_lastMemoryCheck(0),
+    m_statements(0),
+    m_aborted(false)
+{
+}
+
+JavaScriptPluginWatchdog::Owner JavaScriptPluginWatchdog::currentOwner() const {
+    return m_owners.isEmpty() ? Owner() : m_owners.last();
+}
+
+void JavaScriptPluginWatchdog::enter(const Owner &owner) {
+    if (m_owners.isEmpty()) {
+        // The limits are read once per call, as the checks must be cheap
+        m_timeLimit = Settings::pluginScriptTimeLimit();
+        m_memoryLimit = qint64(Settings::pluginScriptMemoryLimit()) * 1024 * 1024;
+        m_startCpuTime = threadCpuTime();
+        m_startMemory = residentMemory();
+        m_peakMemory = m_startMemory;
+        m_lastMemoryCheck = 0;
+        m_statements = 0;
+        m_aborted = false;
+        m_timer.start();
+    }
+
+    m_owners << owner;
+}
+
+void JavaScriptPluginWatchdog::exit() {
+    if (m_owners.isEmpty()) {
+        return;
+    }
+
+    const Owner owner = m_owners.takeLast();
+
+    if (!m_owners.isEmpty()) {
+        return;
+    }
+
+    const QString labels = pluginLabel(owner.fileName);
+    Metrics::instance()->observe("qdl_plugin_script_seconds", labels, cpuTime() / 1000.0);
+
+    if (m_startMemory >= 0) {
+        m_peakMemory = qMax(m_peakMemory, residentMemory());
+        Metrics::instance()->observe("qdl_plugin_script_memory_growth_bytes", labels,
+                                     qMax(qint64(0), m_peakMemory - m_startMemory));
+    }
+}
+
+void JavaScriptPluginWatchdog::positionChange(qint64, int, int) {
+    if ((m_owners.isEmpty()) || (m_aborted) || (++m_statements % CHECK_INTERVAL_STATEMENTS != 0)) {
+        return;
+    }
+
+    const qint64 elapsed = m_timer.elapsed();
+
+    if ((m_timeLimit > 0) && (cpuTime() > m_timeLimit)) {
+        abort("time", QObject::tr("Plugin script exceeded its CPU time limit of %1 ms").arg(m_timeLimit));
+        return;
+    }
+
+    if ((m_startMemory >= 0) && (elapsed - m_lastMemoryCheck >= MEMORY_CHECK_INTERVAL)) {
+        m_lastMemoryCheck = elapsed;
+        m_peakMemory = qMax(m_peakMemory, residentMemory());
+
+        if ((m_memoryLimit > 0) && (m_peakMemory - m_startMemory > m_memoryLimit)) {
+            abort("memory", QObject::tr("Plugin script exceeded its memory limit of %1 MiB")
+                  .arg(m_memoryLimit / 1024 / 1024));
+        }
+    }
+}
+
+qint64 JavaScriptPluginWatchdog::cpuTime() const {
+    // Time spent waiting for the network or for other threads is not counted
+    if (m_startCpuTime >= 0) {
+        const qint64 now = threadCpuTime();
+
+        if (now >= 0) {
+            return now - m_startCpuTime;
+        }
+    }
+
+    return m_timer.elapsed();
+}
+
+void JavaScriptPluginWatchdog::abort(const QString &reason, const QString &errorString) {
+    m_aborted = true;
+    const Owner &owner = m_owners.last();
+    Logger::log(QString("JavaScriptPluginWatchdog::abort(): %1: %2").arg(owner.fileName).arg(errorString));
+    Metrics::instance()->increment("qdl_plugin_script_aborts_total", pluginLabel(owner.fileName) + ","
+                                   + Metrics::label("reason", reason));
+
+    if (owner.plugin) {
+        // Queued, so that the error is reported once the evaluation has unwound
+        QMetaObject::invokeMethod(owner.plugin, "error", Qt::QueuedConnection, Q_ARG(QString, errorString));
+    }
+
+    engine()->abortEvaluation(QScriptValue(errorString));
+}
+
+JavaScriptPluginScope::JavaScriptPluginScope(QScriptEngine *engine, QObject *plugin, const QString &fileName) :
+    m_watchdog(0)
+{
+    if (JavaScriptPluginEngine *e = qobject_cast<JavaScriptPluginEngine*>(engine)) {
+        JavaScriptPluginWatchdog::Owner owner;
+        owner.plugin = plugin;
+        owner.fileName = fileName;
+        m_watchdog = e->watchdog();
+        m_watchdog->enter(owner);
+    }
+}
+
+JavaScriptPluginScope::JavaScriptPluginScope(QScriptEngine *engine, const JavaScriptPluginWatchdog::Owner &owner) :
+    m_watchdog(0)
+{
+    if (JavaScriptPluginEngine *e = qobject_cast<JavaScriptPluginEngine*>(engine)) {
+        m_watchdog = e->watchdog();
+        m_watchdog->enter(owner);
+    }
+}
+
+JavaScriptPluginScope::~JavaScriptPluginScope() {
+    if (m_watchdog) {
+        m_watchdog->exit();
+    }
+}
+
+JavaScriptPluginWatchdog::Owner JavaScriptPluginScope::currentOwner(QScriptEngine *engine) {
+    if (JavaScriptPluginEngine *e = qobject_cast<JavaScriptPluginEngine*>(engine)) {
+        return e->watchdog()->currentOwner();
+    }
+
+    return JavaScriptPluginWatchdog::Owner();
+}
@@ -0,0 +1,106 @@
+/*
+ * Copyright (C) 2017 Stuart Howarth <showarth@marxoft.co.uk>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef JAVASCRIPTPLUGINWATCHDOG_H
+#define JAVASCRIPTPLUGINWATCHDOG_H
+
+#include <QElapsedTimer>
+#include <QList>
+#include <QPointer>
+#include <QScriptEngineAgent>
+
+/**
+ * Enforces time and memory budgets on each call into a JavaScriptPluginEngine, and records the CPU time and
+ * the memory used by each call in Metrics, by plugin.
+ *
+ * A call starts when the outermost JavaScriptPluginScope is entered. The limits are read from
+ * Settings::pluginScriptTimeLimit() and Settings::pluginScriptMemoryLimit() at that point. If the call uses more
+ * CPU time on the engine thread than the time limit, or the resident memory of the process grows by more than the
+ * memory limit during it, the evaluation is aborted and the plugin emits its error() signal.
+ *
+ * QtScript does not report the size of its heap, so the memory budget is measured for the whole process. Memory
+ * allocated by other threads during a call counts against it, so the limit should be set well above what one
+ * plugin is expected to use. Memory is only measured on Linux. Where the CPU time of a thread cannot be measured,
+ * the elapsed time of the call is used instead.
+ *
+ * The budgets are checked between script statements, so a single long running native call (such as a regular
+ * expression match) is only interrupted once it returns.
+ */
+class JavaScriptPluginWatchdog : public QScriptEngineAgent
+{
+
+public:
+    /**
+     * The plugin on whose behalf a script is run.
+     */
+    struct Owner {
+        QPointer<QObject> plugin;
+        QString fileName;
+    };
+
+    explicit JavaScriptPluginWatchdog(QScriptEngine *engine);
+
+    Owner currentOwner() const;
+
+    void enter(const Owner &owner);
+    void exit();
+
+    virtual void positionChange(qint64 scriptId, int lineNumber, int columnNumber);
+
+private:
+    qint64 cpuTime() const;
+
+    void abort(const QString &reason, const QString &errorString);
+
+    QList<Owner> m_owners;
+
+    QElapsedTimer m_timer;
+
+    qint64 m_timeLimit;
+    qint64 m_memoryLimit;
+    qint64 m_startCpuTime;
+    qint64 m_startMemory;
+    qint64 m_peakMemory;
+    qint64 m_lastMemoryCheck;
+
+    uint m_statements;
+
+    bool m_aborted;
+};
+
+/**
+ * Attributes the scripts run while it exists to a plugin, and applies the budgets of JavaScriptPluginWatchdog
+ * to them. Scopes may be nested. Does nothing if the engine is not a JavaScriptPluginEngine.
+ */
+class JavaScriptPluginScope
+{
+
+public:
+    JavaScriptPluginScope(QScriptEngine *engine, QObject *plugin, const QString &fileName);
+    JavaScriptPluginScope(QScriptEngine *engine, const JavaScriptPluginWatchdog::Owner &owner);
+    ~JavaScriptPluginScope();
+
+    /**
+     * Returns the owner of the current scope in engine, so that scripts run later by callbacks can be
+     * attributed to the same plugin.
+     */
+    static JavaScriptPluginWatchdog::Owner currentOwner(QScriptEngine *engine);
+
+private:
+    JavaScriptPluginWatchdog *m_watchdog;
+};
+
+#endif // JAVASCRIPTPLUGINWATCHDOG_H
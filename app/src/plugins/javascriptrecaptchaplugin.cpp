@@ -15,27 +15,39 @@
  */
 
 #include "javascriptrecaptchaplugin.h"
+#include "javascriptpluginengine.h"
+#include "javascriptpluginwatchdog.h"
 #include "logger.h"
-#include <QFile>
 
-JavaScriptRecaptchaPlugin::JavaScriptRecaptchaPlugin(const QScriptValue &plugin, QObject *parent) :
+JavaScriptRecaptchaPlugin::JavaScriptRecaptchaPlugin(const QString &fileName, JavaScriptPluginEngine *engine,
+        QObject *parent) :
     RecaptchaPlugin(parent),
-    m_plugin(plugin),
+    m_engine(engine),
+    m_fileName(fileName),
     m_initted(false)
 {
 }
 
-JavaScriptRecaptchaPlugin::~JavaScriptRecaptchaPlugin() {
-    if (QScriptEngine *engine = m_plugin.engine()) {
-        engine->collectGarbage();
-    }
-}
-
 bool JavaScriptRecaptchaPlugin::init() {
     if (m_initted) {
         return true;
     }
 
+    if (!m_engine) {
+        Logger::log("JavaScriptRecaptchaPlugin::init(): No JavaScript engine");
+        return false;
+    }
+
+    if (!m_plugin.isValid()) {
+        const QScriptValue constructor = m_engine->pluginConstructor(m_fileName);
+
+        if (!constructor.isFunction()) {
+            return false;
+        }
+
+        m_plugin = constructor.construct();
+    }
+
     if (!m_plugin.property("cancelCurrentOperation").isFunction()) {
         Logger::log("JavaScriptRecaptchaPlugin::init(): No cancelCurrentOperation() function found");
         return false;
@@ -62,6 +74,8 @@ bool JavaScriptRecaptchaPlugin::init() {
 }
 
 bool JavaScriptRecaptchaPlugin::cancelCurrentOperation() {
+    const JavaScriptPluginScope scope(m_engine, this, m_fileName);
+
     if (!init()) {
         return false;
     }
@@ -70,6 +84,8 @@ bool JavaScriptRecaptchaPlugin::cancelCurrentOperation() {
 }
 
 void JavaScriptRecaptchaPlugin::getCaptcha(int captchaType, const QString &captchaKey, const QVariantMap &settings) {
+    const JavaScriptPluginScope scope(m_engine, this, m_fileName);
+
     if (!init()) {
         emit error(tr("Plugin not initialized"));
         return;
@@ -86,6 +102,8 @@ void JavaScriptRecaptchaPlugin::getCaptcha(int captchaType, const QString &captc
 }
 
 void JavaScriptRecaptchaPlugin::submitSettingsResponse(const QVariantMap &settings) {
+    const JavaScriptPluginScope scope(m_engine, this, m_fileName);
+
     if (!init()) {
         emit error(tr("Plugin not initialized"));
         return;
@@ -140,56 +158,69 @@ JavaScriptRecaptchaPluginSignaller::JavaScriptRecaptchaPluginSignaller(QObject *
 {
 }
 
-JavaScriptRecaptchaPluginFactory::JavaScriptRecaptchaPluginFactory(const QString &fileName, QScriptEngine *engine,
-        QObject *parent) :
-    QObject(parent),
-    m_engine(engine),
-    m_fileName(fileName),
-    m_initted(false)
+JavaScriptRecaptchaPluginProxy::JavaScriptRecaptchaPluginProxy(RecaptchaPlugin *plugin, QObject *parent) :
+    RecaptchaPlugin(parent),
+    m_plugin(plugin)
 {
+    connectPlugin();
 }
 
-RecaptchaPlugin* JavaScriptRecaptchaPluginFactory::createPlugin(QObject *parent) {
-    if (init()) {
-        return new JavaScriptRecaptchaPlugin(m_constructor.construct(), parent);
+JavaScriptRecaptchaPluginProxy::~JavaScriptRecaptchaPluginProxy() {
+    // The plugin must be deleted in the thread of its engine, which deletes it itself if it has already finished
+    if (m_plugin) {
+        m_plugin->deleteLater();
     }
-
-    return 0;
 }
 
-bool JavaScriptRecaptchaPluginFactory::init() {
-    if (m_initted) {
-        return true;
-    }
-    
-    if (!m_engine) {
-        Logger::log("JavaScriptRecaptchaPluginFactory::init(): No JavaScript engine");
-        return false;
+bool JavaScriptRecaptchaPluginProxy::cancelCurrentOperation() {
+    if (m_plugin) {
+        // A script may still be running in the thread of the engine, so the plugin is not waited for. Its signals are
+        // dropped until the next request instead
+        disconnect(m_plugin, 0, this, 0);
+        QMetaObject::invokeMethod(m_plugin, "cancelCurrentOperation", Qt::QueuedConnection);
     }
 
-    QFile file(m_fileName);
+    return true;
+}
 
-    if (!file.open(QFile::ReadOnly)) {
-        Logger::log("JavaScriptRecaptchaPluginFactory::init(): Cannot read file: " + m_fileName);
-        return false;
+void JavaScriptRecaptchaPluginProxy::getCaptcha(int captchaType, const QString &captchaKey,
+        const QVariantMap &settings) {
+    connectPlugin();
+    QMetaObject::invokeMethod(m_plugin, "getCaptcha", Qt::QueuedConnection,
+            Q_ARG(int, captchaType), Q_ARG(QString, captchaKey), Q_ARG(QVariantMap, settings));
+}
+
+void JavaScriptRecaptchaPluginProxy::submitSettingsResponse(const QVariantMap &settings) {
+    QMetaObject::invokeMethod(m_plugin, "submitSettingsResponse", Qt::QueuedConnection, Q_ARG(QVariantMap, settings));
+}
+
+void JavaScriptRecaptchaPluginProxy::connectPlugin() {
+    if (!m_plugin) {
+        return;
     }
 
-    m_constructor = m_engine->evaluate(QString::fromUtf8(file.readAll()), m_fileName);
-    file.close();
+    connect(m_plugin, SIGNAL(captcha(int, QByteArray)), this, SIGNAL(captcha(int, QByteArray)), Qt::UniqueConnection);
+    connect(m_plugin, SIGNAL(error(QString)), this, SIGNAL(error(QString)), Qt::UniqueConnection);
+    connect(m_plugin, SIGNAL(settingsRequest(QString, QVariantList, QByteArray)),
+            this, SIGNAL(settingsRequest(QString, QVariantList, QByteArray)), Qt::UniqueConnection);
+}
 
-    if (!m_constructor.isFunction()) {
-        if (m_constructor.isError()) {
-            Logger::log("JavaScriptRecaptchaPluginFactory::init(): Error evaluating JavaScript file: "
-                    + m_constructor.toString());
-        }
-        else {
-            Logger::log("JavaScriptRecaptchaPluginFactory::init(): No constructor function");
-        }
+JavaScriptRecaptchaPluginFactory::JavaScriptRecaptchaPluginFactory(const QString &fileName,
+        JavaScriptPluginEngine *engine, QObject *parent) :
+    QObject(parent),
+    m_engine(engine),
+    m_fileName(fileName)
+{
+}
 
-        return false;
+RecaptchaPlugin* JavaScriptRecaptchaPluginFactory::createPlugin(QObject *parent) {
+    if (!m_engine) {
+        Logger::log("JavaScriptRecaptchaPluginFactory::createPlugin(): No JavaScript engine");
+        return 0;
     }
 
-    Logger::log("JavaScriptRecaptchaPluginFactory::init(): Initialized OK", Logger::HighVerbosity);
-    m_initted = true;
-    return true;
+    // The script is evaluated in the thread of the engine when the plugin is first used
+    JavaScriptRecaptchaPlugin *plugin = new JavaScriptRecaptchaPlugin(m_fileName, m_engine);
+    JavaScriptPluginEnginePool::instance()->addPlugin(plugin, m_engine->thread());
+    return new JavaScriptRecaptchaPluginProxy(plugin, parent);
 }
@@ -21,13 +21,14 @@
 #include <QPointer>
 #include <QScriptEngine>
 
+class JavaScriptPluginEngine;
+
 class JavaScriptRecaptchaPlugin : public RecaptchaPlugin
 {
     Q_OBJECT
 
 public:
-    explicit JavaScriptRecaptchaPlugin(const QScriptValue &plugin, QObject *parent = 0);
-    ~JavaScriptRecaptchaPlugin();
+    explicit JavaScriptRecaptchaPlugin(const QString &fileName, JavaScriptPluginEngine *engine, QObject *parent = 0);
 
 public Q_SLOTS:
     virtual bool cancelCurrentOperation();
@@ -42,6 +43,10 @@ private Q_SLOTS:
 
 private:
     bool init();
+
+    QPointer<JavaScriptPluginEngine> m_engine;
+
+    QString m_fileName;
     
     QScriptValue m_plugin;
     QScriptValue m_callback;
@@ -49,6 +54,33 @@ private:
     bool m_initted;
 };
 
+/**
+ * Forwards calls to a JavaScript recaptcha plugin in the thread of its engine, and re-emits its signals.
+ *
+ * All calls are queued and return at once. After cancelCurrentOperation(), the signals of the plugin are not
+ * forwarded until the next request.
+ */
+class JavaScriptRecaptchaPluginProxy : public RecaptchaPlugin
+{
+    Q_OBJECT
+
+public:
+    explicit JavaScriptRecaptchaPluginProxy(RecaptchaPlugin *plugin, QObject *parent = 0);
+    ~JavaScriptRecaptchaPluginProxy();
+
+public Q_SLOTS:
+    virtual bool cancelCurrentOperation();
+    
+    virtual void getCaptcha(int captchaType, const QString &captchaKey, const QVariantMap &settings);
+    
+    void submitSettingsResponse(const QVariantMap &settings);
+
+private:
+    void connectPlugin();
+
+    QPointer<RecaptchaPlugin> m_plugin;
+};
+
 class JavaScriptRecaptchaPluginSignaller : public QObject
 {
     Q_OBJECT
@@ -68,20 +100,15 @@ class JavaScriptRecaptchaPluginFactory : public QObject, public RecaptchaPluginF
     Q_INTERFACES(RecaptchaPluginFactory)
 
 public:
-    explicit JavaScriptRecaptchaPluginFactory(const QString &fileName, QScriptEngine *engine, QObject *parent = 0);
+    explicit JavaScriptRecaptchaPluginFactory(const QString &fileName, JavaScriptPluginEngine *engine,
+            QObject *parent = 0);
 
     virtual RecaptchaPlugin* createPlugin(QObject *parent = 0);
 
 private:
-    bool init();
-
-    QPointer<QScriptEngine> m_engine;
+    QPointer<JavaScriptPluginEngine> m_engine;
 
     QString m_fileName;
-
-    QScriptValue m_constructor;
-
-    bool m_initted;
 };
 
 #endif // JAVASCRIPTRECAPTCHAPLUGIN_H
@@ -15,27 +15,39 @@
  */
 
 #include "javascriptsearchplugin.h"
+#include "javascriptpluginengine.h"
+#include "javascriptpluginwatchdog.h"
 #include "logger.h"
-#include <QFile>
 
-JavaScriptSearchPlugin::JavaScriptSearchPlugin(const QScriptValue &plugin, QObject *parent) :
+JavaScriptSearchPlugin::JavaScriptSearchPlugin(const QString &fileName, JavaScriptPluginEngine *engine,
+        QObject *parent) :
     SearchPlugin(parent),
-    m_plugin(plugin),
+    m_engine(engine),
+    m_fileName(fileName),
     m_initted(false)
 {
 }
 
-JavaScriptSearchPlugin::~JavaScriptSearchPlugin() {
-    if (QScriptEngine *engine = m_plugin.engine()) {
-        engine->collectGarbage();
-    }
-}
-
 bool JavaScriptSearchPlugin::init() {
     if (m_initted) {
         return true;
     }
 
+    if (!m_engine) {
+        Logger::log("JavaScriptSearchPlugin::init(): No JavaScript engine");
+        return false;
+    }
+
+    if (!m_plugin.isValid()) {
+        const QScriptValue constructor = m_engine->pluginConstructor(m_fileName);
+
+        if (!constructor.isFunction()) {
+            return false;
+        }
+
+        m_plugin = constructor.construct();
+    }
+
     if (!m_plugin.property("cancelCurrentOperation").isFunction()) {
         Logger::log("JavaScriptSearchPlugin::init(): No cancelCurrentOperation() function found");
         return false;
@@ -65,6 +77,8 @@ bool JavaScriptSearchPlugin::init() {
 }
 
 bool JavaScriptSearchPlugin::cancelCurrentOperation() {
+    const JavaScriptPluginScope scope(m_engine, this, m_fileName);
+
     if (!init()) {
         error(tr("Plugin not initialized"));
         return false;
@@ -74,6 +88,8 @@ bool JavaScriptSearchPlugin::cancelCurrentOperation() {
 }
 
 void JavaScriptSearchPlugin::fetchMore(const QVariantMap &params) {
+    const JavaScriptPluginScope scope(m_engine, this, m_fileName);
+
     if (!init()) {
         error(tr("Plugin not initialized"));
         return;
@@ -90,6 +106,8 @@ void JavaScriptSearchPlugin::fetchMore(const QVariantMap &params) {
 }
 
 void JavaScriptSearchPlugin::search(const QVariantMap &settings) {
+    const JavaScriptPluginScope scope(m_engine, this, m_fileName);
+
     if (!init()) {
         error(tr("Plugin not initialized"));
         return;
@@ -106,6 +124,8 @@ void JavaScriptSearchPlugin::search(const QVariantMap &settings) {
 }
 
 void JavaScriptSearchPlugin::submitSettingsResponse(const QVariantMap &settings) {
+    const JavaScriptPluginScope scope(m_engine, this, m_fileName);
+
     if (!init()) {
         emit error(tr("Plugin not initialized"));
         return;
@@ -156,56 +176,75 @@ JavaScriptSearchPluginSignaller::JavaScriptSearchPluginSignaller(QObject *parent
 {
 }
 
-JavaScriptSearchPluginFactory::JavaScriptSearchPluginFactory(const QString &fileName, QScriptEngine *engine,
-        QObject *parent) :
-    QObject(parent),
-    m_engine(engine),
-    m_fileName(fileName),
-    m_initted(false)
+JavaScriptSearchPluginProxy::JavaScriptSearchPluginProxy(SearchPlugin *plugin, QObject *parent) :
+    SearchPlugin(parent),
+    m_plugin(plugin)
 {
+    connectPlugin();
 }
 
-SearchPlugin* JavaScriptSearchPluginFactory::createPlugin(QObject *parent) {
-    if (init()) {
-        return new JavaScriptSearchPlugin(m_constructor.construct(), parent);
+JavaScriptSearchPluginProxy::~JavaScriptSearchPluginProxy() {
+    // The plugin must be deleted in the thread of its engine, which deletes it itself if it has already finished
+    if (m_plugin) {
+        m_plugin->deleteLater();
     }
-
-    return 0;
 }
 
-bool JavaScriptSearchPluginFactory::init() {
-    if (m_initted) {
-        return true;
+bool JavaScriptSearchPluginProxy::cancelCurrentOperation() {
+    if (m_plugin) {
+        // A script may still be running in the thread of the engine, so the plugin is not waited for. Its signals are
+        // dropped until the next request instead
+        disconnect(m_plugin, 0, this, 0);
+        QMetaObject::invokeMethod(m_plugin, "cancelCurrentOperation", Qt::QueuedConnection);
     }
 
-    if (!m_engine) {
-        Logger::log("JavaScriptSearchPluginFactory::init(): No JavaScript engine");
-        return false;
-    }
+    return true;
+}
 
-    QFile file(m_fileName);
+void JavaScriptSearchPluginProxy::fetchMore(const QVariantMap &params) {
+    connectPlugin();
+    QMetaObject::invokeMethod(m_plugin, "fetchMore", Qt::QueuedConnection, Q_ARG(QVariantMap, params));
+}
 
-    if (!file.open(QFile::ReadOnly)) {
-        Logger::log("JavaScriptSearchPluginFactory::init(): Cannot read file: " + m_fileName);
-        return false;
+void JavaScriptSearchPluginProxy::search(const QVariantMap &settings) {
+    connectPlugin();
+    QMetaObject::invokeMethod(m_plugin, "search", Qt::QueuedConnection, Q_ARG(QVariantMap, settings));
+}
+
+void JavaScriptSearchPluginProxy::submitSettingsResponse(const QVariantMap &settings) {
+    QMetaObject::invokeMethod(m_plugin, "submitSettingsResponse", Qt::QueuedConnection, Q_ARG(QVariantMap, settings));
+}
+
+void JavaScriptSearchPluginProxy::connectPlugin() {
+    if (!m_plugin) {
+        return;
     }
 
-    m_constructor = m_engine->evaluate(QString::fromUtf8(file.readAll()), m_fileName);
-    file.close();
+    connect(m_plugin, SIGNAL(error(QString)), this, SIGNAL(error(QString)), Qt::UniqueConnection);
+    connect(m_plugin, SIGNAL(searchCompleted(SearchResultList)),
+            this, SIGNAL(searchCompleted(SearchResultList)), Qt::UniqueConnection);
+    connect(m_plugin, SIGNAL(searchCompleted(SearchResultList, QVariantMap)),
+            this, SIGNAL(searchCompleted(SearchResultList, QVariantMap)), Qt::UniqueConnection);
+    connect(m_plugin, SIGNAL(settingsRequest(QString, QVariantList, QByteArray)),
+            this, SIGNAL(settingsRequest(QString, QVariantList, QByteArray)), Qt::UniqueConnection);
+}
 
-    if (!m_constructor.isFunction()) {
-        if (m_constructor.isError()) {
-            Logger::log("JavaScriptSearchPluginFactory::init(): Error evaluating JavaScript file: "
-                    + m_constructor.toString());
-        }
-        else {
-            Logger::log("JavaScriptSearchPluginFactory::init(): No constructor function");
-        }
+JavaScriptSearchPluginFactory::JavaScriptSearchPluginFactory(const QString &fileName,
+        JavaScriptPluginEngine *engine, QObject *parent) :
+    QObject(parent),
+    m_engine(engine),
+    m_fileName(fileName)
+{
+}
 
-        return false;
+SearchPlugin* JavaScriptSearchPluginFactory::createPlugin(QObject *parent) {
+    if (!m_engine) {
+        Logger::log("JavaScriptSearchPluginFactory::createPlugin(): No JavaScript engine");
+        return 0;
     }
 
-    Logger::log("JavaScriptSearchPluginFactory::init(): Initialized OK", Logger::HighVerbosity);
-    m_initted = true;
-    return true;
+    // The script is evaluated in the thread of the engine when the plugin is first used
+    JavaScriptSearchPlugin *plugin = new JavaScriptSearchPlugin(m_fileName, m_engine);
+    JavaScriptPluginEnginePool::instance()->addPlugin(plugin, m_engine->thread());
+    return new JavaScriptSearchPluginProxy(plugin, parent);
 }
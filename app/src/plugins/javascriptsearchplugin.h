@@ -21,13 +21,14 @@
 #include <QPointer>
 #include <QScriptEngine>
 
+class JavaScriptPluginEngine;
+
 class JavaScriptSearchPlugin : public SearchPlugin
 {
     Q_OBJECT
 
 public:
-    explicit JavaScriptSearchPlugin(const QScriptValue &plugin, QObject *parent = 0);
-    ~JavaScriptSearchPlugin();
+    explicit JavaScriptSearchPlugin(const QString &fileName, JavaScriptPluginEngine *engine, QObject *parent = 0);
 
 public Q_SLOTS:
     virtual bool cancelCurrentOperation();
@@ -42,6 +43,10 @@ private Q_SLOTS:
 
 private:
     bool init();
+
+    QPointer<JavaScriptPluginEngine> m_engine;
+
+    QString m_fileName;
     
     QScriptValue m_plugin;
     QScriptValue m_callback;
@@ -49,6 +54,34 @@ private:
     bool m_initted;
 };
 
+/**
+ * Forwards calls to a JavaScript search plugin in the thread of its engine, and re-emits its signals.
+ *
+ * All calls are queued and return at once. After cancelCurrentOperation(), the signals of the plugin are not
+ * forwarded until the next request.
+ */
+class JavaScriptSearchPluginProxy : public SearchPlugin
+{
+    Q_OBJECT
+
+public:
+    explicit JavaScriptSearchPluginProxy(SearchPlugin *plugin, QObject *parent = 0);
+    ~JavaScriptSearchPluginProxy();
+
+public Q_SLOTS:
+    virtual bool cancelCurrentOperation();
+    
+    virtual void fetchMore(const QVariantMap &params);
+    virtual void search(const QVariantMap &settings);
+    
+    void submitSettingsResponse(const QVariantMap &settings);
+
+private:
+    void connectPlugin();
+
+    QPointer<SearchPlugin> m_plugin;
+};
+
 class JavaScriptSearchPluginSignaller : public QObject
 {
     Q_OBJECT
@@ -69,20 +102,15 @@ class JavaScriptSearchPluginFactory : public QObject, public SearchPluginFactory
     Q_INTERFACES(SearchPluginFactory)
 
 public:
-    explicit JavaScriptSearchPluginFactory(const QString &fileName, QScriptEngine *engine, QObject *parent = 0);
+    explicit JavaScriptSearchPluginFactory(const QString &fileName, JavaScriptPluginEngine *engine,
+            QObject *parent = 0);
 
     virtual SearchPlugin* createPlugin(QObject *parent = 0);
 
 private:
-    bool init();
-
-    QPointer<QScriptEngine> m_engine;
+    QPointer<JavaScriptPluginEngine> m_engine;
 
     QString m_fileName;
-
-    QScriptValue m_constructor;
-
-    bool m_initted;
 };
 
 #endif // JAVASCRIPTSEARCHPLUGIN_H
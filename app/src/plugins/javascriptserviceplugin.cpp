@@ -15,27 +15,40 @@
  */
 
 #include "javascriptserviceplugin.h"
+#include "javascriptpluginengine.h"
+#include "javascriptpluginwatchdog.h"
 #include "logger.h"
-#include <QFile>
+#include <QNetworkRequest>
 
-JavaScriptServicePlugin::JavaScriptServicePlugin(const QScriptValue &plugin, QObject *parent) :
+JavaScriptServicePlugin::JavaScriptServicePlugin(const QString &fileName, JavaScriptPluginEngine *engine,
+        QObject *parent) :
     ServicePlugin(parent),
-    m_plugin(plugin),
+    m_engine(engine),
+    m_fileName(fileName),
     m_initted(false)
 {
 }
 
-JavaScriptServicePlugin::~JavaScriptServicePlugin() {
-    if (QScriptEngine *engine = m_plugin.engine()) {
-        engine->collectGarbage();
-    }
-}
-
 bool JavaScriptServicePlugin::init() {
     if (m_initted) {
         return true;
     }
 
+    if (!m_engine) {
+        Logger::log("JavaScriptServicePlugin::init(): No JavaScript engine");
+        return false;
+    }
+
+    if (!m_plugin.isValid()) {
+        const QScriptValue constructor = m_engine->pluginConstructor(m_fileName);
+
+        if (!constructor.isFunction()) {
+            return false;
+        }
+
+        m_plugin = constructor.construct();
+    }
+
     if (!m_plugin.property("cancelCurrentOperation").isFunction()) {
         Logger::log("JavaScriptServicePlugin::init(): No cancelCurrentOperation() function found");
         return false;
@@ -69,6 +82,8 @@ bool JavaScriptServicePlugin::init() {
 }
 
 bool JavaScriptServicePlugin::cancelCurrentOperation() {
+    const JavaScriptPluginScope scope(m_engine, this, m_fileName);
+
     if (!init()) {
         emit error(tr("Plugin not initialized"));
         return false;
@@ -78,6 +93,8 @@ bool JavaScriptServicePlugin::cancelCurrentOperation() {
 }
 
 void JavaScriptServicePlugin::checkUrl(const QString &url, const QVariantMap &settings) {
+    const JavaScriptPluginScope scope(m_engine, this, m_fileName);
+
     if (!init()) {
         emit error(tr("Plugin not initialized"));
         return;
@@ -94,6 +111,8 @@ void JavaScriptServicePlugin::checkUrl(const QString &url, const QVariantMap &se
 }
 
 void JavaScriptServicePlugin::getDownloadRequest(const QString &url, const QVariantMap &settings) {
+    const JavaScriptPluginScope scope(m_engine, this, m_fileName);
+
     if (!init()) {
         emit error(tr("Plugin not initialized"));
         return;
@@ -111,6 +130,8 @@ void JavaScriptServicePlugin::getDownloadRequest(const QString &url, const QVari
 }
 
 void JavaScriptServicePlugin::submitCaptchaResponse(const QString &challenge, const QString &response) {
+    const JavaScriptPluginScope scope(m_engine, this, m_fileName);
+
     if (!init()) {
         emit error(tr("Plugin not initialized"));
         return;
@@ -149,6 +170,8 @@ void JavaScriptServicePlugin::submitCaptchaResponse(const QString &challenge, co
 }
 
 void JavaScriptServicePlugin::submitSettingsResponse(const QVariantMap &settings) {
+    const JavaScriptPluginScope scope(m_engine, this, m_fileName);
+
     if (!init()) {
         emit error(tr("Plugin not initialized"));
         return;
@@ -210,56 +233,87 @@ JavaScriptServicePluginSignaller::JavaScriptServicePluginSignaller(QObject *pare
 {
 }
 
-JavaScriptServicePluginFactory::JavaScriptServicePluginFactory(const QString &fileName, QScriptEngine *engine,
-        QObject *parent) :
-    QObject(parent),
-    m_engine(engine),
-    m_fileName(fileName),
-    m_initted(false)
+JavaScriptServicePluginProxy::JavaScriptServicePluginProxy(ServicePlugin *plugin, QObject *parent) :
+    ServicePlugin(parent),
+    m_plugin(plugin)
 {
+    connectPlugin();
 }
 
-ServicePlugin* JavaScriptServicePluginFactory::createPlugin(QObject *parent) {
-    if (init()) {
-        return new JavaScriptServicePlugin(m_constructor.construct(), parent);
+JavaScriptServicePluginProxy::~JavaScriptServicePluginProxy() {
+    // The plugin must be deleted in the thread of its engine, which deletes it itself if it has already finished
+    if (m_plugin) {
+        m_plugin->deleteLater();
     }
-
-    return 0;
 }
 
-bool JavaScriptServicePluginFactory::init() {
-    if (m_initted) {
-        return true;
+bool JavaScriptServicePluginProxy::cancelCurrentOperation() {
+    if (m_plugin) {
+        // A script may still be running in the thread of the engine, so the plugin is not waited for. Its signals are
+        // dropped until the next request instead
+        disconnect(m_plugin, 0, this, 0);
+        QMetaObject::invokeMethod(m_plugin, "cancelCurrentOperation", Qt::QueuedConnection);
     }
 
-    if (!m_engine) {
-        Logger::log("JavaScriptServicePluginFactory::init(): No JavaScript engine");
-        return false;
-    }
+    return true;
+}
+
+void JavaScriptServicePluginProxy::checkUrl(const QString &url, const QVariantMap &settings) {
+    connectPlugin();
+    QMetaObject::invokeMethod(m_plugin, "checkUrl", Qt::QueuedConnection, Q_ARG(QString, url),
+            Q_ARG(QVariantMap, settings));
+}
 
-    QFile file(m_fileName);
+void JavaScriptServicePluginProxy::getDownloadRequest(const QString &url, const QVariantMap &settings) {
+    connectPlugin();
+    QMetaObject::invokeMethod(m_plugin, "getDownloadRequest", Qt::QueuedConnection, Q_ARG(QString, url),
+            Q_ARG(QVariantMap, settings));
+}
 
-    if (!file.open(QFile::ReadOnly)) {
-        Logger::log("JavaScriptServicePluginFactory::init(): Cannot read file: " + m_fileName);
-        return false;
+void JavaScriptServicePluginProxy::submitCaptchaResponse(const QString &challenge, const QString &response) {
+    QMetaObject::invokeMethod(m_plugin, "submitCaptchaResponse", Qt::QueuedConnection, Q_ARG(QString, challenge),
+            Q_ARG(QString, response));
+}
+
+void JavaScriptServicePluginProxy::submitSettingsResponse(const QVariantMap &settings) {
+    QMetaObject::invokeMethod(m_plugin, "submitSettingsResponse", Qt::QueuedConnection,
+            Q_ARG(QVariantMap, settings));
+}
+
+void JavaScriptServicePluginProxy::connectPlugin() {
+    if (!m_plugin) {
+        return;
     }
 
-    m_constructor = m_engine->evaluate(QString::fromUtf8(file.readAll()), m_fileName);
-    file.close();
+    connect(m_plugin, SIGNAL(captchaRequest(QString, int, QString, QByteArray)),
+            this, SIGNAL(captchaRequest(QString, int, QString, QByteArray)), Qt::UniqueConnection);
+    connect(m_plugin, SIGNAL(downloadRequest(QNetworkRequest, QByteArray, QByteArray)),
+            this, SIGNAL(downloadRequest(QNetworkRequest, QByteArray, QByteArray)), Qt::UniqueConnection);
+    connect(m_plugin, SIGNAL(error(QString)), this, SIGNAL(error(QString)), Qt::UniqueConnection);
+    connect(m_plugin, SIGNAL(settingsRequest(QString, QVariantList, QByteArray)),
+            this, SIGNAL(settingsRequest(QString, QVariantList, QByteArray)), Qt::UniqueConnection);
+    connect(m_plugin, SIGNAL(urlChecked(UrlResult)), this, SIGNAL(urlChecked(UrlResult)), Qt::UniqueConnection);
+    connect(m_plugin, SIGNAL(urlChecked(UrlResultList, QString)),
+            this, SIGNAL(urlChecked(UrlResultList, QString)), Qt::UniqueConnection);
+    connect(m_plugin, SIGNAL(waitRequest(int, bool)), this, SIGNAL(waitRequest(int, bool)), Qt::UniqueConnection);
+}
 
-    if (!m_constructor.isFunction()) {
-        if (m_constructor.isError()) {
-            Logger::log("JavaScriptServicePluginFactory::init(): Error evaluating JavaScript file: "
-                    + m_constructor.toString());
-        }
-        else {
-            Logger::log("JavaScriptServicePluginFactory::init(): No constructor function");
-        }
+JavaScriptServicePluginFactory::JavaScriptServicePluginFactory(const QString &fileName,
+        JavaScriptPluginEngine *engine, QObject *parent) :
+    QObject(parent),
+    m_engine(engine),
+    m_fileName(fileName)
+{
+}
 
-        return false;
+ServicePlugin* JavaScriptServicePluginFactory::createPlugin(QObject *parent) {
+    if (!m_engine) {
+        Logger::log("JavaScriptServicePluginFactory::createPlugin(): No JavaScript engine");
+        return 0;
     }
 
-    Logger::log("JavaScriptServicePluginFactory::init(): Initialized OK", Logger::HighVerbosity);
-    m_initted = true;
-    return true;
+    // The script is evaluated in the thread of the engine when the plugin is first used
+    JavaScriptServicePlugin *plugin = new JavaScriptServicePlugin(m_fileName, m_engine);
+    JavaScriptPluginEnginePool::instance()->addPlugin(plugin, m_engine->thread());
+    return new JavaScriptServicePluginProxy(plugin, parent);
 }
@@ -21,13 +21,14 @@
 #include <QPointer>
 #include <QScriptEngine>
 
+class JavaScriptPluginEngine;
+
 class JavaScriptServicePlugin : public ServicePlugin
 {
     Q_OBJECT
 
 public:
-    explicit JavaScriptServicePlugin(const QScriptValue &value, QObject *parent = 0);
-    ~JavaScriptServicePlugin();
+    explicit JavaScriptServicePlugin(const QString &fileName, JavaScriptPluginEngine *engine, QObject *parent = 0);
 
 public Q_SLOTS:
     virtual bool cancelCurrentOperation();
@@ -47,12 +48,45 @@ private Q_SLOTS:
 private:
     bool init();
 
+    QPointer<JavaScriptPluginEngine> m_engine;
+
+    QString m_fileName;
+
     QScriptValue m_plugin;
     QScriptValue m_callback;
 
     bool m_initted;
 };
 
+/**
+ * Forwards calls to a JavaScript service plugin in the thread of its engine, and re-emits its signals.
+ *
+ * All calls are queued and return at once. After cancelCurrentOperation(), the signals of the plugin are not
+ * forwarded until the next request.
+ */
+class JavaScriptServicePluginProxy : public ServicePlugin
+{
+    Q_OBJECT
+
+public:
+    explicit JavaScriptServicePluginProxy(ServicePlugin *plugin, QObject *parent = 0);
+    ~JavaScriptServicePluginProxy();
+
+public Q_SLOTS:
+    virtual bool cancelCurrentOperation();
+    
+    virtual void checkUrl(const QString &url, const QVariantMap &settings);
+    virtual void getDownloadRequest(const QString &url, const QVariantMap &settings);
+    
+    void submitCaptchaResponse(const QString &challenge, const QString &response);
+    void submitSettingsResponse(const QVariantMap &settings);
+
+private:
+    void connectPlugin();
+
+    QPointer<ServicePlugin> m_plugin;
+};
+
 class JavaScriptServicePluginSignaller : public QObject
 {
     Q_OBJECT
@@ -78,20 +112,15 @@ class JavaScriptServicePluginFactory : public QObject, public ServicePluginFacto
     Q_INTERFACES(ServicePluginFactory)
 
 public:
-    explicit JavaScriptServicePluginFactory(const QString &fileName, QScriptEngine *engine, QObject *parent = 0);
+    explicit JavaScriptServicePluginFactory(const QString &fileName, JavaScriptPluginEngine *engine,
+            QObject *parent = 0);
 
     virtual ServicePlugin* createPlugin(QObject *parent = 0);
 
 private:
-    bool init();
-
-    QPointer<QScriptEngine> m_engine;
+    QPointer<JavaScriptPluginEngine> m_engine;
 
     QString m_fileName;
-
-    QScriptValue m_constructor;
-
-    bool m_initted;
 };
 
 #endif // JAVASCRIPTSERVICEPLUGIN_H
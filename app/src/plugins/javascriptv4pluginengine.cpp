@@ -0,0 +1,76 @@
+/*
+ * Copyright (C) 2017 Stuart Howarth <showarth@marxoft.co.uk>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "javascriptv4pluginengine.h"
+#include "javascriptv4pluginglobalobject.h"
+#include "logger.h"
+#include <QFile>
+#include <QThreadStorage>
+
+// Deleted when the thread finishes
+static QThreadStorage<JavaScriptV4PluginEngine*> engines;
+
+JavaScriptV4PluginEngine::JavaScriptV4PluginEngine() :
+    QJSEngine(),
+    m_global(new JavaScriptV4PluginGlobalObject(this))
+{
+#if QT_VERSION >= 0x050600
+    installExtensions(QJSEngine::TranslationExtension);
+#endif
+}
+
+JavaScriptV4PluginEngine* JavaScriptV4PluginEngine::current() {
+    if (!engines.hasLocalData()) {
+        engines.setLocalData(new JavaScriptV4PluginEngine);
+    }
+
+    return engines.localData();
+}
+
+QJSValue JavaScriptV4PluginEngine::pluginConstructor(const QString &fileName) {
+    const QHash<QString, QJSValue>::const_iterator iterator = m_constructors.constFind(fileName);
+
+    if (iterator != m_constructors.constEnd()) {
+        return iterator.value();
+    }
+
+    QFile file(fileName);
+
+    if (!file.open(QFile::ReadOnly)) {
+        Logger::log("JavaScriptV4PluginEngine::pluginConstructor(): Cannot read file: " + fileName);
+        return QJSValue();
+    }
+
+    const QJSValue constructor = evaluate(QString::fromUtf8(file.readAll()), fileName);
+    file.close();
+
+    if (!constructor.isCallable()) {
+        if (constructor.isError()) {
+            Logger::log("JavaScriptV4PluginEngine::pluginConstructor(): Error evaluating JavaScript file: "
+                    + constructor.toString());
+        }
+        else {
+            Logger::log("JavaScriptV4PluginEngine::pluginConstructor(): No constructor function: " + fileName);
+        }
+
+        return QJSValue();
+    }
+
+    Logger::log("JavaScriptV4PluginEngine::pluginConstructor(): Initialized OK: " + fileName,
+            Logger::HighVerbosity);
+    m_constructors.insert(fileName, constructor);
+    return constructor;
+}
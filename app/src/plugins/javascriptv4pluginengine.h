@@ -0,0 +1,54 @@
+/*
+ * Copyright (C) 2017 Stuart Howarth <showarth@marxoft.co.uk>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef JAVASCRIPTV4PLUGINENGINE_H
+#define JAVASCRIPTV4PLUGINENGINE_H
+
+#include <QHash>
+#include <QJSEngine>
+
+class JavaScriptV4PluginGlobalObject;
+
+/**
+ * A QJSEngine that provides the same global objects to plugins as JavaScriptPluginEngine.
+ *
+ * Plugins that set "engine": "qjsengine" in their config are run by this engine instead of QtScript.
+ * There is one engine for each thread of the JavaScriptPluginEnginePool, created when it is first used.
+ */
+class JavaScriptV4PluginEngine : public QJSEngine
+{
+    Q_OBJECT
+
+public:
+    /**
+     * Returns the engine for the current thread, creating it if necessary.
+     */
+    static JavaScriptV4PluginEngine* current();
+
+    /**
+     * Returns the plugin constructor defined by the script in fileName, evaluating the script on first use.
+     */
+    QJSValue pluginConstructor(const QString &fileName);
+
+private:
+    JavaScriptV4PluginEngine();
+
+    JavaScriptV4PluginGlobalObject *m_global;
+
+    QHash<QString, QJSValue> m_constructors;
+};
+
+#endif // JAVASCRIPTV4PLUGINENGINE_H
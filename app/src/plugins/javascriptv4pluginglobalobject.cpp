@@ -0,0 +1,198 @@
+/*
+ * Copyright (C) 2017 Stuart Howarth <showarth@marxoft.co.uk>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "javascriptv4pluginglobalobject.h"
+#include "htmlparser.h"
+#include "javascriptcaptchatype.h"
+#include "javascriptv4searchplugin.h"
+#include "javascriptv4serviceplugin.h"
+#include "javascriptv4xmlhttprequest.h"
+#include "logger.h"
+#include "utils.h"
+#include <QJSEngine>
+#include <QMetaEnum>
+#include <QNetworkAccessManager>
+#include <QTimerEvent>
+
+// Plugin scripts use the same constructors and functions as with QtScript. Those that cannot be provided
+// by QObjects alone are defined here.
+static const char *GLOBALS =
+    "function atob(ascii) { return __qdl2.atob(ascii); }\n"
+    "function btoa(binary) { return __qdl2.btoa(binary); }\n"
+    "function decodeHtml(text) { return __qdl2.decodeHtml(text); }\n"
+    "function encodeHtml(text) { return __qdl2.encodeHtml(text); }\n"
+    "function clearInterval(timerId) { __qdl2.clearInterval(timerId); }\n"
+    "function clearTimeout(timerId) { __qdl2.clearTimeout(timerId); }\n"
+    "function setInterval(func, msecs) { return __qdl2.setInterval(func, msecs); }\n"
+    "function setTimeout(func, msecs) { return __qdl2.setTimeout(func, msecs); }\n"
+    "function SearchPlugin() { return __qdl2.newSearchPlugin(); }\n"
+    "function ServicePlugin() { return __qdl2.newServicePlugin(); }\n"
+    "function XMLHttpRequest() { return __qdl2.newXMLHttpRequest(); }\n"
+    "XMLHttpRequest.UNSENT = 0;\n"
+    "XMLHttpRequest.OPENED = 1;\n"
+    "XMLHttpRequest.HEADERS_RECEIVED = 2;\n"
+    "XMLHttpRequest.LOADING = 3;\n"
+    "XMLHttpRequest.DONE = 4;\n"
+    "function NetworkRequest(url) {\n"
+    "    this.url = url === undefined ? \"\" : String(url);\n"
+    "    this.headers = {};\n"
+    "}\n"
+    "NetworkRequest.prototype.header = function(name) { return this.headers[name]; };\n"
+    "NetworkRequest.prototype.setHeader = function(name, value) { this.headers[name] = value; };\n"
+    "function SearchResult(name, description, url) {\n"
+    "    this.name = name === undefined ? \"\" : String(name);\n"
+    "    this.description = description === undefined ? \"\" : String(description);\n"
+    "    this.url = url === undefined ? \"\" : String(url);\n"
+    "}\n"
+    "function UrlResult(url, fileName) {\n"
+    "    this.url = url === undefined ? \"\" : String(url);\n"
+    "    this.fileName = fileName === undefined ? \"\" : String(fileName);\n"
+    "}\n";
+
+JavaScriptV4PluginGlobalObject::JavaScriptV4PluginGlobalObject(QJSEngine *engine) :
+    QObject(engine),
+    m_engine(engine),
+    m_nam(0)
+{
+    QJSValue global = engine->globalObject();
+    global.setProperty("__qdl2", engine->newQObject(this));
+
+    QJSValue captchaType = engine->newObject();
+    const QMetaEnum types = JavaScriptCaptchaType::staticMetaObject.enumerator(
+            JavaScriptCaptchaType::staticMetaObject.indexOfEnumerator("Type"));
+
+    for (int i = 0; i < types.keyCount(); i++) {
+        captchaType.setProperty(types.key(i), types.value(i));
+    }
+
+    global.setProperty("CaptchaType", captchaType);
+    global.setProperty("HtmlParser", engine->newQObject(new HtmlParser(engine)));
+
+    const QJSValue result = engine->evaluate(GLOBALS);
+
+    if (result.isError()) {
+        Logger::log("JavaScriptV4PluginGlobalObject::JavaScriptV4PluginGlobalObject(): Error: " + result.toString());
+    }
+}
+
+QObject* JavaScriptV4PluginGlobalObject::newSearchPlugin() {
+    return new JavaScriptV4SearchPluginSignaller;
+}
+
+QObject* JavaScriptV4PluginGlobalObject::newServicePlugin() {
+    return new JavaScriptV4ServicePluginSignaller;
+}
+
+QObject* JavaScriptV4PluginGlobalObject::newXMLHttpRequest() {
+    return new JavaScriptV4XMLHttpRequest(networkAccessManager());
+}
+
+QNetworkAccessManager* JavaScriptV4PluginGlobalObject::networkAccessManager() {
+    return m_nam ? m_nam : m_nam = new QNetworkAccessManager(this);
+}
+
+QString JavaScriptV4PluginGlobalObject::atob(const QString &ascii) const {
+    return QString::fromUtf8(QByteArray::fromBase64(ascii.toUtf8()));
+}
+
+QString JavaScriptV4PluginGlobalObject::btoa(const QString &binary) const {
+    return QString::fromUtf8(binary.toUtf8().toBase64());
+}
+
+QString JavaScriptV4PluginGlobalObject::decodeHtml(const QString &text) const {
+    return Utils::decodeHtml(text);
+}
+
+QString JavaScriptV4PluginGlobalObject::encodeHtml(const QString &text) const {
+    return Utils::encodeHtml(text);
+}
+
+void JavaScriptV4PluginGlobalObject::clearInterval(int timerId) {
+    if (m_intervals.contains(timerId)) {
+        m_intervals.remove(timerId);
+        killTimer(timerId);
+    }
+}
+
+void JavaScriptV4PluginGlobalObject::clearTimeout(int timerId) {
+    if (m_timeouts.contains(timerId)) {
+        m_timeouts.remove(timerId);
+        killTimer(timerId);
+    }
+}
+
+int JavaScriptV4PluginGlobalObject::setInterval(const QJSValue &function, int msecs) {
+    if ((function.isCallable()) || (function.isString())) {
+        const int timerId = startTimer(msecs);
+        m_intervals[timerId] = function;
+        return timerId;
+    }
+
+    return -1;
+}
+
+int JavaScriptV4PluginGlobalObject::setTimeout(const QJSValue &function, int msecs) {
+    if ((function.isCallable()) || (function.isString())) {
+        const int timerId = startTimer(msecs);
+        m_timeouts[timerId] = function;
+        return timerId;
+    }
+
+    return -1;
+}
+
+bool JavaScriptV4PluginGlobalObject::callFunction(QJSValue function) const {
+    if (function.isCallable()) {
+        const QJSValue result = function.call();
+
+        if (result.isError()) {
+            Logger::log("JavaScriptV4PluginGlobalObject::callFunction(). Error: " + result.toString());
+            return false;
+        }
+
+        return true;
+    }
+
+    if (!m_engine.isNull()) {
+        const QJSValue result = m_engine->globalObject().property(function.toString()).call();
+
+        if (result.isError()) {
+            Logger::log("JavaScriptV4PluginGlobalObject::callFunction(). Error: " + result.toString());
+            return false;
+        }
+
+        return true;
+    }
+    
+    return false;
+}
+
+void JavaScriptV4PluginGlobalObject::timerEvent(QTimerEvent *event) {
+    if (m_intervals.contains(event->timerId())) {
+        if (!callFunction(m_intervals.value(event->timerId()))) {
+            clearInterval(event->timerId());
+        }
+        
+        event->accept();
+        return;
+    }
+
+    if (m_timeouts.contains(event->timerId())) {
+        callFunction(m_timeouts.value(event->timerId()));
+        clearTimeout(event->timerId());
+        event->accept();
+    }
+}
@@ -0,0 +1,67 @@
+/*
+ * Copyright (C) 2017 Stuart Howarth <showarth@marxoft.co.uk>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef JAVASCRIPTV4PLUGINGLOBALOBJECT_H
+#define JAVASCRIPTV4PLUGINGLOBALOBJECT_H
+
+#include <QHash>
+#include <QJSValue>
+#include <QObject>
+#include <QPointer>
+
+class QJSEngine;
+class QNetworkAccessManager;
+
+class JavaScriptV4PluginGlobalObject : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit JavaScriptV4PluginGlobalObject(QJSEngine *engine);
+
+public Q_SLOTS:
+    QString atob(const QString &ascii) const;
+    QString btoa(const QString &binary) const;
+
+    QString decodeHtml(const QString &text) const;
+    QString encodeHtml(const QString &text) const;
+
+    void clearInterval(int timerId);
+    void clearTimeout(int timerId);
+
+    int setInterval(const QJSValue &function, int msecs);
+    int setTimeout(const QJSValue &function, int msecs);
+
+    QObject* newSearchPlugin();
+    QObject* newServicePlugin();
+    QObject* newXMLHttpRequest();
+
+private:
+    QNetworkAccessManager* networkAccessManager();
+
+    bool callFunction(QJSValue function) const;
+
+    virtual void timerEvent(QTimerEvent *event);
+
+    QPointer<QJSEngine> m_engine;
+
+    QNetworkAccessManager *m_nam;
+
+    QHash<int, QJSValue> m_intervals;
+    QHash<int, QJSValue> m_timeouts;
+};
+
+#endif // JAVASCRIPTV4PLUGINGLOBALOBJECT_H
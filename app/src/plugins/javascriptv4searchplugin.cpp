@@ -0,0 +1,191 @@
+/*
+ * Copyright (C) 2017 Stuart Howarth <showarth@marxoft.co.uk>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "javascriptv4searchplugin.h"
+#include "javascriptsearchplugin.h"
+#include "javascriptpluginengine.h"
+#include "javascriptv4pluginengine.h"
+#include "logger.h"
+#include <QThread>
+
+JavaScriptV4SearchPlugin::JavaScriptV4SearchPlugin(const QString &fileName, QObject *parent) :
+    SearchPlugin(parent),
+    m_fileName(fileName),
+    m_initted(false)
+{
+}
+
+bool JavaScriptV4SearchPlugin::init() {
+    if (m_initted) {
+        return true;
+    }
+
+    if (m_plugin.isUndefined()) {
+        const QJSValue constructor = JavaScriptV4PluginEngine::current()->pluginConstructor(m_fileName);
+
+        if (!constructor.isCallable()) {
+            return false;
+        }
+
+        m_plugin = constructor.callAsConstructor();
+    }
+
+    if (!m_plugin.property("cancelCurrentOperation").isCallable()) {
+        Logger::log("JavaScriptV4SearchPlugin::init(): No cancelCurrentOperation() function found");
+        return false;
+    }
+
+    if (!m_plugin.property("search").isCallable()) {
+        Logger::log("JavaScriptV4SearchPlugin::init(): No search() function found");
+        return false;
+    }
+
+    QObject *obj = m_plugin.toQObject();
+
+    if ((!obj) || (!connect(obj, SIGNAL(error(QString)), this, SIGNAL(error(QString))))
+            || (!connect(obj, SIGNAL(searchCompleted(QVariant, QVariant)),
+                    this, SLOT(onSearchCompleted(QVariant, QVariant))))
+            || (!connect(obj, SIGNAL(settingsRequest(QString, QVariantList, QJSValue)),
+                    this, SLOT(onSettingsRequest(QString, QVariantList, QJSValue))))) {
+        Logger::log("JavaScriptV4SearchPlugin::init(): Not a valid SearchPlugin");
+        return false;
+    }
+
+    Logger::log("JavaScriptV4SearchPlugin::init(): SearchPlugin initialized OK", Logger::HighVerbosity);
+    m_initted = true;
+    return true;
+}
+
+bool JavaScriptV4SearchPlugin::callFunction(const QString &name, const QJSValueList &args) {
+    const QJSValue result = m_plugin.property(name).callWithInstance(m_plugin, args);
+
+    if (result.isError()) {
+        const QString errorString = result.toString();
+        Logger::log(QString("JavaScriptV4SearchPlugin::callFunction(): Error calling %1(): %2").arg(name)
+                .arg(errorString));
+        emit error(tr("Error calling %1(): %2").arg(name).arg(errorString));
+        return false;
+    }
+
+    return true;
+}
+
+bool JavaScriptV4SearchPlugin::cancelCurrentOperation() {
+    if (!init()) {
+        emit error(tr("Plugin not initialized"));
+        return false;
+    }
+
+    return m_plugin.property("cancelCurrentOperation").callWithInstance(m_plugin).toBool();
+}
+
+void JavaScriptV4SearchPlugin::fetchMore(const QVariantMap &params) {
+    if (!init()) {
+        emit error(tr("Plugin not initialized"));
+        return;
+    }
+
+    callFunction("fetchMore", QJSValueList() << JavaScriptV4PluginEngine::current()->toScriptValue(params));
+}
+
+void JavaScriptV4SearchPlugin::search(const QVariantMap &settings) {
+    if (!init()) {
+        emit error(tr("Plugin not initialized"));
+        return;
+    }
+
+    callFunction("search", QJSValueList() << JavaScriptV4PluginEngine::current()->toScriptValue(settings));
+}
+
+void JavaScriptV4SearchPlugin::submitSettingsResponse(const QVariantMap &settings) {
+    if (!init()) {
+        emit error(tr("Plugin not initialized"));
+        return;
+    }
+
+    const QJSValue value = JavaScriptV4PluginEngine::current()->toScriptValue(settings);
+
+    if (m_callback.isCallable()) {
+        const QJSValue result = m_callback.callWithInstance(m_plugin, QJSValueList() << value);
+
+        if (result.isError()) {
+            const QString errorString = result.toString();
+            Logger::log("JavaScriptV4SearchPlugin::submitSettingsResponse(): Error calling settings callback: "
+                    + errorString);
+            emit error(tr("Settings callback error: %1").arg(errorString));
+        }
+    }
+    else {
+        const QString funcName = m_callback.toString();
+
+        if (m_plugin.property(funcName).isCallable()) {
+            callFunction(funcName, QJSValueList() << value);
+        }
+        else {
+            Logger::log(QString("JavaScriptV4SearchPlugin::submitSettingsResponse(): %1 function not defined")
+                    .arg(funcName));
+            emit error(tr("%1 function not defined in the plugin").arg(funcName));
+        }
+    }
+}
+
+void JavaScriptV4SearchPlugin::onSearchCompleted(const QVariant &results, const QVariant &nextParams) {
+    SearchResultList list;
+
+    foreach (const QVariant &value, results.toList()) {
+        const QVariantMap result = value.toMap();
+        list << SearchResult(result.value("name").toString(), result.value("description").toString(),
+                result.value("url").toString());
+    }
+
+    if (nextParams.isValid()) {
+        emit searchCompleted(list, nextParams.toMap());
+    }
+    else {
+        emit searchCompleted(list);
+    }
+}
+
+void JavaScriptV4SearchPlugin::onSettingsRequest(const QString &title, const QVariantList &settings,
+        const QJSValue &callback) {
+    m_callback = callback;
+    emit settingsRequest(title, settings, "submitSettingsResponse");
+}
+
+JavaScriptV4SearchPluginSignaller::JavaScriptV4SearchPluginSignaller(QObject *parent) :
+    QObject(parent)
+{
+}
+
+JavaScriptV4SearchPluginFactory::JavaScriptV4SearchPluginFactory(const QString &fileName, QThread *thread,
+        QObject *parent) :
+    QObject(parent),
+    m_thread(thread),
+    m_fileName(fileName)
+{
+}
+
+SearchPlugin* JavaScriptV4SearchPluginFactory::createPlugin(QObject *parent) {
+    if (!m_thread) {
+        Logger::log("JavaScriptV4SearchPluginFactory::createPlugin(): No JavaScript engine thread");
+        return 0;
+    }
+
+    // The script is evaluated by the engine of the thread when the plugin is first used
+    JavaScriptV4SearchPlugin *plugin = new JavaScriptV4SearchPlugin(m_fileName);
+    JavaScriptPluginEnginePool::instance()->addPlugin(plugin, m_thread);
+    return new JavaScriptSearchPluginProxy(plugin, parent);
+}
@@ -0,0 +1,91 @@
+/*
+ * Copyright (C) 2017 Stuart Howarth <showarth@marxoft.co.uk>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef JAVASCRIPTV4SEARCHPLUGIN_H
+#define JAVASCRIPTV4SEARCHPLUGIN_H
+
+#include "searchplugin.h"
+#include <QJSValue>
+#include <QPointer>
+
+class QThread;
+
+class JavaScriptV4SearchPlugin : public SearchPlugin
+{
+    Q_OBJECT
+
+public:
+    explicit JavaScriptV4SearchPlugin(const QString &fileName, QObject *parent = 0);
+
+public Q_SLOTS:
+    virtual bool cancelCurrentOperation();
+
+    virtual void fetchMore(const QVariantMap &params);
+    virtual void search(const QVariantMap &settings);
+
+    void submitSettingsResponse(const QVariantMap &settings);
+
+private Q_SLOTS:
+    void onSearchCompleted(const QVariant &results, const QVariant &nextParams);
+    void onSettingsRequest(const QString &title, const QVariantList &settings, const QJSValue &callback);
+
+private:
+    bool init();
+
+    bool callFunction(const QString &name, const QJSValueList &args);
+
+    QString m_fileName;
+
+    QJSValue m_plugin;
+    QJSValue m_callback;
+
+    bool m_initted;
+};
+
+/**
+ * The SearchPlugin object created by scripts. SearchResult is a plain script object in QJSEngine, so the
+ * results are received as variants.
+ */
+class JavaScriptV4SearchPluginSignaller : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit JavaScriptV4SearchPluginSignaller(QObject *parent = 0);
+
+Q_SIGNALS:
+    void error(const QString &errorString);
+    void searchCompleted(const QVariant &results, const QVariant &nextParams = QVariant());
+    void settingsRequest(const QString &title, const QVariantList &settings, const QJSValue &callback);
+};
+
+class JavaScriptV4SearchPluginFactory : public QObject, public SearchPluginFactory
+{
+    Q_OBJECT
+    Q_INTERFACES(SearchPluginFactory)
+
+public:
+    explicit JavaScriptV4SearchPluginFactory(const QString &fileName, QThread *thread, QObject *parent = 0);
+
+    virtual SearchPlugin* createPlugin(QObject *parent = 0);
+
+private:
+    QPointer<QThread> m_thread;
+
+    QString m_fileName;
+};
+
+#endif // JAVASCRIPTV4SEARCHPLUGIN_H
@@ -0,0 +1,258 @@
+/*
+ * Copyright (C) 2017 Stuart Howarth <showarth@marxoft.co.uk>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "javascriptv4serviceplugin.h"
+#include "javascriptserviceplugin.h"
+#include "javascriptpluginengine.h"
+#include "javascriptv4pluginengine.h"
+#include "logger.h"
+#include <QNetworkRequest>
+#include <QThread>
+
+// NetworkRequest is a plain script object with url and headers properties, or just a URL string
+static QNetworkRequest toNetworkRequest(const QVariant &value) {
+    if (value.type() != QVariant::Map) {
+        return QNetworkRequest(value.toString());
+    }
+
+    const QVariantMap map = value.toMap();
+    QNetworkRequest request(map.value("url").toString());
+    const QVariantMap headers = map.value("headers").toMap();
+
+    for (QVariantMap::const_iterator iterator = headers.constBegin(); iterator != headers.constEnd(); ++iterator) {
+        request.setRawHeader(iterator.key().toUtf8(), iterator.value().toString().toUtf8());
+    }
+
+    return request;
+}
+
+static UrlResult toUrlResult(const QVariant &value) {
+    const QVariantMap map = value.toMap();
+    return UrlResult(map.value("url").toString(), map.value("fileName").toString());
+}
+
+JavaScriptV4ServicePlugin::JavaScriptV4ServicePlugin(const QString &fileName, QObject *parent) :
+    ServicePlugin(parent),
+    m_fileName(fileName),
+    m_initted(false)
+{
+}
+
+bool JavaScriptV4ServicePlugin::init() {
+    if (m_initted) {
+        return true;
+    }
+
+    if (m_plugin.isUndefined()) {
+        const QJSValue constructor = JavaScriptV4PluginEngine::current()->pluginConstructor(m_fileName);
+
+        if (!constructor.isCallable()) {
+            return false;
+        }
+
+        m_plugin = constructor.callAsConstructor();
+    }
+
+    if (!m_plugin.property("cancelCurrentOperation").isCallable()) {
+        Logger::log("JavaScriptV4ServicePlugin::init(): No cancelCurrentOperation() function found");
+        return false;
+    }
+
+    if (!m_plugin.property("checkUrl").isCallable()) {
+        Logger::log("JavaScriptV4ServicePlugin::init(): No checkUrl() function found");
+        return false;
+    }
+
+    QObject *obj = m_plugin.toQObject();
+
+    if ((!obj) || (!connect(obj, SIGNAL(captchaRequest(QString, int, QString, QJSValue)),
+                    this, SLOT(onCaptchaRequest(QString, int, QString, QJSValue))))
+            || (!connect(obj, SIGNAL(downloadRequest(QVariant, QString, QString)),
+                    this, SLOT(onDownloadRequest(QVariant, QString, QString))))
+            || (!connect(obj, SIGNAL(error(QString)), this, SIGNAL(error(QString))))
+            || (!connect(obj, SIGNAL(settingsRequest(QString, QVariantList, QJSValue)),
+                    this, SLOT(onSettingsRequest(QString, QVariantList, QJSValue))))
+            || (!connect(obj, SIGNAL(urlChecked(QVariant, QString)), this, SLOT(onUrlChecked(QVariant, QString))))
+            || (!connect(obj, SIGNAL(waitRequest(int, bool)), this, SIGNAL(waitRequest(int, bool))))) {
+        Logger::log("JavaScriptV4ServicePlugin::init(): Not a valid ServicePlugin");
+        return false;
+    }
+
+    Logger::log("JavaScriptV4ServicePlugin::init(): ServicePlugin initialized OK", Logger::HighVerbosity);
+    m_initted = true;
+    return true;
+}
+
+bool JavaScriptV4ServicePlugin::callFunction(const QString &name, const QJSValueList &args) {
+    const QJSValue result = m_plugin.property(name).callWithInstance(m_plugin, args);
+
+    if (result.isError()) {
+        const QString errorString = result.toString();
+        Logger::log(QString("JavaScriptV4ServicePlugin::callFunction(): Error calling %1(): %2").arg(name)
+                .arg(errorString));
+        emit error(tr("Error calling %1(): %2").arg(name).arg(errorString));
+        return false;
+    }
+
+    return true;
+}
+
+bool JavaScriptV4ServicePlugin::cancelCurrentOperation() {
+    if (!init()) {
+        emit error(tr("Plugin not initialized"));
+        return false;
+    }
+
+    return m_plugin.property("cancelCurrentOperation").callWithInstance(m_plugin).toBool();
+}
+
+void JavaScriptV4ServicePlugin::checkUrl(const QString &url, const QVariantMap &settings) {
+    if (!init()) {
+        emit error(tr("Plugin not initialized"));
+        return;
+    }
+
+    callFunction("checkUrl", QJSValueList() << url << JavaScriptV4PluginEngine::current()->toScriptValue(settings));
+}
+
+void JavaScriptV4ServicePlugin::getDownloadRequest(const QString &url, const QVariantMap &settings) {
+    if (!init()) {
+        emit error(tr("Plugin not initialized"));
+        return;
+    }
+
+    callFunction("getDownloadRequest", QJSValueList() << url
+            << JavaScriptV4PluginEngine::current()->toScriptValue(settings));
+}
+
+void JavaScriptV4ServicePlugin::submitCaptchaResponse(const QString &challenge, const QString &response) {
+    if (!init()) {
+        emit error(tr("Plugin not initialized"));
+        return;
+    }
+
+    if (m_callback.isCallable()) {
+        const QJSValue result = m_callback.callWithInstance(m_plugin, QJSValueList() << challenge << response);
+
+        if (result.isError()) {
+            const QString errorString = result.toString();
+            Logger::log("JavaScriptV4ServicePlugin::submitCaptchaResponse(): Error calling captcha callback: "
+                    + errorString);
+            emit error(tr("Captcha callback error: %1").arg(errorString));
+        }
+    }
+    else {
+        const QString funcName = m_callback.toString();
+
+        if (m_plugin.property(funcName).isCallable()) {
+            callFunction(funcName, QJSValueList() << challenge << response);
+        }
+        else {
+            Logger::log(QString("JavaScriptV4ServicePlugin::submitCaptchaResponse(): %1 function not defined")
+                    .arg(funcName));
+            emit error(tr("%1 function not defined in the plugin").arg(funcName));
+        }
+    }
+}
+
+void JavaScriptV4ServicePlugin::submitSettingsResponse(const QVariantMap &settings) {
+    if (!init()) {
+        emit error(tr("Plugin not initialized"));
+        return;
+    }
+
+    const QJSValue value = JavaScriptV4PluginEngine::current()->toScriptValue(settings);
+
+    if (m_callback.isCallable()) {
+        const QJSValue result = m_callback.callWithInstance(m_plugin, QJSValueList() << value);
+
+        if (result.isError()) {
+            const QString errorString = result.toString();
+            Logger::log("JavaScriptV4ServicePlugin::submitSettingsResponse(): Error calling settings callback: "
+                    + errorString);
+            emit error(tr("Settings callback error: %1").arg(errorString));
+        }
+    }
+    else {
+        const QString funcName = m_callback.toString();
+
+        if (m_plugin.property(funcName).isCallable()) {
+            callFunction(funcName, QJSValueList() << value);
+        }
+        else {
+            Logger::log(QString("JavaScriptV4ServicePlugin::submitSettingsResponse(): %1 function not defined")
+                    .arg(funcName));
+            emit error(tr("%1 function not defined in the plugin").arg(funcName));
+        }
+    }
+}
+
+void JavaScriptV4ServicePlugin::onCaptchaRequest(const QString &recaptchaPluginId, int captchaType,
+        const QString &captchaKey, const QJSValue &callback) {
+    m_callback = callback;
+    emit captchaRequest(recaptchaPluginId, captchaType, captchaKey, "submitCaptchaResponse");
+}
+
+void JavaScriptV4ServicePlugin::onDownloadRequest(const QVariant &request, const QString &method,
+        const QString &data) {
+    emit downloadRequest(toNetworkRequest(request), method.toUtf8(), data.toUtf8());
+}
+
+void JavaScriptV4ServicePlugin::onSettingsRequest(const QString &title, const QVariantList &settings,
+        const QJSValue &callback) {
+    m_callback = callback;
+    emit settingsRequest(title, settings, "submitSettingsResponse");
+}
+
+void JavaScriptV4ServicePlugin::onUrlChecked(const QVariant &result, const QString &packageName) {
+    if (result.type() != QVariant::List) {
+        emit urlChecked(toUrlResult(result));
+        return;
+    }
+
+    UrlResultList results;
+
+    foreach (const QVariant &value, result.toList()) {
+        results << toUrlResult(value);
+    }
+
+    emit urlChecked(results, packageName);
+}
+
+JavaScriptV4ServicePluginSignaller::JavaScriptV4ServicePluginSignaller(QObject *parent) :
+    QObject(parent)
+{
+}
+
+JavaScriptV4ServicePluginFactory::JavaScriptV4ServicePluginFactory(const QString &fileName, QThread *thread,
+        QObject *parent) :
+    QObject(parent),
+    m_thread(thread),
+    m_fileName(fileName)
+{
+}
+
+ServicePlugin* JavaScriptV4ServicePluginFactory::createPlugin(QObject *parent) {
+    if (!m_thread) {
+        Logger::log("JavaScriptV4ServicePluginFactory::createPlugin(): No JavaScript engine thread");
+        return 0;
+    }
+
+    // The script is evaluated by the engine of the thread when the plugin is first used
+    JavaScriptV4ServicePlugin *plugin = new JavaScriptV4ServicePlugin(m_fileName);
+    JavaScriptPluginEnginePool::instance()->addPlugin(plugin, m_thread);
+    return new JavaScriptServicePluginProxy(plugin, parent);
+}
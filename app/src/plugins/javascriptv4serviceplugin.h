@@ -0,0 +1,100 @@
+/*
+ * Copyright (C) 2017 Stuart Howarth <showarth@marxoft.co.uk>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef JAVASCRIPTV4SERVICEPLUGIN_H
+#define JAVASCRIPTV4SERVICEPLUGIN_H
+
+#include "serviceplugin.h"
+#include <QJSValue>
+#include <QPointer>
+
+class QThread;
+
+class JavaScriptV4ServicePlugin : public ServicePlugin
+{
+    Q_OBJECT
+
+public:
+    explicit JavaScriptV4ServicePlugin(const QString &fileName, QObject *parent = 0);
+
+public Q_SLOTS:
+    virtual bool cancelCurrentOperation();
+
+    virtual void checkUrl(const QString &url, const QVariantMap &settings);
+    virtual void getDownloadRequest(const QString &url, const QVariantMap &settings);
+
+    void submitCaptchaResponse(const QString &challenge, const QString &response);
+    void submitSettingsResponse(const QVariantMap &settings);
+
+private Q_SLOTS:
+    void onCaptchaRequest(const QString &recaptchaPluginId, int captchaType, const QString &captchaKey,
+            const QJSValue &callback);
+    void onDownloadRequest(const QVariant &request, const QString &method, const QString &data);
+    void onSettingsRequest(const QString &title, const QVariantList &settings, const QJSValue &callback);
+    void onUrlChecked(const QVariant &result, const QString &packageName);
+
+private:
+    bool init();
+
+    bool callFunction(const QString &name, const QJSValueList &args);
+
+    QString m_fileName;
+
+    QJSValue m_plugin;
+    QJSValue m_callback;
+
+    bool m_initted;
+};
+
+/**
+ * The ServicePlugin object created by scripts. NetworkRequest and UrlResult are plain script objects in
+ * QJSEngine, so they are received as variants.
+ */
+class JavaScriptV4ServicePluginSignaller : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit JavaScriptV4ServicePluginSignaller(QObject *parent = 0);
+
+Q_SIGNALS:
+    void captchaRequest(const QString &recaptchaPluginId, int captchaType, const QString &captchaKey,
+            const QJSValue &callback);
+    void downloadRequest(const QVariant &request, const QString &method = QString("GET"),
+            const QString &data = QString());
+    void error(const QString &errorString);
+    void settingsRequest(const QString &title, const QVariantList &settings, const QJSValue &callback);
+    void urlChecked(const QVariant &result, const QString &packageName = QString());
+    void waitRequest(int msecs, bool isLongDelay = false);
+};
+
+class JavaScriptV4ServicePluginFactory : public QObject, public ServicePluginFactory
+{
+    Q_OBJECT
+    Q_INTERFACES(ServicePluginFactory)
+
+public:
+    explicit JavaScriptV4ServicePluginFactory(const QString &fileName, QThread *thread, QObject *parent = 0);
+
+    virtual ServicePlugin* createPlugin(QObject *parent = 0);
+
+private:
+    QPointer<QThread> m_thread;
+
+    QString m_fileName;
+};
+
+#endif // JAVASCRIPTV4SERVICEPLUGIN_H
@@ -0,0 +1,42 @@
+/*
+ * Copyright (C) 2017 Stuart Howarth <showarth@marxoft.co.uk>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "javascriptv4xmlhttprequest.h"
+#include "logger.h"
+
+JavaScriptV4XMLHttpRequest::JavaScriptV4XMLHttpRequest(QNetworkAccessManager *manager, QObject *parent) :
+    XMLHttpRequest(manager, parent)
+{
+    connect(this, SIGNAL(readyStateChanged()), this, SLOT(onReadyStateChanged()));
+}
+
+QJSValue JavaScriptV4XMLHttpRequest::onReadyStateChange() const {
+    return m_onReadyStateChange;
+}
+
+void JavaScriptV4XMLHttpRequest::setOnReadyStateChange(const QJSValue &function) {
+    m_onReadyStateChange = function;
+}
+
+void JavaScriptV4XMLHttpRequest::onReadyStateChanged() {
+    if (m_onReadyStateChange.isCallable()) {
+        const QJSValue result = m_onReadyStateChange.call();
+
+        if (result.isError()) {
+            Logger::log("JavaScriptV4XMLHttpRequest::onReadyStateChanged(): Error: " + result.toString());
+        }
+    }
+}
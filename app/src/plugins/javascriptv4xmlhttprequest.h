@@ -0,0 +1,45 @@
+/*
+ * Copyright (C) 2017 Stuart Howarth <showarth@marxoft.co.uk>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef JAVASCRIPTV4XMLHTTPREQUEST_H
+#define JAVASCRIPTV4XMLHTTPREQUEST_H
+
+#include "xmlhttprequest.h"
+#include <QJSValue>
+
+/**
+ * An XMLHttpRequest whose onreadystatechange handler is a QJSEngine function.
+ */
+class JavaScriptV4XMLHttpRequest : public XMLHttpRequest
+{
+    Q_OBJECT
+
+    Q_PROPERTY(QJSValue onreadystatechange READ onReadyStateChange WRITE setOnReadyStateChange)
+
+public:
+    explicit JavaScriptV4XMLHttpRequest(QNetworkAccessManager *manager, QObject *parent = 0);
+
+    QJSValue onReadyStateChange() const;
+    void setOnReadyStateChange(const QJSValue &function);
+
+private Q_SLOTS:
+    void onReadyStateChanged();
+
+private:
+    QJSValue m_onReadyStateChange;
+};
+
+#endif // JAVASCRIPTV4XMLHTTPREQUEST_H
@@ -0,0 +1,78 @@
+/*
+ * Copyright (C) 2017 Stuart Howarth <showarth@marxoft.co.uk>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LAZYPLUGINFACTORY_H
+#define LAZYPLUGINFACTORY_H
+
+#include "logger.h"
+#include <QPluginLoader>
+
+/**
+ * Loads the Qt plugin library in fileName when the first plugin is created, rather than when the plugin
+ * configs are loaded, so that libraries that are never used are never loaded.
+ *
+ * Factory is the plugin factory interface and Plugin is the type of plugin it creates.
+ */
+template <class Factory, class Plugin>
+class LazyPluginFactory : public QObject, public Factory
+{
+
+public:
+    explicit LazyPluginFactory(const QString &fileName, QObject *parent = 0) :
+        QObject(parent),
+        m_loader(fileName),
+        m_factory(0),
+        m_failed(false)
+    {
+    }
+
+    virtual Plugin* createPlugin(QObject *parent = 0) {
+        if (!m_factory) {
+            if (m_failed) {
+                return 0;
+            }
+
+            QObject *obj = m_loader.instance();
+            m_factory = qobject_cast<Factory*>(obj);
+
+            if (!m_factory) {
+                m_failed = true;
+                Logger::log(QString("LazyPluginFactory::createPlugin(): Error loading Qt plugin: %1: %2")
+                            .arg(m_loader.fileName()).arg(m_loader.errorString()), Logger::LowestVerbosity);
+
+                if (obj) {
+                    m_loader.unload();
+                }
+
+                return 0;
+            }
+
+            Logger::log("LazyPluginFactory::createPlugin(): Qt plugin loaded: " + m_loader.fileName(),
+                        Logger::MediumVerbosity);
+        }
+
+        return m_factory->createPlugin(parent);
+    }
+
+private:
+    QPluginLoader m_loader;
+
+    Factory *m_factory;
+
+    bool m_failed;
+};
+
+#endif // LAZYPLUGINFACTORY_H
@@ -0,0 +1,164 @@
+/*
+ * Copyright (C) 2017 Stuart Howarth <showarth@marxoft.co.uk>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "pluginmanifestcache.h"
+#include "definitions.h"
+#include "json.h"
+#include "logger.h"
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QMutexLocker>
+
+PluginManifestCache* PluginManifestCache::self = 0;
+
+PluginManifestCache::PluginManifestCache() :
+    QObject(),
+    m_restored(false),
+    m_changed(false)
+{
+}
+
+PluginManifestCache::~PluginManifestCache() {
+    save();
+    self = 0;
+}
+
+PluginManifestCache* PluginManifestCache::instance() {
+    return self ? self : self = new PluginManifestCache;
+}
+
+QVariantMap PluginManifestCache::manifest(const QString &filePath, bool *ok) {
+    QMutexLocker locker(&m_mutex);
+
+    if (!m_restored) {
+        restore();
+    }
+
+    const QFileInfo info(filePath);
+    const qint64 modified = info.lastModified().toMSecsSinceEpoch();
+    const qint64 size = info.size();
+    const QVariantMap entry = m_entries.value(filePath).toMap();
+
+    if ((!entry.isEmpty()) && (entry.value("modified").toLongLong() == modified)
+            && (entry.value("size").toLongLong() == size)) {
+        Logger::log("PluginManifestCache::manifest(): Using cached manifest for " + filePath,
+                    Logger::HighVerbosity);
+
+        if (ok) {
+            *ok = true;
+        }
+
+        return entry.value("manifest").toMap();
+    }
+
+    QFile file(filePath);
+
+    if (!file.open(QFile::ReadOnly)) {
+        Logger::log("PluginManifestCache::manifest(): Unable to open config file: " + filePath);
+
+        if (ok) {
+            *ok = false;
+        }
+
+        return QVariantMap();
+    }
+
+    bool parsed;
+    const QVariant v = QtJson::Json::parse(file.readAll(), parsed);
+    file.close();
+
+    if ((!parsed) || (v.type() != QVariant::Map)) {
+        Logger::log("PluginManifestCache::manifest(): Error parsing config file: " + filePath);
+
+        if (ok) {
+            *ok = false;
+        }
+
+        return QVariantMap();
+    }
+
+    QVariantMap newEntry;
+    newEntry["modified"] = modified;
+    newEntry["size"] = size;
+    newEntry["manifest"] = v;
+    m_entries[filePath] = newEntry;
+    m_changed = true;
+
+    if (ok) {
+        *ok = true;
+    }
+
+    return v.toMap();
+}
+
+bool PluginManifestCache::save() {
+    QMutexLocker locker(&m_mutex);
+
+    if (!m_restored) {
+        // No manifests have been used, so there is nothing to prune or write
+        return true;
+    }
+
+    foreach (const QString &filePath, m_entries.keys()) {
+        if (!QFile::exists(filePath)) {
+            m_entries.remove(filePath);
+            m_changed = true;
+        }
+    }
+
+    if (!m_changed) {
+        return true;
+    }
+
+    QDir().mkpath(APP_CONFIG_PATH);
+    QFile file(PLUGIN_MANIFEST_CACHE_FILE);
+
+    if (!file.open(QFile::WriteOnly)) {
+        Logger::log("PluginManifestCache::save(): Unable to open cache file: " + file.errorString());
+        return false;
+    }
+
+    file.write(QtJson::Json::serialize(m_entries));
+    file.close();
+    m_changed = false;
+    Logger::log(QString("PluginManifestCache::save(): %1 manifests cached").arg(m_entries.size()),
+                Logger::MediumVerbosity);
+    return true;
+}
+
+void PluginManifestCache::restore() {
+    m_restored = true;
+    QFile file(PLUGIN_MANIFEST_CACHE_FILE);
+
+    if (!file.open(QFile::ReadOnly)) {
+        return;
+    }
+
+    bool ok;
+    const QVariant v = QtJson::Json::parse(file.readAll(), ok);
+    file.close();
+
+    if (ok) {
+        m_entries = v.toMap();
+        Logger::log(QString("PluginManifestCache::restore(): %1 manifests restored").arg(m_entries.size()),
+                    Logger::MediumVerbosity);
+    }
+    else {
+        Logger::log("PluginManifestCache::restore(): Error parsing cache file");
+    }
+}
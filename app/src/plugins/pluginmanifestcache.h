@@ -0,0 +1,64 @@
+/*
+ * Copyright (C) 2017 Stuart Howarth <showarth@marxoft.co.uk>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PLUGINMANIFESTCACHE_H
+#define PLUGINMANIFESTCACHE_H
+
+#include <QMutex>
+#include <QObject>
+#include <QVariantMap>
+
+/**
+ * Caches the parsed contents of plugin config files in a single file, keyed on the path, modification time and
+ * size of each config, so that unchanged configs are not read and parsed again each time the application starts.
+ */
+class PluginManifestCache : public QObject
+{
+    Q_OBJECT
+
+public:
+    ~PluginManifestCache();
+
+    static PluginManifestCache* instance();
+
+    /**
+     * Returns the parsed contents of the config file in filePath, reading the file only if it has changed since
+     * it was cached. ok is set to false if the file cannot be read or parsed.
+     */
+    QVariantMap manifest(const QString &filePath, bool *ok = 0);
+
+public Q_SLOTS:
+    /**
+     * Writes the cache to disk if it has changed, dropping the entries of configs that no longer exist.
+     */
+    bool save();
+
+private:
+    PluginManifestCache();
+
+    void restore();
+
+    static PluginManifestCache *self;
+
+    QMutex m_mutex;
+
+    QVariantMap m_entries;
+
+    bool m_restored;
+    bool m_changed;
+};
+
+#endif // PLUGINMANIFESTCACHE_H
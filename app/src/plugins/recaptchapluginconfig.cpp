@@ -17,9 +17,8 @@
 
 #include "recaptchapluginconfig.h"
 #include "definitions.h"
-#include "json.h"
 #include "logger.h"
-#include <QFile>
+#include "pluginmanifestcache.h"
 
 RecaptchaPluginConfig::RecaptchaPluginConfig(QObject *parent) :
     QObject(parent),
@@ -61,24 +60,14 @@ int RecaptchaPluginConfig::version() const {
 
 bool RecaptchaPluginConfig::load(const QString &filePath) {
     m_filePath = filePath;
-    QFile file(filePath);
-
-    if ((!file.exists()) || (!file.open(QFile::ReadOnly))) {
-        Logger::log("RecaptchaPluginConfig::load(): Unable to open config file: " + filePath);
-        return false;
-    }
-
     bool ok;
-    const QVariant v = QtJson::Json::parse(QString::fromUtf8(file.readAll()), ok);
-    file.close();
+    const QVariantMap config = PluginManifestCache::instance()->manifest(filePath, &ok);
 
     if (!ok) {
-        Logger::log("RecaptchaPluginConfig::load(): Error parsing config file: " + filePath);
+        Logger::log("RecaptchaPluginConfig::load(): Unable to load config file: " + filePath);
         return false;
     }
 
-    const QVariantMap config = v.toMap();
-
     if (!config.contains("name")) {
         Logger::log("RecaptchaPluginConfig::load(): 'name' parameter is missing");
         return false;
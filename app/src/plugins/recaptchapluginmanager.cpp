@@ -19,11 +19,13 @@
 #include "definitions.h"
 #include "javascriptpluginengine.h"
 #include "javascriptrecaptchaplugin.h"
+#include "lazypluginfactory.h"
 #include "logger.h"
 #include <QDir>
 #include <QFileInfo>
 #include <QNetworkAccessManager>
-#include <QPluginLoader>
+
+typedef LazyPluginFactory<RecaptchaPluginFactory, RecaptchaPlugin> LazyRecaptchaPluginFactory;
 
 static bool displayNameLessThan(const RecaptchaPluginPair &pair, const RecaptchaPluginPair &other) {
     return QString::localeAwareCompare(pair.config->displayName(), other.config->displayName()) < 0;
@@ -57,38 +59,38 @@ RecaptchaPluginList RecaptchaPluginManager::plugins() const {
 RecaptchaPluginConfig* RecaptchaPluginManager::getConfigById(const QString &id) const {
     foreach (const RecaptchaPluginPair &pair, m_plugins) {
         if (pair.config->id() == id) {
-            Logger::log("RecaptchaPluginManager::getConfigById(). Config found: " + id, Logger::HighVerbosity);
+            QDL_LOG(Logger::HighVerbosity, "RecaptchaPluginManager::getConfigById(). Config found: " + id);
             return pair.config;
         }
     }
     
-    Logger::log("RecaptchaPluginManager::getConfigById(). No config found for id " + id, Logger::HighVerbosity);
+    QDL_LOG(Logger::HighVerbosity, "RecaptchaPluginManager::getConfigById(). No config found for id " + id);
     return 0;
 }
 
 RecaptchaPluginConfig* RecaptchaPluginManager::getConfigByFilePath(const QString &filePath) const {
     foreach (const RecaptchaPluginPair &pair, m_plugins) {
         if (pair.config->filePath() == filePath) {
-            Logger::log("RecaptchaPluginManager::getConfigByFilePath(). Config found: " + pair.config->id(),
-                        Logger::HighVerbosity);
+            QDL_LOG(Logger::HighVerbosity,
+                    "RecaptchaPluginManager::getConfigByFilePath(). Config found: " + pair.config->id());
             return pair.config;
         }
     }
     
-    Logger::log("RecaptchaPluginManager::getConfigByFilePath(). No config found for filePath " + filePath,
-                Logger::HighVerbosity);
+    QDL_LOG(Logger::HighVerbosity,
+            "RecaptchaPluginManager::getConfigByFilePath(). No config found for filePath " + filePath);
     return 0;
 }
 
 RecaptchaPluginFactory* RecaptchaPluginManager::getFactoryById(const QString &id) const {
     foreach (const RecaptchaPluginPair &pair, m_plugins) {
         if (pair.config->id() == id) {
-            Logger::log("RecaptchaPluginManager::getFactoryById(). Factory found: " + id, Logger::HighVerbosity);
+            QDL_LOG(Logger::HighVerbosity, "RecaptchaPluginManager::getFactoryById(). Factory found: " + id);
             return pair.factory;
         }
     }
     
-    Logger::log("RecaptchaPluginManager::getFactoryById(). No factory found for id ", Logger::HighVerbosity);
+    QDL_LOG(Logger::HighVerbosity, "RecaptchaPluginManager::getFactoryById(). No factory found for id ");
     return 0;
 }
 
@@ -108,8 +110,8 @@ QNetworkAccessManager* RecaptchaPluginManager::networkAccessManager() {
 }
 
 int RecaptchaPluginManager::load() {
-    Logger::log("RecaptchaPluginManager::load(): Loading plugins modified since "
-                + m_lastLoaded.toString(Qt::ISODate), Logger::LowVerbosity);
+    QDL_LOG(Logger::LowVerbosity, "RecaptchaPluginManager::load(): Loading plugins modified since "
+            + m_lastLoaded.toString(Qt::ISODate));
     int count = 0;
     QDir dir;
     
@@ -127,32 +129,25 @@ int RecaptchaPluginManager::load() {
                         if (config->pluginType() == "js") {
                             JavaScriptRecaptchaPluginFactory *js =
                                 new JavaScriptRecaptchaPluginFactory(config->pluginFilePath(),
-                                        JavaScriptPluginEngine::instance(), this);
+                                        JavaScriptPluginEnginePool::instance()->engine(), this);
                             m_plugins << RecaptchaPluginPair(config, js);
                             ++count;
-                            Logger::log("RecaptchaPluginManager::load(). JavaScript plugin loaded: "
-                                        + config->id(), Logger::MediumVerbosity);
+                            QDL_LOG(Logger::MediumVerbosity,
+                                    "RecaptchaPluginManager::load(). JavaScript plugin loaded: "
+                                    + config->id());
+                        }
+                        else if (QFileInfo(config->pluginFilePath()).exists()) {
+                            // The library is loaded when the first plugin is created
+                            m_plugins << RecaptchaPluginPair(config,
+                                    new LazyRecaptchaPluginFactory(config->pluginFilePath(), this));
+                            ++count;
+                            QDL_LOG(Logger::MediumVerbosity,
+                                    "RecaptchaPluginManager::load(). Qt plugin found: " + config->id());
                         }
                         else {
-                            QPluginLoader loader(config->pluginFilePath());
-                            QObject *obj = loader.instance();
-                            
-                            if (obj) {
-                                if (RecaptchaPluginFactory *factory = qobject_cast<RecaptchaPluginFactory*>(obj)) {
-                                    m_plugins << RecaptchaPluginPair(config, factory);
-                                    ++count;
-                                    Logger::log("RecaptchaPluginManager::load(). Qt Plugin loaded: "
-                                                + config->id(), Logger::MediumVerbosity);
-                                }
-                                else {
-                                    loader.unload();
-                                    Logger::log("RecaptchaPluginManager::load(). Error loading Qt plugin: "
-                                                + config->id());
-                                }
-                            }
-                            else {
-                                Logger::log("RecaptchaPluginManager::load(). Qt plugin is NULL: " + config->id());
-                            }
+                            QDL_LOG(Logger::LowestVerbosity,
+                                    "RecaptchaPluginManager::load(). Qt plugin library not found: " + config->id());
+                            delete config;
                         }
                     }
                     else {
@@ -166,7 +161,7 @@ int RecaptchaPluginManager::load() {
         }
     }
 
-    Logger::log(QString("RecaptchaPluginManager::load() %1 plugins loaded").arg(count), Logger::LowVerbosity);
+    QDL_LOG(Logger::LowVerbosity, QString("RecaptchaPluginManager::load() %1 plugins loaded").arg(count));
 
     if (count > 0) {
         qSort(m_plugins.begin(), m_plugins.end(), displayNameLessThan);
@@ -0,0 +1,531 @@
+/*
+ * Copyright (C) 2017 Stuart Howarth <showarth@marxoft.co.uk>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "rulesserviceplugin.h"
+#include "htmlparser.h"
+#include "logger.h"
+#include "utils.h"
+#include <QNetworkAccessManager>
+#include <QNetworkReply>
+#include <QRegExp>
+#include <QStringList>
+
+static const int MAX_JUMPS = 100;
+static const int MAX_REDIRECTS = 8;
+
+// Returns the names of the named groups in pattern, so that they can be cleared when an optional step does not match
+static QStringList groupNames(const QString &pattern) {
+    QStringList names;
+    QRegExp re("\\(\\?P?<(\\w+)>");
+    int pos = 0;
+
+    while ((pos = re.indexIn(pattern, pos)) != -1) {
+        names << re.cap(1);
+        pos += re.matchedLength();
+    }
+
+    return names;
+}
+
+static QByteArray formData(const QVariantMap &fields) {
+    QByteArray data;
+    QMapIterator<QString, QVariant> iterator(fields);
+
+    while (iterator.hasNext()) {
+        iterator.next();
+        data.append(QUrl::toPercentEncoding(iterator.key()));
+        data.append('=');
+        data.append(QUrl::toPercentEncoding(iterator.value().toString()));
+
+        if (iterator.hasNext()) {
+            data.append('&');
+        }
+    }
+
+    return data;
+}
+
+RulesServicePlugin::RulesServicePlugin(const QVariantMap &rules, QObject *parent) :
+    ServicePlugin(parent),
+    m_rules(rules),
+    m_step(0),
+    m_jumps(0),
+    m_redirects(0)
+{
+    m_timer.setSingleShot(true);
+    connect(&m_timer, SIGNAL(timeout()), this, SLOT(runSteps()));
+}
+
+void RulesServicePlugin::setNetworkAccessManager(QNetworkAccessManager *manager) {
+    m_nam = manager;
+}
+
+QNetworkAccessManager* RulesServicePlugin::networkAccessManager() {
+    return m_nam ? m_nam : m_nam = new QNetworkAccessManager(this);
+}
+
+bool RulesServicePlugin::cancelCurrentOperation() {
+    m_timer.stop();
+    m_steps.clear();
+
+    if (m_reply) {
+        QNetworkReply *reply = m_reply;
+        m_reply = 0;
+        reply->abort();
+    }
+
+    return true;
+}
+
+void RulesServicePlugin::checkUrl(const QString &url, const QVariantMap &settings) {
+    start("checkUrl", url, settings);
+}
+
+void RulesServicePlugin::getDownloadRequest(const QString &url, const QVariantMap &settings) {
+    start("getDownloadRequest", url, settings);
+}
+
+void RulesServicePlugin::start(const QString &name, const QString &url, const QVariantMap &settings) {
+    cancelCurrentOperation();
+    m_steps = m_rules.value(name).toList();
+
+    if (m_steps.isEmpty()) {
+        Logger::log(QString("RulesServicePlugin::start(): No %1 rules defined").arg(name));
+        emit error(tr("%1 is not supported by this plugin").arg(name));
+        return;
+    }
+
+    m_labels.clear();
+
+    for (int i = 0; i < m_steps.size(); i++) {
+        const QString label = m_steps.at(i).toMap().value("label").toString();
+
+        if (!label.isEmpty()) {
+            m_labels[label] = i;
+        }
+    }
+
+    m_variables = settings;
+    m_variables["url"] = url;
+    m_variables["pageUrl"] = url;
+    m_page.clear();
+    m_pageUrl = QUrl(url);
+    m_step = 0;
+    m_jumps = 0;
+    runSteps();
+}
+
+void RulesServicePlugin::runSteps() {
+    while (m_step < m_steps.size()) {
+        const QVariantMap step = m_steps.at(m_step++).toMap();
+
+        if (!conditionsMet(step)) {
+            continue;
+        }
+
+        const QString action = step.value("action").toString();
+        Logger::log(QString("RulesServicePlugin::runSteps(): Step %1: %2").arg(m_step - 1).arg(action),
+                Logger::HighestVerbosity);
+
+        if (action == "fetch") {
+            fetch(step);
+            return;
+        }
+
+        if (action == "extract") {
+            if (!extract(step)) {
+                return;
+            }
+        }
+        else if (action == "submit") {
+            if (submit(step)) {
+                return;
+            }
+
+            setError(step.value("error", tr("No form found")).toString());
+            return;
+        }
+        else if (action == "set") {
+            m_variables[step.value("name").toString()] = expand(step.value("value").toString());
+        }
+        else if (action == "wait") {
+            wait(step);
+            return;
+        }
+        else if (action == "goto") {
+            const QString label = step.value("to").toString();
+
+            if (!m_labels.contains(label)) {
+                setError(tr("Unknown label: %1").arg(label));
+                return;
+            }
+
+            if (++m_jumps > MAX_JUMPS) {
+                setError(tr("Too many steps"));
+                return;
+            }
+
+            m_step = m_labels.value(label);
+        }
+        else if (action == "urlChecked") {
+            emitUrlChecked(step);
+            return;
+        }
+        else if (action == "downloadRequest") {
+            emitDownloadRequest(step);
+            return;
+        }
+        else if (action == "error") {
+            setError(expand(step.value("message").toString()));
+            return;
+        }
+        else {
+            setError(tr("Unknown action: %1").arg(action));
+            return;
+        }
+    }
+
+    setError(tr("No result"));
+}
+
+void RulesServicePlugin::fetch(const QVariantMap &step) {
+    m_redirects = 0;
+    sendRequest(expandRequest(step), step.value("method", "GET").toString().toUpper().toUtf8(),
+            expand(step.value("data").toString()).toUtf8());
+}
+
+bool RulesServicePlugin::extract(const QVariantMap &step) {
+    const QString source = step.contains("from") ? m_variables.value(step.value("from").toString()).toString()
+                                                 : m_page;
+    const bool all = step.value("all", false).toBool();
+    const QString into = step.value("into", QString(all ? "matches" : "value")).toString();
+    QVariantList matches;
+
+    if (step.contains("selector")) {
+        const QString selector = step.value("selector").toString();
+        QStringList values;
+
+        if (step.contains("attribute")) {
+            values = HtmlParser::attribute(source, selector, step.value("attribute").toString());
+        }
+        else {
+            foreach (const QVariant &element, HtmlParser::select(source, selector)) {
+                values << element.toMap().value("text").toString();
+            }
+        }
+
+        foreach (const QString &value, values) {
+            QVariantMap match;
+            match["0"] = value;
+            matches << match;
+
+            if (!all) {
+                break;
+            }
+        }
+
+        if (!all) {
+            m_variables[into] = values.isEmpty() ? QString() : values.first();
+        }
+    }
+    else {
+        const QString pattern = step.value("pattern").toString();
+        const QString flags = step.value("flags").toString();
+
+        if (all) {
+            matches = HtmlParser::findAll(source, pattern, flags);
+        }
+        else {
+            const QVariantMap match = HtmlParser::find(source, pattern, flags);
+
+            if (match.isEmpty()) {
+                foreach (const QString &name, groupNames(pattern)) {
+                    m_variables.remove(name);
+                }
+            }
+            else {
+                matches << match;
+
+                for (QVariantMap::const_iterator iterator = match.constBegin(); iterator != match.constEnd();
+                        ++iterator) {
+                    m_variables[iterator.key()] = iterator.value();
+                }
+            }
+        }
+    }
+
+    if (all) {
+        m_variables[into] = step.value("append", false).toBool() ? m_variables.value(into).toList() + matches
+                                                                 : matches;
+    }
+
+    if ((matches.isEmpty()) && (!step.value("optional", false).toBool())) {
+        setError(step.value("error", tr("File not found")).toString());
+        return false;
+    }
+
+    return true;
+}
+
+bool RulesServicePlugin::submit(const QVariantMap &step) {
+    const QString name = step.value("form").toString();
+    QVariantMap form;
+
+    foreach (const QVariant &v, HtmlParser::forms(m_page)) {
+        const QVariantMap f = v.toMap();
+
+        if ((name.isEmpty()) || (f.value("id") == name) || (f.value("name") == name)
+                || (f.value("action").toString().contains(name))) {
+            form = f;
+            break;
+        }
+    }
+
+    if (form.isEmpty()) {
+        return false;
+    }
+
+    QVariantMap fields = form.value("inputs").toMap();
+    const QVariantMap extra = step.value("fields").toMap();
+
+    for (QVariantMap::const_iterator iterator = extra.constBegin(); iterator != extra.constEnd(); ++iterator) {
+        fields[iterator.key()] = expand(iterator.value().toString());
+    }
+
+    const QString action = form.value("action").toString();
+    QUrl url = action.isEmpty() ? m_pageUrl : m_pageUrl.resolved(QUrl(action));
+    const QByteArray method = form.value("method").toString().toUpper().toUtf8();
+    QByteArray data = formData(fields);
+
+    if (method != "POST") {
+        url = QUrl(url.toString(QUrl::RemoveQuery) + "?" + QString::fromUtf8(data));
+        data.clear();
+    }
+
+    QNetworkRequest request(url);
+    request.setRawHeader("Referer", m_pageUrl.toEncoded());
+    m_redirects = 0;
+    sendRequest(request, method == "POST" ? method : QByteArray("GET"), data);
+    return true;
+}
+
+void RulesServicePlugin::wait(const QVariantMap &step) {
+    const int msecs = step.contains("secs") ? expand(step.value("secs").toString()).toInt() * 1000
+                                            : expand(step.value("msecs").toString()).toInt();
+
+    if (step.value("long", false).toBool()) {
+        // The application will check the url again later
+        m_steps.clear();
+        emit waitRequest(msecs, true);
+        return;
+    }
+
+    m_timer.start(qMax(0, msecs));
+    emit waitRequest(msecs, false);
+}
+
+void RulesServicePlugin::emitUrlChecked(const QVariantMap &step) {
+    if (!step.contains("each")) {
+        emit urlChecked(UrlResult(expand(step.value("url", "{url}").toString()),
+                    expand(step.value("fileName", "{url|basename}").toString())));
+        return;
+    }
+
+    const QVariantList items = m_variables.value(step.value("each").toString()).toList();
+
+    if (items.isEmpty()) {
+        setError(step.value("error", tr("File not found")).toString());
+        return;
+    }
+
+    const QString url = step.value("url", "{0}").toString();
+    const QString fileName = step.value("fileName", "{0|basename}").toString();
+    UrlResultList results;
+
+    foreach (const QVariant &item, items) {
+        const QVariantMap map = item.toMap();
+        results << UrlResult(expand(url, map), expand(fileName, map));
+    }
+
+    emit urlChecked(results, expand(step.value("packageName").toString(), items.first().toMap()));
+}
+
+void RulesServicePlugin::emitDownloadRequest(const QVariantMap &step) {
+    emit downloadRequest(expandRequest(step), step.value("method", "GET").toString().toUpper().toUtf8(),
+            expand(step.value("data").toString()).toUtf8());
+}
+
+void RulesServicePlugin::sendRequest(QNetworkRequest request, const QByteArray &method, const QByteArray &data) {
+    Logger::log(QString("RulesServicePlugin::sendRequest(): %1 %2").arg(QString::fromUtf8(method))
+            .arg(request.url().toString()), Logger::HighVerbosity);
+
+    if (method == "POST") {
+        if (request.header(QNetworkRequest::ContentTypeHeader).isNull()) {
+            request.setHeader(QNetworkRequest::ContentTypeHeader, "application/x-www-form-urlencoded");
+        }
+
+        m_reply = networkAccessManager()->post(request, data);
+    }
+    else if (method == "HEAD") {
+        m_reply = networkAccessManager()->head(request);
+    }
+    else {
+        m_reply = networkAccessManager()->get(request);
+    }
+
+    connect(m_reply, SIGNAL(finished()), this, SLOT(onReplyFinished()));
+}
+
+void RulesServicePlugin::setError(const QString &errorString) {
+    Logger::log("RulesServicePlugin::setError(): " + errorString);
+    m_steps.clear();
+    emit error(errorString);
+}
+
+bool RulesServicePlugin::conditionsMet(const QVariantMap &step) const {
+    foreach (const QString &name, step.value("if").toStringList()) {
+        if (!isSet(name)) {
+            return false;
+        }
+    }
+
+    foreach (const QString &name, step.value("unless").toStringList()) {
+        if (isSet(name)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool RulesServicePlugin::isSet(const QString &name) const {
+    const QVariant value = m_variables.value(name);
+
+    switch (value.type()) {
+    case QVariant::Invalid:
+        return false;
+    case QVariant::Bool:
+        return value.toBool();
+    case QVariant::List:
+        return !value.toList().isEmpty();
+    default:
+        return !value.toString().isEmpty();
+    }
+}
+
+QString RulesServicePlugin::expand(const QString &text, const QVariantMap &item) const {
+    if (!text.contains('{')) {
+        return text;
+    }
+
+    QString result;
+    int i = 0;
+
+    while (i < text.size()) {
+        const int start = text.indexOf('{', i);
+        const int end = (start == -1 ? -1 : text.indexOf('}', start));
+
+        if (end == -1) {
+            result.append(text.midRef(i));
+            break;
+        }
+
+        result.append(text.midRef(i, start - i));
+        const QStringList parts = text.mid(start + 1, end - start - 1).split('|');
+        const QString &name = parts.first();
+        QString value = item.contains(name) ? item.value(name).toString() : m_variables.value(name).toString();
+
+        for (int j = 1; j < parts.size(); j++) {
+            const QString &filter = parts.at(j);
+
+            if (filter == "basename") {
+                value = value.section('?', 0, 0).section('/', -1);
+            }
+            else if (filter == "decode") {
+                value = Utils::decodeHtml(value);
+            }
+            else if (filter == "encode") {
+                value = QString::fromUtf8(QUrl::toPercentEncoding(value));
+            }
+        }
+
+        result.append(value);
+        i = end + 1;
+    }
+
+    return result;
+}
+
+QNetworkRequest RulesServicePlugin::expandRequest(const QVariantMap &step) const {
+    QNetworkRequest request(m_pageUrl.resolved(QUrl(expand(step.value("url", "{url}").toString()))));
+    const QVariantMap headers = step.value("headers").toMap();
+
+    for (QVariantMap::const_iterator iterator = headers.constBegin(); iterator != headers.constEnd(); ++iterator) {
+        request.setRawHeader(iterator.key().toUtf8(), expand(iterator.value().toString()).toUtf8());
+    }
+
+    return request;
+}
+
+void RulesServicePlugin::onReplyFinished() {
+    QNetworkReply *reply = qobject_cast<QNetworkReply*>(sender());
+
+    if (!reply) {
+        return;
+    }
+
+    reply->deleteLater();
+
+    if (reply != m_reply) {
+        // Canceled
+        return;
+    }
+
+    m_reply = 0;
+    const QUrl redirect = reply->attribute(QNetworkRequest::RedirectionTargetAttribute).toUrl();
+
+    if (!redirect.isEmpty()) {
+        if (++m_redirects > MAX_REDIRECTS) {
+            setError(tr("Maximum redirects reached"));
+            return;
+        }
+
+        QNetworkRequest request(reply->url().resolved(redirect));
+        request.setRawHeader("Referer", reply->url().toEncoded());
+        sendRequest(request, "GET", QByteArray());
+        return;
+    }
+
+    if (reply->error() != QNetworkReply::NoError) {
+        setError(reply->errorString());
+        return;
+    }
+
+    m_page = QString::fromUtf8(reply->readAll());
+    m_pageUrl = reply->url();
+    m_variables["pageUrl"] = m_pageUrl.toString();
+    runSteps();
+}
+
+RulesServicePluginFactory::RulesServicePluginFactory(const QVariantMap &rules, QObject *parent) :
+    QObject(parent),
+    m_rules(rules)
+{
+}
+
+ServicePlugin* RulesServicePluginFactory::createPlugin(QObject *parent) {
+    return new RulesServicePlugin(m_rules, parent);
+}
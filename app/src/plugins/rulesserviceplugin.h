@@ -0,0 +1,133 @@
+/*
+ * Copyright (C) 2017 Stuart Howarth <showarth@marxoft.co.uk>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef RULESSERVICEPLUGIN_H
+#define RULESSERVICEPLUGIN_H
+
+#include "serviceplugin.h"
+#include <QHash>
+#include <QNetworkRequest>
+#include <QPointer>
+#include <QTimer>
+#include <QUrl>
+
+class QNetworkReply;
+
+/**
+ * Runs a service plugin described by rules in its config, with no script engine.
+ *
+ * The rules contain a list of steps for checkUrl and getDownloadRequest, which are run in order. Each step is an
+ * object with an "action":
+ *
+ * - "fetch" requests "url" (default "{url}"), with an optional "method", "data" and "headers". The response
+ *   becomes the current page.
+ * - "extract" matches "pattern" against the page, or the variable named by "from", and sets a variable for each
+ *   named group. With "selector", the "attribute" (or text) of the first matching element is stored in "into"
+ *   (default "value").
+ *   With "all", every match is stored as a list in "into" (default "matches"), or appended to it with
+ *   "append". Unless the step is
+ *   "optional", no match is an error ("error", default "File not found").
+ * - "submit" submits the "form" with that id, name or action (default the first form) on the page, with any
+ *   "fields" added. The response becomes the current page.
+ * - "set" sets the variable "name" to "value".
+ * - "wait" waits for "msecs" or "secs". If "long" is true, the application is asked to retry later instead.
+ * - "goto" continues from the step whose "label" matches "to". Any other step can have a label.
+ * - "urlChecked" emits a result with "url" (default "{url}") and "fileName" (default "{url|basename}"), or with
+ *   "each", a result for each item of a list variable and a "packageName".
+ * - "downloadRequest" emits a download request with "url", and optional "method", "data" and "headers".
+ * - "error" emits "message" as an error.
+ *
+ * A step with "if" or "unless" is only run if the named variables are (or are not) set and non-empty.
+ *
+ * Variables are used in strings as {name}, optionally followed by the filters |basename, |decode (HTML entities)
+ * and |encode (percent encoding). The variables "url" and "pageUrl", and the plugin settings, are always set.
+ */
+class RulesServicePlugin : public ServicePlugin
+{
+    Q_OBJECT
+
+public:
+    explicit RulesServicePlugin(const QVariantMap &rules, QObject *parent = 0);
+
+    virtual void setNetworkAccessManager(QNetworkAccessManager *manager);
+
+public Q_SLOTS:
+    virtual bool cancelCurrentOperation();
+
+    virtual void checkUrl(const QString &url, const QVariantMap &settings);
+    virtual void getDownloadRequest(const QString &url, const QVariantMap &settings);
+
+private Q_SLOTS:
+    void runSteps();
+
+    void onReplyFinished();
+
+private:
+    QNetworkAccessManager* networkAccessManager();
+
+    void start(const QString &name, const QString &url, const QVariantMap &settings);
+
+    void fetch(const QVariantMap &step);
+    bool extract(const QVariantMap &step);
+    bool submit(const QVariantMap &step);
+    void wait(const QVariantMap &step);
+    void emitUrlChecked(const QVariantMap &step);
+    void emitDownloadRequest(const QVariantMap &step);
+
+    void sendRequest(QNetworkRequest request, const QByteArray &method, const QByteArray &data);
+
+    void setError(const QString &errorString);
+
+    bool conditionsMet(const QVariantMap &step) const;
+    bool isSet(const QString &name) const;
+
+    QString expand(const QString &text, const QVariantMap &item = QVariantMap()) const;
+    QNetworkRequest expandRequest(const QVariantMap &step) const;
+
+    QVariantMap m_rules;
+
+    QPointer<QNetworkAccessManager> m_nam;
+    QPointer<QNetworkReply> m_reply;
+
+    QTimer m_timer;
+
+    QVariantList m_steps;
+    QHash<QString, int> m_labels;
+    int m_step;
+    int m_jumps;
+    int m_redirects;
+
+    QVariantMap m_variables;
+
+    QString m_page;
+    QUrl m_pageUrl;
+};
+
+class RulesServicePluginFactory : public QObject, public ServicePluginFactory
+{
+    Q_OBJECT
+    Q_INTERFACES(ServicePluginFactory)
+
+public:
+    explicit RulesServicePluginFactory(const QVariantMap &rules, QObject *parent = 0);
+
+    virtual ServicePlugin* createPlugin(QObject *parent = 0);
+
+private:
+    QVariantMap m_rules;
+};
+
+#endif // RULESSERVICEPLUGIN_H
@@ -17,9 +17,8 @@
 
 #include "searchpluginconfig.h"
 #include "definitions.h"
-#include "json.h"
 #include "logger.h"
-#include <QFile>
+#include "pluginmanifestcache.h"
 
 SearchPluginConfig::SearchPluginConfig(QObject *parent) :
     QObject(parent),
@@ -51,6 +50,10 @@ QString SearchPluginConfig::pluginType() const {
     return m_pluginType;
 }
 
+QString SearchPluginConfig::scriptEngine() const {
+    return m_scriptEngine;
+}
+
 QVariantList SearchPluginConfig::settings() const {
     return m_settings;
 }
@@ -61,24 +64,14 @@ int SearchPluginConfig::version() const {
 
 bool SearchPluginConfig::load(const QString &filePath) {
     m_filePath = filePath;
-    QFile file(filePath);
-
-    if ((!file.exists()) || (!file.open(QFile::ReadOnly))) {
-        Logger::log("SearchPluginConfig::load(): Unable to open config file: " + filePath);
-        return false;
-    }
-
     bool ok;
-    const QVariant v = QtJson::Json::parse(QString::fromUtf8(file.readAll()), ok);
-    file.close();
+    const QVariantMap config = PluginManifestCache::instance()->manifest(filePath, &ok);
 
     if (!ok) {
-        Logger::log("SearchPluginConfig::load(): Error parsing config file: " + filePath);
+        Logger::log("SearchPluginConfig::load(): Unable to load config file: " + filePath);
         return false;
     }
 
-    const QVariantMap config = v.toMap();
-
     if (!config.contains("name")) {
         Logger::log("SearchPluginConfig::load(): 'name' parameter is missing");
         return false;
@@ -94,6 +87,7 @@ bool SearchPluginConfig::load(const QString &filePath) {
                                              : DEFAULT_ICON;
     m_id = fileName.left(dot);
     m_pluginType = config.value("type").toString();
+    m_scriptEngine = config.value("engine", "qtscript").toString();
     m_settings = config.value("settings").toList();
     m_version = qMax(1, config.value("version").toInt());
     
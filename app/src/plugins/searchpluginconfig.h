@@ -31,6 +31,7 @@ class SearchPluginConfig : public QObject
     Q_PROPERTY(QString id READ id NOTIFY changed)
     Q_PROPERTY(QString pluginFilePath READ pluginFilePath NOTIFY changed)
     Q_PROPERTY(QString pluginType READ pluginType NOTIFY changed)
+    Q_PROPERTY(QString scriptEngine READ scriptEngine NOTIFY changed)
     Q_PROPERTY(QVariantList settings READ settings NOTIFY changed)
     Q_PROPERTY(int version READ version NOTIFY changed)
 
@@ -48,6 +49,8 @@ public:
     QString pluginFilePath() const;
     
     QString pluginType() const;
+
+    QString scriptEngine() const;
         
     QVariantList settings() const;
     
@@ -66,6 +69,7 @@ private:
     QString m_id;
     QString m_pluginFilePath;
     QString m_pluginType;
+    QString m_scriptEngine;
         
     QVariantList m_settings;
     
@@ -19,11 +19,16 @@
 #include "definitions.h"
 #include "javascriptpluginengine.h"
 #include "javascriptsearchplugin.h"
+#if QT_VERSION >= 0x050000
+#include "javascriptv4searchplugin.h"
+#endif
+#include "lazypluginfactory.h"
 #include "logger.h"
 #include <QDir>
 #include <QFileInfo>
 #include <QNetworkAccessManager>
-#include <QPluginLoader>
+
+typedef LazyPluginFactory<SearchPluginFactory, SearchPlugin> LazySearchPluginFactory;
 
 static bool displayNameLessThan(const SearchPluginPair &pair, const SearchPluginPair &other) {
     return QString::localeAwareCompare(pair.config->displayName(), other.config->displayName()) < 0;
@@ -57,38 +62,38 @@ SearchPluginList SearchPluginManager::plugins() const {
 SearchPluginConfig* SearchPluginManager::getConfigById(const QString &id) const {
     foreach (const SearchPluginPair &pair, m_plugins) {
         if (pair.config->id() == id) {
-            Logger::log("SearchPluginManager::getConfigById(). Config found: " + id, Logger::HighVerbosity);
+            QDL_LOG(Logger::HighVerbosity, "SearchPluginManager::getConfigById(). Config found: " + id);
             return pair.config;
         }
     }
     
-    Logger::log("SearchPluginManager::getConfigById(). No config found for id " + id, Logger::HighVerbosity);
+    QDL_LOG(Logger::HighVerbosity, "SearchPluginManager::getConfigById(). No config found for id " + id);
     return 0;
 }
 
 SearchPluginConfig* SearchPluginManager::getConfigByFilePath(const QString &filePath) const {
     foreach (const SearchPluginPair &pair, m_plugins) {
         if (pair.config->filePath() == filePath) {
-            Logger::log("SearchPluginManager::getConfigByFilePath(). Config found: " + pair.config->id(),
-                        Logger::HighVerbosity);
+            QDL_LOG(Logger::HighVerbosity,
+                    "SearchPluginManager::getConfigByFilePath(). Config found: " + pair.config->id());
             return pair.config;
         }
     }
     
-    Logger::log("SearchPluginManager::getConfigByFilePath(). No config found for filePath " + filePath,
-                Logger::HighVerbosity);
+    QDL_LOG(Logger::HighVerbosity,
+            "SearchPluginManager::getConfigByFilePath(). No config found for filePath " + filePath);
     return 0;
 }
 
 SearchPluginFactory* SearchPluginManager::getFactoryById(const QString &id) const {
     foreach (const SearchPluginPair &pair, m_plugins) {
         if (pair.config->id() == id) {
-            Logger::log("SearchPluginManager::getFactoryById(). Factory found: " + id, Logger::HighVerbosity);
+            QDL_LOG(Logger::HighVerbosity, "SearchPluginManager::getFactoryById(). Factory found: " + id);
             return pair.factory;
         }
     }
     
-    Logger::log("SearchPluginManager::getFactoryById(). No factory found for id ", Logger::HighVerbosity);
+    QDL_LOG(Logger::HighVerbosity, "SearchPluginManager::getFactoryById(). No factory found for id ");
     return 0;
 }
 
@@ -108,8 +113,8 @@ QNetworkAccessManager* SearchPluginManager::networkAccessManager() {
 }
 
 int SearchPluginManager::load() {
-    Logger::log("SearchPluginManager::load(): Loading plugins modified since "
-                + m_lastLoaded.toString(Qt::ISODate), Logger::LowVerbosity);
+    QDL_LOG(Logger::LowVerbosity, "SearchPluginManager::load(): Loading plugins modified since "
+            + m_lastLoaded.toString(Qt::ISODate));
     int count = 0;
     QDir dir;
     
@@ -125,34 +130,35 @@ int SearchPluginManager::load() {
                     
                     if (config->load(info.absoluteFilePath())) {
                         if (config->pluginType() == "js") {
-                            JavaScriptSearchPluginFactory *js =
-                                new JavaScriptSearchPluginFactory(config->pluginFilePath(),
-                                        JavaScriptPluginEngine::instance(), this);
+                            SearchPluginFactory *js = 0;
+#if QT_VERSION >= 0x050000
+                            if (config->scriptEngine() == "qjsengine") {
+                                js = new JavaScriptV4SearchPluginFactory(config->pluginFilePath(),
+                                        JavaScriptPluginEnginePool::instance()->engine()->thread(), this);
+                            }
+#endif
+                            if (!js) {
+                                js = new JavaScriptSearchPluginFactory(config->pluginFilePath(),
+                                        JavaScriptPluginEnginePool::instance()->engine(), this);
+                            }
+
                             m_plugins << SearchPluginPair(config, js);
                             ++count;
-                            Logger::log("SearchPluginManager::load(). JavaScript plugin loaded: "
-                                        + config->id(), Logger::MediumVerbosity);
+                            QDL_LOG(Logger::MediumVerbosity, "SearchPluginManager::load(). JavaScript plugin loaded: "
+                                    + config->id());
+                        }
+                        else if (QFileInfo(config->pluginFilePath()).exists()) {
+                            // The library is loaded when the first plugin is created
+                            m_plugins << SearchPluginPair(config,
+                                    new LazySearchPluginFactory(config->pluginFilePath(), this));
+                            ++count;
+                            QDL_LOG(Logger::MediumVerbosity,
+                                    "SearchPluginManager::load(). Qt plugin found: " + config->id());
                         }
                         else {
-                            QPluginLoader loader(config->pluginFilePath());
-                            QObject *obj = loader.instance();
-                            
-                            if (obj) {
-                                if (SearchPluginFactory *factory = qobject_cast<SearchPluginFactory*>(obj)) {
-                                    m_plugins << SearchPluginPair(config, factory);
-                                    ++count;
-                                    Logger::log("SearchPluginManager::load(). Qt Plugin loaded: "
-                                                + config->id(), Logger::MediumVerbosity);
-                                }
-                                else {
-                                    loader.unload();
-                                    Logger::log("SearchPluginManager::load(). Error loading Qt plugin: "
-                                                + config->id());
-                                }
-                            }
-                            else {
-                                Logger::log("SearchPluginManager::load(). Qt plugin is NULL: " + config->id());
-                            }
+                            QDL_LOG(Logger::LowestVerbosity,
+                                    "SearchPluginManager::load(). Qt plugin library not found: " + config->id());
+                            delete config;
                         }
                     }
                     else {
@@ -166,7 +172,7 @@ int SearchPluginManager::load() {
         }
     }
 
-    Logger::log(QString("SearchPluginManager::load() %1 plugins loaded").arg(count), Logger::LowVerbosity);
+    QDL_LOG(Logger::LowVerbosity, QString("SearchPluginManager::load() %1 plugins loaded").arg(count));
 
     if (count > 0) {
         qSort(m_plugins.begin(), m_plugins.end(), displayNameLessThan);
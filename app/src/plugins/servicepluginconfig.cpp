@@ -17,12 +17,12 @@
 
 #include "servicepluginconfig.h"
 #include "definitions.h"
-#include "json.h"
 #include "logger.h"
-#include <QFile>
+#include "pluginmanifestcache.h"
 
 ServicePluginConfig::ServicePluginConfig(QObject *parent) :
     QObject(parent),
+    m_linkTtl(0),
     m_version(1)
 {
 }
@@ -43,6 +43,10 @@ QString ServicePluginConfig::id() const {
     return m_id;
 }
 
+int ServicePluginConfig::linkTtl() const {
+    return m_linkTtl;
+}
+
 QString ServicePluginConfig::pluginFilePath() const {
     return m_pluginFilePath;
 }
@@ -55,6 +59,14 @@ QRegExp ServicePluginConfig::regExp() const {
     return m_regExp;
 }
 
+QVariantMap ServicePluginConfig::rules() const {
+    return m_rules;
+}
+
+QString ServicePluginConfig::scriptEngine() const {
+    return m_scriptEngine;
+}
+
 QVariantList ServicePluginConfig::settings() const {
     return m_settings;
 }
@@ -65,24 +77,14 @@ int ServicePluginConfig::version() const {
 
 bool ServicePluginConfig::load(const QString &filePath) {
     m_filePath = filePath;
-    QFile file(filePath);
-
-    if ((!file.exists()) || (!file.open(QFile::ReadOnly))) {
-        Logger::log("ServicePluginConfig::load(): Unable to open config file: " + filePath);
-        return false;
-    }
-
     bool ok;
-    const QVariant v = QtJson::Json::parse(QString::fromUtf8(file.readAll()), ok);
-    file.close();
+    const QVariantMap config = PluginManifestCache::instance()->manifest(filePath, &ok);
 
     if (!ok) {
-        Logger::log("ServicePluginConfig::load(): Error parsing config file: " + filePath);
+        Logger::log("ServicePluginConfig::load(): Unable to load config file: " + filePath);
         return false;
     }
 
-    const QVariantMap config = v.toMap();
-
     if (!config.contains("name")) {
         Logger::log("ServicePluginConfig::load(): 'name' parameter is missing");
         return false;
@@ -102,14 +104,21 @@ bool ServicePluginConfig::load(const QString &filePath) {
                                                                      .arg(config.value("icon").toString())
                                              : DEFAULT_ICON;
     m_id = fileName.left(dot);
+    m_linkTtl = qMax(0, config.value("linkTtl").toInt());
     m_pluginType = config.value("type").toString();
+    m_scriptEngine = config.value("engine", "qtscript").toString();
     m_regExp = QRegExp(config.value("regExp").toString());
+    m_rules = config.value("rules").toMap();
     m_settings = config.value("settings").toList();
     m_version = qMax(1, config.value("version").toInt());
     
     if (m_pluginType == "js") {
         m_pluginFilePath = filePath.left(slash + 1) + m_id + ".js";
     }
+    else if (m_pluginType == "rules") {
+        // The rules are part of the config
+        m_pluginFilePath = filePath;
+    }
     else {
         m_pluginFilePath = filePath.left(slash + 1) + LIB_PREFIX + m_id + LIB_SUFFIX;
     }
@@ -30,9 +30,12 @@ class ServicePluginConfig : public QObject
     Q_PROPERTY(QString filePath READ filePath NOTIFY changed)
     Q_PROPERTY(QString iconFilePath READ iconFilePath NOTIFY changed)
     Q_PROPERTY(QString id READ id NOTIFY changed)
+    Q_PROPERTY(int linkTtl READ linkTtl NOTIFY changed)
     Q_PROPERTY(QString pluginFilePath READ pluginFilePath NOTIFY changed)
     Q_PROPERTY(QString pluginType READ pluginType NOTIFY changed)
     Q_PROPERTY(QRegExp regExp READ regExp NOTIFY changed)
+    Q_PROPERTY(QVariantMap rules READ rules NOTIFY changed)
+    Q_PROPERTY(QString scriptEngine READ scriptEngine NOTIFY changed)
     Q_PROPERTY(QVariantList settings READ settings NOTIFY changed)
     Q_PROPERTY(int version READ version NOTIFY changed)
 
@@ -47,11 +50,17 @@ public:
     
     QString id() const;
 
+    int linkTtl() const;
+
     QString pluginFilePath() const;
     
     QString pluginType() const;
     
     QRegExp regExp() const;
+
+    QVariantMap rules() const;
+
+    QString scriptEngine() const;
     
     QVariantList settings() const;
     
@@ -72,11 +81,15 @@ private:
     QString m_id;
     QString m_pluginFilePath;
     QString m_pluginType;
+    QString m_scriptEngine;
     
     QRegExp m_regExp;
+
+    QVariantMap m_rules;
     
     QVariantList m_settings;
     
+    int m_linkTtl;
     int m_version;
 };
 
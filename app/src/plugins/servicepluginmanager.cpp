@@ -19,11 +19,17 @@
 #include "definitions.h"
 #include "javascriptpluginengine.h"
 #include "javascriptserviceplugin.h"
+#if QT_VERSION >= 0x050000
+#include "javascriptv4serviceplugin.h"
+#endif
+#include "lazypluginfactory.h"
 #include "logger.h"
+#include "rulesserviceplugin.h"
 #include <QDir>
 #include <QFileInfo>
 #include <QNetworkAccessManager>
-#include <QPluginLoader>
+
+typedef LazyPluginFactory<ServicePluginFactory, ServicePlugin> LazyServicePluginFactory;
 
 static bool displayNameLessThan(const ServicePluginPair &pair, const ServicePluginPair &other) {
     return QString::localeAwareCompare(pair.config->displayName(), other.config->displayName()) < 0;
@@ -57,64 +63,63 @@ ServicePluginList ServicePluginManager::plugins() const {
 ServicePluginConfig* ServicePluginManager::getConfigById(const QString &id) const {
     foreach (const ServicePluginPair &pair, m_plugins) {
         if (pair.config->id() == id) {
-            Logger::log("ServicePluginManager::getConfigById(). Config found: " + id, Logger::HighVerbosity);
+            QDL_LOG(Logger::HighVerbosity, "ServicePluginManager::getConfigById(). Config found: " + id);
             return pair.config;
         }
     }
     
-    Logger::log("ServicePluginManager::getConfigById(). No config found for id " + id, Logger::HighVerbosity);
+    QDL_LOG(Logger::HighVerbosity, "ServicePluginManager::getConfigById(). No config found for id " + id);
     return 0;
 }
 
 ServicePluginConfig* ServicePluginManager::getConfigByFilePath(const QString &filePath) const {
     foreach (const ServicePluginPair &pair, m_plugins) {
         if (pair.config->filePath() == filePath) {
-            Logger::log("ServicePluginManager::getConfigByFilePath(). Config found: " + pair.config->id(),
-                        Logger::HighVerbosity);
+            QDL_LOG(Logger::HighVerbosity,
+                    "ServicePluginManager::getConfigByFilePath(). Config found: " + pair.config->id());
             return pair.config;
         }
     }
     
-    Logger::log("ServicePluginManager::getConfigByFilePath(). No config found for filePath " + filePath,
-                Logger::HighVerbosity);
+    QDL_LOG(Logger::HighVerbosity,
+            "ServicePluginManager::getConfigByFilePath(). No config found for filePath " + filePath);
     return 0;
 }
 
 ServicePluginConfig* ServicePluginManager::getConfigByUrl(const QString &url) const {
     foreach (const ServicePluginPair &pair, m_plugins) {
         if (pair.config->urlIsSupported(url)) {
-            Logger::log("ServicePluginManager::getConfigByUrl(). Config found: " + pair.config->id(),
-                        Logger::HighVerbosity);
+            QDL_LOG(Logger::HighVerbosity, "ServicePluginManager::getConfigByUrl(). Config found: " + pair.config->id());
             return pair.config;
         }
     }
     
-    Logger::log("ServicePluginManager::getConfigByUrl(). No config found for URL " + url, Logger::HighVerbosity);
+    QDL_LOG(Logger::HighVerbosity, "ServicePluginManager::getConfigByUrl(). No config found for URL " + url);
     return 0;
 }
 
 ServicePluginFactory* ServicePluginManager::getFactoryById(const QString &id) const {
     foreach (const ServicePluginPair &pair, m_plugins) {
         if (pair.config->id() == id) {
-            Logger::log("ServicePluginManager::getFactoryById(). Factory found: " + id, Logger::HighVerbosity);
+            QDL_LOG(Logger::HighVerbosity, "ServicePluginManager::getFactoryById(). Factory found: " + id);
             return pair.factory;
         }
     }
     
-    Logger::log("ServicePluginManager::getFactoryById(). No factory found for id " + id, Logger::HighVerbosity);
+    QDL_LOG(Logger::HighVerbosity, "ServicePluginManager::getFactoryById(). No factory found for id " + id);
     return 0;
 }
 
 ServicePluginFactory* ServicePluginManager::getFactoryByUrl(const QString &url) const {
     foreach (const ServicePluginPair &pair, m_plugins) {
         if (pair.config->urlIsSupported(url)) {
-            Logger::log("ServicePluginManager::getFactoryByUrl(). Factory found: " + pair.config->id(),
-                        Logger::HighVerbosity);
+            QDL_LOG(Logger::HighVerbosity,
+                    "ServicePluginManager::getFactoryByUrl(). Factory found: " + pair.config->id());
             return pair.factory;
         }
     }
     
-    Logger::log("ServicePluginManager::getFactoryByUrl(). No factory found for URL " + url, Logger::HighVerbosity);
+    QDL_LOG(Logger::HighVerbosity, "ServicePluginManager::getFactoryByUrl(). No factory found for URL " + url);
     return 0;
 }
 
@@ -153,8 +158,8 @@ QNetworkAccessManager* ServicePluginManager::networkAccessManager() {
 }
 
 int ServicePluginManager::load() {
-    Logger::log("ServicePluginManager::load(): Loading plugins modified since "
-                + m_lastLoaded.toString(Qt::ISODate), Logger::LowVerbosity);
+    QDL_LOG(Logger::LowVerbosity, "ServicePluginManager::load(): Loading plugins modified since "
+            + m_lastLoaded.toString(Qt::ISODate));
     int count = 0;
     QDir dir;
     
@@ -170,34 +175,42 @@ int ServicePluginManager::load() {
                     
                     if (config->load(info.absoluteFilePath())) {
                         if (config->pluginType() == "js") {
-                            JavaScriptServicePluginFactory *js =
-                                new JavaScriptServicePluginFactory(config->pluginFilePath(),
-                                        JavaScriptPluginEngine::instance(), this);
+                            ServicePluginFactory *js = 0;
+#if QT_VERSION >= 0x050000
+                            if (config->scriptEngine() == "qjsengine") {
+                                js = new JavaScriptV4ServicePluginFactory(config->pluginFilePath(),
+                                        JavaScriptPluginEnginePool::instance()->engine()->thread(), this);
+                            }
+#endif
+                            if (!js) {
+                                js = new JavaScriptServicePluginFactory(config->pluginFilePath(),
+                                        JavaScriptPluginEnginePool::instance()->engine(), this);
+                            }
+
                             m_plugins << ServicePluginPair(config, js);
                             ++count;
-                            Logger::log("ServicePluginManager::load(). JavaScript plugin loaded: " + config->id(),
-                                        Logger::MediumVerbosity);
+                            QDL_LOG(Logger::MediumVerbosity,
+                                    "ServicePluginManager::load(). JavaScript plugin loaded: " + config->id());
+                        }
+                        else if (config->pluginType() == "rules") {
+                            RulesServicePluginFactory *rules = new RulesServicePluginFactory(config->rules(), this);
+                            m_plugins << ServicePluginPair(config, rules);
+                            ++count;
+                            QDL_LOG(Logger::MediumVerbosity,
+                                    "ServicePluginManager::load(). Rules plugin loaded: " + config->id());
+                        }
+                        else if (QFileInfo(config->pluginFilePath()).exists()) {
+                            // The library is loaded when the first plugin is created
+                            m_plugins << ServicePluginPair(config,
+                                    new LazyServicePluginFactory(config->pluginFilePath(), this));
+                            ++count;
+                            QDL_LOG(Logger::MediumVerbosity,
+                                    "ServicePluginManager::load(). Qt plugin found: " + config->id());
                         }
                         else {
-                            QPluginLoader loader(config->pluginFilePath());
-                            QObject *obj = loader.instance();
-                            
-                            if (obj) {
-                                if (ServicePluginFactory *factory = qobject_cast<ServicePluginFactory*>(obj)) {
-                                    m_plugins << ServicePluginPair(config, factory);
-                                    ++count;
-                                    Logger::log("ServicePluginManager::load(). Qt Plugin loaded: " + config->id(),
-                                                Logger::MediumVerbosity);
-                                }
-                                else {
-                                    loader.unload();
-                                    Logger::log("ServicePluginManager::load(). Error loading Qt plugin: "
-                                                + config->id());
-                                }
-                            }
-                            else {
-                                Logger::log("ServicePluginManager::load(). Qt plugin is NULL: " + config->id());
-                            }
+                            QDL_LOG(Logger::LowestVerbosity,
+                                    "ServicePluginManager::load(). Qt plugin library not found: " + config->id());
+                            delete config;
                         }
                     }
                     else {
@@ -211,7 +224,7 @@ int ServicePluginManager::load() {
         }
     }
 
-    Logger::log(QString("ServicePluginManager::load() %1 plugins loaded").arg(count), Logger::LowVerbosity);
+    QDL_LOG(Logger::LowVerbosity, QString("ServicePluginManager::load() %1 plugins loaded").arg(count));
 
     if (count > 0) {
         qSort(m_plugins.begin(), m_plugins.end(), displayNameLessThan);
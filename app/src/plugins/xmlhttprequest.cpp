@@ -22,6 +22,7 @@
 #include <QNetworkCookie>
 #include <QNetworkCookieJar>
 #include <QNetworkReply>
+#include <QScriptEngine>
 
 XMLHttpRequest::XMLHttpRequest(QObject *parent) :
     QObject(parent),
@@ -70,7 +71,11 @@ void XMLHttpRequest::setReadyState(int state) {
     
     if (state != readyState()) {
         m_readyState = state;
-        m_onReadyStateChange.call(QScriptValue());
+        {
+            const JavaScriptPluginScope scope(m_onReadyStateChange.engine(), m_owner);
+            m_onReadyStateChange.call(QScriptValue());
+        }
+        emit readyStateChanged();
     }
 }
 
@@ -106,6 +111,10 @@ void XMLHttpRequest::setOnReadyStateChange(const QScriptValue &function) {
     m_onReadyStateChange = function;
 }
 
+void XMLHttpRequest::setOwner(const JavaScriptPluginWatchdog::Owner &owner) {
+    m_owner = owner;
+}
+
 void XMLHttpRequest::setRequestHeader(const QString &name, const QString &value) {
     m_request.setRawHeader(name.toUtf8(), value.toUtf8());
 
@@ -260,6 +269,11 @@ void XMLHttpRequest::onReplyFinished() {
         m_response += m_reply->readAll();
     }
     
+    if (QScriptEngine *engine = m_onReadyStateChange.engine()) {
+        // The response is held outside the script heap, so the collector must be told about it
+        engine->reportAdditionalMemoryCost(m_response.size());
+    }
+
     setStatus(m_reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt());
     setStatusText(m_reply->attribute(QNetworkRequest::HttpReasonPhraseAttribute).toString());
     setReadyState(DONE);
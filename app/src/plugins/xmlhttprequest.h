@@ -17,6 +17,7 @@
 #ifndef XMLHTTPREQUEST_H
 #define XMLHTTPREQUEST_H
 
+#include "javascriptpluginwatchdog.h"
 #include <QObject>
 #include <QNetworkRequest>
 #include <QPointer>
@@ -65,6 +66,11 @@ public:
 
     QScriptValue onReadyStateChange() const;
     void setOnReadyStateChange(const QScriptValue &function);
+
+    /**
+     * Sets the plugin to which the onreadystatechange handler is attributed by JavaScriptPluginWatchdog.
+     */
+    void setOwner(const JavaScriptPluginWatchdog::Owner &owner);
     
 public Q_SLOTS:
     void setRequestHeader(const QString &name, const QString &value);
@@ -77,6 +83,9 @@ public Q_SLOTS:
     void send(const QString &body = QString());
     void abort();    
 
+Q_SIGNALS:
+    void readyStateChanged();
+
 private Q_SLOTS:
     void onReplyMetaDataChanged();
     void onReplyReadyRead();
@@ -113,6 +122,8 @@ private:
     QMap<QString, QString> m_responseHeaders;
 
     QScriptValue m_onReadyStateChange;
+
+    JavaScriptPluginWatchdog::Owner m_owner;
 };
 
 Q_DECLARE_METATYPE(XMLHttpRequest*)
@@ -24,21 +24,35 @@
 
 #include <QTcpSocket>
 #include <QHostAddress>
+#include <limits.h>
 
 #include "http_parser.h"
 #include "qhttprequest.h"
 #include "qhttpresponse.h"
+#include "qhttpserver.h"
 
 /// @cond nodoc
 
+// The size of the buffer that each connection reads into
+static const int READ_BUFFER_SIZE = 16384;
+
 QHttpConnection::QHttpConnection(QTcpSocket *socket, QObject *parent)
     : QObject(parent),
       m_socket(socket),
       m_parser(0),
       m_parserSettings(0),
       m_request(0),
+      m_requestEmitted(false),
+      m_maxHeaderSize(0),
+      m_maxBodySize(0),
+      m_bodyFileThreshold(0),
+      m_headerSize(0),
+      m_bodySize(0),
+      m_rejected(false),
       m_transmitLen(0),
-      m_transmitPos(0)
+      m_transmitPos(0),
+      m_writeHighWaterMark(1048576),
+      m_writeBufferFull(false)
 {
     m_parser = (http_parser *)malloc(sizeof(http_parser));
     http_parser_init(m_parser, HTTP_REQUEST);
@@ -75,7 +89,7 @@ void QHttpConnection::socketDisconnected()
 {
     deleteLater();
 
-    if (m_request) {
+    if ((m_request) && (m_requestEmitted)) {
         if (m_request->successful())
             return;
 
@@ -84,12 +98,48 @@ void QHttpConnection::socketDisconnected()
     }
 }
 
+void QHttpConnection::setMaxHeaderSize(int bytes)
+{
+    m_maxHeaderSize = bytes;
+}
+
+void QHttpConnection::setMaxBodySize(qint64 bytes)
+{
+    m_maxBodySize = bytes;
+}
+
+void QHttpConnection::setBodyFileThreshold(qint64 bytes)
+{
+    m_bodyFileThreshold = bytes;
+}
+
+void QHttpConnection::setWriteHighWaterMark(qint64 bytes)
+{
+    m_writeHighWaterMark = qMax(qint64(0), bytes);
+}
+
+qint64 QHttpConnection::bytesToWrite() const
+{
+    return m_transmitLen - m_transmitPos;
+}
+
+bool QHttpConnection::isWriteBufferFull() const
+{
+    return m_writeBufferFull;
+}
+
 void QHttpConnection::updateWriteCount(qint64 count)
 {
     Q_ASSERT(m_transmitPos + count <= m_transmitLen);
 
     m_transmitPos += count;
 
+    if ((m_writeBufferFull) && (bytesToWrite() <= m_writeHighWaterMark / 2)) {
+        // Producers may resume once half of the high-water mark has been sent
+        m_writeBufferFull = false;
+        emit writeBufferDrained();
+    }
+
     if (m_transmitPos == m_transmitLen)
     {
         m_transmitLen = 0;
@@ -102,9 +152,16 @@ void QHttpConnection::parseRequest()
 {
     Q_ASSERT(m_parser);
 
-    while (m_socket->bytesAvailable()) {
-        QByteArray arr = m_socket->readAll();
-        http_parser_execute(m_parser, m_parserSettings, arr.constData(), arr.size());
+    if (m_readBuffer.size() != READ_BUFFER_SIZE)
+        m_readBuffer.resize(READ_BUFFER_SIZE);
+
+    while ((!m_rejected) && (m_socket->bytesAvailable())) {
+        const qint64 length = m_socket->read(m_readBuffer.data(), m_readBuffer.size());
+
+        if (length <= 0)
+            break;
+
+        http_parser_execute(m_parser, m_parserSettings, m_readBuffer.constData(), length);
     }
 }
 
@@ -112,6 +169,53 @@ void QHttpConnection::write(const QByteArray &data)
 {
     m_socket->write(data);
     m_transmitLen += data.size();
+
+    if (bytesToWrite() >= m_writeHighWaterMark)
+        m_writeBufferFull = true;
+}
+
+bool QHttpConnection::addHeaderBytes(size_t length)
+{
+    m_headerSize += length;
+
+    if ((m_maxHeaderSize > 0) && (m_headerSize > m_maxHeaderSize)) {
+        rejectRequest(QHttpResponse::STATUS_REQUEST_HEADER_FIELDS_TOO_LARGE);
+        return false;
+    }
+
+    return true;
+}
+
+void QHttpConnection::rejectRequest(int status)
+{
+    if (m_rejected)
+        return;
+
+    m_rejected = true;
+
+    if ((m_request) && (!m_requestEmitted)) {
+        // The request was never seen by the application
+        delete m_request;
+        m_request = 0;
+    }
+
+    // The rest of the request is not read, so the connection cannot be reused
+    if (m_requestEmitted) {
+        // The application already has the response, so it is ended with the status. If the application has
+        // begun to answer, it is too late for a status and the connection is just closed
+        if ((m_response) && (!m_response->m_headerWritten) && (!m_response->m_finished)) {
+            m_response->setHeader("Connection", "close");
+            m_response->setHeader("Content-Length", "0");
+            m_response->writeHead(status);
+            m_response->end();
+        }
+    } else {
+        // The reply goes through write(), so that its bytes are counted when bytesWritten() is reported
+        write(QString("HTTP/1.1 %1 %2\r\nContent-Length: 0\r\nConnection: close\r\n\r\n").arg(status)
+              .arg(STATUS_CODES[status]).toLatin1());
+    }
+
+    m_socket->disconnectFromHost();
 }
 
 void QHttpConnection::flush()
@@ -173,10 +277,15 @@ int QHttpConnection::MessageBegin(http_parser *parser)
     theConnection->m_currentHeaders.clear();
     theConnection->m_currentUrl.clear();
     theConnection->m_currentUrl.reserve(128);
+    theConnection->m_headerSize = 0;
+    theConnection->m_bodySize = 0;
 
     // The QHttpRequest should not be parented to this, since it's memory
     // management is the responsibility of the user of the library.
     theConnection->m_request = new QHttpRequest(theConnection);
+    theConnection->m_request->m_bodyFileThreshold = theConnection->m_bodyFileThreshold;
+    theConnection->m_requestEmitted = false;
+    theConnection->m_response = 0;
     return 0;
 }
 
@@ -185,6 +294,13 @@ int QHttpConnection::HeadersComplete(http_parser *parser)
     QHttpConnection *theConnection = static_cast<QHttpConnection *>(parser->data);
     Q_ASSERT(theConnection->m_request);
 
+    // Reject a declared body that is too large before any of it is read
+    if ((theConnection->m_maxBodySize > 0) && (parser->content_length != ULLONG_MAX)
+        && (parser->content_length > quint64(theConnection->m_maxBodySize))) {
+        theConnection->rejectRequest(QHttpResponse::STATUS_REQUEST_ENTITY_TOO_LARGE);
+        return -1;
+    }
+
     /** set method **/
     theConnection->m_request->setMethod(static_cast<QHttpRequest::HttpMethod>(parser->method));
 
@@ -219,6 +335,8 @@ int QHttpConnection::HeadersComplete(http_parser *parser)
     connect(response, SIGNAL(done()), theConnection, SLOT(responseDone()));
 
     // we are good to go!
+    theConnection->m_requestEmitted = true;
+    theConnection->m_response = response;
     emit theConnection->newRequest(theConnection->m_request, response);
     return 0;
 }
@@ -239,6 +357,9 @@ int QHttpConnection::Url(http_parser *parser, const char *at, size_t length)
     QHttpConnection *theConnection = static_cast<QHttpConnection *>(parser->data);
     Q_ASSERT(theConnection->m_request);
 
+    if (!theConnection->addHeaderBytes(length))
+        return -1;
+
     theConnection->m_currentUrl.append(at, length);
     return 0;
 }
@@ -248,6 +369,9 @@ int QHttpConnection::HeaderField(http_parser *parser, const char *at, size_t len
     QHttpConnection *theConnection = static_cast<QHttpConnection *>(parser->data);
     Q_ASSERT(theConnection->m_request);
 
+    if (!theConnection->addHeaderBytes(length))
+        return -1;
+
     // insert the header we parsed previously
     // into the header map
     if (!theConnection->m_currentHeaderField.isEmpty() &&
@@ -272,6 +396,9 @@ int QHttpConnection::HeaderValue(http_parser *parser, const char *at, size_t len
     QHttpConnection *theConnection = static_cast<QHttpConnection *>(parser->data);
     Q_ASSERT(theConnection->m_request);
 
+    if (!theConnection->addHeaderBytes(length))
+        return -1;
+
     QString valueSuffix = QString::fromLatin1(at, length);
     theConnection->m_currentHeaderValue += valueSuffix;
     return 0;
@@ -282,6 +409,14 @@ int QHttpConnection::Body(http_parser *parser, const char *at, size_t length)
     QHttpConnection *theConnection = static_cast<QHttpConnection *>(parser->data);
     Q_ASSERT(theConnection->m_request);
 
+    // Chunked bodies have no declared length, so they are checked as they arrive
+    theConnection->m_bodySize += length;
+
+    if ((theConnection->m_maxBodySize > 0) && (theConnection->m_bodySize > theConnection->m_maxBodySize)) {
+        theConnection->rejectRequest(QHttpResponse::STATUS_REQUEST_ENTITY_TOO_LARGE);
+        return -1;
+    }
+
     emit theConnection->m_request->data(QByteArray(at, length));
     return 0;
 }
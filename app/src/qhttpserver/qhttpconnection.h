@@ -27,6 +27,7 @@
 #include "qhttpserverfwd.h"
 
 #include <QObject>
+#include <QPointer>
 
 /// @cond nodoc
 
@@ -38,12 +39,21 @@ public:
     QHttpConnection(QTcpSocket *socket, QObject *parent = 0);
     virtual ~QHttpConnection();
 
+    void setMaxHeaderSize(int bytes);
+    void setMaxBodySize(qint64 bytes);
+    void setBodyFileThreshold(qint64 bytes);
+    void setWriteHighWaterMark(qint64 bytes);
+
+    qint64 bytesToWrite() const;
+    bool isWriteBufferFull() const;
+
     void write(const QByteArray &data);
     void flush();
 
 signals:
     void newRequest(QHttpRequest *, QHttpResponse *);
     void allBytesWritten();
+    void writeBufferDrained();
 
 private slots:
     void parseRequest();
@@ -52,6 +62,9 @@ private slots:
     void updateWriteCount(qint64);
 
 private:
+    bool addHeaderBytes(size_t length);
+    void rejectRequest(int status);
+
     static int MessageBegin(http_parser *parser);
     static int Url(http_parser *parser, const char *at, size_t length);
     static int HeaderField(http_parser *parser, const char *at, size_t length);
@@ -67,6 +80,20 @@ private:
 
     // Since there can only be one request at any time even with pipelining.
     QHttpRequest *m_request;
+    bool m_requestEmitted;
+    // The response to the current request, once it has been emitted
+    QPointer<QHttpResponse> m_response;
+
+    // Reused for every read from the socket
+    QByteArray m_readBuffer;
+
+    // Limits on the size of requests. A size of zero means unlimited.
+    int m_maxHeaderSize;
+    qint64 m_maxBodySize;
+    qint64 m_bodyFileThreshold;
+    qint64 m_headerSize;
+    qint64 m_bodySize;
+    bool m_rejected;
 
     QByteArray m_currentUrl;
     // The ones we are reading in from the parser
@@ -77,6 +104,8 @@ private:
     // Keep track of transmit buffer status
     qint64 m_transmitLen;
     qint64 m_transmitPos;
+    qint64 m_writeHighWaterMark;
+    bool m_writeBufferFull;
 };
 
 /// @endcond
@@ -24,8 +24,16 @@
 
 #include "qhttpconnection.h"
 
+#include <QDebug>
+#include <QTemporaryFile>
+
 QHttpRequest::QHttpRequest(QHttpConnection *connection, QObject *parent)
-    : QObject(parent), m_connection(connection), m_url("http://localhost/"), m_success(false)
+    : QObject(parent),
+      m_connection(connection),
+      m_url("http://localhost/"),
+      m_bodyFile(0),
+      m_bodyFileThreshold(0),
+      m_success(false)
 {
 }
 
@@ -78,6 +86,29 @@ quint16 QHttpRequest::remotePort() const
     return m_remotePort;
 }
 
+const QByteArray &QHttpRequest::body() const
+{
+    if ((m_bodyFile) && (m_body.isEmpty())) {
+        m_bodyFile->seek(0);
+        m_body = m_bodyFile->readAll();
+    }
+
+    return m_body;
+}
+
+QIODevice *QHttpRequest::bodyFile() const
+{
+    if (m_bodyFile)
+        m_bodyFile->seek(0);
+
+    return m_bodyFile;
+}
+
+qint64 QHttpRequest::bodySize() const
+{
+    return m_bodyFile ? m_bodyFile->size() : m_body.size();
+}
+
 void QHttpRequest::storeBody()
 {
 #if QT_VERSION >= 0x040600
@@ -97,5 +128,25 @@ QString QHttpRequest::MethodToString(HttpMethod method)
 
 void QHttpRequest::appendBody(const QByteArray &body)
 {
+    if (m_bodyFile) {
+        m_bodyFile->write(body);
+        return;
+    }
+
     m_body.append(body);
+
+    if ((m_bodyFileThreshold > 0) && (m_body.size() > m_bodyFileThreshold)) {
+        QTemporaryFile *file = new QTemporaryFile(this);
+
+        if (file->open()) {
+            // Further data is written straight to the file
+            file->write(m_body);
+            m_body = QByteArray();
+            m_bodyFile = file;
+        } else {
+            qWarning() << "QHttpRequest::appendBody() Cannot open temporary file:" << file->errorString();
+            delete file;
+            m_bodyFileThreshold = 0;
+        }
+    }
 }
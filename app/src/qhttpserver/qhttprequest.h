@@ -31,6 +31,9 @@
 #include <QMetaType>
 #include <QUrl>
 
+class QIODevice;
+class QTemporaryFile;
+
 /// The QHttpRequest class represents the header and body data sent by the client.
 /** The requests header data is available immediately. Body data is streamed as
     it comes in via the data() signal. As a consequence the application's request
@@ -137,11 +140,20 @@ public:
     quint16 remotePort() const;
 
     /// Request body data, empty for non POST/PUT requests.
-    /** @sa storeBody() */
-    const QByteArray &body() const
-    {
-        return m_body;
-    }
+    /** A body that was stored in a temporary file is read into memory
+        when this is first called.
+        @sa storeBody() bodyFile() */
+    const QByteArray &body() const;
+
+    /// The temporary file holding the request body, or 0 if the body is held in memory.
+    /** Bodies larger than the threshold set with QHttpServer::setBodyFileThreshold()
+        are written to a temporary file as they arrive, so that they can be
+        read incrementally instead of being held in memory.
+        @sa storeBody() */
+    QIODevice *bodyFile() const;
+
+    /// The size of the stored request body in bytes.
+    qint64 bodySize() const;
 
     /// If this request was successfully received.
     /** Set before end() has been emitted, stating whether
@@ -195,7 +207,9 @@ private:
     QString m_version;
     QString m_remoteAddress;
     quint16 m_remotePort;
-    QByteArray m_body;
+    mutable QByteArray m_body;
+    QTemporaryFile *m_bodyFile;
+    qint64 m_bodyFileThreshold;
     bool m_success;
 };
 
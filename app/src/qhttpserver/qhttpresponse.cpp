@@ -24,6 +24,7 @@
 
 #include <QDateTime>
 #include <QLocale>
+#include <QStringList>
 
 #include "qhttpserver.h"
 #include "qhttpconnection.h"
@@ -40,9 +41,13 @@ QHttpResponse::QHttpResponse(QHttpConnection *connection)
       m_keepAlive(true),
       m_last(false),
       m_useChunkedEncoding(false),
-      m_finished(false)
+      m_finished(false),
+      m_acceptedEncodings(ENCODING_NONE),
+      m_compressionThreshold(1024),
+      m_pendingStatus(-1)
 {
    connect(m_connection, SIGNAL(allBytesWritten()), this, SIGNAL(allBytesWritten()));
+   connect(m_connection, SIGNAL(writeBufferDrained()), this, SIGNAL(writeBufferDrained()));
 }
 
 QHttpResponse::~QHttpResponse()
@@ -51,8 +56,15 @@ QHttpResponse::~QHttpResponse()
 
 void QHttpResponse::setHeader(const QString &field, const QString &value)
 {
-    if (!m_finished)
+    if (!m_finished) {
+        // Replace any existing value, whatever the case of the field name
+        foreach(const QString & name, m_headers.keys()) {
+            if (name.compare(field, Qt::CaseInsensitive) == 0)
+                m_headers.remove(name);
+        }
+
         m_headers[field] = value;
+    }
     else
         qWarning() << "QHttpResponse::setHeader() Cannot set headers after response has finished.";
 }
@@ -133,12 +145,33 @@ void QHttpResponse::writeHead(int status)
         return;
     }
 
+    m_headerWritten = true;
+
+    if (m_acceptedEncodings != ENCODING_NONE) {
+        // Wait for the body, which may be compressed
+        m_pendingStatus = status;
+        return;
+    }
+
+    writeStatusLine(status);
+}
+
+void QHttpResponse::writeStatusLine(int status)
+{
     m_connection->write(
         QString("HTTP/1.1 %1 %2\r\n").arg(status).arg(STATUS_CODES[status]).toLatin1());
     writeHeaders();
     m_connection->write("\r\n");
+}
 
-    m_headerWritten = true;
+void QHttpResponse::flushHead()
+{
+    if (m_pendingStatus < 0)
+        return;
+
+    const int status = m_pendingStatus;
+    m_pendingStatus = -1;
+    writeStatusLine(status);
 }
 
 void QHttpResponse::writeHead(StatusCode statusCode)
@@ -158,7 +191,21 @@ void QHttpResponse::write(const QByteArray &data)
         return;
     }
 
-    m_connection->write(data);
+    flushHead();
+    writeBody(data);
+}
+
+void QHttpResponse::writeBody(const QByteArray &data)
+{
+    if (data.isEmpty())
+        return;
+
+    if (m_useChunkedEncoding) {
+        m_connection->write(QByteArray::number(data.size(), 16) + "\r\n");
+        m_connection->write(data);
+        m_connection->write("\r\n");
+    } else
+        m_connection->write(data);
 }
 
 void QHttpResponse::end(const QByteArray &data)
@@ -168,8 +215,17 @@ void QHttpResponse::end(const QByteArray &data)
         return;
     }
 
-    if (data.size() > 0)
+    if (m_pendingStatus >= 0) {
+        QByteArray body = data;
+        compressBody(body);
+        flushHead();
+        writeBody(body);
+    } else if (data.size() > 0)
         write(data);
+
+    if (m_useChunkedEncoding)
+        m_connection->write("0\r\n\r\n");
+
     m_finished = true;
 
     emit done();
@@ -184,3 +240,146 @@ void QHttpResponse::connectionClosed()
     emit done();
     deleteLater();
 }
+
+bool QHttpResponse::isWriteBufferFull() const
+{
+    return m_connection->isWriteBufferFull();
+}
+
+int QHttpResponse::acceptedEncodings() const
+{
+    return m_acceptedEncodings;
+}
+
+void QHttpResponse::setAcceptEncoding(const QString &acceptEncoding)
+{
+    if (m_headerWritten) {
+        qWarning() << "QHttpResponse::setAcceptEncoding() Cannot be called after writeHead().";
+        return;
+    }
+
+    m_acceptedEncodings = ENCODING_NONE;
+
+    foreach(const QString & token, acceptEncoding.split(",", QString::SkipEmptyParts)) {
+        const QStringList params = token.split(";");
+        const QString coding = params.first().trimmed().toLower();
+        bool accepted = true;
+
+        for (int i = 1; i < params.size(); i++) {
+            const QString param = params.at(i).trimmed();
+
+            if (param.startsWith("q=", Qt::CaseInsensitive))
+                accepted = param.mid(2).toDouble() > 0;
+        }
+
+        if (!accepted)
+            continue;
+
+        if ((coding == "gzip") || (coding == "x-gzip"))
+            m_acceptedEncodings |= ENCODING_GZIP;
+        else if (coding == "deflate")
+            m_acceptedEncodings |= ENCODING_DEFLATE;
+        else if (coding == "*")
+            m_acceptedEncodings |= ENCODING_GZIP | ENCODING_DEFLATE;
+    }
+}
+
+void QHttpResponse::setCompressionThreshold(int bytes)
+{
+    m_compressionThreshold = bytes;
+}
+
+QString QHttpResponse::header(const QString &field) const
+{
+    foreach(const QString & name, m_headers.keys()) {
+        if (name.compare(field, Qt::CaseInsensitive) == 0)
+            return m_headers.value(name);
+    }
+
+    return QString();
+}
+
+void QHttpResponse::compressBody(QByteArray &body)
+{
+    const QString contentType = header("content-type").toLower();
+
+    if ((!contentType.startsWith("text/")) && (!contentType.contains("json"))
+        && (!contentType.contains("javascript")) && (!contentType.contains("xml")))
+        return;
+
+    // The representation depends upon Accept-Encoding, so caches must take it into account
+    setHeader("Vary", "Accept-Encoding");
+
+    // Only complete representations are compressed, never partial content or errors
+    if ((body.size() < m_compressionThreshold) || (!header("content-encoding").isEmpty())
+        || (!header("transfer-encoding").isEmpty()) || (m_pendingStatus != STATUS_OK))
+        return;
+
+    const Encoding encoding =
+        (m_acceptedEncodings & ENCODING_GZIP) ? ENCODING_GZIP : ENCODING_DEFLATE;
+    const QByteArray compressed = compress(body, encoding);
+
+    if ((compressed.isEmpty()) || (compressed.size() >= body.size()))
+        return;
+
+    body = compressed;
+    setHeader("Content-Encoding", encoding == ENCODING_GZIP ? "gzip" : "deflate");
+    setHeader("Content-Length", QString::number(body.size()));
+}
+
+static quint32 crc32(const QByteArray &data)
+{
+    static quint32 table[256];
+    static bool tableReady = false;
+
+    if (!tableReady) {
+        for (quint32 i = 0; i < 256; i++) {
+            quint32 c = i;
+
+            for (int k = 0; k < 8; k++)
+                c = (c & 1) ? 0xedb88320 ^ (c >> 1) : c >> 1;
+
+            table[i] = c;
+        }
+
+        tableReady = true;
+    }
+
+    quint32 crc = 0xffffffff;
+
+    for (int i = 0; i < data.size(); i++)
+        crc = table[(crc ^ static_cast<uchar>(data.at(i))) & 0xff] ^ (crc >> 8);
+
+    return crc ^ 0xffffffff;
+}
+
+static void appendLittleEndian(QByteArray &data, quint32 value)
+{
+    for (int i = 0; i < 4; i++)
+        data.append(static_cast<char>((value >> (i * 8)) & 0xff));
+}
+
+QByteArray QHttpResponse::compress(const QByteArray &data, Encoding encoding)
+{
+    // qCompress() produces a 4 byte length followed by a zlib stream, which
+    // is what HTTP calls deflate
+    const QByteArray zlib = qCompress(data);
+
+    if (zlib.size() < 10)
+        return QByteArray();
+
+    if (encoding == ENCODING_DEFLATE)
+        return zlib.mid(4);
+
+    if (encoding != ENCODING_GZIP)
+        return QByteArray();
+
+    // Rewrap the raw deflate data (without the 2 byte zlib header and
+    // 4 byte Adler-32 trailer) as a gzip member
+    static const char header[] = { '\x1f', '\x8b', '\x08', 0, 0, 0, 0, 0, 0, '\x03' };
+    QByteArray gzip(header, sizeof(header));
+    gzip.append(zlib.constData() + 6, zlib.size() - 10);
+    appendLittleEndian(gzip, crc32(data));
+    appendLittleEndian(gzip, static_cast<quint32>(data.size()));
+    return gzip;
+}
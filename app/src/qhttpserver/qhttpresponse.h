@@ -77,6 +77,7 @@ public:
         STATUS_REQUEST_UNSUPPORTED_MEDIA_TYPE = 415,
         STATUS_REQUESTED_RANGE_NOT_SATISFIABLE = 416,
         STATUS_EXPECTATION_FAILED = 417,
+        STATUS_REQUEST_HEADER_FIELDS_TOO_LARGE = 431,
         STATUS_INTERNAL_SERVER_ERROR = 500,
         STATUS_NOT_IMPLEMENTED = 501,
         STATUS_BAD_GATEWAY = 502,
@@ -85,8 +86,26 @@ public:
         STATUS_HTTP_VERSION_NOT_SUPPORTED = 505
     };
 
+    /// Content encodings accepted by the client.
+    enum Encoding {
+        ENCODING_NONE = 0,
+        ENCODING_DEFLATE = 1,
+        ENCODING_GZIP = 2
+    };
+
     virtual ~QHttpResponse();
 
+    /// Returns the encodings accepted by the client, as set by setAcceptEncoding().
+    int acceptedEncodings() const;
+
+    /// Compresses @c data using @c encoding. Returns an empty array on failure.
+    static QByteArray compress(const QByteArray &data, Encoding encoding);
+
+    /// Returns true if the connection has reached its write high-water mark.
+    /** Producers should stop calling write() until writeBufferDrained() is emitted.
+        @sa QHttpServer::setWriteHighWaterMark() */
+    bool isWriteBufferFull() const;
+
     /// @cond nodoc
     friend class QHttpConnection;
     /// @endcond
@@ -99,6 +118,20 @@ public slots:
         @param value Header value to be set. */
     void setHeader(const QString &field, const QString &value);
 
+    /// Enables compression of the response body according to the
+    /// client's Accept-Encoding header.
+    /** When compression is enabled, the header section is held back
+        until the body is known. A body passed in full to end() is
+        compressed if it is at least as large as the compression threshold
+        and its Content-Type is textual. Responses that call write()
+        are sent uncompressed.
+        @note This must be called before writeHead().
+        @param acceptEncoding The value of the request's Accept-Encoding header. */
+    void setAcceptEncoding(const QString &acceptEncoding);
+
+    /// Sets the minimum body size, in bytes, that will be compressed.
+    void setCompressionThreshold(int bytes);
+
     /// Writes the header section of the response
     /// using @c status as the response status code.
     /** @param statusCode Status code for the response.
@@ -110,7 +143,9 @@ public slots:
     void writeHead(StatusCode statusCode);
 
     /// Writes a block of @c data to the client.
-    /** @note writeHead() must be called before this function. */
+    /** If the Transfer-Encoding header was set to chunked, each block
+        is sent as one chunk, and end() sends the last chunk.
+        @note writeHead() must be called before this function. */
     void write(const QByteArray &data);
 
     /// End/finish the response.
@@ -131,6 +166,10 @@ signals:
         receiving this signal. */
     void allBytesWritten();
 
+    /// Emitted when a full write buffer has drained to half of the high-water mark.
+    /** @sa isWriteBufferFull() */
+    void writeBufferDrained();
+
     /// Emitted when the response is finished.
     /** You should <b>not</b> interact with this object
         after done() has been emitted as the object
@@ -142,6 +181,12 @@ private:
 
     void writeHeaders();
     void writeHeader(const char *field, const QString &value);
+    void writeStatusLine(int status);
+    void flushHead();
+    void writeBody(const QByteArray &data);
+
+    QString header(const QString &field) const;
+    void compressBody(QByteArray &body);
 
     QHttpConnection *m_connection;
 
@@ -157,6 +202,10 @@ private:
     bool m_useChunkedEncoding;
     bool m_finished;
 
+    int m_acceptedEncodings;
+    int m_compressionThreshold;
+    int m_pendingStatus;
+
 private slots:
     void connectionClosed();
 };
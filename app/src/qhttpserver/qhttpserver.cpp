@@ -31,7 +31,13 @@
 
 QHash<int, QString> STATUS_CODES;
 
-QHttpServer::QHttpServer(QObject *parent) : QObject(parent), m_tcpServer(0)
+QHttpServer::QHttpServer(QObject *parent)
+    : QObject(parent),
+      m_tcpServer(0),
+      m_maxHeaderSize(0),
+      m_maxBodySize(0),
+      m_bodyFileThreshold(0),
+      m_writeHighWaterMark(1048576)
 {
 #define STATUS_CODE(num, reason) STATUS_CODES.insert(num, reason);
     // {{{
@@ -77,6 +83,7 @@ QHttpServer::QHttpServer(QObject *parent) : QObject(parent), m_tcpServer(0)
     STATUS_CODE(424, "Failed Dependency")    // RFC 4918
     STATUS_CODE(425, "Unordered Collection") // RFC 4918
     STATUS_CODE(426, "Upgrade Required")     // RFC 2817
+    STATUS_CODE(431, "Request Header Fields Too Large") // RFC 6585
     STATUS_CODE(500, "Internal Server Error")
     STATUS_CODE(501, "Not Implemented")
     STATUS_CODE(502, "Bad Gateway")
@@ -101,6 +108,10 @@ void QHttpServer::newConnection()
     while (m_tcpServer->hasPendingConnections()) {
         QHttpConnection *connection =
             new QHttpConnection(m_tcpServer->nextPendingConnection(), this);
+        connection->setMaxHeaderSize(m_maxHeaderSize);
+        connection->setMaxBodySize(m_maxBodySize);
+        connection->setBodyFileThreshold(m_bodyFileThreshold);
+        connection->setWriteHighWaterMark(m_writeHighWaterMark);
         connect(connection, SIGNAL(newRequest(QHttpRequest *, QHttpResponse *)), this,
                 SIGNAL(newRequest(QHttpRequest *, QHttpResponse *)));
     }
@@ -131,3 +142,23 @@ void QHttpServer::close()
     if (m_tcpServer)
         m_tcpServer->close();
 }
+
+void QHttpServer::setMaxHeaderSize(int bytes)
+{
+    m_maxHeaderSize = bytes;
+}
+
+void QHttpServer::setMaxBodySize(qint64 bytes)
+{
+    m_maxBodySize = bytes;
+}
+
+void QHttpServer::setBodyFileThreshold(qint64 bytes)
+{
+    m_bodyFileThreshold = bytes;
+}
+
+void QHttpServer::setWriteHighWaterMark(qint64 bytes)
+{
+    m_writeHighWaterMark = bytes;
+}
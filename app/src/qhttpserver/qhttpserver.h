@@ -81,6 +81,29 @@ public:
 
     /// Stop the server and listening for new connections.
     void close();
+
+    /// Sets the maximum size, in bytes, of the request line and headers.
+    /** Larger requests are answered with status 431 and the connection
+        is closed. A value of zero means unlimited, which is the default. */
+    void setMaxHeaderSize(int bytes);
+
+    /// Sets the maximum size, in bytes, of a request body.
+    /** Larger requests are answered with status 413 and the connection
+        is closed. A value of zero means unlimited, which is the default. */
+    void setMaxBodySize(qint64 bytes);
+
+    /// Sets the size, in bytes, above which a stored request body is
+    /// written to a temporary file.
+    /** A value of zero keeps all bodies in memory, which is the default.
+        @sa QHttpRequest::storeBody() QHttpRequest::bodyFile() */
+    void setBodyFileThreshold(qint64 bytes);
+
+    /// Sets the number of unsent bytes at which a connection's
+    /// write buffer is considered full.
+    /** A value of zero pauses producers after every write until all
+        data has been sent. The default is 1 MiB.
+        @sa QHttpResponse::isWriteBufferFull() */
+    void setWriteHighWaterMark(qint64 bytes);
 signals:
     /// Emitted when a client makes a new request to the server.
     /** The slot should use the given @c request and @c response
@@ -94,6 +117,11 @@ private slots:
 
 private:
     QTcpServer *m_tcpServer;
+
+    int m_maxHeaderSize;
+    qint64 m_maxBodySize;
+    qint64 m_bodyFileThreshold;
+    qint64 m_writeHighWaterMark;
 };
 
 #endif
@@ -19,6 +19,7 @@
 #include "qdl.h"
 #include "qhttprequest.h"
 #include "qhttpresponse.h"
+#include "requestbody.h"
 #include "utils.h"
 
 void CategoryServer::handleRequest(QHttpRequest *request, QHttpResponse *response) {
@@ -27,7 +28,7 @@ void CategoryServer::handleRequest(QHttpRequest *request, QHttpResponse *respons
     if (method == "addcategory") {
         // Add category
         if (request->method() == QHttpRequest::HTTP_POST) {
-            QVariantMap category = QtJson::Json::parse(request->body()).toMap();
+            QVariantMap category = RequestBody::parseJson(request).toMap();
             const QString name = category.value("name").toString();
             const QString path = category.value("path").toString();
 
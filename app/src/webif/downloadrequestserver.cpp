@@ -19,6 +19,7 @@
 #include "qdl.h"
 #include "qhttprequest.h"
 #include "qhttpresponse.h"
+#include "requestbody.h"
 
 void DownloadRequestServer::handleRequest(QHttpRequest *request, QHttpResponse *response) {
     const QString method = request->path().mid(request->path().lastIndexOf("/") + 1).toLower();
@@ -26,7 +27,7 @@ void DownloadRequestServer::handleRequest(QHttpRequest *request, QHttpResponse *
     if (method == "addrequests") {
         // Add download requests
         if (request->method() == QHttpRequest::HTTP_POST) {
-            const QStringList urls = QtJson::Json::parse(request->body()).toStringList();
+            const QStringList urls = RequestBody::parseJson(request).toStringList();
 
             if (!urls.isEmpty()) {
                 // OK
@@ -123,7 +124,7 @@ void DownloadRequestServer::handleRequest(QHttpRequest *request, QHttpResponse *
     else if (method == "submitsettingsresponse") {
         // Submit settings response
         if (request->method() == QHttpRequest::HTTP_POST) {
-            const QVariantMap settings = QtJson::Json::parse(request->body()).toMap();
+            const QVariantMap settings = RequestBody::parseJson(request).toMap();
 
             if (Qdl::submitDownloadRequestSettingsResponse(settings)) {
                 // OK
@@ -0,0 +1,488 @@
+/*
+ * Copyright (C) 2016 Stuart Howarth <showarth@marxoft.co.uk>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "eventserver.h"
+#include "json.h"
+#include "logger.h"
+#include "qdl.h"
+#include "qhttprequest.h"
+#include "qhttpresponse.h"
+#include "transfermodel.h"
+#include <QTimer>
+
+// Deltas are coalesced for this long before being pushed to clients
+static const int FLUSH_INTERVAL = 500;
+// Comment lines are sent at this interval so that dead connections are detected
+static const int KEEP_ALIVE_INTERVAL = 15000;
+// A client that falls further behind than this is asked to reload the transfers
+static const int MAX_BACKLOG_SIZE = 262144;
+
+EventServer* EventServer::self = 0;
+
+EventServer::EventServer() :
+    QObject(),
+    m_flushTimer(new QTimer(this)),
+    m_keepAliveTimer(new QTimer(this)),
+    m_statusChanged(false)
+{
+    m_flushTimer->setInterval(FLUSH_INTERVAL);
+    m_flushTimer->setSingleShot(true);
+    m_keepAliveTimer->setInterval(KEEP_ALIVE_INTERVAL);
+    connect(m_flushTimer, SIGNAL(timeout()), this, SLOT(flush()));
+    connect(m_keepAliveTimer, SIGNAL(timeout()), this, SLOT(keepAlive()));
+
+    TransferModel *model = TransferModel::instance();
+    connect(model, SIGNAL(itemDataChanged(TransferItem*, int)), this, SLOT(onItemDataChanged(TransferItem*, int)));
+    connect(model, SIGNAL(rowsInserted(QModelIndex, int, int)), this, SLOT(onRowsInserted(QModelIndex, int, int)));
+    connect(model, SIGNAL(rowsAboutToBeRemoved(QModelIndex, int, int)),
+            this, SLOT(onRowsAboutToBeRemoved(QModelIndex, int, int)));
+    connect(model, SIGNAL(rowsAboutToBeMoved(QModelIndex, int, int, QModelIndex, int)),
+            this, SLOT(onRowsAboutToBeMoved(QModelIndex, int, int, QModelIndex, int)));
+    connect(model, SIGNAL(modelReset()), this, SLOT(onModelReset()));
+    connect(model, SIGNAL(activeTransfersChanged(int)), this, SLOT(onStatusChanged()));
+    connect(model, SIGNAL(totalSpeedChanged(int)), this, SLOT(onStatusChanged()));
+    connect(model, SIGNAL(captchaRequest(TransferItem*)), this, SLOT(onCaptchaRequest(TransferItem*)));
+    connect(model, SIGNAL(settingsRequest(TransferItem*)), this, SLOT(onSettingsRequest(TransferItem*)));
+}
+
+EventServer::~EventServer() {
+    self = 0;
+}
+
+EventServer* EventServer::instance() {
+    return self ? self : self = new EventServer;
+}
+
+void EventServer::handleRequest(QHttpRequest *request, QHttpResponse *response) {
+    if (request->method() == QHttpRequest::HTTP_GET) {
+        // OK
+        // Browsers send the id of the last event received when they reconnect
+        bool ok;
+        const qint64 lastEventId = request->header("last-event-id").toLongLong(&ok);
+        instance()->addClient(response, ok ? lastEventId : -1);
+    }
+    else {
+        // Method not allowed
+        response->writeHead(QHttpResponse::STATUS_METHOD_NOT_ALLOWED);
+        response->end();
+    }
+}
+
+int EventServer::clientCount() const {
+    return m_clients.size();
+}
+
+void EventServer::addClient(QHttpResponse *response, qint64 lastEventId) {
+    Logger::log("EventServer::addClient(): Client connected", Logger::MediumVerbosity);
+    // No Content-Length is sent, so the response is delimited by closing the connection
+    response->setHeader("Content-Type", "text/event-stream");
+    response->setHeader("Cache-Control", "no-cache");
+    response->writeHead(QHttpResponse::STATUS_OK);
+    connect(response, SIGNAL(allBytesWritten()), this, SLOT(onClientBytesWritten()));
+    connect(response, SIGNAL(done()), this, SLOT(onClientDone()));
+    Client &client = m_clients[response];
+    client.writing = true;
+    // Send what changed since the client's last event, or everything if that revision is unknown
+    const qint64 revision = TransferModel::instance()->revision();
+    response->write("retry: 3000\n\n" + event("sync", Qdl::getTransfersSince(lastEventId), revision)
+                    + event("status", Qdl::getTransfersStatus(), revision));
+
+    if (!m_keepAliveTimer->isActive()) {
+        m_keepAliveTimer->start();
+    }
+}
+
+void EventServer::addItem(TransferItem *item, const QString &id) {
+    if (!m_items.contains(id)) {
+        m_items[id] = item;
+    }
+}
+
+void EventServer::scheduleFlush() {
+    if (!m_flushTimer->isActive()) {
+        m_flushTimer->start();
+    }
+}
+
+void EventServer::clearPending() {
+    m_items.clear();
+    m_changed.clear();
+    m_inserted.clear();
+    m_moved.clear();
+    m_removed.clear();
+    m_captchaRequests.clear();
+    m_settingsRequests.clear();
+    m_statusChanged = false;
+}
+
+QVariantMap EventServer::itemEventData(TransferItem *item) const {
+    QVariantMap data = item->itemDataWithRoleNames();
+    const TransferItem *parent = item->parentItem();
+    data["parentId"] = (parent) && (parent->itemType() == TransferItem::PackageType)
+                       ? parent->data(TransferItem::IdRole).toString() : QString();
+    return data;
+}
+
+void EventServer::broadcast(const QByteArray &data) {
+    QMutableHashIterator<QHttpResponse*, Client> iterator(m_clients);
+
+    while (iterator.hasNext()) {
+        iterator.next();
+        send(iterator.key(), iterator.value(), data);
+    }
+}
+
+void EventServer::send(QHttpResponse *response, Client &client, const QByteArray &data) {
+    if (client.resync) {
+        // The client will reload everything once it catches up
+        return;
+    }
+
+    if (client.writing) {
+        // Hold back data until the previous write has been sent, so slow clients do not grow the socket buffer
+        if (client.backlog.size() + data.size() > MAX_BACKLOG_SIZE) {
+            Logger::log("EventServer::send(): Client backlog exceeded. Requesting resync", Logger::MediumVerbosity);
+            client.backlog.clear();
+            client.resync = true;
+        }
+        else {
+            client.backlog.append(data);
+        }
+
+        return;
+    }
+
+    client.writing = true;
+    response->write(data);
+}
+
+QByteArray EventServer::event(const QString &name, const QVariant &data, qint64 id) {
+    // The id is the model revision that the event brings the client up to
+    const QByteArray message = "event: " + name.toUtf8() + "\ndata: " + QtJson::Json::serialize(data) + "\n\n";
+    return id >= 0 ? "id: " + QByteArray::number(id) + "\n" + message : message;
+}
+
+QList<int> EventServer::dependentRoles(int role) {
+    // Roles whose values are derived from the changed role, and so must be pushed with it
+    QList<int> roles;
+
+    switch (role) {
+    case TransferItem::BytesTransferredRole:
+    case TransferItem::ProgressRole:
+    case TransferItem::SizeRole:
+        roles << TransferItem::ProgressRole << TransferItem::ProgressStringRole;
+        break;
+    case TransferItem::CaptchaTimeoutRole:
+        roles << TransferItem::CaptchaTimeoutStringRole << TransferItem::StatusStringRole;
+        break;
+    case TransferItem::ErrorStringRole:
+        roles << TransferItem::StatusStringRole;
+        break;
+    case TransferItem::PriorityRole:
+        roles << TransferItem::PriorityStringRole;
+        break;
+    case TransferItem::RequestedSettingsTimeoutRole:
+        roles << TransferItem::RequestedSettingsTimeoutStringRole << TransferItem::StatusStringRole;
+        break;
+    case TransferItem::SpeedRole:
+        roles << TransferItem::SpeedStringRole;
+        break;
+    case TransferItem::StatusRole:
+        roles << TransferItem::StatusStringRole << TransferItem::CanCancelRole << TransferItem::CanPauseRole
+              << TransferItem::CanStartRole;
+        break;
+    case TransferItem::WaitTimeRole:
+        roles << TransferItem::WaitTimeStringRole << TransferItem::StatusStringRole;
+        break;
+    default:
+        break;
+    }
+
+    return roles;
+}
+
+void EventServer::onItemDataChanged(TransferItem *item, int role) {
+    if (m_clients.isEmpty()) {
+        return;
+    }
+
+    const QString id = item->data(TransferItem::IdRole).toString();
+    QSet<int> &roles = m_changed[id];
+    roles << role;
+
+    foreach (const int dependent, dependentRoles(role)) {
+        roles << dependent;
+    }
+
+    addItem(item, id);
+    scheduleFlush();
+}
+
+void EventServer::onRowsInserted(const QModelIndex &parent, int first, int last) {
+    if (m_clients.isEmpty()) {
+        return;
+    }
+
+    TransferModel *model = TransferModel::instance();
+
+    for (int i = first; i <= last; i++) {
+        if (TransferItem *item = model->get(model->index(i, 0, parent))) {
+            const QString id = item->data(TransferItem::IdRole).toString();
+            m_inserted << id;
+            addItem(item, id);
+        }
+    }
+
+    scheduleFlush();
+}
+
+void EventServer::onRowsAboutToBeRemoved(const QModelIndex &parent, int first, int last) {
+    if (m_clients.isEmpty()) {
+        return;
+    }
+
+    TransferModel *model = TransferModel::instance();
+
+    for (int i = first; i <= last; i++) {
+        if (TransferItem *item = model->get(model->index(i, 0, parent))) {
+            QStringList ids;
+            ids << item->data(TransferItem::IdRole).toString();
+            m_removed << ids.first();
+
+            for (int j = 0; j < item->rowCount(); j++) {
+                ids << item->childItem(j)->data(TransferItem::IdRole).toString();
+            }
+
+            // Pending deltas for removed items (and their children) are no longer of interest
+            foreach (const QString &id, ids) {
+                m_items.remove(id);
+                m_changed.remove(id);
+                m_inserted.removeAll(id);
+                m_moved.removeAll(id);
+            }
+        }
+    }
+
+    scheduleFlush();
+}
+
+void EventServer::onRowsAboutToBeMoved(const QModelIndex &parent, int first, int last, const QModelIndex &,
+                                       int) {
+    if (m_clients.isEmpty()) {
+        return;
+    }
+
+    TransferModel *model = TransferModel::instance();
+
+    // The new positions are read when the deltas are flushed
+    for (int i = first; i <= last; i++) {
+        if (TransferItem *item = model->get(model->index(i, 0, parent))) {
+            const QString id = item->data(TransferItem::IdRole).toString();
+
+            if (!m_moved.contains(id)) {
+                m_moved << id;
+            }
+
+            addItem(item, id);
+        }
+    }
+
+    scheduleFlush();
+}
+
+void EventServer::onModelReset() {
+    if (m_clients.isEmpty()) {
+        return;
+    }
+
+    // Deltas cannot describe a reset, so clients must reload
+    clearPending();
+    broadcast(event("reset", QVariant()));
+}
+
+void EventServer::onStatusChanged() {
+    if (m_clients.isEmpty()) {
+        return;
+    }
+
+    m_statusChanged = true;
+    scheduleFlush();
+}
+
+void EventServer::onCaptchaRequest(TransferItem *transfer) {
+    if (m_clients.isEmpty()) {
+        return;
+    }
+
+    const QString id = transfer->data(TransferItem::IdRole).toString();
+    m_captchaRequests << id;
+    addItem(transfer, id);
+    scheduleFlush();
+}
+
+void EventServer::onSettingsRequest(TransferItem *transfer) {
+    if (m_clients.isEmpty()) {
+        return;
+    }
+
+    const QString id = transfer->data(TransferItem::IdRole).toString();
+    m_settingsRequests << id;
+    addItem(transfer, id);
+    scheduleFlush();
+}
+
+void EventServer::onClientBytesWritten() {
+    QHttpResponse *response = qobject_cast<QHttpResponse*>(sender());
+
+    if (!response) {
+        return;
+    }
+
+    QHash<QHttpResponse*, Client>::iterator iterator = m_clients.find(response);
+
+    if (iterator == m_clients.end()) {
+        return;
+    }
+
+    Client &client = iterator.value();
+
+    if (client.resync) {
+        client.resync = false;
+        response->write(event("reset", QVariant()));
+    }
+    else if (!client.backlog.isEmpty()) {
+        const QByteArray data = client.backlog;
+        client.backlog.clear();
+        response->write(data);
+    }
+    else {
+        client.writing = false;
+    }
+}
+
+void EventServer::onClientDone() {
+    if (QHttpResponse *response = qobject_cast<QHttpResponse*>(sender())) {
+        Logger::log("EventServer::onClientDone(): Client disconnected", Logger::MediumVerbosity);
+        m_clients.remove(response);
+
+        if (m_clients.isEmpty()) {
+            m_keepAliveTimer->stop();
+            m_flushTimer->stop();
+            clearPending();
+        }
+    }
+}
+
+void EventServer::flush() {
+    if (m_clients.isEmpty()) {
+        clearPending();
+        return;
+    }
+
+    const qint64 revision = TransferModel::instance()->revision();
+    QByteArray data;
+
+    if (!m_removed.isEmpty()) {
+        data += event("removed", m_removed, revision);
+    }
+
+    if (!m_inserted.isEmpty()) {
+        QVariantList inserted;
+
+        foreach (const QString &id, m_inserted) {
+            if (TransferItem *item = m_items.value(id)) {
+                inserted << itemEventData(item);
+            }
+        }
+
+        data += event("inserted", inserted, revision);
+    }
+
+    if (!m_moved.isEmpty()) {
+        QVariantList moved;
+
+        foreach (const QString &id, m_moved) {
+            if (TransferItem *item = m_items.value(id)) {
+                QVariantMap position;
+                position["id"] = id;
+                position["parentId"] = itemEventData(item).value("parentId");
+                position["row"] = item->row();
+                moved << position;
+            }
+        }
+
+        data += event("moved", moved, revision);
+    }
+
+    if (!m_changed.isEmpty()) {
+        const QHash<int, QByteArray> roleNames = TransferItem::roleNames();
+        QVariantMap changed;
+        QHashIterator<QString, QSet<int> > iterator(m_changed);
+
+        while (iterator.hasNext()) {
+            iterator.next();
+
+            if (m_inserted.contains(iterator.key())) {
+                // Already sent in full
+                continue;
+            }
+
+            if (TransferItem *item = m_items.value(iterator.key())) {
+                QVariantMap roles;
+
+                foreach (const int role, iterator.value()) {
+                    if (roleNames.contains(role)) {
+                        roles[roleNames.value(role)] = item->data(role);
+                    }
+                }
+
+                if (!roles.isEmpty()) {
+                    changed[iterator.key()] = roles;
+                }
+            }
+        }
+
+        if (!changed.isEmpty()) {
+            data += event("changed", changed, revision);
+        }
+    }
+
+    if (m_statusChanged) {
+        data += event("status", Qdl::getTransfersStatus(), revision);
+    }
+
+    foreach (const QString &id, m_captchaRequests) {
+        if (TransferItem *item = m_items.value(id)) {
+            data += event("captcha", itemEventData(item), revision);
+        }
+    }
+
+    foreach (const QString &id, m_settingsRequests) {
+        if (TransferItem *item = m_items.value(id)) {
+            data += event("settings", itemEventData(item), revision);
+        }
+    }
+
+    clearPending();
+
+    if (!data.isEmpty()) {
+        broadcast(data);
+    }
+}
+
+void EventServer::keepAlive() {
+    broadcast(": keep-alive\n\n");
+}
@@ -0,0 +1,104 @@
+/*
+ * Copyright (C) 2016 Stuart Howarth <showarth@marxoft.co.uk>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef EVENTSERVER_H
+#define EVENTSERVER_H
+
+#include <QObject>
+#include <QHash>
+#include <QPointer>
+#include <QSet>
+#include <QStringList>
+#include <QVariantMap>
+
+class TransferItem;
+class QHttpRequest;
+class QHttpResponse;
+class QModelIndex;
+class QTimer;
+
+class EventServer : public QObject
+{
+    Q_OBJECT
+
+public:
+    ~EventServer();
+
+    static EventServer* instance();
+
+    static void handleRequest(QHttpRequest *request, QHttpResponse *response);
+
+    int clientCount() const;
+
+private Q_SLOTS:
+    void onItemDataChanged(TransferItem *item, int role);
+    void onRowsInserted(const QModelIndex &parent, int first, int last);
+    void onRowsAboutToBeRemoved(const QModelIndex &parent, int first, int last);
+    void onRowsAboutToBeMoved(const QModelIndex &parent, int first, int last, const QModelIndex &destination, int row);
+    void onModelReset();
+    void onStatusChanged();
+    void onCaptchaRequest(TransferItem *transfer);
+    void onSettingsRequest(TransferItem *transfer);
+
+    void onClientBytesWritten();
+    void onClientDone();
+
+    void flush();
+    void keepAlive();
+
+private:
+    struct Client {
+        Client() : writing(false), resync(false) {}
+
+        QByteArray backlog;
+        bool writing;
+        bool resync;
+    };
+
+    EventServer();
+
+    void addClient(QHttpResponse *response, qint64 lastEventId);
+
+    void addItem(TransferItem *item, const QString &id);
+    void scheduleFlush();
+    void clearPending();
+
+    QVariantMap itemEventData(TransferItem *item) const;
+
+    void broadcast(const QByteArray &data);
+    void send(QHttpResponse *response, Client &client, const QByteArray &data);
+
+    static QByteArray event(const QString &name, const QVariant &data, qint64 id = -1);
+    static QList<int> dependentRoles(int role);
+
+    static EventServer *self;
+
+    QTimer *m_flushTimer;
+    QTimer *m_keepAliveTimer;
+
+    QHash<QHttpResponse*, Client> m_clients;
+
+    QHash<QString, QPointer<TransferItem> > m_items;
+    QHash<QString, QSet<int> > m_changed;
+    QStringList m_inserted;
+    QStringList m_moved;
+    QStringList m_removed;
+    QStringList m_captchaRequests;
+    QStringList m_settingsRequests;
+    bool m_statusChanged;
+};
+
+#endif // EVENTSERVER_H
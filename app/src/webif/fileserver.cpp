@@ -16,9 +16,188 @@
 
 #include "fileserver.h"
 #include "definitions.h"
+#include "filestreamer.h"
 #include "qhttprequest.h"
 #include "qhttpresponse.h"
+#include <QCache>
+#include <QDateTime>
 #include <QFile>
+#include <QFileInfo>
+#include <QLocale>
+
+QString FileServer::contentType(const QString &filePath) {
+    const QString suffix = QFileInfo(filePath).suffix().toLower();
+
+    if (suffix.isEmpty()) {
+        // The web interface pages have no suffix
+        return QString("text/html; charset=utf-8");
+    }
+
+    if (suffix == "css") {
+        return QString("text/css; charset=utf-8");
+    }
+
+    if (suffix == "js") {
+        return QString("application/javascript; charset=utf-8");
+    }
+
+    if ((suffix == "html") || (suffix == "htm")) {
+        return QString("text/html; charset=utf-8");
+    }
+
+    if (suffix == "json") {
+        return QString("application/json");
+    }
+
+    if (suffix == "png") {
+        return QString("image/png");
+    }
+
+    if ((suffix == "jpg") || (suffix == "jpeg")) {
+        return QString("image/jpeg");
+    }
+
+    if (suffix == "gif") {
+        return QString("image/gif");
+    }
+
+    if (suffix == "svg") {
+        return QString("image/svg+xml");
+    }
+
+    if (suffix == "ico") {
+        return QString("image/x-icon");
+    }
+
+    if (suffix == "mp4") {
+        return QString("video/mp4");
+    }
+
+    if (suffix == "mkv") {
+        return QString("video/x-matroska");
+    }
+
+    if (suffix == "webm") {
+        return QString("video/webm");
+    }
+
+    if (suffix == "avi") {
+        return QString("video/x-msvideo");
+    }
+
+    if (suffix == "mp3") {
+        return QString("audio/mpeg");
+    }
+
+    if (suffix == "ogg") {
+        return QString("audio/ogg");
+    }
+
+    return QString("application/octet-stream");
+}
+
+// Files up to this size are cached in memory, larger files are streamed from disk
+static const qint64 MAX_CACHED_FILE_SIZE = 262144;
+// The total size of the cached files
+static const int MAX_CACHE_SIZE = 4194304;
+
+struct CachedFile
+{
+    QDateTime lastModified;
+    QByteArray data;
+};
+
+static QCache<QString, CachedFile>& cache() {
+    static QCache<QString, CachedFile> files(MAX_CACHE_SIZE);
+    return files;
+}
+
+static QString httpDate(const QDateTime &dateTime) {
+    return QLocale::c().toString(dateTime.toUTC(), "ddd, dd MMM yyyy hh:mm:ss") + " GMT";
+}
+
+// Accepts the three formats required by HTTP/1.1. Returns an invalid QDateTime if the date cannot be parsed
+static QDateTime parseHttpDate(const QString &date) {
+    const QString value = date.simplified();
+    QDateTime dateTime;
+
+    if (value.contains(",")) {
+        const QString dayAndTime = value.section(",", 1).trimmed();
+
+        if (dayAndTime.contains("-")) {
+            // RFC 850: Sunday, 06-Nov-94 08:49:37 GMT
+            dateTime = QLocale::c().toDateTime(dayAndTime.left(18), "dd-MMM-yy hh:mm:ss");
+
+            if ((dateTime.isValid()) && (dateTime.date().year() < 1970)) {
+                dateTime = dateTime.addYears(100);
+            }
+        }
+        else {
+            // RFC 1123: Sun, 06 Nov 1994 08:49:37 GMT
+            dateTime = QLocale::c().toDateTime(dayAndTime.left(20), "dd MMM yyyy hh:mm:ss");
+        }
+    }
+    else {
+        // asctime(): Sun Nov  6 08:49:37 1994
+        dateTime = QLocale::c().toDateTime(value, "ddd MMM d hh:mm:ss yyyy");
+    }
+
+    dateTime.setTimeSpec(Qt::UTC);
+    return dateTime;
+}
+
+// Returns false if the Range header is present but cannot be satisfied
+bool FileServer::parseRange(const QString &header, qint64 size, qint64 &offset, qint64 &length) {
+    offset = 0;
+    length = size;
+
+    if (header.isEmpty()) {
+        return true;
+    }
+
+    if ((!header.startsWith("bytes=")) || (header.contains(","))) {
+        // Unsupported ranges are ignored, and the whole file is sent
+        return true;
+    }
+
+    const QString range = header.mid(6).trimmed();
+    const int dash = range.indexOf("-");
+
+    if (dash == -1) {
+        return true;
+    }
+
+    const QString first = range.left(dash).trimmed();
+    const QString last = range.mid(dash + 1).trimmed();
+
+    if (first.isEmpty()) {
+        // Suffix range
+        const qint64 suffix = last.toLongLong();
+
+        if (suffix <= 0) {
+            return false;
+        }
+
+        offset = qMax(qint64(0), size - suffix);
+        length = size - offset;
+        return true;
+    }
+
+    offset = first.toLongLong();
+
+    if (offset >= size) {
+        return false;
+    }
+
+    const qint64 end = last.isEmpty() ? size - 1 : qMin(size - 1, last.toLongLong());
+
+    if (end < offset) {
+        return false;
+    }
+
+    length = end - offset + 1;
+    return true;
+}
 
 void FileServer::handleRequest(QHttpRequest *request, QHttpResponse *response) {
     QString filePath = request->path();
@@ -29,25 +208,115 @@ void FileServer::handleRequest(QHttpRequest *request, QHttpResponse *response) {
         filePath.prepend(WEB_INTERFACE_PATH);
     }
 
-    if (QFile::exists(filePath)) {
-        QFile file(filePath);
+    QFileInfo info(filePath);
 
-        if (file.open(QFile::ReadOnly)) {
-            // OK
-            response->setHeader("Content-Length", QString::number(file.size()));
-            response->writeHead(QHttpResponse::STATUS_OK);
-            response->end(file.readAll());
-            file.close();
+    if ((!info.exists()) || (!info.isFile())) {
+        // Not found
+        response->writeHead(QHttpResponse::STATUS_NOT_FOUND);
+        response->end();
+        return;
+    }
+
+    const QString type = contentType(filePath);
+    const QString rangeHeader = request->header("range");
+    response->setHeader("Content-Type", type);
+    response->setHeader("Accept-Ranges", "bytes");
+    // Pages are revalidated on every load, other assets are cached for a while
+    response->setHeader("Cache-Control", type.startsWith("text/html") ? "no-cache" : "max-age=3600");
+
+    if ((rangeHeader.isEmpty()) && (response->acceptedEncodings() & QHttpResponse::ENCODING_GZIP)) {
+        // Prefer a variant compressed at build time, if it is up to date
+        const QFileInfo compressed(filePath + ".gz");
+
+        if ((compressed.exists()) && (compressed.lastModified() >= info.lastModified())) {
+            info = compressed;
+            response->setHeader("Content-Encoding", "gzip");
+            response->setHeader("Vary", "Accept-Encoding");
         }
-        else {
-            // Internal server error
-            response->writeHead(QHttpResponse::STATUS_INTERNAL_SERVER_ERROR);
-            response->end();
+    }
+
+    const QDateTime lastModified = info.lastModified();
+    const QString etag = QString("\"%1-%2%3\"").arg(info.size(), 0, 16).arg(lastModified.toTime_t(), 0, 16)
+                         .arg(info.suffix() == "gz" ? "-gz" : "");
+    response->setHeader("ETag", etag);
+    response->setHeader("Last-Modified", httpDate(lastModified));
+    const QString ifNoneMatch = request->header("if-none-match");
+    // An If-Modified-Since date that cannot be parsed is ignored
+    const QDateTime ifModifiedSince = parseHttpDate(request->header("if-modified-since"));
+
+    if (((!ifNoneMatch.isEmpty()) && ((ifNoneMatch == "*") || (ifNoneMatch.contains(etag))))
+        || ((ifNoneMatch.isEmpty()) && (ifModifiedSince.isValid())
+            && (lastModified.toTime_t() <= ifModifiedSince.toTime_t()))) {
+        // Not modified
+        response->setHeader("Content-Length", "0");
+        response->writeHead(QHttpResponse::STATUS_NOT_MODIFIED);
+        response->end();
+        return;
+    }
+
+    qint64 offset = 0;
+    qint64 length = info.size();
+
+    if (!parseRange(rangeHeader, info.size(), offset, length)) {
+        // Range not satisfiable
+        response->setHeader("Content-Range", QString("bytes */%1").arg(info.size()));
+        response->setHeader("Content-Length", "0");
+        response->writeHead(QHttpResponse::STATUS_REQUESTED_RANGE_NOT_SATISFIABLE);
+        response->end();
+        return;
+    }
+
+    const bool partial = length < info.size();
+    const int status = partial ? QHttpResponse::STATUS_PARTIAL_CONTENT : QHttpResponse::STATUS_OK;
+
+    if (partial) {
+        response->setHeader("Content-Range", QString("bytes %1-%2/%3").arg(offset).arg(offset + length - 1)
+                            .arg(info.size()));
+    }
+
+    response->setHeader("Content-Length", QString::number(length));
+
+    if (info.size() <= MAX_CACHED_FILE_SIZE) {
+        const QString key = info.absoluteFilePath();
+        CachedFile *cached = cache().object(key);
+
+        if ((!cached) || (cached->lastModified != lastModified)) {
+            QFile file(info.filePath());
+
+            if (!file.open(QFile::ReadOnly)) {
+                // Internal server error
+                response->setHeader("Content-Length", "0");
+                response->writeHead(QHttpResponse::STATUS_INTERNAL_SERVER_ERROR);
+                response->end();
+                return;
+            }
+
+            cached = new CachedFile;
+            cached->lastModified = lastModified;
+            cached->data = file.readAll();
+            file.close();
+            cache().insert(key, cached, qMax(1, cached->data.size()));
         }
+
+        // OK
+        response->writeHead(status);
+        response->end(partial ? cached->data.mid(offset, length) : cached->data);
+        return;
     }
-    else {
-        // Not found
-        response->writeHead(QHttpResponse::STATUS_NOT_FOUND);
+
+    QFile *file = new QFile(info.filePath());
+
+    if (!file->open(QFile::ReadOnly)) {
+        // Internal server error
+        delete file;
+        response->setHeader("Content-Length", "0");
+        response->writeHead(QHttpResponse::STATUS_INTERNAL_SERVER_ERROR);
         response->end();
+        return;
     }
+
+    // OK
+    response->writeHead(status);
+    FileStreamer *streamer = new FileStreamer(file, offset, length, response);
+    streamer->start();
 }
@@ -17,6 +17,8 @@
 #ifndef FILESERVER_H
 #define FILESERVER_H
 
+#include <QString>
+
 class QHttpRequest;
 class QHttpResponse;
 
@@ -25,6 +27,9 @@ class FileServer
 
 public:    
     static void handleRequest(QHttpRequest *request, QHttpResponse *response);
+
+    static QString contentType(const QString &filePath);
+    static bool parseRange(const QString &header, qint64 size, qint64 &offset, qint64 &length);
 };
 
 #endif // FILESERVER_H
@@ -0,0 +1,114 @@
+/*
+ * Copyright (C) 2017 Stuart Howarth <showarth@marxoft.co.uk>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "filestreamer.h"
+#include "qhttpresponse.h"
+#include "transferitem.h"
+#include <QFile>
+#include <QTimer>
+
+static const qint64 CHUNK_SIZE = 65536;
+// How often a followed file is checked for new data
+static const int FOLLOW_INTERVAL = 500;
+
+FileStreamer::FileStreamer(QFile *file, qint64 offset, qint64 length, QHttpResponse *response) :
+    QObject(),
+    m_file(file),
+    m_response(response),
+    m_followTimer(0),
+    m_remaining(length)
+{
+    m_file->seek(offset);
+    connect(response, SIGNAL(writeBufferDrained()), this, SLOT(writeChunks()));
+    connect(response, SIGNAL(done()), this, SLOT(onResponseDone()));
+}
+
+FileStreamer::~FileStreamer() {
+    delete m_file;
+    m_file = 0;
+}
+
+void FileStreamer::follow(TransferItem *transfer) {
+    m_transfer = transfer;
+    connect(transfer, SIGNAL(statusChanged(TransferItem*, TransferItem::Status)),
+            this, SLOT(onTransferStatusChanged()));
+
+    if (!m_followTimer) {
+        m_followTimer = new QTimer(this);
+        m_followTimer->setInterval(FOLLOW_INTERVAL);
+        m_followTimer->setSingleShot(true);
+        connect(m_followTimer, SIGNAL(timeout()), this, SLOT(writeChunks()));
+    }
+}
+
+bool FileStreamer::isFollowing() const {
+    if (!m_transfer) {
+        return false;
+    }
+
+    return m_transfer->data(TransferItem::StatusRole) == TransferItem::Downloading;
+}
+
+void FileStreamer::start() {
+    writeChunks();
+}
+
+void FileStreamer::writeChunks() {
+    while ((m_response) && (!m_response->isWriteBufferFull()) && (writeChunk()));
+}
+
+void FileStreamer::onResponseDone() {
+    m_response = 0;
+    deleteLater();
+}
+
+void FileStreamer::onTransferStatusChanged() {
+    if ((!isFollowing()) && (m_followTimer->isActive())) {
+        // Send what remains of the file and finish, rather than waiting for the next check
+        m_followTimer->stop();
+        writeChunks();
+    }
+}
+
+// Returns false if no more chunks can be written for now
+bool FileStreamer::writeChunk() {
+    const qint64 maxSize = m_remaining < 0 ? CHUNK_SIZE : qMin(CHUNK_SIZE, m_remaining);
+    const QByteArray data = maxSize > 0 ? m_file->read(maxSize) : QByteArray();
+
+    if ((data.isEmpty()) && (maxSize > 0) && (isFollowing())) {
+        // Wait for the transfer to write more data
+        if (!m_followTimer->isActive()) {
+            m_followTimer->start();
+        }
+
+        return false;
+    }
+
+    if (m_remaining > 0) {
+        m_remaining -= data.size();
+    }
+
+    if ((data.isEmpty()) || (m_remaining == 0)) {
+        // Either the range has been sent or the file can no longer be read
+        QHttpResponse *response = m_response;
+        m_response = 0;
+        response->end(data);
+        return false;
+    }
+
+    m_response->write(data);
+    return true;
+}
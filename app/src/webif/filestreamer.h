@@ -0,0 +1,70 @@
+/*
+ * Copyright (C) 2017 Stuart Howarth <showarth@marxoft.co.uk>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef FILESTREAMER_H
+#define FILESTREAMER_H
+
+#include <QObject>
+#include <QPointer>
+
+class TransferItem;
+class QFile;
+class QHttpResponse;
+class QTimer;
+
+/**
+ * Writes a range of a file to a response in chunks, pausing whenever the connection's write buffer is
+ * full, so that large files are never held in memory. The streamer deletes itself when the response is
+ * done.
+ */
+class FileStreamer : public QObject
+{
+    Q_OBJECT
+
+public:
+    /**
+     * Takes ownership of file, which must be open. The response head must already have been written.
+     * A negative length streams to the end of the file.
+     */
+    FileStreamer(QFile *file, qint64 offset, qint64 length, QHttpResponse *response);
+    ~FileStreamer();
+
+    /**
+     * Keeps waiting for the file to grow while transfer is downloading, so that a download in progress can be
+     * followed. The response is finished as soon as the transfer stops downloading and all data has been sent.
+     */
+    void follow(TransferItem *transfer);
+
+    void start();
+
+private Q_SLOTS:
+    void writeChunks();
+    void onResponseDone();
+    void onTransferStatusChanged();
+
+private:
+    bool isFollowing() const;
+    bool writeChunk();
+
+    QFile *m_file;
+    QHttpResponse *m_response;
+    QPointer<TransferItem> m_transfer;
+    QTimer *m_followTimer;
+
+    qint64 m_remaining;
+};
+
+#endif // FILESTREAMER_H
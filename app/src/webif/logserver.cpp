@@ -0,0 +1,95 @@
+/*
+ * Copyright (C) 2017 Stuart Howarth <showarth@marxoft.co.uk>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "logserver.h"
+#include "jsonwriter.h"
+#include "logreader.h"
+#include "qhttprequest.h"
+#include "qhttpresponse.h"
+#include "utils.h"
+
+static const int DEFAULT_LINES = 100;
+
+// One reader is shared between requests, so the line index is only extended as the log grows
+Q_GLOBAL_STATIC(LogReader, logReader)
+
+void LogServer::handleRequest(QHttpRequest *request, QHttpResponse *response) {
+    if (request->method() != QHttpRequest::HTTP_GET) {
+        // Method not allowed
+        response->writeHead(QHttpResponse::STATUS_METHOD_NOT_ALLOWED);
+        response->end();
+        return;
+    }
+
+    const QUrl &url = request->url();
+    const QString offset = Utils::urlQueryItemValue(url, "offset");
+    const QString first = Utils::urlQueryItemValue(url, "first");
+    const QString since = Utils::urlQueryItemValue(url, "since");
+    const int limit = Utils::urlQueryItemValue(url, "limit", QString::number(DEFAULT_LINES)).toInt();
+    LogReader::Page page;
+    bool ok = true;
+
+    if (!offset.isEmpty()) {
+        page = logReader()->read(offset.toLongLong(&ok), limit);
+    }
+    else if (!first.isEmpty()) {
+        page = logReader()->lines(first.toInt(&ok), limit);
+    }
+    else if (!since.isEmpty()) {
+        const QDateTime time = QDateTime::fromString(since, Qt::ISODate);
+        ok = time.isValid();
+
+        if (ok) {
+            page = logReader()->read(logReader()->offsetForTime(time), limit);
+        }
+    }
+    else {
+        page = logReader()->tail(Utils::urlQueryItemValue(url, "lines", QString::number(DEFAULT_LINES))
+                                 .toInt(&ok));
+    }
+
+    if (!ok) {
+        // Bad request
+        response->writeHead(QHttpResponse::STATUS_BAD_REQUEST);
+        response->end();
+        return;
+    }
+
+    // OK
+    QByteArray json;
+    QtJson::JsonWriter writer(&json);
+    writer.beginObject();
+    writer.writeKey("lines");
+    writer.beginArray();
+
+    foreach (const QString &line, page.lines) {
+        writer.writeString(line);
+    }
+
+    writer.endArray();
+    writer.writeKey("offset");
+    writer.writeInteger(page.offset);
+    writer.writeKey("nextOffset");
+    writer.writeInteger(page.nextOffset);
+    writer.writeKey("size");
+    writer.writeInteger(logReader()->size());
+    writer.endObject();
+    response->setHeader("Cache-Control", "no-cache");
+    response->setHeader("Content-Type", "application/json");
+    response->setHeader("Content-Length", QString::number(json.size()));
+    response->writeHead(QHttpResponse::STATUS_OK);
+    response->end(json);
+}
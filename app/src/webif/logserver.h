@@ -0,0 +1,38 @@
+/*
+ * Copyright (C) 2017 Stuart Howarth <showarth@marxoft.co.uk>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LOGSERVER_H
+#define LOGSERVER_H
+
+class QHttpRequest;
+class QHttpResponse;
+
+/**
+ * Serves pages of the log.
+ *
+ * GET /log?lines=N returns the last N lines. GET /log?offset=N, /log?first=N and /log?since=TIME return up
+ * to limit lines starting at a byte offset, a line number or an ISO 8601 time respectively. The response
+ * contains the lines, the byte offsets of the page and the current size of the log. Clients can follow the
+ * log by requesting /log?offset= with the nextOffset of the previous response.
+ */
+class LogServer
+{
+
+public:    
+    static void handleRequest(QHttpRequest *request, QHttpResponse *response);
+};
+
+#endif // LOGSERVER_H
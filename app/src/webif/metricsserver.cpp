@@ -0,0 +1,37 @@
+/*
+ * Copyright (C) 2017 Stuart Howarth <showarth@marxoft.co.uk>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "metricsserver.h"
+#include "metrics.h"
+#include "qhttprequest.h"
+#include "qhttpresponse.h"
+
+void MetricsServer::handleRequest(QHttpRequest *request, QHttpResponse *response) {
+    if (request->method() == QHttpRequest::HTTP_GET) {
+        // OK
+        const QByteArray text = Metrics::instance()->exposition();
+        response->setHeader("Cache-Control", "no-cache");
+        response->setHeader("Content-Type", "text/plain; version=0.0.4");
+        response->setHeader("Content-Length", QString::number(text.size()));
+        response->writeHead(QHttpResponse::STATUS_OK);
+        response->end(text);
+    }
+    else {
+        // Method not allowed
+        response->writeHead(QHttpResponse::STATUS_METHOD_NOT_ALLOWED);
+        response->end();
+    }
+}
@@ -0,0 +1,58 @@
+/*
+ * Copyright (C) 2017 Stuart Howarth <showarth@marxoft.co.uk>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "requestbody.h"
+#include "json.h"
+#include "jsonreader.h"
+#include "logger.h"
+#include "qhttprequest.h"
+#include "requestbody.h"
+#include <QFile>
+#include <climits>
+
+QVariant RequestBody::parseJson(QHttpRequest *request) {
+    QFile *file = qobject_cast<QFile*>(request->bodyFile());
+
+    if (!file) {
+        return RequestBody::parseJson(request);
+    }
+
+    const qint64 size = file->size();
+
+    if ((size <= 0) || (size > INT_MAX)) {
+        return QVariant();
+    }
+
+    uchar *data = file->map(0, size);
+
+    if (!data) {
+        // Reading the file into memory instead would defeat the limit on in-memory bodies
+        Logger::log("RequestBody::parseJson(): Cannot map request body: " + file->errorString());
+        return QVariant();
+    }
+
+    QtJson::JsonReader reader;
+    const QVariant result = reader.parse(reinterpret_cast<const char*>(data), int(size));
+    file->unmap(data);
+
+    if (reader.hasError()) {
+        Logger::log("RequestBody::parseJson(): Error parsing request body: " + reader.errorString(),
+                    Logger::MediumVerbosity);
+        return QVariant();
+    }
+
+    return result;
+}
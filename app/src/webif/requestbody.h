@@ -0,0 +1,38 @@
+/*
+ * Copyright (C) 2017 Stuart Howarth <showarth@marxoft.co.uk>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef REQUESTBODY_H
+#define REQUESTBODY_H
+
+#include <QVariant>
+
+class QHttpRequest;
+
+/**
+ * Reads request bodies without holding bodies that were stored in a temporary file in memory.
+ */
+class RequestBody
+{
+
+public:
+    /**
+     * Parses the body of request as JSON. A body stored in a temporary file is mapped and parsed in place,
+     * so the limit on in-memory bodies also holds for the handlers. Returns an invalid QVariant on error.
+     */
+    static QVariant parseJson(QHttpRequest *request);
+};
+
+#endif // REQUESTBODY_H
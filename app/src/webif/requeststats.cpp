@@ -0,0 +1,122 @@
+/*
+ * Copyright (C) 2017 Stuart Howarth <showarth@marxoft.co.uk>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "requeststats.h"
+#include "json.h"
+#include "metrics.h"
+#include "qhttprequest.h"
+#include "qhttpresponse.h"
+#include <QThreadPool>
+
+// The number of recent requests of each kind used to calculate percentiles
+static const int MAX_SAMPLES = 1000;
+
+RequestStats* RequestStats::self = 0;
+
+RequestStats::RequestStats() :
+    QObject(),
+    m_readCount(0),
+    m_writeCount(0)
+{
+}
+
+RequestStats::~RequestStats() {
+    self = 0;
+}
+
+RequestStats* RequestStats::instance() {
+    return self ? self : self = new RequestStats;
+}
+
+void RequestStats::handleRequest(QHttpRequest *request, QHttpResponse *response) {
+    if (request->method() == QHttpRequest::HTTP_GET) {
+        // OK
+        const QByteArray json = QtJson::Json::serialize(instance()->stats());
+        response->setHeader("Cache-Control", "no-cache");
+        response->setHeader("Content-Type", "application/json");
+        response->setHeader("Content-Length", QString::number(json.size()));
+        response->writeHead(QHttpResponse::STATUS_OK);
+        response->end(json);
+    }
+    else {
+        // Method not allowed
+        response->writeHead(QHttpResponse::STATUS_METHOD_NOT_ALLOWED);
+        response->end();
+    }
+}
+
+void RequestStats::addRequest(QHttpRequest *request, QHttpResponse *response, const QString &route) {
+    Pending pending;
+    pending.timer.start();
+    pending.labels = Metrics::label("route", route) + "," + Metrics::label("method", request->methodString().mid(5));
+    pending.write = (request->method() != QHttpRequest::HTTP_GET) && (request->method() != QHttpRequest::HTTP_HEAD);
+    m_pending.insert(response, pending);
+    connect(response, SIGNAL(done()), this, SLOT(onResponseDone()));
+}
+
+QVariantMap RequestStats::stats() const {
+    QVariantMap workers;
+    workers["activeThreads"] = QThreadPool::globalInstance()->activeThreadCount();
+    workers["maxThreads"] = QThreadPool::globalInstance()->maxThreadCount();
+    QVariantMap result;
+    result["read"] = percentiles(m_readSamples, m_readCount);
+    result["write"] = percentiles(m_writeSamples, m_writeCount);
+    result["workers"] = workers;
+    return result;
+}
+
+void RequestStats::onResponseDone() {
+    QHttpResponse *response = static_cast<QHttpResponse*>(sender());
+
+    if (!m_pending.contains(response)) {
+        return;
+    }
+
+    const Pending pending = m_pending.take(response);
+    const qint64 elapsed = pending.timer.elapsed();
+    QList<qint64> &samples = pending.write ? m_writeSamples : m_readSamples;
+    samples << elapsed;
+    Metrics::instance()->observe("qdl_http_request_duration_seconds", pending.labels, elapsed / 1000.0);
+
+    if (samples.size() > MAX_SAMPLES) {
+        samples.removeFirst();
+    }
+
+    if (pending.write) {
+        m_writeCount++;
+    }
+    else {
+        m_readCount++;
+    }
+}
+
+// Returns the count and the 50th, 90th and 99th percentile and maximum latencies in milliseconds
+QVariantMap RequestStats::percentiles(QList<qint64> samples, qint64 count) {
+    QVariantMap result;
+    result["count"] = count;
+
+    if (samples.isEmpty()) {
+        return result;
+    }
+
+    qSort(samples);
+    const int last = samples.size() - 1;
+    result["p50"] = samples.at(last * 50 / 100);
+    result["p90"] = samples.at(last * 90 / 100);
+    result["p99"] = samples.at(last * 99 / 100);
+    result["max"] = samples.at(last);
+    return result;
+}
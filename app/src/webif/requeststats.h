@@ -0,0 +1,72 @@
+/*
+ * Copyright (C) 2017 Stuart Howarth <showarth@marxoft.co.uk>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef REQUESTSTATS_H
+#define REQUESTSTATS_H
+
+#include <QObject>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QVariantMap>
+
+class QHttpRequest;
+class QHttpResponse;
+
+/**
+ * Measures the time taken to complete each web interface request, from dispatch until the response is done,
+ * and reports percentiles over the most recent requests. Requests using the GET or HEAD method are counted as
+ * reads, and others as writes. Each latency is also added to the request duration histogram for its route.
+ */
+class RequestStats : public QObject
+{
+    Q_OBJECT
+
+public:
+    ~RequestStats();
+
+    static RequestStats* instance();
+
+    static void handleRequest(QHttpRequest *request, QHttpResponse *response);
+
+    void addRequest(QHttpRequest *request, QHttpResponse *response, const QString &route);
+
+    QVariantMap stats() const;
+
+private Q_SLOTS:
+    void onResponseDone();
+
+private:
+    struct Pending {
+        QElapsedTimer timer;
+        QString labels;
+        bool write;
+    };
+
+    RequestStats();
+
+    static QVariantMap percentiles(QList<qint64> samples, qint64 count);
+
+    static RequestStats *self;
+
+    QHash<QHttpResponse*, Pending> m_pending;
+
+    QList<qint64> m_readSamples;
+    QList<qint64> m_writeSamples;
+    qint64 m_readCount;
+    qint64 m_writeCount;
+};
+
+#endif // REQUESTSTATS_H
@@ -0,0 +1,96 @@
+/*
+ * Copyright (C) 2017 Stuart Howarth <showarth@marxoft.co.uk>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "requestworker.h"
+#include "qhttprequest.h"
+#include "qhttpresponse.h"
+#include "transfersnapshot.h"
+#include "transferstreamer.h"
+#include <QThreadPool>
+
+// Larger lists are streamed uncompressed, so that they are never held in memory in full
+static const int MAX_COMPRESSED_SIZE = 1048576;
+
+RequestWorker::RequestWorker(Handler handler, QHttpRequest *request, QHttpResponse *response,
+                             QSharedPointer<const TransferSnapshot> snapshot) :
+    QObject(),
+    QRunnable(),
+    m_handler(handler),
+    m_url(request->url()),
+    m_httpVersion(request->httpVersion()),
+    m_headers(request->headers()),
+    m_response(response),
+    m_snapshot(snapshot),
+    m_compressible(response->acceptedEncodings() != QHttpResponse::ENCODING_NONE)
+{
+    // The worker is deleted in the main thread, once the reply has been written
+    setAutoDelete(false);
+    connect(this, SIGNAL(finished()), this, SLOT(writeReply()), Qt::QueuedConnection);
+}
+
+void RequestWorker::start(Handler handler, QHttpRequest *request, QHttpResponse *response) {
+    QThreadPool::globalInstance()->start(new RequestWorker(handler, request, response, TransferSnapshot::current()));
+}
+
+void RequestWorker::run() {
+    m_handler(m_url, m_headers, *m_snapshot, m_reply);
+
+    if (m_reply.streamer) {
+        // Chunked bodies are sent uncompressed, so serialize the body here if it is small enough, and let end()
+        // compress it
+        if ((m_compressible) && (m_reply.streamer->readAll(m_reply.body, MAX_COMPRESSED_SIZE))) {
+            m_reply.headers << qMakePair(QString("Content-Length"), QString::number(m_reply.body.size()));
+            delete m_reply.streamer;
+            m_reply.streamer = 0;
+        }
+        else {
+            if (m_compressible) {
+                m_reply.headers << qMakePair(QString("Vary"), QString("Accept-Encoding"));
+            }
+
+            // The streamer is driven by the response's signals in the main thread
+            m_reply.streamer->moveToThread(thread());
+        }
+    }
+
+    emit finished();
+}
+
+void RequestWorker::writeReply() {
+    if (m_response) {
+        for (int i = 0; i < m_reply.headers.size(); i++) {
+            m_response->setHeader(m_reply.headers.at(i).first, m_reply.headers.at(i).second);
+        }
+
+        if (m_reply.streamer) {
+            if (m_httpVersion == "1.1") {
+                m_response->setHeader("Transfer-Encoding", "chunked");
+            }
+
+            m_response->writeHead(m_reply.status);
+            m_reply.streamer->start(m_response);
+        }
+        else {
+            m_response->writeHead(m_reply.status);
+            m_response->end(m_reply.body);
+        }
+    }
+    else if (m_reply.streamer) {
+        delete m_reply.streamer;
+    }
+
+    deleteLater();
+}
@@ -0,0 +1,86 @@
+/*
+ * Copyright (C) 2017 Stuart Howarth <showarth@marxoft.co.uk>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef REQUESTWORKER_H
+#define REQUESTWORKER_H
+
+#include "qhttpserverfwd.h"
+#include <QObject>
+#include <QPair>
+#include <QPointer>
+#include <QRunnable>
+#include <QSharedPointer>
+#include <QUrl>
+
+class TransferSnapshot;
+class TransferStreamer;
+
+/**
+ * Serves a read-only request in a worker thread, using a snapshot of the transfer model. Only the
+ * request URL and headers are read in the worker thread. The reply is written to the response in the
+ * main thread once it is ready.
+ */
+class RequestWorker : public QObject, public QRunnable
+{
+    Q_OBJECT
+
+public:
+    struct Reply {
+        Reply() : status(200), streamer(0) {}
+
+        int status;
+        QList<QPair<QString, QString> > headers;
+        QByteArray body;
+
+        /**
+         * If set, the body is written to the response by the streamer instead, using chunked transfer
+         * encoding where the client supports it. If the client accepts a compressed response and the body is
+         * no larger than 1 MB, it is serialized in full in the worker thread instead, so that it can be compressed.
+         */
+        TransferStreamer *streamer;
+    };
+
+    typedef void (*Handler)(const QUrl &url, const HeaderHash &headers, const TransferSnapshot &snapshot,
+                            Reply &reply);
+
+    RequestWorker(Handler handler, QHttpRequest *request, QHttpResponse *response,
+                  QSharedPointer<const TransferSnapshot> snapshot);
+
+    /**
+     * Runs the worker in the global thread pool.
+     */
+    static void start(Handler handler, QHttpRequest *request, QHttpResponse *response);
+
+    virtual void run();
+
+Q_SIGNALS:
+    void finished();
+
+private Q_SLOTS:
+    void writeReply();
+
+private:
+    Handler m_handler;
+    QUrl m_url;
+    QString m_httpVersion;
+    HeaderHash m_headers;
+    QPointer<QHttpResponse> m_response;
+    QSharedPointer<const TransferSnapshot> m_snapshot;
+    bool m_compressible;
+    Reply m_reply;
+};
+
+#endif // REQUESTWORKER_H
@@ -19,6 +19,7 @@
 #include "qdl.h"
 #include "qhttprequest.h"
 #include "qhttpresponse.h"
+#include "requestbody.h"
 #include "utils.h"
 
 void ServiceServer::handleRequest(QHttpRequest *request, QHttpResponse *response) {
@@ -107,7 +108,7 @@ void ServiceServer::handleRequest(QHttpRequest *request, QHttpResponse *response
             const QString id = Utils::urlQueryItemValue(request->url(), "id");
 
             if (!id.isEmpty()) {
-                const QVariantMap settings = QtJson::Json::parse(request->body()).toMap();
+                const QVariantMap settings = RequestBody::parseJson(request).toMap();
 
                 if (Qdl::setServicePluginSettings(id, settings)) {
                     // OK
@@ -19,6 +19,7 @@
 #include "qdl.h"
 #include "qhttprequest.h"
 #include "qhttpresponse.h"
+#include "requestbody.h"
 
 void SettingsServer::handleRequest(QHttpRequest *request, QHttpResponse *response) {
      const QString method = request->path().mid(request->path().lastIndexOf("/") + 1).toLower();   
@@ -43,7 +44,7 @@ void SettingsServer::handleRequest(QHttpRequest *request, QHttpResponse *respons
      else if (method == "setsettings") {
          // Set settings
          if (request->method() == QHttpRequest::HTTP_PUT) {
-             const QVariantMap settings = QtJson::Json::parse(request->body()).toMap();
+             const QVariantMap settings = RequestBody::parseJson(request).toMap();
 
              if ((!settings.isEmpty()) && (Qdl::setSettings(settings))) {
                  // OK
@@ -0,0 +1,215 @@
+/*
+ * Copyright (C) 2017 Stuart Howarth <showarth@marxoft.co.uk>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "transferfileserver.h"
+#include "fileserver.h"
+#include "filestreamer.h"
+#include "logger.h"
+#include "qhttprequest.h"
+#include "qhttpresponse.h"
+#include "transfermodel.h"
+#include "utils.h"
+#include <QFile>
+#include <QFileInfo>
+
+// The number of completed transfers whose files remain available after their package is removed
+static const int MAX_COMPLETED_TRANSFERS = 100;
+
+static TransferItem* findTransfer(const QString &id) {
+    const TransferItem *root = TransferModel::instance()->get(QModelIndex());
+
+    if (!root) {
+        return 0;
+    }
+
+    for (int i = 0; i < root->rowCount(); i++) {
+        const TransferItem *package = root->childItem(i);
+
+        for (int j = 0; j < package->rowCount(); j++) {
+            TransferItem *transfer = package->childItem(j);
+
+            if (transfer->data(TransferItem::IdRole) == id) {
+                return transfer;
+            }
+        }
+    }
+
+    return 0;
+}
+
+static void writeError(QHttpResponse *response, int status) {
+    response->setHeader("Content-Length", "0");
+    response->writeHead(status);
+    response->end();
+}
+
+TransferFileServer* TransferFileServer::self = 0;
+
+TransferFileServer::TransferFileServer() :
+    QObject()
+{
+    connect(TransferModel::instance(), SIGNAL(itemDataChanged(TransferItem*, int)),
+            this, SLOT(onItemDataChanged(TransferItem*, int)));
+}
+
+TransferFileServer::~TransferFileServer() {
+    self = 0;
+}
+
+TransferFileServer* TransferFileServer::instance() {
+    return self ? self : self = new TransferFileServer;
+}
+
+void TransferFileServer::handleRequest(QHttpRequest *request, QHttpResponse *response) {
+    if ((request->method() != QHttpRequest::HTTP_GET) && (request->method() != QHttpRequest::HTTP_HEAD)) {
+        // Method not allowed
+        writeError(response, QHttpResponse::STATUS_METHOD_NOT_ALLOWED);
+        return;
+    }
+
+    const QString id = request->path().section("/", 2, 2);
+    TransferItem *transfer = findTransfer(id);
+    QString filePath;
+    bool growing = false;
+    qint64 totalSize = -1;
+
+    if (transfer) {
+        filePath = transfer->data(TransferItem::FilePathRole).toString();
+        growing = transfer->data(TransferItem::StatusRole) != TransferItem::Completed;
+        totalSize = transfer->data(TransferItem::SizeRole).toLongLong();
+    }
+    else {
+        filePath = instance()->completedFilePath(id);
+    }
+
+    if (filePath.isEmpty()) {
+        // Not found
+        writeError(response, QHttpResponse::STATUS_NOT_FOUND);
+        return;
+    }
+
+    QFile *file = new QFile(filePath);
+    QIODevice::OpenMode mode = QFile::ReadOnly;
+
+    if (growing) {
+        // Reads must reach the disk, so that data written after the file was opened is seen
+        mode |= QFile::Unbuffered;
+    }
+
+    if (!file->open(mode)) {
+        // Not found, as the file is not created until the transfer starts
+        Logger::log("TransferFileServer::handleRequest(): Cannot open file " + filePath, Logger::MediumVerbosity);
+        delete file;
+        writeError(response, QHttpResponse::STATUS_NOT_FOUND);
+        return;
+    }
+
+    // Only the prefix that has already been written is served
+    const qint64 available = file->size();
+
+    if ((!growing) || (totalSize < available)) {
+        totalSize = available;
+    }
+
+    // Only a transfer that is downloading can be followed. Others may not write anything for a long time
+    const bool follow = (growing) && (transfer->data(TransferItem::StatusRole) == TransferItem::Downloading)
+                        && (Utils::urlQueryItemValue(request->url(), "follow") == "true");
+    const QString rangeHeader = request->header("range");
+    const QString suffix = QFileInfo(filePath).suffix();
+    response->setHeader("Content-Type", suffix.isEmpty() ? QString("application/octet-stream")
+                                                         : FileServer::contentType(filePath));
+    response->setHeader("Content-Disposition", QString("inline; filename=\"%1\"")
+                        .arg(QFileInfo(filePath).fileName().replace("\"", "")));
+    response->setHeader("Accept-Ranges", "bytes");
+    response->setHeader("Cache-Control", "no-cache");
+    qint64 offset = 0;
+    qint64 length = available;
+    // A followed transfer is served up to its expected size, waiting for data that has not been written yet
+    const qint64 rangeSize = follow ? totalSize : available;
+
+    if (!FileServer::parseRange(rangeHeader, rangeSize, offset, length)) {
+        // Range not satisfiable
+        delete file;
+        response->setHeader("Content-Range", QString("bytes */%1").arg(available));
+        writeError(response, QHttpResponse::STATUS_REQUESTED_RANGE_NOT_SATISFIABLE);
+        return;
+    }
+
+    if ((follow) && (totalSize <= available) && (offset + length >= available)) {
+        // The size is not known yet, so the file is streamed until the transfer is finished
+        length = -1;
+    }
+
+    const bool partial = (offset > 0) || ((length >= 0) && (length < totalSize));
+    const int status = ((partial) && (!rangeHeader.isEmpty())) ? QHttpResponse::STATUS_PARTIAL_CONTENT
+                                                                : QHttpResponse::STATUS_OK;
+
+    if (status == QHttpResponse::STATUS_PARTIAL_CONTENT) {
+        const qint64 last = length >= 0 ? offset + length - 1 : totalSize - 1;
+        response->setHeader("Content-Range", QString("bytes %1-%2/%3").arg(offset).arg(last)
+                            .arg(growing ? (totalSize > available ? QString::number(totalSize) : QString("*"))
+                                         : QString::number(totalSize)));
+    }
+
+    if ((length >= 0) && (!follow)) {
+        // A followed response is delimited by closing the connection, as the transfer may stop early
+        response->setHeader("Content-Length", QString::number(length));
+    }
+
+    // OK
+    response->writeHead(status);
+
+    if ((request->method() == QHttpRequest::HTTP_HEAD) || (length == 0)) {
+        delete file;
+        response->end();
+        return;
+    }
+
+    FileStreamer *streamer = new FileStreamer(file, offset, length, response);
+
+    if (follow) {
+        streamer->follow(transfer);
+    }
+
+    streamer->start();
+}
+
+QString TransferFileServer::completedFilePath(const QString &id) const {
+    return m_completed.value(id);
+}
+
+void TransferFileServer::onItemDataChanged(TransferItem *item, int role) {
+    if ((role != TransferItem::StatusRole) || (item->itemType() != TransferItem::PackageType)
+        || (item->data(TransferItem::StatusRole) != TransferItem::Completed)) {
+        return;
+    }
+
+    // Completed packages are removed from the model, so the final file paths are remembered here
+    for (int i = 0; i < item->rowCount(); i++) {
+        const TransferItem *transfer = item->childItem(i);
+        const QString id = transfer->data(TransferItem::IdRole).toString();
+
+        if (!m_completed.contains(id)) {
+            m_completedIds << id;
+        }
+
+        m_completed[id] = transfer->data(TransferItem::FilePathRole).toString();
+    }
+
+    while (m_completedIds.size() > MAX_COMPLETED_TRANSFERS) {
+        m_completed.remove(m_completedIds.takeFirst());
+    }
+}
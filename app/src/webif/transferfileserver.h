@@ -0,0 +1,53 @@
+/*
+ * Copyright (C) 2017 Stuart Howarth <showarth@marxoft.co.uk>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TRANSFERFILESERVER_H
+#define TRANSFERFILESERVER_H
+
+#include <QObject>
+#include <QHash>
+#include <QStringList>
+
+class TransferItem;
+class QHttpRequest;
+class QHttpResponse;
+
+class TransferFileServer : public QObject
+{
+    Q_OBJECT
+
+public:
+    ~TransferFileServer();
+
+    static TransferFileServer* instance();
+
+    static void handleRequest(QHttpRequest *request, QHttpResponse *response);
+
+private Q_SLOTS:
+    void onItemDataChanged(TransferItem *item, int role);
+
+private:
+    TransferFileServer();
+
+    QString completedFilePath(const QString &id) const;
+
+    static TransferFileServer *self;
+
+    QHash<QString, QString> m_completed;
+    QStringList m_completedIds;
+};
+
+#endif // TRANSFERFILESERVER_H
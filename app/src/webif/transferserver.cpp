@@ -19,15 +19,168 @@
 #include "qdl.h"
 #include "qhttprequest.h"
 #include "qhttpresponse.h"
+#include "requestbody.h"
+#include "transferquery.h"
+#include "transfersnapshot.h"
+#include "transferstreamer.h"
 #include "utils.h"
 
+// Returns the fields, sort and filter parameters of a transfer query
+static QVariantMap transferQuery(const QUrl &url) {
+    QVariantMap query = Utils::urlQueryItemMap(url);
+    query.remove("hits");
+    query.remove("includeChildren");
+    query.remove("limit");
+    query.remove("offset");
+    query.remove("property");
+    query.remove("since");
+    query.remove("value");
+    return query;
+}
+
+static void setJson(RequestWorker::Reply &reply, const QVariant &data) {
+    reply.body = QtJson::Json::serialize(data);
+    reply.headers << qMakePair(QString("Content-Type"), QString("application/json"));
+    reply.headers << qMakePair(QString("Content-Length"), QString::number(reply.body.size()));
+}
+
+// Streams the packages from the main thread, so that the list is never serialized in full
+static void setJsonStream(RequestWorker::Reply &reply, const TransferQuery &query,
+                          const TransferQuery::Selection &packages) {
+    reply.streamer = new TransferStreamer(query, packages);
+    reply.headers << qMakePair(QString("Content-Type"), QString("application/json"));
+}
+
+static QVariantMap getTransfersSince(const TransferSnapshot &snapshot, qint64 revision, const QVariantMap &query) {
+    // Only the projection applies, since items that stop matching a filter could not be reported
+    TransferQuery projection;
+    projection.setFields(TransferQuery(query).fields());
+    const QStringList fields = projection.fields();
+    const bool reset = !snapshot.hasRevisionHistory(revision);
+
+    if (reset) {
+        // The requested revision is unknown, so return everything
+        revision = 0;
+    }
+
+    QVariantList transfers;
+
+    foreach (const QString &packageId, snapshot.packageIds()) {
+        if (snapshot.itemRevision(packageId) > revision) {
+            QVariantMap item = projection.itemData(snapshot.itemData(packageId, fields));
+            item["parentId"] = QString();
+            transfers << item;
+        }
+
+        foreach (const QString &transferId, snapshot.childIds(packageId)) {
+            if (snapshot.itemRevision(transferId) > revision) {
+                QVariantMap item = projection.itemData(snapshot.itemData(transferId, fields));
+                item["parentId"] = packageId;
+                transfers << item;
+            }
+        }
+    }
+
+    QVariantMap result;
+    result["revision"] = snapshot.revision();
+    result["reset"] = reset;
+    result["transfers"] = transfers;
+    result["removed"] = reset ? QStringList() : snapshot.removedSince(revision);
+    return result;
+}
+
+void TransferServer::handleSnapshotRequest(const QUrl &url, const HeaderHash &headers,
+                                           const TransferSnapshot &snapshot, RequestWorker::Reply &reply) {
+    const QString method = url.path().mid(url.path().lastIndexOf("/") + 1).toLower();
+
+    if (method == "gettransfers") {
+        // Get transfers
+        // The model revision identifies the state of every transfer, so it serves as the entity tag
+        const QString etag = QString("\"%1\"").arg(snapshot.revision());
+        reply.headers << qMakePair(QString("ETag"), etag);
+
+        if (headers.value("if-none-match") == etag) {
+            // Not modified
+            reply.headers << qMakePair(QString("Content-Length"), QString("0"));
+            reply.status = QHttpResponse::STATUS_NOT_MODIFIED;
+            return;
+        }
+
+        // OK
+        const QString since = Utils::urlQueryItemValue(url, "since");
+        reply.headers << qMakePair(QString("Cache-Control"), QString("no-cache"));
+
+        if (!since.isEmpty()) {
+            setJson(reply, getTransfersSince(snapshot, since.toLongLong(), transferQuery(url)));
+        }
+        else {
+            const int offset = Utils::urlQueryItemValue(url, "offset", "0").toInt();
+            const int limit = Utils::urlQueryItemValue(url, "limit", "-1").toInt();
+            const TransferQuery query(transferQuery(url));
+            setJsonStream(reply, query, query.select(snapshot, offset, limit));
+        }
+    }
+    else if (method == "gettransfersstatus") {
+        // Get transfers status
+        // OK
+        setJson(reply, snapshot.status());
+    }
+    else if (method == "gettransfer") {
+        // Get transfer
+        const QString id = Utils::urlQueryItemValue(url, "id");
+
+        if (id.isEmpty()) {
+            // Bad request
+            reply.status = QHttpResponse::STATUS_BAD_REQUEST;
+        }
+        else if (!snapshot.contains(id)) {
+            // Not found
+            reply.status = QHttpResponse::STATUS_NOT_FOUND;
+        }
+        else {
+            // OK
+            QVariantMap transfer = snapshot.itemData(id);
+            QVariantList children;
+
+            foreach (const QString &childId, snapshot.childIds(id)) {
+                children << snapshot.itemData(childId);
+            }
+
+            transfer["children"] = children;
+            setJson(reply, transfer);
+        }
+    }
+    else if (method == "searchtransfers") {
+        // Search transfers
+        const QString property = Utils::urlQueryItemValue(url, "property");
+
+        if (!property.isEmpty()) {
+            // OK
+            const QString value = Utils::urlQueryItemValue(url, "value");
+            const int offset = Utils::urlQueryItemValue(url, "offset", "0").toInt();
+            const int limit = Utils::urlQueryItemValue(url, "limit", "-1").toInt();
+            TransferQuery search(transferQuery(url));
+            search.addFilter(property, QVariantList() << value, true);
+            setJsonStream(reply, search, search.select(snapshot, offset, limit <= 0 ? -1 : limit));
+        }
+        else {
+            // Bad request
+            reply.status = QHttpResponse::STATUS_BAD_REQUEST;
+        }
+    }
+    else {
+        // Bad request
+        reply.status = QHttpResponse::STATUS_BAD_REQUEST;
+    }
+}
+
 void TransferServer::handleRequest(QHttpRequest *request, QHttpResponse *response) {
     const QString method = request->path().mid(request->path().lastIndexOf("/") + 1).toLower();
 
     if (method == "addtransfer") {
         // Add transfer
         if (request->method() == QHttpRequest::HTTP_POST) {
-            const QVariantMap properties = QtJson::Json::parse(request->body()).toMap();
+            const QVariantMap properties = RequestBody::parseJson(request).toMap();
             const QString url = properties.value("url").toString();
 
             if (!url.isEmpty()) {
@@ -64,7 +217,7 @@ void TransferServer::handleRequest(QHttpRequest *request, QHttpResponse *respons
     else if (method == "addtransfers") {
         // Add transfers
         if (request->method() == QHttpRequest::HTTP_POST) {
-            const QVariantMap properties = QtJson::Json::parse(request->body()).toMap();
+            const QVariantMap properties = RequestBody::parseJson(request).toMap();
             const QStringList urls = properties.value("urls").toStringList();
 
             if (!urls.isEmpty()) {
@@ -97,98 +250,11 @@ void TransferServer::handleRequest(QHttpRequest *request, QHttpResponse *respons
             response->end();
         }
     }
-    else if (method == "gettransfers") {
-        // Get transfers
-        if (request->method() == QHttpRequest::HTTP_GET) {
-            // OK
-            const int offset = Utils::urlQueryItemValue(request->url(), "offset", "0").toInt();
-            const int limit = Utils::urlQueryItemValue(request->url(), "limit", "-1").toInt();
-            const QVariantList transfers = Qdl::getTransfers(offset, limit);
-            const QByteArray json = QtJson::Json::serialize(transfers);
-            response->setHeader("Content-Type", "application/json");
-            response->setHeader("Content-Length", QString::number(json.size()));
-            response->writeHead(QHttpResponse::STATUS_OK);
-            response->end(json);
-        }
-        else {
-            // Method not allowed
-            response->writeHead(QHttpResponse::STATUS_METHOD_NOT_ALLOWED);
-            response->end();
-        }
-    }
-    else if (method == "gettransfersstatus") {
-        // Get transfers status
+    else if ((method == "gettransfers") || (method == "gettransfersstatus") || (method == "gettransfer")
+             || (method == "searchtransfers")) {
         if (request->method() == QHttpRequest::HTTP_GET) {
-            // OK
-            const QVariantMap status = Qdl::getTransfersStatus();
-            const QByteArray json = QtJson::Json::serialize(status);
-            response->setHeader("Content-Type", "application/json");
-            response->setHeader("Content-Length", QString::number(json.size()));
-            response->writeHead(QHttpResponse::STATUS_OK);
-            response->end(json);
-        }
-        else {
-            // Method not allowed
-            response->writeHead(QHttpResponse::STATUS_METHOD_NOT_ALLOWED);
-            response->end();
-        }
-    }
-    else if (method == "gettransfer") {
-        // Get transfer
-        if (request->method() == QHttpRequest::HTTP_GET) {
-            const QString id = Utils::urlQueryItemValue(request->url(), "id");
-
-            if (!id.isEmpty()) {
-                const QVariantMap transfer = Qdl::getTransfer(id);
-
-                if (!transfer.isEmpty()) {
-                    // OK
-                    const QByteArray json = QtJson::Json::serialize(transfer);
-                    response->setHeader("Content-Type", "application/json");
-                    response->setHeader("Content-Length", QString::number(json.size()));
-                    response->writeHead(QHttpResponse::STATUS_OK);
-                    response->end(json);
-                }
-                else {
-                    // Not found
-                    response->writeHead(QHttpResponse::STATUS_NOT_FOUND);
-                    response->end();
-                }
-            }
-            else {
-                // Bad request
-                response->writeHead(QHttpResponse::STATUS_BAD_REQUEST);
-                response->end();
-            }
-        }
-        else {
-            // Method not allowed
-            response->writeHead(QHttpResponse::STATUS_METHOD_NOT_ALLOWED);
-            response->end();
-        }
-    }
-    else if (method == "searchtransfers") {
-        // Search transfers
-        if (request->method() == QHttpRequest::HTTP_GET) {
-            const QString property = Utils::urlQueryItemValue(request->url(), "property");
-
-            if (!property.isEmpty()) {
-                // OK
-                const QString value = Utils::urlQueryItemValue(request->url(), "value");
-                const int offset = Utils::urlQueryItemValue(request->url(), "offset", "0").toInt();
-                const int limit = Utils::urlQueryItemValue(request->url(), "limit", "-1").toInt();
-                const QVariantList transfers = Qdl::searchTransfers(property, value, offset, limit);
-                const QByteArray json = QtJson::Json::serialize(transfers);
-                response->setHeader("Content-Type", "application/json");
-                response->setHeader("Content-Length", QString::number(json.size()));
-                response->writeHead(QHttpResponse::STATUS_OK);
-                response->end(json);
-            }
-            else {
-                // Bad request
-                response->writeHead(QHttpResponse::STATUS_BAD_REQUEST);
-                response->end();
-            }
+            // Serialization of large results should not block the main thread
+            RequestWorker::start(handleSnapshotRequest, request, response);
         }
         else {
             // Method not allowed
@@ -202,7 +268,7 @@ void TransferServer::handleRequest(QHttpRequest *request, QHttpResponse *respons
             const QString id = Utils::urlQueryItemValue(request->url(), "id");
 
             if (!id.isEmpty()) {
-                const QVariantMap properties = QtJson::Json::parse(request->body()).toMap();
+                const QVariantMap properties = RequestBody::parseJson(request).toMap();
 
                 if (Qdl::setTransferProperties(id, properties)) {
                     // OK
@@ -327,6 +393,31 @@ void TransferServer::handleRequest(QHttpRequest *request, QHttpResponse *respons
             response->end();
         }
     }
+    else if (method == "batch") {
+        // Apply many operations at once
+        if (request->method() == QHttpRequest::HTTP_POST) {
+            const QVariant operations = RequestBody::parseJson(request);
+
+            if (operations.type() == QVariant::List) {
+                // OK
+                const QByteArray json = QtJson::Json::serialize(Qdl::batchTransfers(operations.toList()));
+                response->setHeader("Content-Type", "application/json");
+                response->setHeader("Content-Length", QString::number(json.size()));
+                response->writeHead(QHttpResponse::STATUS_OK);
+                response->end(json);
+            }
+            else {
+                // Bad request
+                response->writeHead(QHttpResponse::STATUS_BAD_REQUEST);
+                response->end();
+            }
+        }
+        else {
+            // Method not allowed
+            response->writeHead(QHttpResponse::STATUS_METHOD_NOT_ALLOWED);
+            response->end();
+        }
+    }
     else if (method == "starttransfers") {
         // Start transfers
         if (request->method() == QHttpRequest::HTTP_GET) {
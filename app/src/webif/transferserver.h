@@ -17,6 +17,8 @@
 #ifndef TRANSFERSERVER_H
 #define TRANSFERSERVER_H
 
+#include "requestworker.h"
+
 class QHttpRequest;
 class QHttpResponse;
 
@@ -25,6 +27,10 @@ class TransferServer
 
 public:    
     static void handleRequest(QHttpRequest *request, QHttpResponse *response);
+
+private:
+    static void handleSnapshotRequest(const QUrl &url, const HeaderHash &headers, const TransferSnapshot &snapshot,
+                                      RequestWorker::Reply &reply);
 };
 
 #endif // TRANSFERSERVER_H
@@ -0,0 +1,113 @@
+/*
+ * Copyright (C) 2017 Stuart Howarth <showarth@marxoft.co.uk>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "transferstreamer.h"
+#include "qhttpresponse.h"
+
+static const int CHUNK_SIZE = 16384;
+
+TransferStreamer::TransferStreamer(const TransferQuery &query, const TransferQuery::Selection &packages) :
+    QObject(),
+    m_response(0),
+    m_query(query),
+    m_packages(packages),
+    m_package(-1),
+    m_child(-1),
+    m_writer(&m_buffer)
+{
+}
+
+void TransferStreamer::start(QHttpResponse *response) {
+    m_response = response;
+    connect(response, SIGNAL(writeBufferDrained()), this, SLOT(writeChunks()));
+    connect(response, SIGNAL(done()), this, SLOT(onResponseDone()));
+    writeChunks();
+}
+
+void TransferStreamer::writeChunks() {
+    while ((m_response) && (!m_response->isWriteBufferFull()) && (writeChunk()));
+}
+
+void TransferStreamer::onResponseDone() {
+    m_response = 0;
+    deleteLater();
+}
+
+// Serializes items until the buffer holds at least size bytes. Returns true once the whole list has been written
+bool TransferStreamer::fillBuffer(int size) {
+    if (m_package < 0) {
+        m_writer.beginArray();
+        m_package = 0;
+    }
+
+    while ((m_buffer.size() < size) && (m_package < m_packages.size())) {
+        const TransferQuery::Package &package = m_packages.at(m_package);
+
+        if (m_child < 0) {
+            m_writer.beginObject();
+            m_query.writeItemData(m_writer, package.first);
+            m_writer.writeKey("children");
+            m_writer.beginArray();
+            m_child = 0;
+        }
+        else if (m_child < package.second.size()) {
+            m_writer.beginObject();
+            m_query.writeItemData(m_writer, package.second.at(m_child));
+            m_writer.endObject();
+            ++m_child;
+        }
+        else {
+            m_writer.endArray();
+            m_writer.endObject();
+            // The items have been written, so their data need not be kept
+            m_packages[m_package] = TransferQuery::Package();
+            ++m_package;
+            m_child = -1;
+        }
+    }
+
+    if (m_package == m_packages.size()) {
+        m_writer.endArray();
+        ++m_package;
+    }
+
+    return m_package > m_packages.size();
+}
+
+// Returns false once the whole list has been written
+bool TransferStreamer::writeChunk() {
+    if (fillBuffer(CHUNK_SIZE)) {
+        QHttpResponse *response = m_response;
+        m_response = 0;
+        response->end(m_buffer);
+        return false;
+    }
+
+    m_response->write(m_buffer);
+    m_buffer.resize(0);
+    return true;
+}
+
+bool TransferStreamer::readAll(QByteArray &body, int maxSize) {
+    // Anything serialized here is kept in the buffer, and written first if the list is streamed instead
+    if ((!fillBuffer(maxSize + 1)) || (m_buffer.size() > maxSize)) {
+        return false;
+    }
+
+    body = m_buffer;
+    m_buffer.clear();
+    return true;
+}
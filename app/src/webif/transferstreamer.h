@@ -0,0 +1,69 @@
+/*
+ * Copyright (C) 2017 Stuart Howarth <showarth@marxoft.co.uk>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TRANSFERSTREAMER_H
+#define TRANSFERSTREAMER_H
+
+#include "jsonwriter.h"
+#include "transferquery.h"
+#include <QObject>
+
+class QHttpResponse;
+
+/**
+ * Writes a selection of packages and their children to a response as a JSON array, serializing one item
+ * at a time and pausing whenever the connection's write buffer is full, so that the size of the list
+ * never affects the memory used by the request. The streamer deletes itself when the response is done.
+ */
+class TransferStreamer : public QObject
+{
+    Q_OBJECT
+
+public:
+    TransferStreamer(const TransferQuery &query, const TransferQuery::Selection &packages);
+
+    /**
+     * The response head must already have been written.
+     */
+    void start(QHttpResponse *response);
+
+    /**
+     * Serializes the whole list into body at once, for responses that are compressed, provided that it is no
+     * larger than maxSize bytes. Otherwise returns false, and the list is written by start() instead.
+     */
+    bool readAll(QByteArray &body, int maxSize);
+
+private Q_SLOTS:
+    void writeChunks();
+    void onResponseDone();
+
+private:
+    bool fillBuffer(int size);
+    bool writeChunk();
+
+    QHttpResponse *m_response;
+
+    TransferQuery m_query;
+    TransferQuery::Selection m_packages;
+
+    int m_package;
+    int m_child;
+
+    QByteArray m_buffer;
+    QtJson::JsonWriter m_writer;
+};
+
+#endif // TRANSFERSTREAMER_H
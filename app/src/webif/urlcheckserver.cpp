@@ -19,6 +19,7 @@
 #include "qdl.h"
 #include "qhttprequest.h"
 #include "qhttpresponse.h"
+#include "requestbody.h"
 
 void UrlCheckServer::handleRequest(QHttpRequest *request, QHttpResponse *response) {
     const QString method = request->path().mid(request->path().lastIndexOf("/") + 1).toLower();
@@ -26,7 +27,7 @@ void UrlCheckServer::handleRequest(QHttpRequest *request, QHttpResponse *respons
     if (method == "addchecks") {
         // Add URL checks
         if (request->method() == QHttpRequest::HTTP_POST) {
-            const QVariantMap properties = QtJson::Json::parse(request->body()).toMap();
+            const QVariantMap properties = RequestBody::parseJson(request).toMap();
             const QStringList urls = properties.value("urls").toStringList();
 
             if (!urls.isEmpty()) {
@@ -131,7 +132,7 @@ void UrlCheckServer::handleRequest(QHttpRequest *request, QHttpResponse *respons
     else if (method == "submitsettingsresponse") {
         // Submit settings response
         if (request->method() == QHttpRequest::HTTP_POST) {
-            const QVariantMap settings = QtJson::Json::parse(request->body()).toMap();
+            const QVariantMap settings = RequestBody::parseJson(request).toMap();
 
             if (Qdl::submitUrlCheckSettingsResponse(settings)) {
                 // OK
@@ -19,6 +19,7 @@
 #include "qdl.h"
 #include "qhttprequest.h"
 #include "qhttpresponse.h"
+#include "requestbody.h"
 
 void UrlRetrievalServer::handleRequest(QHttpRequest *request, QHttpResponse *response) {
     const QString method = request->path().mid(request->path().lastIndexOf("/") + 1).toLower();
@@ -26,7 +27,7 @@ void UrlRetrievalServer::handleRequest(QHttpRequest *request, QHttpResponse *res
     if (method == "addretrievals") {
         // Add URL retrievals
         if (request->method() == QHttpRequest::HTTP_POST) {
-            const QVariantMap properties = QtJson::Json::parse(request->body()).toMap();
+            const QVariantMap properties = RequestBody::parseJson(request).toMap();
             const QStringList urls = properties.value("urls").toStringList();
 
             if (!urls.isEmpty()) {
@@ -19,17 +19,36 @@
 #include "clipboardserver.h"
 #include "decaptchaserver.h"
 #include "downloadrequestserver.h"
+#include "eventserver.h"
 #include "fileserver.h"
+#include "logserver.h"
+#include "metricsserver.h"
 #include "qhttprequest.h"
 #include "qhttpresponse.h"
 #include "qhttpserver.h"
 #include "recaptchaserver.h"
+#include "requeststats.h"
 #include "searchserver.h"
 #include "serviceserver.h"
 #include "settingsserver.h"
+#include "transferfileserver.h"
+#include "transfermetrics.h"
 #include "transferserver.h"
 #include "urlcheckserver.h"
 #include "urlretrievalserver.h"
+#include <QStringList>
+
+// Requests with larger headers or bodies are rejected
+static const int MAX_HEADER_SIZE = 65536;
+static const qint64 MAX_BODY_SIZE = 33554432;
+// Larger request bodies are stored in a temporary file while they are received
+static const qint64 BODY_FILE_THRESHOLD = 1048576;
+
+// Requests to other paths are for static files, which share one route in the request metrics
+static const QStringList ROUTES = QStringList() << "batch" << "categories" << "clipboard" << "decaptcha"
+                                                << "downloadrequests" << "log" << "metrics" << "recaptcha"
+                                                << "search" << "services" << "settings" << "stats"
+                                                << "transfers" << "urlchecks" << "urlretrievals";
 
 WebServer* WebServer::self = 0;
 
@@ -151,8 +170,15 @@ void WebServer::stop() {
 void WebServer::init() {
     if (!m_server) {
         m_server = new QHttpServer(this);
+        m_server->setMaxHeaderSize(MAX_HEADER_SIZE);
+        m_server->setMaxBodySize(MAX_BODY_SIZE);
+        m_server->setBodyFileThreshold(BODY_FILE_THRESHOLD);
         connect(m_server, SIGNAL(newRequest(QHttpRequest*,QHttpResponse*)),
                 this, SLOT(onNewRequest(QHttpRequest*,QHttpResponse*)));
+        // Completed files must be recorded before any are requested
+        TransferFileServer::instance();
+        // Metrics are maintained as transfers change, rather than when they are requested
+        TransferMetrics::instance();
     }
 }
 
@@ -168,6 +194,7 @@ void WebServer::onNewRequest(QHttpRequest *request, QHttpResponse *response) {
         }
     }
 
+    response->setAcceptEncoding(request->header("accept-encoding"));
     request->storeBody();
     
     if (request->successful()) {
@@ -193,13 +220,21 @@ void WebServer::onRequestEnd() {
     }
     
     m_requests.remove(request);
-    handleRequest(request, response);
+
+    if (request->successful()) {
+        handleRequest(request, response);
+    }
 }
 
 void WebServer::handleRequest(QHttpRequest *request, QHttpResponse *response) {
     const QString server = request->path().section("/", 1, 1).toLower();
 
-    if (server == "transfers") {
+    if ((server != "events") && (server != "files")) {
+        // Streams are excluded, since they last as long as the client wants
+        RequestStats::instance()->addRequest(request, response, ROUTES.contains(server) ? server : QString("static"));
+    }
+
+    if ((server == "transfers") || (server == "batch")) {
         TransferServer::handleRequest(request, response);
     }
     else if (server == "categories") {
@@ -214,9 +249,24 @@ void WebServer::handleRequest(QHttpRequest *request, QHttpResponse *response) {
     else if (server == "downloadrequests") {
         DownloadRequestServer::handleRequest(request, response);
     }
+    else if (server == "events") {
+        EventServer::handleRequest(request, response);
+    }
+    else if (server == "files") {
+        TransferFileServer::handleRequest(request, response);
+    }
+    else if (server == "log") {
+        LogServer::handleRequest(request, response);
+    }
+    else if (server == "metrics") {
+        MetricsServer::handleRequest(request, response);
+    }
     else if (server == "recaptcha") {
         RecaptchaServer::handleRequest(request, response);
     }
+    else if (server == "stats") {
+        RequestStats::handleRequest(request, response);
+    }
     else if (server == "search") {
         SearchServer::handleRequest(request, response);
     }
@@ -22,6 +22,7 @@ var currentServicePlugin = "";
 var currentRecaptchaPlugin = "";
 var currentDecaptchaPlugin = "";
 var requestId = "";
+var transferCache = {};
 var requestedSettings = {};
 
 function init() {
@@ -178,6 +179,9 @@ function init() {
         cancelSettingsDialog();
         var settings = {};
         settings["maximumConcurrentTransfers"] = document.getElementById("concurrentTransfersSelector").value;
+        settings["adaptiveConcurrentTransfers"] = document.getElementById("adaptiveCheckBox").checked;
+        settings["minimumConcurrentTransfers"] =
+            document.getElementById("minimumConcurrentTransfersSelector").value;
         settings["startTransfersAutomatically"] = document.getElementById("automaticCheckBox").checked;
         settings["createSubfolders"] = document.getElementById("subfoldersCheckBox").checked;
         settings["extractArchives"] = document.getElementById("extractArchivesCheckBox").checked;
@@ -186,6 +190,7 @@ function init() {
     }
     
     loadTransfers(0, -1);
+    listenForEvents();
 }
 
 function loadTransfers(offset, limit) {
@@ -202,6 +207,115 @@ function loadTransfers(offset, limit) {
     });
 }
 
+function reloadTransfers() {
+    var list = document.getElementById("transfersTable");
+    
+    while (list.firstChild) {
+        list.removeChild(list.firstChild);
+    }
+    
+    transferCache = {};
+    loadTransfers(0, -1);
+}
+
+function insertChangedTransfer(transfer) {
+    if (!transfer.parentId) {
+        insertTransfer(transfer);
+        return;
+    }
+    
+    // Child transfers are only shown while their package is expanded
+    var parent = document.getElementById(transfer.parentId);
+    
+    if ((parent) && (parent.getAttribute("data-expanded") == "true")) {
+        var next = parent.nextSibling;
+        
+        while ((next) && (next.getAttribute("data-itemtype") == TransferItemType.TransferType)) {
+            next = next.nextSibling;
+        }
+        
+        insertTransfer(transfer, next);
+    }
+}
+
+function removeTransfers(ids) {
+    for (var i = 0; i < ids.length; i++) {
+        var row = document.getElementById(ids[i]);
+        
+        if (row) {
+            removeTransfer(row);
+        }
+    }
+}
+
+function listenForEvents() {
+    var source = qdl.listen({
+        "inserted": function (transfers) {
+            for (var i = 0; i < transfers.length; i++) {
+                insertChangedTransfer(transfers[i]);
+            }
+        },
+        "removed": removeTransfers,
+        "moved": reloadTransfers,
+        "reset": reloadTransfers,
+        "changed": function (changes) {
+            for (var id in changes) {
+                var transfer = transferCache[id];
+                
+                if (transfer) {
+                    var properties = changes[id];
+                    
+                    for (var property in properties) {
+                        transfer[property] = properties[property];
+                    }
+                    
+                    updateTransfer(transfer);
+                }
+            }
+        },
+        "status": function (status) {
+            document.getElementById("activeLabel").innerHTML = status.activeTransfers + "DLs";
+            document.getElementById("speedLabel").innerHTML = status.totalSpeedString;
+        },
+        "captcha": function (transfer) {
+            showCaptchaDialog(transfer);
+        },
+        "settings": function (transfer) {
+            showSettingsRequestDialog(transfer);
+        }
+    });
+    
+    if (!source) {
+        // No server-push support, so fall back to polling for changes
+        var revision = 0;
+        setInterval(function () {
+            qdl.getTransfersSince(revision, function (result) {
+                if ((result.reset) && (revision > 0)) {
+                    reloadTransfers();
+                }
+                else {
+                    removeTransfers(result.removed);
+                    var transfers = result.transfers;
+                    
+                    for (var i = 0; i < transfers.length; i++) {
+                        var transfer = transfers[i];
+                        
+                        if (transferCache[transfer.id]) {
+                            transferCache[transfer.id] = transfer;
+                            updateTransfer(transfer);
+                        }
+                        else {
+                            insertChangedTransfer(transfer);
+                        }
+                    }
+                }
+                
+                revision = result.revision;
+            });
+        }, 5000);
+    }
+}
+
 function showChildTransfers(row) {
     row.setAttribute("data-expanded", "true");
     row.childNodes[0].innerHTML = "-";
@@ -218,6 +332,7 @@ function hideChildTransfers(row) {
     var next = row.nextSibling;
         
     while ((next) && (next.getAttribute("data-itemtype") == TransferItemType.TransferType)) {        
+        delete transferCache[next.id];
         row.parentNode.removeChild(next);
         next = row.nextSibling;
     }
@@ -233,6 +348,7 @@ function toggleRowExpanded(row) {
 }
 
 function insertTransfer(transfer, before) {
+    transferCache[transfer.id] = transfer;
     var table = document.getElementById("transfersTable");
     var row = document.createElement("li");
     row.setAttribute("class", "TableRow");
@@ -319,6 +435,8 @@ function insertTransfer(transfer, before) {
 }
 
 function removeTransfer(row) {
+    delete transferCache[row.id];
+    
     if (row.getAttribute("data-expanded") == "true") {
         hideChildTransfers(row);
     }
@@ -331,6 +449,9 @@ function updateTransfer(transfer) {
         
     if (row) {
         row.setAttribute("title", transfer.name);
+        row.setAttribute("data-cancancel", transfer.canCancel);
+        row.setAttribute("data-canpause", transfer.canPause);
+        row.setAttribute("data-canstart", transfer.canStart);
         row.setAttribute("data-priority", transfer.priority);
         row.setAttribute("data-status", transfer.status);
         
@@ -812,10 +933,15 @@ function showSettingsDialog() {
     document.getElementById("popupBackground").style.display = "block";
     document.getElementById("settingsDialog").style.display = "block";
     showGeneralSettingsTab();
-    qdl.getSettings(["maximumConcurrentTransfers", "startTransfersAutomatically", "createSubfolders",
-                     "extractArchives", "deleteExtractedArchives"], function (settings) {
+    qdl.getSettings(["maximumConcurrentTransfers", "adaptiveConcurrentTransfers", "minimumConcurrentTransfers",
+                     "startTransfersAutomatically", "createSubfolders", "extractArchives",
+                     "deleteExtractedArchives"], function (settings) {
                          document.getElementById("concurrentTransfersSelector").value =
                              settings.maximumConcurrentTransfers;
+                         document.getElementById("adaptiveCheckBox").checked =
+                             settings.adaptiveConcurrentTransfers === true;
+                         document.getElementById("minimumConcurrentTransfersSelector").value =
+                             settings.minimumConcurrentTransfers;
                          document.getElementById("automaticCheckBox").checked =
                              settings.startTransfersAutomatically === true;
                          document.getElementById("extractArchivesCheckBox").checked =
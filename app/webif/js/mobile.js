@@ -22,6 +22,7 @@ var currentServicePlugin = "";
 var currentRecaptchaPlugin = "";
 var currentDecaptchaPlugin = "";
 var requestId = "";
+var transferCache = {};
 var requestedSettings = {};
 
 function init() {
@@ -98,6 +99,7 @@ function init() {
     }
     
     loadTransfers(0, -1);
+    listenForEvents();
 }
 
 function loadTransfers(offset, limit) {
@@ -113,6 +115,109 @@ function loadTransfers(offset, limit) {
     });
 }
 
+function reloadTransfers() {
+    var list = document.getElementById("transfersList");
+    
+    while (list.firstChild) {
+        list.removeChild(list.firstChild);
+    }
+    
+    transferCache = {};
+    loadTransfers(0, -1);
+}
+
+function insertChangedTransfer(transfer) {
+    if (!transfer.parentId) {
+        insertTransfer(transfer);
+        return;
+    }
+    
+    // Child transfers are only shown while their package is expanded
+    var parent = document.getElementById(transfer.parentId);
+    
+    if ((parent) && (parent.getAttribute("data-expanded") == "true")) {
+        var next = parent.nextSibling;
+        
+        while ((next) && (next.getAttribute("data-itemtype") == TransferItemType.TransferType)) {
+            next = next.nextSibling;
+        }
+        
+        insertTransfer(transfer, next);
+    }
+}
+
+function removeTransfers(ids) {
+    for (var i = 0; i < ids.length; i++) {
+        var item = document.getElementById(ids[i]);
+        
+        if (item) {
+            removeTransfer(item);
+        }
+    }
+}
+
+function listenForEvents() {
+    var source = qdl.listen({
+        "inserted": function (transfers) {
+            for (var i = 0; i < transfers.length; i++) {
+                insertChangedTransfer(transfers[i]);
+            }
+        },
+        "removed": removeTransfers,
+        "moved": reloadTransfers,
+        "reset": reloadTransfers,
+        "changed": function (changes) {
+            for (var id in changes) {
+                var transfer = transferCache[id];
+                
+                if (transfer) {
+                    var properties = changes[id];
+                    
+                    for (var property in properties) {
+                        transfer[property] = properties[property];
+                    }
+                    
+                    updateTransfer(transfer);
+                }
+            }
+        },
+        "status": function (status) {
+            document.getElementById("transfersTitle").innerHTML = status.activeTransfers + "DLs - "
+                + status.totalSpeedString;
+        }
+    });
+    
+    if (!source) {
+        // No server-push support, so fall back to polling for changes
+        var revision = 0;
+        setInterval(function () {
+            qdl.getTransfersSince(revision, function (result) {
+                if ((result.reset) && (revision > 0)) {
+                    reloadTransfers();
+                }
+                else {
+                    removeTransfers(result.removed);
+                    var transfers = result.transfers;
+                    
+                    for (var i = 0; i < transfers.length; i++) {
+                        var transfer = transfers[i];
+                        
+                        if (transferCache[transfer.id]) {
+                            transferCache[transfer.id] = transfer;
+                            updateTransfer(transfer);
+                        }
+                        else {
+                            insertChangedTransfer(transfer);
+                        }
+                    }
+                }
+                
+                revision = result.revision;
+            });
+        }, 5000);
+    }
+}
+
 function showChildTransfers(item) {
     item.setAttribute("data-expanded", "true");
     item.childNodes[0].innerHTML = "-";
@@ -129,6 +234,7 @@ function hideChildTransfers(item) {
     var next = item.nextSibling;
         
     while ((next) && (next.getAttribute("data-itemtype") == TransferItemType.TransferType)) {        
+        delete transferCache[next.id];
         item.parentNode.removeChild(next);
         next = item.nextSibling;
     }
@@ -144,6 +250,7 @@ function toggleItemExpanded(item) {
 }
 
 function insertTransfer(transfer, before) {
+    transferCache[transfer.id] = transfer;
     var list = document.getElementById("transfersList");
     var item = document.createElement("li");
     item.setAttribute("class", "ListItem");
@@ -206,6 +313,8 @@ function insertTransfer(transfer, before) {
 }
 
 function removeTransfer(item) {
+    delete transferCache[item.id];
+    
     if (item.getAttribute("data-expanded") == "true") {
         hideChildTransfers(item);
     }
@@ -218,6 +327,9 @@ function updateTransfer(transfer) {
         
     if (item) {
         item.setAttribute("title", transfer.name);
+        item.setAttribute("data-cancancel", transfer.canCancel);
+        item.setAttribute("data-canpause", transfer.canPause);
+        item.setAttribute("data-canstart", transfer.canStart);
         item.setAttribute("data-priority", transfer.priority);
         item.setAttribute("data-status", transfer.status);
         
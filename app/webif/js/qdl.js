@@ -18,6 +18,8 @@
 var APPLICATION_PATH = "/app";
 var CATEGORIES_PATH = "/categories";
 var DECAPTCHA_PATH = "/decaptcha";
+var EVENTS_PATH = "/events";
+var FILES_PATH = "/files";
 var RECAPTCHA_PATH = "/recaptcha";
 var SERVICE_PATH = "/services";
 var SETTINGS_PATH = "/settings"
@@ -92,6 +94,19 @@ var UrlRetrievalStatus = {
     "Canceled": 3
 }
 
+function transferQueryString(query) {
+    var result = "";
+    
+    if (query) {
+        for (var key in query) {
+            var value = query[key];
+            result += "&" + key + "=" + encodeURIComponent(value instanceof Array ? value.join(",") : value);
+        }
+    }
+    
+    return result;
+}
+
 var Qdl = function (address, username, password) {
     this.ipaddress = address || "";
     this.username = username || "";
@@ -196,6 +211,32 @@ Qdl.prototype.put = function (path, json_data, callback_ok, callback_error) {
     request.send(JSON.stringify(json_data));
 }
 
+// Opens the server-push event stream. callbacks maps event names ("sync", "inserted", "removed", "moved",
+// "changed", "status", "captcha", "settings" and "reset") to functions receiving the parsed event data.
+// "sync" is sent whenever the stream (re)connects, with the same data as getTransfersSince().
+// Returns null if the browser does not support EventSource, in which case the caller should poll.
+Qdl.prototype.listen = function (callbacks, callback_error) {
+    if (typeof EventSource == "undefined") {
+        return null;
+    }
+    
+    var source = new EventSource(this.ipaddress + EVENTS_PATH);
+    
+    for (var name in callbacks) {
+        (function (callback) {
+            source.addEventListener(name, function (event) {
+                callback.call(this, JSON.parse(event.data));
+            });
+        })(callbacks[name]);
+    }
+    
+    if (callback_error) {
+        source.onerror = callback_error;
+    }
+    
+    return source;
+}
+
 Qdl.prototype.quit = function (callback_ok, callback_error) {
     this.get(APPLICATION_PATH + "/quit", callback_ok, callback_error);
 }
@@ -216,15 +257,27 @@ Qdl.prototype.addTransfers = function (urls, callback_ok, callback_error) {
     this.post(TRANSFERS_PATH, {"urls": urls}, callback_ok, callback_error);
 }
 
-Qdl.prototype.getTransfers = function (offset, limit, includeChildren, callback_ok, callback_error) {
-    this.get(TRANSFERS_PATH + "?offset=" + offset + "&limit=" + limit + "&includeChildren=" + includeChildren,
-             callback_ok, callback_error);
+// query may contain "fields" (list of properties to return), "sort" (list of properties, prefixed with "-" for
+// descending order) and filters such as "status", "category", "plugin" and "priority" (value or list of values)
+Qdl.prototype.getTransfers = function (offset, limit, includeChildren, callback_ok, callback_error, query) {
+    this.get(TRANSFERS_PATH + "?offset=" + offset + "&limit=" + limit + "&includeChildren=" + includeChildren
+             + transferQueryString(query), callback_ok, callback_error);
+}
+
+// Returns {revision, reset, transfers, removed}, where transfers holds only the items changed since revision
+Qdl.prototype.getTransfersSince = function (revision, callback_ok, callback_error) {
+    this.get(TRANSFERS_PATH + "?since=" + revision, callback_ok, callback_error);
 }
 
 Qdl.prototype.getTransfer = function (id, includeChildren, callback_ok, callback_error) {
     this.get(TRANSFERS_PATH + "/" + id + "?includeChildren=" + includeChildren, callback_ok, callback_error);
 }
 
+// Returns the URL of the downloaded file of a transfer. If follow is true, a transfer in progress is streamed until it finishes
+Qdl.prototype.transferFileUrl = function (id, follow) {
+    return this.ipaddress + FILES_PATH + "/" + id + (follow ? "?follow=true" : "");
+}
+
 Qdl.prototype.searchTransfers = function (property, value, hits, includeChildren, callback_ok, callback_error) {
     this.get(TRANSFERS_PATH + "/search?property=" + property + "&value=" + value.toString() + "&hits=" + hits
              + "&includeChildren=" + includeChildren, callback_ok, callback_error);
@@ -18,7 +18,6 @@ HEADERS += \
     src/base/concurrenttransfersmodel.h \
     src/base/downloadrequestmodel.h \
     src/base/imagecache.h \
-    src/base/json.h \
     src/base/logger.h \
     src/base/loggerverbositymodel.h \
     src/base/networkproxytypemodel.h \
@@ -53,7 +52,6 @@ SOURCES += \
     src/base/clipboardurlmodel.cpp \
     src/base/downloadrequestmodel.cpp \
     src/base/imagecache.cpp \
-    src/base/json.cpp \
     src/base/logger.cpp \
     src/base/package.cpp \
     src/base/request.cpp \
@@ -76,6 +74,8 @@ SOURCES += \
     src/plugins/servicepluginconfigmodel.cpp \
     src/plugins/servicepluginmanager.cpp
 
+include(../json/json.pri)
+
 maemo5 {
     QT += \
         maemo5 \
@@ -292,7 +292,7 @@ void Request::onReplyFinished() {
     }
 
     if (reply->header(QNetworkRequest::ContentTypeHeader) == "application/json") {
-        setResult(QtJson::Json::parse(QString::fromUtf8(reply->readAll())));
+        setResult(QtJson::Json::parse(reply->readAll()));
     }
     else {
         setResult(reply->readAll());
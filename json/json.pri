@@ -0,0 +1,12 @@
+INCLUDEPATH += $$PWD
+DEPENDPATH += $$PWD
+
+HEADERS += \
+    $$PWD/json.h \
+    $$PWD/jsonreader.h \
+    $$PWD/jsonwriter.h
+
+SOURCES += \
+    $$PWD/json.cpp \
+    $$PWD/jsonreader.cpp \
+    $$PWD/jsonwriter.cpp
@@ -0,0 +1,642 @@
+/*
+ * Copyright (C) 2017 Stuart Howarth <showarth@marxoft.co.uk>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "jsonreader.h"
+#include <QList>
+#include <QVariantList>
+#include <QVariantMap>
+
+namespace QtJson
+{
+
+static const int DEFAULT_MAXIMUM_DEPTH = 512;
+
+// Forwards events to a JsonHandler
+class HandlerSink
+{
+
+public:
+    explicit HandlerSink(JsonHandler *handler) :
+        m_handler(handler)
+    {
+    }
+
+    inline bool startObject() { return m_handler->startObject(); }
+    inline bool key(const QString &key) { return m_handler->key(key); }
+    inline bool endObject() { return m_handler->endObject(); }
+    inline bool startArray() { return m_handler->startArray(); }
+    inline bool endArray() { return m_handler->endArray(); }
+    inline bool nullValue() { return m_handler->nullValue(); }
+    inline bool boolValue(bool value) { return m_handler->boolValue(value); }
+    inline bool integerValue(qint64 value) { return m_handler->integerValue(value); }
+    inline bool unsignedValue(quint64 value) { return m_handler->unsignedValue(value); }
+    inline bool doubleValue(double value) { return m_handler->doubleValue(value); }
+    inline bool stringValue(const QString &value) { return m_handler->stringValue(value); }
+
+private:
+    JsonHandler *m_handler;
+};
+
+// Builds a QVariant hierarchy. Containers are only added to their parent once complete, so that the parent
+// never shares data with a container that is still being modified.
+class VariantSink
+{
+
+public:
+    inline bool startObject() {
+        m_stack.append(Frame(true));
+        return true;
+    }
+
+    inline bool key(const QString &key) {
+        m_stack.last().key = key;
+        return true;
+    }
+
+    inline bool endObject() {
+        const QVariantMap map = m_stack.last().map;
+        m_stack.removeLast();
+        return add(map);
+    }
+
+    inline bool startArray() {
+        m_stack.append(Frame(false));
+        return true;
+    }
+
+    inline bool endArray() {
+        const QVariantList list = m_stack.last().list;
+        m_stack.removeLast();
+        return add(list);
+    }
+
+    inline bool nullValue() { return add(QVariant()); }
+    inline bool boolValue(bool value) { return add(value); }
+    inline bool integerValue(qint64 value) { return add(qlonglong(value)); }
+    inline bool unsignedValue(quint64 value) { return add(qulonglong(value)); }
+    inline bool doubleValue(double value) { return add(value); }
+    inline bool stringValue(const QString &value) { return add(value); }
+
+    QVariant result() const {
+        return m_result;
+    }
+
+private:
+    struct Frame {
+        explicit Frame(bool o) :
+            isObject(o)
+        {
+        }
+
+        bool isObject;
+        QString key;
+        QVariantMap map;
+        QVariantList list;
+    };
+
+    inline bool add(const QVariant &value) {
+        if (m_stack.isEmpty()) {
+            m_result = value;
+        }
+        else {
+            Frame &frame = m_stack.last();
+
+            if (frame.isObject) {
+                frame.map.insert(frame.key, value);
+            }
+            else {
+                frame.list.append(value);
+            }
+        }
+
+        return true;
+    }
+
+    QList<Frame> m_stack;
+    QVariant m_result;
+};
+
+// Recursive descent parser over UTF-8 bytes. Each value is read exactly once and reported to the sink as
+// soon as it is complete.
+template<typename Sink>
+class Parser
+{
+
+public:
+    Parser(const char *data, int size, int maximumDepth, Sink &sink) :
+        m_begin(data),
+        m_pos(data),
+        m_end(data + size),
+        m_maximumDepth(maximumDepth),
+        m_errorOffset(-1),
+        m_sink(sink)
+    {
+    }
+
+    bool parse() {
+        // Skip the UTF-8 byte order mark
+        if ((m_end - m_pos >= 3) && (uchar(m_pos[0]) == 0xEF) && (uchar(m_pos[1]) == 0xBB)
+            && (uchar(m_pos[2]) == 0xBF)) {
+            m_pos += 3;
+        }
+
+        if (!parseValue(0)) {
+            return false;
+        }
+
+        skipWhitespace();
+        return m_pos == m_end ? true : fail("Unexpected data after the value");
+    }
+
+    QString errorString() const {
+        return m_errorString;
+    }
+
+    int errorOffset() const {
+        return m_errorOffset;
+    }
+
+private:
+    inline void skipWhitespace() {
+        while ((m_pos < m_end) && ((*m_pos == ' ') || (*m_pos == '\n') || (*m_pos == '\r') || (*m_pos == '\t'))) {
+            ++m_pos;
+        }
+    }
+
+    bool fail(const char *errorString) {
+        m_errorString = QString::fromLatin1(errorString);
+        m_errorOffset = int(m_pos - m_begin);
+        return false;
+    }
+
+    inline bool handled(bool ok) {
+        return ok ? true : fail("Aborted by handler");
+    }
+
+    bool parseValue(int depth) {
+        skipWhitespace();
+
+        if (m_pos == m_end) {
+            return fail("Unexpected end of data");
+        }
+
+        switch (*m_pos) {
+        case '{':
+            return parseObject(depth + 1);
+        case '[':
+            return parseArray(depth + 1);
+        case '"':
+        {
+            QString value;
+            return parseString(value) && handled(m_sink.stringValue(value));
+        }
+        case 't':
+            return parseLiteral("true", 4) && handled(m_sink.boolValue(true));
+        case 'f':
+            return parseLiteral("false", 5) && handled(m_sink.boolValue(false));
+        case 'n':
+            return parseLiteral("null", 4) && handled(m_sink.nullValue());
+        case '-':
+        case '0': case '1': case '2': case '3': case '4':
+        case '5': case '6': case '7': case '8': case '9':
+            return parseNumber();
+        default:
+            return fail("Unexpected character");
+        }
+    }
+
+    bool parseObject(int depth) {
+        if (depth > m_maximumDepth) {
+            return fail("Maximum depth exceeded");
+        }
+
+        ++m_pos;
+
+        if (!handled(m_sink.startObject())) {
+            return false;
+        }
+
+        skipWhitespace();
+
+        if ((m_pos < m_end) && (*m_pos == '}')) {
+            ++m_pos;
+            return handled(m_sink.endObject());
+        }
+
+        QString key;
+
+        while (true) {
+            skipWhitespace();
+
+            if ((m_pos == m_end) || (*m_pos != '"')) {
+                return fail("Expected a string key");
+            }
+
+            if ((!parseString(key)) || (!handled(m_sink.key(key)))) {
+                return false;
+            }
+
+            skipWhitespace();
+
+            if ((m_pos == m_end) || (*m_pos != ':')) {
+                return fail("Expected ':'");
+            }
+
+            ++m_pos;
+
+            if (!parseValue(depth)) {
+                return false;
+            }
+
+            skipWhitespace();
+
+            if (m_pos == m_end) {
+                return fail("Unexpected end of data");
+            }
+
+            if (*m_pos == ',') {
+                ++m_pos;
+            }
+            else if (*m_pos == '}') {
+                ++m_pos;
+                return handled(m_sink.endObject());
+            }
+            else {
+                return fail("Expected ',' or '}'");
+            }
+        }
+    }
+
+    bool parseArray(int depth) {
+        if (depth > m_maximumDepth) {
+            return fail("Maximum depth exceeded");
+        }
+
+        ++m_pos;
+
+        if (!handled(m_sink.startArray())) {
+            return false;
+        }
+
+        skipWhitespace();
+
+        if ((m_pos < m_end) && (*m_pos == ']')) {
+            ++m_pos;
+            return handled(m_sink.endArray());
+        }
+
+        while (true) {
+            if (!parseValue(depth)) {
+                return false;
+            }
+
+            skipWhitespace();
+
+            if (m_pos == m_end) {
+                return fail("Unexpected end of data");
+            }
+
+            if (*m_pos == ',') {
+                ++m_pos;
+            }
+            else if (*m_pos == ']') {
+                ++m_pos;
+                return handled(m_sink.endArray());
+            }
+            else {
+                return fail("Expected ',' or ']'");
+            }
+        }
+    }
+
+    bool parseString(QString &value) {
+        ++m_pos;
+        const char *start = m_pos;
+
+        // Strings without escapes are decoded straight from the input
+        while ((m_pos < m_end) && (*m_pos != '"') && (*m_pos != '\\')) {
+            ++m_pos;
+        }
+
+        if (m_pos == m_end) {
+            return fail("Unterminated string");
+        }
+
+        if (*m_pos == '"') {
+            value = QString::fromUtf8(start, int(m_pos - start));
+            ++m_pos;
+            return true;
+        }
+
+        m_buffer.resize(0);
+
+        while (true) {
+            m_buffer.append(start, int(m_pos - start));
+
+            if (m_pos == m_end) {
+                return fail("Unterminated string");
+            }
+
+            if (*m_pos++ == '"') {
+                value = QString::fromUtf8(m_buffer.constData(), m_buffer.size());
+                return true;
+            }
+
+            if (m_pos == m_end) {
+                return fail("Unterminated string");
+            }
+
+            switch (*m_pos++) {
+            case 'b':
+                m_buffer.append('\b');
+                break;
+            case 'f':
+                m_buffer.append('\f');
+                break;
+            case 'n':
+                m_buffer.append('\n');
+                break;
+            case 'r':
+                m_buffer.append('\r');
+                break;
+            case 't':
+                m_buffer.append('\t');
+                break;
+            case 'u':
+            {
+                uint code;
+
+                if (!parseHex(code)) {
+                    return false;
+                }
+
+                if ((code >= 0xD800) && (code < 0xDC00) && (m_end - m_pos >= 6) && (m_pos[0] == '\\')
+                    && (m_pos[1] == 'u')) {
+                    const char *high = m_pos;
+                    uint low;
+                    m_pos += 2;
+
+                    if (!parseHex(low)) {
+                        return false;
+                    }
+
+                    if ((low >= 0xDC00) && (low < 0xE000)) {
+                        code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+                    }
+                    else {
+                        m_pos = high;
+                    }
+                }
+
+                if ((code >= 0xD800) && (code < 0xE000)) {
+                    // Unpaired surrogates cannot be encoded in UTF-8, so they are replaced, as JsonWriter does
+                    code = 0xFFFD;
+                }
+
+                appendUtf8(code);
+                break;
+            }
+            default:
+                // Includes \" \\ and \/. Unknown escapes are kept as the escaped character.
+                m_buffer.append(m_pos[-1]);
+                break;
+            }
+
+            start = m_pos;
+
+            while ((m_pos < m_end) && (*m_pos != '"') && (*m_pos != '\\')) {
+                ++m_pos;
+            }
+        }
+    }
+
+    bool parseHex(uint &code) {
+        if (m_end - m_pos < 4) {
+            return fail("Invalid unicode escape");
+        }
+
+        code = 0;
+
+        for (int i = 0; i < 4; i++) {
+            const char c = *m_pos;
+            code <<= 4;
+
+            if ((c >= '0') && (c <= '9')) {
+                code |= uint(c - '0');
+            }
+            else if ((c >= 'a') && (c <= 'f')) {
+                code |= uint(c - 'a' + 10);
+            }
+            else if ((c >= 'A') && (c <= 'F')) {
+                code |= uint(c - 'A' + 10);
+            }
+            else {
+                return fail("Invalid unicode escape");
+            }
+
+            ++m_pos;
+        }
+
+        return true;
+    }
+
+    void appendUtf8(uint code) {
+        if (code < 0x80) {
+            m_buffer.append(char(code));
+        }
+        else if (code < 0x800) {
+            m_buffer.append(char(0xC0 | (code >> 6)));
+            m_buffer.append(char(0x80 | (code & 0x3F)));
+        }
+        else if (code < 0x10000) {
+            m_buffer.append(char(0xE0 | (code >> 12)));
+            m_buffer.append(char(0x80 | ((code >> 6) & 0x3F)));
+            m_buffer.append(char(0x80 | (code & 0x3F)));
+        }
+        else {
+            m_buffer.append(char(0xF0 | (code >> 18)));
+            m_buffer.append(char(0x80 | ((code >> 12) & 0x3F)));
+            m_buffer.append(char(0x80 | ((code >> 6) & 0x3F)));
+            m_buffer.append(char(0x80 | (code & 0x3F)));
+        }
+    }
+
+    bool parseNumber() {
+        const char *start = m_pos;
+        const bool negative = (*m_pos == '-');
+        bool integer = true;
+        bool overflow = false;
+        quint64 value = 0;
+
+        if (negative) {
+            ++m_pos;
+        }
+
+        const char *digits = m_pos;
+
+        while ((m_pos < m_end) && (*m_pos >= '0') && (*m_pos <= '9')) {
+            const uint digit = uint(*m_pos - '0');
+
+            if (value > (Q_UINT64_C(18446744073709551615) - digit) / 10) {
+                overflow = true;
+            }
+            else {
+                value = value * 10 + digit;
+            }
+
+            ++m_pos;
+        }
+
+        if (m_pos == digits) {
+            return fail("Invalid number");
+        }
+
+        if ((m_pos < m_end) && (*m_pos == '.')) {
+            integer = false;
+            ++m_pos;
+
+            while ((m_pos < m_end) && (*m_pos >= '0') && (*m_pos <= '9')) {
+                ++m_pos;
+            }
+        }
+
+        if ((m_pos < m_end) && ((*m_pos == 'e') || (*m_pos == 'E'))) {
+            integer = false;
+            ++m_pos;
+
+            if ((m_pos < m_end) && ((*m_pos == '+') || (*m_pos == '-'))) {
+                ++m_pos;
+            }
+
+            while ((m_pos < m_end) && (*m_pos >= '0') && (*m_pos <= '9')) {
+                ++m_pos;
+            }
+        }
+
+        if ((integer) && (!overflow)) {
+            if (!negative) {
+                return handled(m_sink.unsignedValue(value));
+            }
+
+            if (value < Q_UINT64_C(9223372036854775808)) {
+                return handled(m_sink.integerValue(-qint64(value)));
+            }
+
+            if (value == Q_UINT64_C(9223372036854775808)) {
+                return handled(m_sink.integerValue(Q_INT64_C(-9223372036854775807) - 1));
+            }
+        }
+
+        bool ok = false;
+        const double d = QByteArray::fromRawData(start, int(m_pos - start)).toDouble(&ok);
+
+        if (!ok) {
+            return fail("Invalid number");
+        }
+
+        return handled(m_sink.doubleValue(d));
+    }
+
+    bool parseLiteral(const char *literal, int length) {
+        if ((m_end - m_pos < length) || (qstrncmp(m_pos, literal, uint(length)) != 0)) {
+            return fail("Invalid literal");
+        }
+
+        m_pos += length;
+        return true;
+    }
+
+    const char *m_begin;
+    const char *m_pos;
+    const char *m_end;
+
+    int m_maximumDepth;
+
+    QByteArray m_buffer;
+
+    QString m_errorString;
+    int m_errorOffset;
+
+    Sink &m_sink;
+};
+
+JsonReader::JsonReader() :
+    m_maximumDepth(DEFAULT_MAXIMUM_DEPTH),
+    m_errorOffset(-1)
+{
+}
+
+int JsonReader::maximumDepth() const {
+    return m_maximumDepth;
+}
+
+void JsonReader::setMaximumDepth(int depth) {
+    m_maximumDepth = qMax(1, depth);
+}
+
+bool JsonReader::parse(const QByteArray &json, JsonHandler *handler) {
+    return parse(json.constData(), json.size(), handler);
+}
+
+bool JsonReader::parse(const char *json, int size, JsonHandler *handler) {
+    setError(QString(), -1);
+    JsonHandler discard;
+    HandlerSink sink(handler ? handler : &discard);
+    Parser<HandlerSink> parser(json, size, m_maximumDepth, sink);
+
+    if (parser.parse()) {
+        return true;
+    }
+
+    setError(parser.errorString(), parser.errorOffset());
+    return false;
+}
+
+QVariant JsonReader::parse(const QByteArray &json) {
+    return parse(json.constData(), json.size());
+}
+
+QVariant JsonReader::parse(const char *json, int size) {
+    setError(QString(), -1);
+    VariantSink sink;
+    Parser<VariantSink> parser(json, size, m_maximumDepth, sink);
+
+    if (parser.parse()) {
+        return sink.result();
+    }
+
+    setError(parser.errorString(), parser.errorOffset());
+    return QVariant();
+}
+
+bool JsonReader::hasError() const {
+    return m_errorOffset >= 0;
+}
+
+QString JsonReader::errorString() const {
+    return m_errorString;
+}
+
+int JsonReader::errorOffset() const {
+    return m_errorOffset;
+}
+
+void JsonReader::setError(const QString &errorString, int offset) {
+    m_errorString = errorString;
+    m_errorOffset = offset;
+}
+
+}
@@ -0,0 +1,92 @@
+/*
+ * Copyright (C) 2017 Stuart Howarth <showarth@marxoft.co.uk>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef JSONREADER_H
+#define JSONREADER_H
+
+#include <QByteArray>
+#include <QString>
+#include <QVariant>
+
+namespace QtJson
+{
+
+/**
+ * Receives the events reported by JsonReader::parse(const QByteArray&, JsonHandler*).
+ * Returning false from any method stops the parse, which then fails with "Aborted by handler".
+ * The default implementations accept and discard the event.
+ */
+class JsonHandler
+{
+
+public:
+    virtual ~JsonHandler() {}
+
+    virtual bool startObject() { return true; }
+    virtual bool key(const QString &) { return true; }
+    virtual bool endObject() { return true; }
+
+    virtual bool startArray() { return true; }
+    virtual bool endArray() { return true; }
+
+    virtual bool nullValue() { return true; }
+    virtual bool boolValue(bool) { return true; }
+    virtual bool integerValue(qint64) { return true; }
+    virtual bool unsignedValue(quint64) { return true; }
+    virtual bool doubleValue(double) { return true; }
+    virtual bool stringValue(const QString &) { return true; }
+};
+
+/**
+ * A single pass JSON parser that works directly on UTF-8 encoded data.
+ *
+ * The document can either be reported as a sequence of events to a JsonHandler, or built into a
+ * QVariant hierarchy. Non-negative integers are returned as qulonglong, negative integers as qlonglong
+ * and any number with a fraction or exponent (or that does not fit in 64 bits) as double.
+ *
+ * The data must hold a single value. Anything but whitespace after it is an error.
+ */
+class JsonReader
+{
+
+public:
+    JsonReader();
+
+    int maximumDepth() const;
+    void setMaximumDepth(int depth);
+
+    bool parse(const QByteArray &json, JsonHandler *handler);
+    bool parse(const char *json, int size, JsonHandler *handler);
+
+    QVariant parse(const QByteArray &json);
+    QVariant parse(const char *json, int size);
+
+    bool hasError() const;
+    QString errorString() const;
+    int errorOffset() const;
+
+private:
+    void setError(const QString &errorString, int offset);
+
+    int m_maximumDepth;
+
+    QString m_errorString;
+    int m_errorOffset;
+};
+
+}
+
+#endif // JSONREADER_H
@@ -0,0 +1,375 @@
+/*
+ * Copyright (C) 2017 Stuart Howarth <showarth@marxoft.co.uk>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "jsonwriter.h"
+#include <QIODevice>
+#include <QStringList>
+#include <QVariantHash>
+#include <QVariantList>
+#include <QVariantMap>
+#include <qnumeric.h>
+
+namespace QtJson
+{
+
+static const char HEX_DIGITS[] = "0123456789abcdef";
+
+JsonWriter::JsonWriter(QByteArray *output) :
+    m_output(output),
+    m_device(0),
+    m_bufferSize(0),
+    m_afterKey(false),
+    m_error(false)
+{
+}
+
+JsonWriter::JsonWriter(QIODevice *device, int bufferSize) :
+    m_output(&m_buffer),
+    m_device(device),
+    m_bufferSize(bufferSize),
+    m_afterKey(false),
+    m_error(false)
+{
+}
+
+JsonWriter::~JsonWriter() {
+    flush();
+}
+
+int JsonWriter::bufferSize() const {
+    return m_bufferSize;
+}
+
+bool JsonWriter::hasError() const {
+    return m_error;
+}
+
+void JsonWriter::beginObject() {
+    beginValue();
+    m_output->append('{');
+    m_first.append(char(1));
+}
+
+void JsonWriter::endObject() {
+    m_first.chop(1);
+    m_output->append('}');
+    flushIfFull();
+}
+
+void JsonWriter::beginArray() {
+    beginValue();
+    m_output->append('[');
+    m_first.append(char(1));
+}
+
+void JsonWriter::endArray() {
+    m_first.chop(1);
+    m_output->append(']');
+    flushIfFull();
+}
+
+void JsonWriter::writeKey(const QString &key) {
+    beginValue();
+    appendString(key);
+    m_output->append(':');
+    m_afterKey = true;
+}
+
+void JsonWriter::writeKey(const char *key) {
+    beginValue();
+    appendLatin1String(key);
+    m_output->append(':');
+    m_afterKey = true;
+}
+
+void JsonWriter::writeNull() {
+    beginValue();
+    m_output->append("null", 4);
+    flushIfFull();
+}
+
+void JsonWriter::writeBool(bool value) {
+    beginValue();
+
+    if (value) {
+        m_output->append("true", 4);
+    }
+    else {
+        m_output->append("false", 5);
+    }
+
+    flushIfFull();
+}
+
+void JsonWriter::writeInteger(qint64 value) {
+    beginValue();
+    m_output->append(QByteArray::number(value));
+    flushIfFull();
+}
+
+void JsonWriter::writeUnsigned(quint64 value) {
+    beginValue();
+    m_output->append(QByteArray::number(value));
+    flushIfFull();
+}
+
+void JsonWriter::writeDouble(double value) {
+    if (!qIsFinite(value)) {
+        writeNull();
+        return;
+    }
+
+    // Use the shortest precision that reads back as the same value
+    QByteArray number = QByteArray::number(value, 'g', 15);
+
+    if (number.toDouble() != value) {
+        number = QByteArray::number(value, 'g', 17);
+    }
+
+    // Keep the number distinguishable from an integer when it is read back
+    if ((!number.contains('.')) && (!number.contains('e'))) {
+        number.append(".0", 2);
+    }
+
+    beginValue();
+    m_output->append(number);
+    flushIfFull();
+}
+
+void JsonWriter::writeString(const QString &value) {
+    beginValue();
+    appendString(value);
+    flushIfFull();
+}
+
+void JsonWriter::writeString(const char *value) {
+    beginValue();
+    appendLatin1String(value);
+    flushIfFull();
+}
+
+bool JsonWriter::writeValue(const QVariant &value) {
+    switch (value.userType()) {
+    case QVariant::Invalid:
+        writeNull();
+        return true;
+    case QVariant::Map:
+    {
+        const QVariantMap map = value.toMap();
+        beginObject();
+
+        for (QVariantMap::const_iterator iterator = map.constBegin(); iterator != map.constEnd(); ++iterator) {
+            writeKey(iterator.key());
+
+            if (!writeValue(iterator.value())) {
+                return false;
+            }
+        }
+
+        endObject();
+        return true;
+    }
+    case QVariant::Hash:
+    {
+        const QVariantHash hash = value.toHash();
+        beginObject();
+
+        for (QVariantHash::const_iterator iterator = hash.constBegin(); iterator != hash.constEnd(); ++iterator) {
+            writeKey(iterator.key());
+
+            if (!writeValue(iterator.value())) {
+                return false;
+            }
+        }
+
+        endObject();
+        return true;
+    }
+    case QVariant::List:
+    {
+        const QVariantList list = value.toList();
+        beginArray();
+
+        for (int i = 0; i < list.size(); i++) {
+            if (!writeValue(list.at(i))) {
+                return false;
+            }
+        }
+
+        endArray();
+        return true;
+    }
+    case QVariant::StringList:
+    {
+        const QStringList list = value.toStringList();
+        beginArray();
+
+        for (int i = 0; i < list.size(); i++) {
+            writeString(list.at(i));
+        }
+
+        endArray();
+        return true;
+    }
+    case QVariant::String:
+    case QVariant::ByteArray:
+        writeString(value.toString());
+        return true;
+    case QVariant::Bool:
+        writeBool(value.toBool());
+        return true;
+    case QVariant::Double:
+    case QMetaType::Float:
+        writeDouble(value.toDouble());
+        return true;
+    case QVariant::ULongLong:
+        writeUnsigned(value.toULongLong());
+        return true;
+    default:
+        break;
+    }
+
+    if (value.canConvert<qlonglong>()) {
+        writeInteger(value.toLongLong());
+        return true;
+    }
+
+    if (value.canConvert<QString>()) {
+        // This will catch QDate, QDateTime, QUrl, ...
+        writeString(value.toString());
+        return true;
+    }
+
+    m_error = true;
+    return false;
+}
+
+void JsonWriter::writeRaw(const QByteArray &json) {
+    beginValue();
+    m_output->append(json);
+    flushIfFull();
+}
+
+bool JsonWriter::flush() {
+    if ((m_device) && (!m_buffer.isEmpty())) {
+        if (m_device->write(m_buffer) != m_buffer.size()) {
+            m_error = true;
+        }
+
+        m_buffer.resize(0);
+    }
+
+    return !m_error;
+}
+
+void JsonWriter::beginValue() {
+    if (m_afterKey) {
+        m_afterKey = false;
+    }
+    else if (!m_first.isEmpty()) {
+        char &first = m_first.data()[m_first.size() - 1];
+
+        if (first) {
+            first = 0;
+        }
+        else {
+            m_output->append(',');
+        }
+    }
+}
+
+void JsonWriter::appendString(const QString &value) {
+    QByteArray &out = *m_output;
+    const ushort *data = value.utf16();
+    const int size = value.size();
+    out.append('"');
+
+    for (int i = 0; i < size; i++) {
+        uint c = data[i];
+
+        if (c < 0x80) {
+            if ((c >= 0x20) && (c != '"') && (c != '\\')) {
+                out.append(char(c));
+                continue;
+            }
+
+            switch (c) {
+            case '"':
+                out.append("\\\"", 2);
+                break;
+            case '\\':
+                out.append("\\\\", 2);
+                break;
+            case '\b':
+                out.append("\\b", 2);
+                break;
+            case '\f':
+                out.append("\\f", 2);
+                break;
+            case '\n':
+                out.append("\\n", 2);
+                break;
+            case '\r':
+                out.append("\\r", 2);
+                break;
+            case '\t':
+                out.append("\\t", 2);
+                break;
+            default:
+                out.append("\\u00", 4);
+                out.append(HEX_DIGITS[c >> 4]);
+                out.append(HEX_DIGITS[c & 0xF]);
+                break;
+            }
+        }
+        else if (c < 0x800) {
+            out.append(char(0xC0 | (c >> 6)));
+            out.append(char(0x80 | (c & 0x3F)));
+        }
+        else if ((c >= 0xD800) && (c < 0xE000)) {
+            if ((c < 0xDC00) && (i + 1 < size) && (data[i + 1] >= 0xDC00) && (data[i + 1] < 0xE000)) {
+                c = 0x10000 + ((c - 0xD800) << 10) + (data[++i] - 0xDC00);
+                out.append(char(0xF0 | (c >> 18)));
+                out.append(char(0x80 | ((c >> 12) & 0x3F)));
+                out.append(char(0x80 | ((c >> 6) & 0x3F)));
+                out.append(char(0x80 | (c & 0x3F)));
+            }
+            else {
+                // Unpaired surrogate
+                out.append("\xEF\xBF\xBD", 3);
+            }
+        }
+        else {
+            out.append(char(0xE0 | (c >> 12)));
+            out.append(char(0x80 | ((c >> 6) & 0x3F)));
+            out.append(char(0x80 | (c & 0x3F)));
+        }
+    }
+
+    out.append('"');
+}
+
+void JsonWriter::appendLatin1String(const char *value) {
+    appendString(QString::fromLatin1(value));
+}
+
+void JsonWriter::flushIfFull() {
+    if ((m_device) && (m_buffer.size() >= m_bufferSize)) {
+        flush();
+    }
+}
+
+}
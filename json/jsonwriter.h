@@ -0,0 +1,96 @@
+/*
+ * Copyright (C) 2017 Stuart Howarth <showarth@marxoft.co.uk>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef JSONWRITER_H
+#define JSONWRITER_H
+
+#include <QByteArray>
+#include <QString>
+#include <QVariant>
+
+class QIODevice;
+
+namespace QtJson
+{
+
+/**
+ * Writes compact UTF-8 encoded JSON, either appending to a QByteArray or through a buffer to a QIODevice.
+ *
+ * Separators are inserted automatically, so a document is written as a sequence of begin/end, key and
+ * value calls. When writing to a device, the buffer is written out whenever it grows beyond
+ * bufferSize(), and must be flushed once the document is complete.
+ */
+class JsonWriter
+{
+
+public:
+    explicit JsonWriter(QByteArray *output);
+    explicit JsonWriter(QIODevice *device, int bufferSize = 16384);
+    ~JsonWriter();
+
+    int bufferSize() const;
+
+    bool hasError() const;
+
+    void beginObject();
+    void endObject();
+
+    void beginArray();
+    void endArray();
+
+    void writeKey(const QString &key);
+    void writeKey(const char *key);
+
+    void writeNull();
+    void writeBool(bool value);
+    void writeInteger(qint64 value);
+    void writeUnsigned(quint64 value);
+    void writeDouble(double value);
+    void writeString(const QString &value);
+    void writeString(const char *value);
+
+    /**
+     * Writes a QVariant hierarchy. Returns false if the value, or any value it contains, cannot be
+     * represented in JSON, in which case the output is incomplete.
+     */
+    bool writeValue(const QVariant &value);
+
+    /**
+     * Appends already serialized JSON as the next value.
+     */
+    void writeRaw(const QByteArray &json);
+
+    bool flush();
+
+private:
+    void beginValue();
+    void appendString(const QString &value);
+    void appendLatin1String(const char *value);
+    void flushIfFull();
+
+    QByteArray *m_output;
+    QIODevice *m_device;
+    QByteArray m_buffer;
+    int m_bufferSize;
+
+    QByteArray m_first;
+    bool m_afterKey;
+    bool m_error;
+};
+
+}
+
+#endif // JSONWRITER_H
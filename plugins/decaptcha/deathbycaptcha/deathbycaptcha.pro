@@ -4,13 +4,13 @@ TARGET = qdl2-deathbycaptcha
 TEMPLATE = lib
 
 HEADERS += \
-    deathbycaptchaplugin.h \
-    json.h
+    deathbycaptchaplugin.h
 
 SOURCES += \
-    json.cpp \
     deathbycaptchaplugin.cpp
 
+include(../../../json/json.pri)
+
 maemo5 {
     INCLUDEPATH += /usr/include/qdl2
     HEADERS += /usr/include/qdl2/decaptchaplugin.h
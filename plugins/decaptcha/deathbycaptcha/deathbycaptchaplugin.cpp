@@ -235,7 +235,7 @@ void DeathByCaptchaPlugin::checkCaptchaStatusResponse() {
         return;
     }
 
-    const QVariantMap map = Json::parse(QString::fromUtf8(reply->readAll())).toMap();
+    const QVariantMap map = Json::parse(reply->readAll()).toMap();
     m_captchaId = map.value("captcha").toString();
     const bool success = map.value("is_correct").toBool();
     
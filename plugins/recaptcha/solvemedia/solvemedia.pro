@@ -4,13 +4,13 @@ TARGET = qdl2-solvemediarecaptcha
 TEMPLATE = lib
 
 HEADERS += \
-    json.h \
     solvemediarecaptchaplugin.h
 
 SOURCES += \
-    json.cpp \
     solvemediarecaptchaplugin.cpp
 
+include(../../../json/json.pri)
+
 maemo5 {
     INCLUDEPATH += /usr/include/qdl2
     HEADERS += /usr/include/qdl2/recaptchaplugin.h
@@ -95,7 +95,7 @@ void SolveMediaRecaptchaPlugin::onCaptchaDownloaded() {
         return;
     }
 
-    const QVariantMap map = QtJson::Json::parse(QString::fromUtf8(reply->readAll())).toMap();
+    const QVariantMap map = QtJson::Json::parse(reply->readAll()).toMap();
     reply->deleteLater();
 
     if (map.contains("ACChallengeResult")) {
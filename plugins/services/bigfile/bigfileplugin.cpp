@@ -307,7 +307,7 @@ void BigFilePlugin::checkWaitTime() {
         return;
     }
 
-    const QVariantMap response = Json::parse(QString::fromUtf8(reply->readAll())).toMap();
+    const QVariantMap response = Json::parse(reply->readAll()).toMap();
     const int secs = response.value("waitTime").toInt();
     
     if (secs > 0) {
@@ -368,7 +368,7 @@ void BigFilePlugin::checkCaptcha() {
         return;
     }
     
-    const QVariantMap map = Json::parse(QString::fromUtf8(reply->readAll())).toMap();
+    const QVariantMap map = Json::parse(reply->readAll()).toMap();
     
     if (map.value("success") == "showCaptcha") {
         emit captchaRequest(RECAPTCHA_PLUGIN_ID, CaptchaType::Image, m_recaptchaKey, "submitCaptchaResponse");
@@ -432,7 +432,7 @@ void BigFilePlugin::checkCaptchaResponse() {
         return;
     }
 
-    const QVariantMap response = Json::parse(QString::fromUtf8(reply->readAll())).toMap();
+    const QVariantMap response = Json::parse(reply->readAll()).toMap();
     const bool success = response.value("success", false).toBool();
     
     if (success) {
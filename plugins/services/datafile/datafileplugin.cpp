@@ -317,7 +317,7 @@ void DataFilePlugin::checkCaptchaResponse() {
         return;
     }
 
-    const QVariantMap response = Json::parse(QString::fromUtf8(reply->readAll())).toMap();
+    const QVariantMap response = Json::parse(reply->readAll()).toMap();
     const bool success = response.value("success", false).toBool();
 
     if (success) {
@@ -394,7 +394,7 @@ void DataFilePlugin::checkDownloadLink() {
         return;
     }
 
-    const QVariantMap response = Json::parse(QString::fromUtf8(reply->readAll())).toMap();
+    const QVariantMap response = Json::parse(reply->readAll()).toMap();
     const bool success = response.value("success", false).toBool();
     
     if (success) {
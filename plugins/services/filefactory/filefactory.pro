@@ -8,12 +8,12 @@ greaterThan(QT_MAJOR_VERSION, 4) {
 }
 
 HEADERS += \
-    filefactoryplugin.h \
-    json.h
+    filefactoryplugin.h
 
 SOURCES += \
-    filefactoryplugin.cpp \
-    json.cpp
+    filefactoryplugin.cpp
+
+include(../../../json/json.pri)
 
 maemo5 {
     INCLUDEPATH += /usr/include/qdl2
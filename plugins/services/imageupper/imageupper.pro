@@ -7,13 +7,9 @@ maemo5 {
     icon.files = qdl2-imageupper.jpg
     icon.path = /opt/qdl2/plugins/icons
 
-    plugin.files = qdl2-imageupper.js
-    plugin.path = /opt/qdl2/plugins/services
-
     INSTALLS += \
         config \
-        icon \
-        plugin
+        icon
 
 } else:unix {
     config.files = qdl2-imageupper.json
@@ -22,11 +18,7 @@ maemo5 {
     icon.files = qdl2-imageupper.jpg
     icon.path = /usr/share/qdl2/plugins/icons
 
-    plugin.files = qdl2-imageupper.js
-    plugin.path = /usr/share/qdl2/plugins/services
-
     INSTALLS += \
         config \
-        icon \
-        plugin
+        icon
 }
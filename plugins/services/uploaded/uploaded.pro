@@ -8,13 +8,13 @@ greaterThan(QT_MAJOR_VERSION, 4) {
 }
 
 HEADERS += \
-    json.h \
     uploadedplugin.h
 
 SOURCES += \
-    json.cpp \
     uploadedplugin.cpp
 
+include(../../../json/json.pri)
+
 maemo5 {
     INCLUDEPATH += /usr/include/qdl2
     HEADERS += /usr/include/qdl2/serviceplugin.h
@@ -1,2 +1,7 @@
 TEMPLATE = subdirs
 SUBDIRS = app plugins
+
+# The tests and benchmarks are built only when requested with qmake CONFIG+=tests
+tests {
+    SUBDIRS += tests
+}
@@ -0,0 +1,82 @@
+/*
+ * Copyright (C) 2017 Stuart Howarth <showarth@marxoft.co.uk>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// The globals used by the service plugins, written in plain JavaScript so that they behave the same in both engines.
+// XMLHttpRequest answers synchronously from the pages that the benchmark adds, so only the plugin code is measured.
+
+var pages = {};
+var results = 0;
+var lastError = "";
+
+function ServicePlugin() {}
+
+ServicePlugin.prototype.urlChecked = function(result, packageName) {
+    results++;
+};
+
+ServicePlugin.prototype.downloadRequest = function(request) {
+    results++;
+};
+
+ServicePlugin.prototype.error = function(errorString) {
+    lastError = "" + errorString;
+};
+
+function UrlResult(url, fileName) {
+    this.url = url;
+    this.fileName = fileName;
+}
+
+function NetworkRequest(url) {
+    this.url = url;
+}
+
+function XMLHttpRequest() {
+    this.readyState = 0;
+    this.status = 0;
+    this.responseText = "";
+    this.onreadystatechange = null;
+}
+
+XMLHttpRequest.prototype.open = function(method, url) {
+    this.url = url;
+    this.readyState = 1;
+};
+
+XMLHttpRequest.prototype.send = function(data) {
+    if (pages.hasOwnProperty(this.url)) {
+        this.status = 200;
+        this.responseText = pages[this.url];
+    }
+    else {
+        this.status = 404;
+        this.responseText = "";
+    }
+
+    this.readyState = 4;
+
+    if (this.onreadystatechange) {
+        this.onreadystatechange();
+    }
+};
+
+XMLHttpRequest.prototype.abort = function() {
+    this.onreadystatechange = null;
+};
+
+function qsTr(text) {
+    return text;
+}
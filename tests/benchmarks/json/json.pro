@@ -0,0 +1,11 @@
+TEMPLATE = app
+TARGET = tst_bench_json
+
+QT += testlib
+QT -= gui
+
+CONFIG += console
+
+include(../../../json/json.pri)
+
+SOURCES += tst_bench_json.cpp
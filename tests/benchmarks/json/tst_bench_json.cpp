@@ -0,0 +1,252 @@
+/*
+ * Copyright (C) 2017 Stuart Howarth <showarth@marxoft.co.uk>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "json.h"
+#include <QBuffer>
+#include <QtTest>
+#if QT_VERSION >= 0x050000
+#include <QJsonDocument>
+#endif
+
+using namespace QtJson;
+
+/**
+ * Counts the events reported by JsonReader, so that the event mode is measured without building any values.
+ */
+class CountingHandler : public JsonHandler
+{
+
+public:
+    CountingHandler() :
+        JsonHandler(),
+        events(0)
+    {
+    }
+
+    virtual bool startObject() { ++events; return true; }
+    virtual bool key(const QString &) { ++events; return true; }
+    virtual bool endObject() { ++events; return true; }
+
+    virtual bool startArray() { ++events; return true; }
+    virtual bool endArray() { ++events; return true; }
+
+    virtual bool nullValue() { ++events; return true; }
+    virtual bool boolValue(bool) { ++events; return true; }
+    virtual bool integerValue(qint64) { ++events; return true; }
+    virtual bool unsignedValue(quint64) { ++events; return true; }
+    virtual bool doubleValue(double) { ++events; return true; }
+    virtual bool stringValue(const QString &) { ++events; return true; }
+
+    int events;
+};
+
+/**
+ * Returns a transfer as reported by the web interface, with the same fields as Transfer::itemDataWithRoleNames().
+ */
+static QVariantMap transferData(int package, int transfer) {
+    const QString id = QString("{%1-%2}").arg(package).arg(transfer);
+    const QString fileName = QString("Holiday Photos %1 - part%2.rar").arg(package).arg(transfer + 1);
+    const qint64 size = 104857600 + transfer * 1048576;
+    const qint64 transferred = (transfer % 3 == 0) ? size : size / (transfer % 3 + 1);
+    QVariantMap data;
+    data["bytesTransferred"] = transferred;
+    data["captchaData"] = QString();
+    data["captchaResponse"] = QString();
+    data["captchaTimeout"] = 0;
+    data["captchaTimeoutString"] = QString("--:--");
+    data["captchaType"] = 0;
+    data["captchaTypeString"] = QString("Unknown");
+    data["customCommand"] = QString();
+    data["customCommandOverrideEnabled"] = false;
+    data["deadline"] = QString();
+    data["downloadPath"] = QString("/home/user/Downloads/.incomplete/%1/").arg(id);
+    data["errorString"] = QString();
+    data["fileName"] = fileName;
+    data["filePath"] = QString("/home/user/Downloads/.incomplete/%1/%2").arg(id).arg(fileName);
+    data["id"] = id;
+    data["name"] = fileName;
+    data["pluginIconPath"] = QString("/opt/qdl2/plugins/icons/qdl2-rapidgator.jpg");
+    data["pluginId"] = QString("qdl2-rapidgator");
+    data["pluginName"] = QString("Rapidgator");
+    data["postData"] = QString();
+    data["priority"] = 2;
+    data["priorityString"] = QString("Normal");
+    data["progress"] = int(transferred * 100 / size);
+    data["progressString"] = QString("%1 of %2 MB (%3%)").arg(transferred / 1048576).arg(size / 1048576)
+                             .arg(transferred * 100 / size);
+    data["requestedSettings"] = QVariantList();
+    data["requestedSettingsTimeout"] = 0;
+    data["requestedSettingsTimeoutString"] = QString("--:--");
+    data["requestedSettingsTitle"] = QString();
+    data["requestHeaders"] = QVariantMap();
+    data["requestMethod"] = QString("GET");
+    data["size"] = size;
+    data["speed"] = (transferred < size) ? 1254976 : 0;
+    data["speedString"] = (transferred < size) ? QString("1225 kB/s") : QString("0 kB/s");
+    data["status"] = (transferred < size) ? 5 : 13;
+    data["statusString"] = (transferred < size) ? QString("Downloading") : QString("Completed");
+    data["suffix"] = QString("rar");
+    data["url"] = QString("https://rapidgator.net/file/5f1b8e9a0c3d47e2a6b9%1/%2.html").arg(id).arg(fileName);
+    data["usePlugins"] = true;
+    data["waitTime"] = 0;
+    data["waitTimeString"] = QString("--:--");
+    return data;
+}
+
+/**
+ * Returns the response to a gettransfers request for the given number of packages and transfers in each.
+ */
+static QByteArray transfersPayload(int packages, int transfers) {
+    QVariantList list;
+
+    for (int i = 0; i < packages; i++) {
+        QVariantList children;
+
+        for (int j = 0; j < transfers; j++) {
+            children << transferData(i, j);
+        }
+
+        QVariantMap package;
+        package["category"] = QString("Default");
+        package["createSubfolder"] = true;
+        package["errorString"] = QString();
+        package["id"] = QString("{%1}").arg(i);
+        package["name"] = QString("Holiday Photos %1").arg(i);
+        package["priority"] = 2;
+        package["priorityString"] = QString("Normal");
+        package["progress"] = 48;
+        package["progressString"] = QString("48%");
+        package["status"] = 5;
+        package["statusString"] = QString("Downloading");
+        package["suffix"] = QString();
+        package["children"] = children;
+        list << package;
+    }
+
+    return Json::serialize(list);
+}
+
+class JsonBenchmark : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void parse_data() {
+        QTest::addColumn<QByteArray>("json");
+
+        QTest::newRow("gettransfers, 1 package") << transfersPayload(1, 10);
+        QTest::newRow("gettransfers, 20 packages") << transfersPayload(20, 25);
+        // Responses of the hoster APIs used by the bundled plugins
+        QTest::newRow("rapidgator download") << QByteArray("{\"response\":{\"delay\":30,\"sid\":"
+            "\"b7c8f0e1d2a34f5b9c6d7e8f90a1b2c3\",\"state\":\"started\",\"fid\":\"51806422\"},"
+            "\"response_status\":200,\"response_details\":null}");
+        QTest::newRow("uploaded account") << QByteArray("{\"err\":\"\",\"account\":{\"id\":\"7hgq3l\","
+            "\"alias\":\"user\",\"premium\":true,\"traffic_left\":322122547200,\"traffic_max\":536870912000,"
+            "\"expire\":\"2017-12-31 23:59:59\",\"points\":1250,\"balance\":\"0.00\",\"ddl\":true,"
+            "\"files\":[{\"id\":\"tyyhzx8j\",\"name\":\"Holiday Photos 1 - part1.rar\",\"size\":104857600,"
+            "\"date\":1496312400,\"downloads\":12},{\"id\":\"q1w2e3r4\",\"name\":\"Holiday Photos 1 - "
+            "part2.rar\",\"size\":105906176,\"date\":1496312460,\"downloads\":9}]}}");
+        QTest::newRow("deathbycaptcha captcha") << QByteArray("{\"status\":0,\"captcha\":1402873,"
+            "\"is_correct\":true,\"text\":\"7ubm3a\"}");
+    }
+
+    void parse() {
+        QFETCH(QByteArray, json);
+        bool ok = false;
+        QVERIFY(Json::parse(json, ok).isValid());
+        QVERIFY(ok);
+
+        QBENCHMARK {
+            Json::parse(json);
+        }
+    }
+
+    void parseString_data() {
+        parse_data();
+    }
+
+    void parseString() {
+        QFETCH(QByteArray, json);
+        // As the callers that read QStrings used to, the data is decoded on every call
+        QBENCHMARK {
+            Json::parse(QString::fromUtf8(json));
+        }
+    }
+
+    void parseEvents_data() {
+        parse_data();
+    }
+
+    void parseEvents() {
+        QFETCH(QByteArray, json);
+        JsonReader reader;
+
+        QBENCHMARK {
+            CountingHandler handler;
+            QVERIFY(reader.parse(json, &handler));
+        }
+    }
+
+#if QT_VERSION >= 0x050000
+    void parseQJsonDocument_data() {
+        parse_data();
+    }
+
+    void parseQJsonDocument() {
+        QFETCH(QByteArray, json);
+        // For comparison with the parser of Qt 5, converted to the same QVariant hierarchy
+        QBENCHMARK {
+            QJsonDocument::fromJson(json).toVariant();
+        }
+    }
+#endif
+
+    void serialize_data() {
+        QTest::addColumn<QVariantList>("data");
+
+        QTest::newRow("gettransfers, 1 package") << Json::parse(transfersPayload(1, 10)).toList();
+        QTest::newRow("gettransfers, 20 packages") << Json::parse(transfersPayload(20, 25)).toList();
+    }
+
+    void serialize() {
+        QFETCH(QVariantList, data);
+
+        QBENCHMARK {
+            Json::serialize(data);
+        }
+    }
+
+    void serializeDevice_data() {
+        serialize_data();
+    }
+
+    void serializeDevice() {
+        QFETCH(QVariantList, data);
+        // As when a response is written to a socket
+        QBuffer buffer;
+        buffer.open(QBuffer::WriteOnly);
+
+        QBENCHMARK {
+            buffer.seek(0);
+            JsonWriter writer(&buffer);
+            QVERIFY(writer.writeValue(data));
+            QVERIFY(writer.flush());
+        }
+    }
+};
+
+QTEST_APPLESS_MAIN(JsonBenchmark)
+#include "tst_bench_json.moc"
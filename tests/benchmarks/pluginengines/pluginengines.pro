@@ -0,0 +1,17 @@
+TEMPLATE = app
+TARGET = tst_bench_pluginengines
+
+QT += script testlib
+QT -= gui
+
+CONFIG += console
+
+greaterThan(QT_MAJOR_VERSION, 4) {
+    QT += qml
+}
+
+DEFINES += \
+    DATA_PATH=\\\"$$PWD/../data\\\" \
+    PLUGINS_PATH=\\\"$$PWD/../../../plugins\\\"
+
+SOURCES += tst_bench_pluginengines.cpp
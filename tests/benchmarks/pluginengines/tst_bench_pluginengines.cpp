@@ -0,0 +1,131 @@
+/*
+ * Copyright (C) 2017 Stuart Howarth <showarth@marxoft.co.uk>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <QFile>
+#include <QScriptEngine>
+#include <QtTest>
+#if QT_VERSION >= 0x050000
+#include <QJSEngine>
+#endif
+
+static QString readFile(const QString &fileName) {
+    QFile file(fileName);
+    return file.open(QFile::ReadOnly) ? QString::fromUtf8(file.readAll()) : QString();
+}
+
+/**
+ * Runs the bundled service plugins on saved pages with QtScript and with QJSEngine.
+ *
+ * The engines are created without the globals of JavaScriptPluginEngine. pluginglobals.js provides plain
+ * JavaScript versions that answer requests synchronously, so that the time is spent in the plugin code and not
+ * in the network or the event loop. The watchdog is not installed either, so the QtScript times are a lower bound.
+ */
+class PluginEnginesBenchmark : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase() {
+        m_globals = readFile(DATA_PATH "/pluginglobals.js");
+        QVERIFY(!m_globals.isEmpty());
+    }
+
+    void plugins_data() {
+        QTest::addColumn<QString>("script");
+        QTest::addColumn<QString>("method");
+        QTest::addColumn<QString>("url");
+        QTest::addColumn<QString>("page");
+
+        QTest::newRow("imagebam image") << "services/imagebam/qdl2-imagebam.js" << "checkUrl"
+            << "http://www.imagebam.com/image/3f0a1b2c3d4e5f" << "imagebam-image.html";
+        QTest::newRow("imagebam gallery") << "services/imagebam/qdl2-imagebam.js" << "checkUrl"
+            << "http://www.imagebam.com/gallery/9k8j7h6g5f4d" << "imagebam-gallery.html";
+        QTest::newRow("imagebam download") << "services/imagebam/qdl2-imagebam.js" << "getDownloadRequest"
+            << "http://www.imagebam.com/image/3f0a1b2c3d4e5f" << "imagebam-image.html";
+        QTest::newRow("imgbox image") << "services/imgbox/qdl2-imgbox.js" << "checkUrl"
+            << "http://imgbox.com/Xy12Ab34" << "imgbox-image.html";
+        QTest::newRow("imgbox gallery") << "services/imgbox/qdl2-imgbox.js" << "checkUrl"
+            << "http://imgbox.com/g/Qw9Er8Ty7U" << "imgbox-gallery.html";
+        QTest::newRow("imgbox download") << "services/imgbox/qdl2-imgbox.js" << "getDownloadRequest"
+            << "http://imgbox.com/Xy12Ab34" << "imgbox-image.html";
+    }
+
+    void qtScript_data() {
+        plugins_data();
+    }
+
+    void qtScript() {
+        QFETCH(QString, script);
+        QFETCH(QString, method);
+        QFETCH(QString, url);
+        QFETCH(QString, page);
+        QScriptEngine engine;
+        engine.evaluate(m_globals, "pluginglobals.js");
+        QVERIFY(!engine.hasUncaughtException());
+        engine.globalObject().property("pages").setProperty(url, readFile(QString(DATA_PATH "/") + page));
+        const QScriptValue constructor = engine.evaluate(readFile(QString(PLUGINS_PATH "/") + script), script);
+        QVERIFY(constructor.isFunction());
+        QScriptValue plugin = constructor.call();
+        QScriptValue function = plugin.property(method);
+        const QScriptValueList args = QScriptValueList() << QScriptValue(url) << engine.newObject();
+        function.call(plugin, args);
+        QCOMPARE(engine.globalObject().property("lastError").toString(), QString());
+        QCOMPARE(engine.globalObject().property("results").toInt32(), 1);
+
+        QBENCHMARK {
+            function.call(plugin, args);
+        }
+    }
+
+#if QT_VERSION >= 0x050000
+    void qjsEngine_data() {
+        plugins_data();
+    }
+
+    void qjsEngine() {
+        QFETCH(QString, script);
+        QFETCH(QString, method);
+        QFETCH(QString, url);
+        QFETCH(QString, page);
+        QJSEngine engine;
+        QVERIFY(!engine.evaluate(m_globals, "pluginglobals.js").isError());
+        engine.globalObject().property("pages").setProperty(url, readFile(QString(DATA_PATH "/") + page));
+        const QJSValue constructor = engine.evaluate(readFile(QString(PLUGINS_PATH "/") + script), script);
+        QVERIFY(constructor.isCallable());
+        QJSValue plugin = constructor.call();
+        QJSValue function = plugin.property(method);
+        const QJSValueList args = QJSValueList() << QJSValue(url) << engine.newObject();
+        function.callWithInstance(plugin, args);
+        QCOMPARE(engine.globalObject().property("lastError").toString(), QString());
+        QCOMPARE(engine.globalObject().property("results").toInt(), 1);
+
+        QBENCHMARK {
+            function.callWithInstance(plugin, args);
+        }
+    }
+#endif
+
+private:
+    QString m_globals;
+};
+
+// QJSEngine needs an application object
+#if QT_VERSION >= 0x050000
+QTEST_GUILESS_MAIN(PluginEnginesBenchmark)
+#else
+QTEST_APPLESS_MAIN(PluginEnginesBenchmark)
+#endif
+#include "tst_bench_pluginengines.moc"
@@ -0,0 +1,37 @@
+TEMPLATE = app
+TARGET = tst_bench_rulesserviceplugin
+
+QT += network script testlib
+
+greaterThan(QT_MAJOR_VERSION, 4) {
+    QT -= gui
+}
+
+CONFIG += console
+
+DEFINES += \
+    DATA_PATH=\\\"$$PWD/../data\\\" \
+    PLUGINS_PATH=\\\"$$PWD/../../../plugins\\\"
+
+INCLUDEPATH += \
+    ../../../app/src/base \
+    ../../../app/src/plugins
+
+include(../../../json/json.pri)
+
+HEADERS += \
+    ../../../app/src/base/htmlparser.h \
+    ../../../app/src/base/logger.h \
+    ../../../app/src/base/logreader.h \
+    ../../../app/src/base/urlresult.h \
+    ../../../app/src/base/utils.h \
+    ../../../app/src/plugins/rulesserviceplugin.h \
+    ../../../app/src/plugins/serviceplugin.h
+
+SOURCES += \
+    ../../../app/src/base/htmlparser.cpp \
+    ../../../app/src/base/logger.cpp \
+    ../../../app/src/base/logreader.cpp \
+    ../../../app/src/base/utils.cpp \
+    ../../../app/src/plugins/rulesserviceplugin.cpp \
+    tst_bench_rulesserviceplugin.cpp
@@ -0,0 +1,256 @@
+/*
+ * Copyright (C) 2017 Stuart Howarth <showarth@marxoft.co.uk>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "json.h"
+#include "logger.h"
+#include "rulesserviceplugin.h"
+#include <QEventLoop>
+#include <QFile>
+#include <QNetworkAccessManager>
+#include <QNetworkReply>
+#include <QScriptEngine>
+#include <QSignalSpy>
+#include <QtTest>
+
+static QByteArray readFile(const QString &fileName) {
+    QFile file(fileName);
+    return file.open(QFile::ReadOnly) ? file.readAll() : QByteArray();
+}
+
+/**
+ * A reply with the contents of a saved page, or a 404 error if there is none. It finishes in the next iteration of
+ * the event loop, as a real reply would at the earliest.
+ */
+class SavedPageReply : public QNetworkReply
+{
+    Q_OBJECT
+
+public:
+    SavedPageReply(QNetworkAccessManager::Operation operation, const QNetworkRequest &request, const QByteArray &page,
+            QObject *parent = 0) :
+        QNetworkReply(parent),
+        m_page(page),
+        m_offset(0)
+    {
+        setOperation(operation);
+        setRequest(request);
+        setUrl(request.url());
+        open(ReadOnly | Unbuffered);
+
+        if (page.isNull()) {
+            setAttribute(QNetworkRequest::HttpStatusCodeAttribute, 404);
+            setError(ContentNotFoundError, "Not found");
+        }
+        else {
+            setAttribute(QNetworkRequest::HttpStatusCodeAttribute, 200);
+            setHeader(QNetworkRequest::ContentLengthHeader, page.size());
+        }
+
+        QMetaObject::invokeMethod(this, "finish", Qt::QueuedConnection);
+    }
+
+    virtual void abort() {}
+
+    virtual qint64 bytesAvailable() const {
+        return m_page.size() - m_offset + QNetworkReply::bytesAvailable();
+    }
+
+    virtual bool isSequential() const {
+        return true;
+    }
+
+protected:
+    virtual qint64 readData(char *data, qint64 maxSize) {
+        if (m_offset >= m_page.size()) {
+            return -1;
+        }
+
+        const int size = int(qMin(maxSize, qint64(m_page.size() - m_offset)));
+        memcpy(data, m_page.constData() + m_offset, size);
+        m_offset += size;
+        return size;
+    }
+
+private Q_SLOTS:
+    void finish() {
+        emit metaDataChanged();
+        emit readyRead();
+        setFinished(true);
+        emit finished();
+    }
+
+private:
+    QByteArray m_page;
+    int m_offset;
+};
+
+class SavedPagesNetworkAccessManager : public QNetworkAccessManager
+{
+
+public:
+    void addPage(const QString &url, const QByteArray &page) {
+        m_pages[url] = page;
+    }
+
+protected:
+    virtual QNetworkReply* createRequest(Operation operation, const QNetworkRequest &request, QIODevice *) {
+        return new SavedPageReply(operation, request, m_pages.value(request.url().toString()), this);
+    }
+
+private:
+    QHash<QString, QByteArray> m_pages;
+};
+
+/**
+ * Compares the ImageTwist and Image Upper rules with the JavaScript plugins that they replaced, on saved pages.
+ *
+ * The JavaScript plugins run with QtScript and the plain globals of pluginglobals.js, which answer requests
+ * synchronously. The rules fetch the same pages through a network access manager that serves them from memory, so
+ * their times also include one pass of the event loop for each page.
+ */
+class RulesServicePluginBenchmark : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase() {
+        Logger::setVerbosity(Logger::NoVerbosity);
+        qRegisterMetaType<QNetworkRequest>("QNetworkRequest");
+        qRegisterMetaType<UrlResult>("UrlResult");
+        qRegisterMetaType<UrlResultList>("UrlResultList");
+        m_globals = QString::fromUtf8(readFile(DATA_PATH "/pluginglobals.js"));
+        QVERIFY(!m_globals.isEmpty());
+    }
+
+    void plugins_data() {
+        QTest::addColumn<QString>("plugin");
+        QTest::addColumn<QString>("method");
+        QTest::addColumn<QString>("url");
+        QTest::addColumn<QVariantMap>("pages");
+
+        QVariantMap pages;
+        pages["https://imagetwist.com/4k2j9x1m7q3z"] = "imagetwist-image.html";
+        QTest::newRow("imagetwist image") << "imagetwist" << "checkUrl" << "https://imagetwist.com/4k2j9x1m7q3z"
+            << pages;
+        QTest::newRow("imagetwist download") << "imagetwist" << "getDownloadRequest"
+            << "https://imagetwist.com/4k2j9x1m7q3z" << pages;
+
+        pages.clear();
+        pages["http://imageupper.com/i/?S0200010050001A1496312400123456"] = "imageupper-image.html";
+        QTest::newRow("imageupper image") << "imageupper" << "checkUrl"
+            << "http://imageupper.com/i/?S0200010050001A1496312400123456" << pages;
+        QTest::newRow("imageupper download") << "imageupper" << "getDownloadRequest"
+            << "http://imageupper.com/i/?S0200010050001A1496312400123456" << pages;
+
+        pages.clear();
+        pages["http://imageupper.com/g/?galID=Xk3mP9Lq"] = "imageupper-gallery-1.html";
+        pages["http://imageupper.com/g/?galID=Xk3mP9Lq&n=2"] = "imageupper-gallery-2.html";
+        pages["http://imageupper.com/g/?galID=Xk3mP9Lq&n=3"] = "imageupper-gallery-3.html";
+        QTest::newRow("imageupper gallery, 3 pages") << "imageupper" << "checkUrl"
+            << "http://imageupper.com/g/?galID=Xk3mP9Lq" << pages;
+    }
+
+    void rules_data() {
+        plugins_data();
+    }
+
+    void rules() {
+        QFETCH(QString, plugin);
+        QFETCH(QString, method);
+        QFETCH(QString, url);
+        QFETCH(QVariantMap, pages);
+        bool ok = false;
+        const QVariantMap config = QtJson::Json::parse(readFile(QString("%1/services/%2/qdl2-%2.json")
+                                                                .arg(PLUGINS_PATH).arg(plugin)), ok).toMap();
+        QVERIFY(ok);
+        SavedPagesNetworkAccessManager manager;
+
+        for (QVariantMap::const_iterator iterator = pages.constBegin(); iterator != pages.constEnd(); ++iterator) {
+            manager.addPage(iterator.key(), readFile(QString(DATA_PATH "/") + iterator.value().toString()));
+        }
+
+        RulesServicePlugin rulesPlugin(config.value("rules").toMap());
+        rulesPlugin.setNetworkAccessManager(&manager);
+        QEventLoop loop;
+        connect(&rulesPlugin, SIGNAL(urlChecked(UrlResult)), &loop, SLOT(quit()));
+        connect(&rulesPlugin, SIGNAL(urlChecked(UrlResultList, QString)), &loop, SLOT(quit()));
+        connect(&rulesPlugin, SIGNAL(downloadRequest(QNetworkRequest, QByteArray, QByteArray)), &loop, SLOT(quit()));
+        connect(&rulesPlugin, SIGNAL(error(QString)), &loop, SLOT(quit()));
+        QSignalSpy urlCheckedSpy(&rulesPlugin, SIGNAL(urlChecked(UrlResult)));
+        QSignalSpy galleryCheckedSpy(&rulesPlugin, SIGNAL(urlChecked(UrlResultList, QString)));
+        QSignalSpy downloadRequestSpy(&rulesPlugin, SIGNAL(downloadRequest(QNetworkRequest, QByteArray, QByteArray)));
+        QSignalSpy errorSpy(&rulesPlugin, SIGNAL(error(QString)));
+        const QByteArray member = method.toLatin1();
+        QVERIFY(QMetaObject::invokeMethod(&rulesPlugin, member.constData(), Q_ARG(QString, url),
+                                          Q_ARG(QVariantMap, QVariantMap())));
+        loop.exec();
+        QCOMPARE(errorSpy.count(), 0);
+        QCOMPARE(urlCheckedSpy.count() + galleryCheckedSpy.count() + downloadRequestSpy.count(), 1);
+
+        QBENCHMARK {
+            QMetaObject::invokeMethod(&rulesPlugin, member.constData(), Q_ARG(QString, url),
+                                      Q_ARG(QVariantMap, QVariantMap()));
+            loop.exec();
+        }
+    }
+
+    void qtScript_data() {
+        plugins_data();
+    }
+
+    void qtScript() {
+        QFETCH(QString, plugin);
+        QFETCH(QString, method);
+        QFETCH(QString, url);
+        QFETCH(QVariantMap, pages);
+        QScriptEngine engine;
+        engine.evaluate(m_globals, "pluginglobals.js");
+        QVERIFY(!engine.hasUncaughtException());
+        QScriptValue pagesObject = engine.globalObject().property("pages");
+
+        for (QVariantMap::const_iterator iterator = pages.constBegin(); iterator != pages.constEnd(); ++iterator) {
+            pagesObject.setProperty(iterator.key(), QString::fromUtf8(readFile(QString(DATA_PATH "/")
+                                                                               + iterator.value().toString())));
+        }
+
+        // The script as it was before the plugin was converted to rules
+        const QString fileName = QString("qdl2-%1.js").arg(plugin);
+        const QScriptValue constructor = engine.evaluate(QString::fromUtf8(readFile(QString(DATA_PATH "/")
+                                                                                    + fileName)), fileName);
+        QVERIFY(constructor.isFunction());
+        QScriptValue scriptPlugin = constructor.call();
+        QScriptValue function = scriptPlugin.property(method);
+        const QScriptValueList args = QScriptValueList() << QScriptValue(url) << engine.newObject();
+        function.call(scriptPlugin, args);
+        QCOMPARE(engine.globalObject().property("lastError").toString(), QString());
+        QCOMPARE(engine.globalObject().property("results").toInt32(), 1);
+
+        QBENCHMARK {
+            function.call(scriptPlugin, args);
+        }
+    }
+
+private:
+    QString m_globals;
+};
+
+// The rules need an event loop
+#if QT_VERSION >= 0x050000
+QTEST_GUILESS_MAIN(RulesServicePluginBenchmark)
+#else
+QTEST_MAIN(RulesServicePluginBenchmark)
+#endif
+#include "tst_bench_rulesserviceplugin.moc"
@@ -0,0 +1,13 @@
+TEMPLATE = app
+TARGET = tst_json
+
+QT += testlib
+QT -= gui
+
+CONFIG += \
+    console \
+    testcase
+
+include(../../json/json.pri)
+
+SOURCES += tst_json.cpp
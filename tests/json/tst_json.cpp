@@ -0,0 +1,200 @@
+/*
+ * Copyright (C) 2016 Stuart Howarth <showarth@marxoft.co.uk>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "json.h"
+#include <QBuffer>
+#include <QtTest>
+
+using namespace QtJson;
+
+class JsonTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void strings_data();
+    void strings();
+    void numbers_data();
+    void numbers();
+    void errors_data();
+    void errors();
+    void depthLimit();
+    void roundTrip();
+};
+
+void JsonTest::strings_data() {
+    QTest::addColumn<QByteArray>("json");
+    QTest::addColumn<QString>("expected");
+
+    QTest::newRow("plain") << QByteArray("\"plain\"") << QString("plain");
+    QTest::newRow("escapes") << QByteArray("\"\\\"\\\\\\/\\b\\f\\n\\r\\t\"") << QString("\"\\/\b\f\n\r\t");
+    QTest::newRow("unicode escape") << QByteArray("\"caf\\u00e9\"") << QString::fromUtf8("caf\xC3\xA9");
+    QTest::newRow("unicode escape, upper case") << QByteArray("\"\\u20AC\"") << QString(QChar(0x20AC));
+    QTest::newRow("utf-8") << QByteArray("\"caf\xC3\xA9\"") << QString::fromUtf8("caf\xC3\xA9");
+    QTest::newRow("surrogate pair") << QByteArray("\"\\ud83d\\ude00\"") << QString::fromUtf8("\xF0\x9F\x98\x80");
+    QTest::newRow("unpaired high surrogate") << QByteArray("\"\\ud83d\\u0041\"")
+        << QString(QChar(0xFFFD)) + QLatin1Char('A');
+    QTest::newRow("unpaired low surrogate") << QByteArray("\"\\ude00\"") << QString(QChar(0xFFFD));
+    QTest::newRow("byte order mark") << QByteArray("\xEF\xBB\xBF\"plain\"") << QString("plain");
+}
+
+void JsonTest::strings() {
+    QFETCH(QByteArray, json);
+    QFETCH(QString, expected);
+    JsonReader reader;
+    const QVariant value = reader.parse(json);
+    QVERIFY(!reader.hasError());
+    QCOMPARE(int(value.type()), int(QVariant::String));
+    QCOMPARE(value.toString(), expected);
+}
+
+void JsonTest::numbers_data() {
+    QTest::addColumn<QByteArray>("json");
+    QTest::addColumn<int>("type");
+    QTest::addColumn<QByteArray>("expected");
+
+    QTest::newRow("zero") << QByteArray("0") << int(QVariant::ULongLong) << QByteArray("0");
+    QTest::newRow("negative zero") << QByteArray("-0") << int(QVariant::LongLong) << QByteArray("0");
+    QTest::newRow("largest unsigned") << QByteArray("18446744073709551615") << int(QVariant::ULongLong)
+        << QByteArray("18446744073709551615");
+    QTest::newRow("unsigned overflow") << QByteArray("18446744073709551616") << int(QVariant::Double)
+        << QByteArray("18446744073709551616");
+    QTest::newRow("smallest integer") << QByteArray("-9223372036854775808") << int(QVariant::LongLong)
+        << QByteArray("-9223372036854775808");
+    QTest::newRow("integer overflow") << QByteArray("-9223372036854775809") << int(QVariant::Double)
+        << QByteArray("-9223372036854775809");
+    QTest::newRow("fraction") << QByteArray("-1.5") << int(QVariant::Double) << QByteArray("-1.5");
+    QTest::newRow("exponent") << QByteArray("1e3") << int(QVariant::Double) << QByteArray("1000");
+    QTest::newRow("negative exponent") << QByteArray("2.5E-3") << int(QVariant::Double) << QByteArray("0.0025");
+    QTest::newRow("whitespace") << QByteArray(" \t\r\n42 \t\r\n") << int(QVariant::ULongLong) << QByteArray("42");
+}
+
+void JsonTest::numbers() {
+    QFETCH(QByteArray, json);
+    QFETCH(int, type);
+    QFETCH(QByteArray, expected);
+    JsonReader reader;
+    const QVariant value = reader.parse(json);
+    QVERIFY(!reader.hasError());
+    QCOMPARE(int(value.type()), type);
+
+    switch (type) {
+    case QVariant::ULongLong:
+        QCOMPARE(value.toULongLong(), expected.toULongLong());
+        break;
+    case QVariant::LongLong:
+        QCOMPARE(value.toLongLong(), expected.toLongLong());
+        break;
+    default:
+        QCOMPARE(value.toDouble(), expected.toDouble());
+        break;
+    }
+}
+
+void JsonTest::errors_data() {
+    QTest::addColumn<QByteArray>("json");
+    QTest::addColumn<int>("maximumDepth");
+    QTest::addColumn<QString>("errorString");
+    QTest::addColumn<int>("errorOffset");
+
+    QTest::newRow("empty") << QByteArray() << 0 << QString("Unexpected end of data") << 0;
+    QTest::newRow("whitespace") << QByteArray("  ") << 0 << QString("Unexpected end of data") << 2;
+    QTest::newRow("unterminated array") << QByteArray("[1,2") << 0 << QString("Unexpected end of data") << 4;
+    QTest::newRow("missing comma") << QByteArray("[1 2]") << 0 << QString("Expected ',' or ']'") << 3;
+    QTest::newRow("trailing comma") << QByteArray("[1,]") << 0 << QString("Unexpected character") << 3;
+    QTest::newRow("missing colon") << QByteArray("{\"a\" 1}") << 0 << QString("Expected ':'") << 5;
+    QTest::newRow("number key") << QByteArray("{1:2}") << 0 << QString("Expected a string key") << 1;
+    QTest::newRow("trailing comma in object") << QByteArray("{\"a\":1,}") << 0 << QString("Expected a string key")
+        << 7;
+    QTest::newRow("unterminated string") << QByteArray("\"abc") << 0 << QString("Unterminated string") << 4;
+    QTest::newRow("invalid unicode escape") << QByteArray("\"\\u12g4\"") << 0 << QString("Invalid unicode escape")
+        << 5;
+    QTest::newRow("invalid literal") << QByteArray("tru") << 0 << QString("Invalid literal") << 0;
+    QTest::newRow("invalid number") << QByteArray("[-]") << 0 << QString("Invalid number") << 2;
+    QTest::newRow("trailing value") << QByteArray("1 2") << 0 << QString("Unexpected data after the value") << 2;
+    QTest::newRow("trailing data") << QByteArray("[1] x") << 0 << QString("Unexpected data after the value") << 4;
+    QTest::newRow("maximum depth, array") << QByteArray("[[[1]]]") << 2 << QString("Maximum depth exceeded") << 2;
+    QTest::newRow("maximum depth, object") << QByteArray("{\"a\":{\"b\":{}}}") << 2
+        << QString("Maximum depth exceeded") << 10;
+}
+
+void JsonTest::errors() {
+    QFETCH(QByteArray, json);
+    QFETCH(int, maximumDepth);
+    QFETCH(QString, errorString);
+    QFETCH(int, errorOffset);
+    JsonReader reader;
+
+    if (maximumDepth > 0) {
+        reader.setMaximumDepth(maximumDepth);
+    }
+
+    QVERIFY(!reader.parse(json).isValid());
+    QVERIFY(reader.hasError());
+    QCOMPARE(reader.errorString(), errorString);
+    QCOMPARE(reader.errorOffset(), errorOffset);
+
+    // The events are checked in the same way
+    JsonHandler handler;
+    QVERIFY(!reader.parse(json, &handler));
+    QCOMPARE(reader.errorString(), errorString);
+    QCOMPARE(reader.errorOffset(), errorOffset);
+}
+
+void JsonTest::depthLimit() {
+    // Values nested up to the maximum depth are accepted
+    JsonReader reader;
+    reader.setMaximumDepth(2);
+    QVERIFY(reader.parse(QByteArray("[[1]]")).isValid());
+    QVERIFY(!reader.hasError());
+    QVERIFY(reader.parse(QByteArray("{\"a\":{\"b\":1}}")).isValid());
+    QVERIFY(!reader.hasError());
+}
+
+void JsonTest::roundTrip() {
+    // The values have the types that JsonReader returns, so that they compare equal once read back
+    QVariantMap map;
+    map["string"] = QString::fromUtf8("\"quoted\" \\ caf\xC3\xA9 \xF0\x9F\x98\x80\n\x01");
+    map["empty"] = QString();
+    map["unsigned"] = qulonglong(Q_UINT64_C(18446744073709551615));
+    map["negative"] = qlonglong(Q_INT64_C(-9223372036854775807) - 1);
+    map["fraction"] = 0.1;
+    map["large"] = 1e300;
+    map["whole"] = 2.0;
+    map["bool"] = true;
+    map["null"] = QVariant();
+    map["list"] = QVariantList() << qulonglong(1) << QVariantMap() << QVariantList();
+    bool ok = false;
+    const QByteArray json = Json::serialize(map, ok);
+    QVERIFY(ok);
+
+    JsonReader reader;
+    const QVariant value = reader.parse(json);
+    QVERIFY(!reader.hasError());
+    QCOMPARE(value, QVariant(map));
+    QCOMPARE(Json::serialize(value), json);
+
+    // Writing through a device with a small buffer gives the same output
+    QBuffer buffer;
+    buffer.open(QBuffer::WriteOnly);
+    JsonWriter writer(&buffer, 4);
+    QVERIFY(writer.writeValue(map));
+    QVERIFY(writer.flush());
+    QCOMPARE(buffer.data(), json);
+}
+
+QTEST_APPLESS_MAIN(JsonTest)
+#include "tst_json.moc"
@@ -0,0 +1,20 @@
+TEMPLATE = app
+TARGET = tst_schedulingpolicy
+
+QT += testlib
+QT -= gui
+
+CONFIG += \
+    console \
+    testcase
+
+INCLUDEPATH += ../../app/src/base
+
+HEADERS += \
+    ../../app/src/base/schedulingpolicy.h \
+    ../../app/src/base/transferitem.h
+
+SOURCES += \
+    ../../app/src/base/schedulingpolicy.cpp \
+    ../../app/src/base/transferitem.cpp \
+    tst_schedulingpolicy.cpp
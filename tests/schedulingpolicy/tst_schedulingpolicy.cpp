@@ -0,0 +1,291 @@
+/*
+ * Copyright (C) 2016 Stuart Howarth <showarth@marxoft.co.uk>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "schedulingpolicy.h"
+#include "transferitem.h"
+#include <QDateTime>
+#include <QtTest>
+
+static const QDateTime START_TIME(QDate(2017, 1, 1), QTime(0, 0));
+
+class SimulatedPackage : public TransferItem
+{
+
+public:
+    explicit SimulatedPackage(const QString &category) :
+        TransferItem(),
+        m_category(category)
+    {
+    }
+
+    virtual QVariant data(int role) const {
+        return role == CategoryRole ? QVariant(m_category) : TransferItem::data(role);
+    }
+
+    virtual ItemType itemType() const {
+        return PackageType;
+    }
+
+private:
+    QString m_category;
+};
+
+/**
+ * A transfer that downloads one unit of its size per second once it is started.
+ */
+class SimulatedTransfer : public TransferItem
+{
+
+public:
+    SimulatedTransfer(qint64 size, int deadline) :
+        TransferItem(),
+        size(size),
+        transferred(0),
+        deadline(deadline),
+        started(-1)
+    {
+    }
+
+    virtual QVariant data(int role) const {
+        switch (role) {
+        case BytesTransferredRole:
+            return transferred;
+        case DeadlineRole:
+            return deadline >= 0 ? START_TIME.addSecs(deadline) : QDateTime();
+        case PriorityRole:
+            return int(NormalPriority);
+        case SizeRole:
+            return size;
+        default:
+            return TransferItem::data(role);
+        }
+    }
+
+    virtual ItemType itemType() const {
+        return TransferType;
+    }
+
+    qint64 size;
+    qint64 transferred;
+    int deadline;
+    qint64 started;
+};
+
+struct SimulationResult {
+    SimulationResult() : makespan(0), totalCompletion(0), missedDeadlines(0) {}
+
+    qint64 makespan;
+    qint64 totalCompletion;
+    int missedDeadlines;
+};
+
+// Starts transfers in the order given by SchedulingPolicy::schedule() whenever one of slots is free, as
+// TransferModel::startNextTransfers() does, until every transfer is complete
+static SimulationResult simulate(const QList<SimulatedTransfer*> &transfers, const QHash<QString, int> &policies,
+                                 int slots) {
+    SimulationResult result;
+    QList<TransferItem*> queued;
+    QList<TransferItem*> active;
+    qint64 time = 0;
+
+    foreach (SimulatedTransfer *transfer, transfers) {
+        transfer->transferred = 0;
+        transfer->started = -1;
+        queued << transfer;
+    }
+
+    while ((!queued.isEmpty()) || (!active.isEmpty())) {
+        foreach (TransferItem *item, SchedulingPolicy::schedule(queued, active, policies)) {
+            if (active.size() >= slots) {
+                break;
+            }
+
+            queued.removeOne(item);
+            active << item;
+            static_cast<SimulatedTransfer*>(item)->started = time;
+        }
+
+        // Advance to the next completion
+        qint64 step = -1;
+
+        foreach (const TransferItem *item, active) {
+            const SimulatedTransfer *transfer = static_cast<const SimulatedTransfer*>(item);
+            const qint64 remaining = transfer->size - transfer->transferred;
+
+            if ((step < 0) || (remaining < step)) {
+                step = remaining;
+            }
+        }
+
+        time += step;
+
+        for (int i = active.size() - 1; i >= 0; i--) {
+            SimulatedTransfer *transfer = static_cast<SimulatedTransfer*>(active.at(i));
+            transfer->transferred += step;
+
+            if (transfer->transferred >= transfer->size) {
+                result.totalCompletion += time;
+
+                if ((transfer->deadline >= 0) && (time > transfer->deadline)) {
+                    ++result.missedDeadlines;
+                }
+
+                active.removeAt(i);
+            }
+        }
+    }
+
+    result.makespan = time;
+    return result;
+}
+
+static QHash<QString, int> policies(int type) {
+    QHash<QString, int> hash;
+    hash["a"] = type;
+    hash["b"] = type;
+    return hash;
+}
+
+class SchedulingPolicyTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void cleanup();
+
+    void comparePolicies();
+    void fairShareAcrossCategories();
+    void earliestDeadlineFirst();
+
+private:
+    SimulatedPackage* addPackage(const QString &category);
+    SimulatedTransfer* addTransfer(SimulatedPackage *package, qint64 size, int deadline = -1);
+    void addSyntheticQueue();
+
+    QList<SimulatedPackage*> m_packages;
+    QList<SimulatedTransfer*> m_transfers;
+};
+
+void SchedulingPolicyTest::cleanup() {
+    qDeleteAll(m_transfers);
+    m_transfers.clear();
+    qDeleteAll(m_packages);
+    m_packages.clear();
+}
+
+SimulatedPackage* SchedulingPolicyTest::addPackage(const QString &category) {
+    SimulatedPackage *package = new SimulatedPackage(category);
+    m_packages << package;
+    return package;
+}
+
+SimulatedTransfer* SchedulingPolicyTest::addTransfer(SimulatedPackage *package, qint64 size, int deadline) {
+    SimulatedTransfer *transfer = new SimulatedTransfer(size, deadline);
+    package->appendRow(transfer);
+    m_transfers << transfer;
+    return transfer;
+}
+
+// One large package queued ahead of several packages of small transfers of varying size
+void SchedulingPolicyTest::addSyntheticQueue() {
+    uint seed = 1;
+    SimulatedPackage *large = addPackage("a");
+
+    for (int i = 0; i < 4; i++) {
+        addTransfer(large, 1000);
+    }
+
+    for (int i = 0; i < 3; i++) {
+        SimulatedPackage *package = addPackage("a");
+
+        for (int j = 0; j < 8; j++) {
+            seed = seed * 1103515245 + 12345;
+            addTransfer(package, 10 + (seed >> 16) % 191, 500 + i * 100 + j * 10);
+        }
+    }
+}
+
+void SchedulingPolicyTest::comparePolicies() {
+    const int slots = 3;
+    addSyntheticQueue();
+    qint64 total = 0;
+    qint64 largest = 0;
+
+    foreach (const SimulatedTransfer *transfer, m_transfers) {
+        total += transfer->size;
+        largest = qMax(largest, transfer->size);
+    }
+
+    QHash<int, SimulationResult> results;
+
+    foreach (const int type, SchedulingPolicy::types()) {
+        const SimulationResult result = simulate(m_transfers, policies(type), slots);
+        // Any order is within the bounds of list scheduling
+        QVERIFY(result.makespan >= qMax((total + slots - 1) / slots, largest));
+        QVERIFY(result.makespan <= total / slots + largest);
+        results[type] = result;
+    }
+
+    const SimulationResult priority = results.value(SchedulingPolicy::PriorityPolicy);
+    const SimulationResult shortest = results.value(SchedulingPolicy::ShortestJobFirstPolicy);
+    const SimulationResult fairShare = results.value(SchedulingPolicy::FairSharePolicy);
+    const SimulationResult deadline = results.value(SchedulingPolicy::DeadlinePolicy);
+
+    // Shortest first has the lowest mean completion time, and earliest deadline first misses the fewest deadlines
+    QVERIFY(shortest.totalCompletion < deadline.totalCompletion);
+    QVERIFY(shortest.totalCompletion < fairShare.totalCompletion);
+    QVERIFY(deadline.missedDeadlines < shortest.missedDeadlines);
+    QVERIFY(deadline.missedDeadlines < fairShare.missedDeadlines);
+
+    // Queue order leaves the small packages waiting behind the large one, so every other policy does better
+    QVERIFY(fairShare.totalCompletion < priority.totalCompletion);
+    QVERIFY(fairShare.missedDeadlines < priority.missedDeadlines);
+}
+
+void SchedulingPolicyTest::fairShareAcrossCategories() {
+    SimulatedPackage *large = addPackage("a");
+
+    for (int i = 0; i < 6; i++) {
+        addTransfer(large, 1000);
+    }
+
+    SimulatedPackage *small = addPackage("b");
+    const SimulatedTransfer *first = addTransfer(small, 10);
+    addTransfer(small, 10);
+
+    simulate(m_transfers, policies(SchedulingPolicy::PriorityPolicy), 2);
+    QVERIFY(first->started > 0);
+
+    // The packages take turns although they are in different categories
+    simulate(m_transfers, policies(SchedulingPolicy::FairSharePolicy), 2);
+    QCOMPARE(first->started, qint64(0));
+}
+
+void SchedulingPolicyTest::earliestDeadlineFirst() {
+    SimulatedPackage *package = addPackage("a");
+
+    // Deadlines are in the reverse of queue order, and can all be met
+    for (int i = 0; i < 5; i++) {
+        addTransfer(package, 10, 50 - i * 10);
+    }
+
+    QCOMPARE(simulate(m_transfers, policies(SchedulingPolicy::PriorityPolicy), 1).missedDeadlines, 2);
+    QCOMPARE(simulate(m_transfers, policies(SchedulingPolicy::DeadlinePolicy), 1).missedDeadlines, 0);
+}
+
+QTEST_APPLESS_MAIN(SchedulingPolicyTest)
+#include "tst_schedulingpolicy.moc"